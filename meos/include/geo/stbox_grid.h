@@ -0,0 +1,113 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @brief In-memory grid index for spatiotemporal boxes
+ */
+
+#ifndef __STBOX_GRID_H__
+#define __STBOX_GRID_H__
+
+/* MEOS */
+#include <meos.h>
+#include <meos_geo.h>
+
+/*****************************************************************************
+ * STGrid
+ *****************************************************************************/
+
+/**
+ * @brief Number of dimensions of a cell of the grid: X, Y, Z, and time
+ */
+#define STGRID_DIMS 4
+
+/**
+ * @brief Maximum number of cells covered by a box stored in the grid
+ */
+#define STGRID_MAX_BOX_CELLS 65536
+
+/**
+ * @brief Cell of the grid, i.e., a slot of the hash table of the cells
+ * @details The coordinates of a cell are the numbers of the tiles of the
+ * space-time grid, counted from the origin, a missing dimension being always
+ * zero. An empty slot has a @p NULL array of entries.
+ */
+typedef struct
+{
+  int64 key[STGRID_DIMS];  /**< Coordinates of the cell */
+  int count;               /**< Number of entries of the cell */
+  int capacity;            /**< Allocated capacity of @p entries */
+  int *entries;            /**< Positions of the entries covering the cell */
+} STGridCell;
+
+/**
+ * @brief Entry of the grid
+ */
+typedef struct
+{
+  STBox box;                 /**< Bounding box */
+  int64 id;                  /**< Identifier of the box */
+  int64 lo[STGRID_DIMS];     /**< First cell covered by the box */
+  int64 hi[STGRID_DIMS];     /**< Last cell covered by the box */
+} STGridEntry;
+
+/**
+ * @brief In-memory grid index for spatiotemporal boxes
+ * @details A box is stored in every cell of a fixed space-time grid that it
+ * covers, the cells being those of #stbox_get_space_time_tile, and the cells
+ * are kept in an open-addressing hash table keyed by their coordinates. The
+ * entries are kept in a dense array, a deleted entry being replaced by the
+ * last one.
+ */
+struct STGrid
+{
+  double xsize;             /**< Size of the tiles in the X dimension */
+  double ysize;             /**< Size of the tiles in the Y dimension */
+  double zsize;             /**< Size of the tiles in the Z dimension */
+  int64 tunits;             /**< Duration of the tiles in microseconds, 0 for
+                                 a grid without time dimension */
+  double xorigin;           /**< Origin of the grid in the X dimension */
+  double yorigin;           /**< Origin of the grid in the Y dimension */
+  double zorigin;           /**< Origin of the grid in the Z dimension */
+  TimestampTz torigin;      /**< Origin of the grid in the time dimension */
+  int32 srid;               /**< SRID of the boxes */
+  int16 flags;              /**< Flags giving the dimensions of the boxes */
+  STGridEntry *entries;     /**< Array of entries */
+  int count;                /**< Number of entries */
+  int capacity;             /**< Allocated capacity of @p entries */
+  STGridCell *cells;        /**< Hash table of the cells */
+  int ncells;               /**< Number of cells in use */
+  int cellcap;              /**< Number of slots of @p cells, a power of 2 */
+  int64 lo[STGRID_DIMS];    /**< First cell covered by the entries */
+  int64 hi[STGRID_DIMS];    /**< Last cell covered by the entries */
+};
+
+/*****************************************************************************/
+
+#endif /* __STBOX_GRID_H__ */
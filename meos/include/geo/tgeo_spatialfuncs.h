@@ -42,6 +42,7 @@
 #include <meos.h>
 #include "geo/geo_funcs.h"
 #include "temporal/temporal.h"
+#include "temporal/tsequence.h"
 
 /** Symbolic constants for transforming tgeompoint <-> tgeogpoint */
 #define TGEOMP_TO_TGEOGP    true
@@ -149,6 +150,10 @@ extern bool geopoint_collinear(Datum value1, Datum value2, Datum value3,
 
 extern LWLINE *lwline_make(Datum value1, Datum value2);
 
+/* Length functions */
+
+extern double tpointseqview_length(const TSequenceView *view);
+
 /* Stop function */
 
 int tpointseq_stops_iter(const TSequence *seq, double maxdist, int64 mintunits,
@@ -0,0 +1,96 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @brief Packed encoding of temporal point sequences
+ */
+
+#ifndef __TPOINT_PACKED_H__
+#define __TPOINT_PACKED_H__
+
+/* MEOS */
+#include <meos.h>
+#include <meos_geo.h>
+
+/*****************************************************************************
+ * TPointSeqPacked
+ *****************************************************************************/
+
+/**
+ * @brief Packed temporal point sequence
+ * @details The instants are kept as contiguous arrays rather than as
+ * serialized instants: the array of timestamps is followed by the arrays of
+ * the x, y, and, if any, z coordinates, all of @p count elements, so that a
+ * 2D instant takes 24 bytes. The SRID and the flags, which give the
+ * interpolation and the dimensions as those of a temporal sequence, are kept
+ * once in the header.
+ */
+struct TPointSeqPacked
+{
+  int32 vl_len_;        /**< Varlena header (do not touch directly!) */
+  uint8 temptype;       /**< Temporal type */
+  uint8 padding;        /**< Not used */
+  int16 flags;          /**< Flags as those of a temporal sequence */
+  int32 count;          /**< Number of instants */
+  int32 srid;           /**< SRID of the points */
+  Span period;          /**< Time span of the sequence, which gives its
+                             bounds */
+  /* variable-length data follows */
+};
+
+/**
+ * @brief Return a pointer to the array of timestamps of a packed temporal
+ * point sequence
+ */
+#define TPOINTSEQ_PACKED_TIMES(pseq) ( (TimestampTz *)( \
+  ((char *) (pseq)) + sizeof(TPointSeqPacked) ) )
+
+/**
+ * @brief Return a pointer to the array of x coordinates of a packed temporal
+ * point sequence
+ */
+#define TPOINTSEQ_PACKED_X(pseq) ( (double *)( \
+  TPOINTSEQ_PACKED_TIMES(pseq) + (pseq)->count ) )
+
+/**
+ * @brief Return a pointer to the array of y coordinates of a packed temporal
+ * point sequence
+ */
+#define TPOINTSEQ_PACKED_Y(pseq) ( TPOINTSEQ_PACKED_X(pseq) + (pseq)->count )
+
+/**
+ * @brief Return a pointer to the array of z coordinates of a packed temporal
+ * point sequence
+ * @pre The sequence has Z dimension
+ */
+#define TPOINTSEQ_PACKED_Z(pseq) ( TPOINTSEQ_PACKED_Y(pseq) + (pseq)->count )
+
+/*****************************************************************************/
+
+#endif /* __TPOINT_PACKED_H__ */
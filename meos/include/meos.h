@@ -350,6 +350,82 @@ typedef enum
   RTREE_CONTAINED_BY   /**< Find stored boxes contained by the query */
 } RTreeSearchOp;
 
+/**
+ * @brief Enumeration that defines the node layout of an in-memory Rtree index
+ */
+typedef enum
+{
+  RTREE_LAYOUT_BOXES,  /**< The nodes store an array of bounding boxes */
+  RTREE_LAYOUT_AXES,   /**< The nodes also store the bounds of every axis in
+                            contiguous arrays scanned with vector instructions */
+  RTREE_LAYOUT_QUANT8, /**< The nodes store the bounds of their entries as
+                            8-bit codes relative to the box of the node */
+  RTREE_LAYOUT_QUANT16 /**< The nodes store the bounds of their entries as
+                            16-bit codes relative to the box of the node */
+} RTreeLayout;
+
+/**
+ * @brief Enumeration that defines the algorithm splitting an overflowing node
+ * of an in-memory Rtree index
+ */
+typedef enum
+{
+  RTREE_SPLIT_LARGEST_AXIS, /**< Split along the largest axis of the node */
+  RTREE_SPLIT_RSTAR,        /**< R*-tree split with forced reinsertion */
+  RTREE_SPLIT_LINEAR        /**< Guttman's linear split */
+} RTreeSplit;
+
+/**
+ * @brief Enumeration that defines the packing strategy of the bulk load of an
+ * in-memory Rtree index
+ */
+typedef enum
+{
+  RTREE_LOAD_STR,    /**< Sort-Tile-Recursive packing */
+  RTREE_LOAD_HILBERT /**< Packing in the order of the Hilbert curve over the
+                          centres of the boxes */
+} RTreeLoad;
+
+/**
+ * @brief Cost of searches in an in-memory Rtree index
+ */
+typedef struct
+{
+  int64 inner_nodes;   /**< Number of inner nodes visited */
+  int64 leaves;        /**< Number of leaves visited */
+  int64 entries;       /**< Number of entries tested against the query */
+  int64 results;       /**< Number of ids returned */
+} RTreeSearchCost;
+
+/**
+ * @brief Overlap of the nodes of an in-memory Rtree index, the volumes being
+ * relative to the extent of the tree
+ */
+typedef struct
+{
+  int64 nodes;         /**< Number of inner nodes */
+  int64 pairs;         /**< Number of pairs of entries of an inner node */
+  int64 overlapping;   /**< Number of those pairs whose boxes intersect */
+  double overlap;      /**< Sum of the volumes of their intersections */
+  double volume;       /**< Sum of the volumes of the entries of the inner
+                            nodes */
+} RTreeOverlap;
+
+/**
+ * @brief Statistics of an in-memory Rtree or space-partitioning index
+ */
+typedef struct
+{
+  int64 entries;       /**< Number of ids of the index */
+  int height;          /**< Number of levels */
+  int64 inner_nodes;   /**< Number of inner nodes */
+  int64 leaves;        /**< Number of leaves */
+  double fill;         /**< Mean fill factor of the nodes, from 0 to 1 */
+  double overlap;      /**< Volume of the intersections of the entries of the
+                            inner nodes relative to the extent of the tree */
+  size_t memory;       /**< Memory footprint in bytes */
+} RTreeStats;
+
 /**
  * Structure for the in-memory Rtree index
  */
@@ -368,12 +444,23 @@ extern RTree *rtree_create_stbox();
 extern RTree *rtree_create_tpcbox();
 #endif
 extern void rtree_free(RTree *rtree);
+extern bool rtree_save(const RTree *rtree, const char *filename);
+extern RTree *rtree_open(const char *filename);
 extern void rtree_insert(RTree *rtree, void *box, int64 id);
+extern bool rtree_delete(RTree *rtree, const void *box, int64 id);
+extern bool rtree_update(RTree *rtree, const void *oldbox, const void *newbox, int64 id);
 extern void rtree_load(RTree *rtree, const void *boxes, const int64 *ids, int count);
+extern void rtree_load_parallel(RTree *rtree, const void *boxes, const int64 *ids, int count, int nthreads);
+extern void rtree_load_config(RTree *rtree, const void *boxes, const int64 *ids, int count, RTreeLoad load, int nthreads);
+extern void rtree_overlap(const RTree *rtree, RTreeOverlap *stats);
+extern void rtree_stats(const RTree *rtree, RTreeStats *stats);
 extern void rtree_insert_temporal(RTree *rtree, const Temporal *temp, int64 id);
 extern void rtree_insert_temporal_split(RTree *rtree, const Temporal *temp, int64 id, int maxboxes);
 extern int rtree_search(const RTree *rtree, RTreeSearchOp op, const void *query, MeosArray *result);
+extern int rtree_search_cost(const RTree *rtree, RTreeSearchOp op, const void *query, MeosArray *result, RTreeSearchCost *cost);
 extern int rtree_join(const RTree *rtree1, const RTree *rtree2, RTreeSearchOp op, MeosArray *result);
+extern int rtree_join_parallel(const RTree *rtree1, const RTree *rtree2, RTreeSearchOp op, MeosArray *result, int nthreads);
+extern int rtree_search_batch(const RTree *rtree, RTreeSearchOp op, const void *queries, int count, MeosArray *result, MeosArray *offsets);
 extern int rtree_search_temporal(const RTree *rtree, RTreeSearchOp op, const Temporal *temp, MeosArray *result);
 extern int rtree_search_temporal_dedup(const RTree *rtree, RTreeSearchOp op, const Temporal *temp, int maxboxes, MeosArray *result);
 
@@ -382,10 +469,88 @@ extern int rtree_search_temporal_dedup(const RTree *rtree, RTreeSearchOp op, con
  */
 typedef struct RTreeNNCursor RTreeNNCursor;
 
+/**
+ * Exact distance of an id of an index to the query of a nearest-neighbour
+ * scan, and temporal value of an id of an index
+ */
+typedef double (*RTreeRefineFn)(int64 id, void *arg);
+typedef const Temporal *(*RTreeLookupFn)(int64 id, void *arg);
+
 extern RTreeNNCursor *rtree_nn_cursor_open(const RTree *rtree, const void *query);
+extern RTreeNNCursor *rtree_nn_cursor_open_refine(const RTree *rtree, const void *query, RTreeRefineFn refine, void *arg);
+extern RTreeNNCursor *rtree_nn_cursor_open_tgeo(const RTree *rtree, const Temporal *temp, RTreeLookupFn lookup, void *arg);
 extern bool rtree_nn_cursor_next(RTreeNNCursor *cursor, int64 *id_out, double *dist_out);
 extern void rtree_nn_cursor_close(RTreeNNCursor *cursor);
 
+/**
+ * Snapshot of an in-memory Rtree index searched concurrently with insertions
+ */
+typedef struct RTreeSnapshot RTreeSnapshot;
+
+extern bool rtree_set_concurrent(RTree *rtree);
+extern RTreeSnapshot *rtree_snapshot_open(const RTree *rtree);
+extern const RTree *rtree_snapshot_tree(const RTreeSnapshot *snapshot);
+extern void rtree_snapshot_close(RTreeSnapshot *snapshot);
+
+/**
+ * Cursor for a search of an in-memory Rtree index
+ */
+typedef struct RTreeSearchCursor RTreeSearchCursor;
+
+extern RTreeSearchCursor *rtree_search_cursor_open(const RTree *rtree, RTreeSearchOp op, const void *query);
+extern bool rtree_search_cursor_next(RTreeSearchCursor *cursor, int64 *id_out);
+extern void rtree_search_cursor_close(RTreeSearchCursor *cursor);
+
+/**
+ * Structure for a time-partitioned forest of in-memory Rtree indexes
+ */
+typedef struct RTreeForest RTreeForest;
+
+extern RTreeForest *rtree_forest_create_tstzspan(const Interval *duration, TimestampTz torigin);
+extern RTreeForest *rtree_forest_create_tbox(const Interval *duration, TimestampTz torigin);
+extern RTreeForest *rtree_forest_create_stbox(const Interval *duration, TimestampTz torigin);
+extern void rtree_forest_free(RTreeForest *forest);
+extern int rtree_forest_buckets(const RTreeForest *forest);
+extern bool rtree_forest_insert(RTreeForest *forest, void *box, int64 id);
+extern bool rtree_forest_insert_temporal(RTreeForest *forest, const Temporal *temp, int64 id);
+extern int rtree_forest_search(const RTreeForest *forest, RTreeSearchOp op, const void *query, MeosArray *result);
+extern int rtree_forest_search_temporal(const RTreeForest *forest, RTreeSearchOp op, const Temporal *temp, MeosArray *result);
+extern int rtree_forest_freeze(RTreeForest *forest, TimestampTz t);
+extern int rtree_forest_drop(RTreeForest *forest, TimestampTz t);
+
+/**
+ * Structure for a static in-memory index of time ranges
+ */
+typedef struct TimeIndex TimeIndex;
+
+extern TimeIndex *timeindex_make_tstzspan(const Span *spans, const int64 *ids, int count);
+extern TimeIndex *timeindex_make_tbox(const TBox *boxes, const int64 *ids, int count);
+extern void timeindex_free(TimeIndex *tindex);
+extern int timeindex_count(const TimeIndex *tindex);
+extern int timeindex_search(const TimeIndex *tindex, RTreeSearchOp op, const Span *query, MeosArray *result);
+extern int timeindex_stab(const TimeIndex *tindex, TimestampTz t, MeosArray *result);
+
+/**
+ * Structure for an in-memory inverted index for sets
+ */
+typedef struct SetIndex SetIndex;
+
+extern SetIndex *setindex_create(void);
+extern void setindex_free(SetIndex *sindex);
+extern int setindex_count(const SetIndex *sindex);
+extern bool setindex_insert(SetIndex *sindex, const Set *s, int64 id);
+extern int setindex_search(const SetIndex *sindex, RTreeSearchOp op, const Set *query, MeosArray *result);
+
+/**
+ * Structure for the compressed encoding of temporal sequences
+ */
+typedef struct TSequenceComp TSequenceComp;
+
+extern TSequenceComp *tsequence_compress(const TSequence *seq, int precision);
+extern TSequence *tsequence_decompress(const TSequenceComp *cseq);
+extern int tsequencecomp_num_instants(const TSequenceComp *cseq);
+extern size_t tsequencecomp_mem_size(const TSequenceComp *cseq);
+
 /**
  * @brief Enumeration that defines the kind of an in-memory space-partitioning
  * index
@@ -414,12 +579,19 @@ extern SPTree *sptree_create_stbox(SPTreeKind kind);
 extern SPTree *sptree_create_tpcbox(SPTreeKind kind);
 #endif
 extern void sptree_free(SPTree *sptree);
+extern bool sptree_save(const SPTree *sptree, const char *filename);
+extern SPTree *sptree_open(const char *filename);
 extern void sptree_insert(SPTree *sptree, void *box, int64 id);
+extern void sptree_load(SPTree *sptree, const void *boxes, const int64 *ids, int count);
+extern bool sptree_delete(SPTree *sptree, const void *box, int64 id);
 extern void sptree_insert_temporal(SPTree *sptree, const Temporal *temp, int64 id);
 extern void sptree_insert_temporal_split(SPTree *sptree, const Temporal *temp, int64 id, int maxboxes);
 extern int sptree_search(const SPTree *sptree, RTreeSearchOp op, const void *query, MeosArray *result);
+extern int sptree_search_cost(const SPTree *sptree, RTreeSearchOp op, const void *query, MeosArray *result, RTreeSearchCost *cost);
+extern void sptree_stats(const SPTree *sptree, RTreeStats *stats);
 extern int sptree_search_temporal(const SPTree *sptree, RTreeSearchOp op, const Temporal *temp, MeosArray *result);
 extern int sptree_search_temporal_dedup(const SPTree *sptree, RTreeSearchOp op, const Temporal *temp, int maxboxes, MeosArray *result);
+extern int sptree_join(const SPTree *sptree1, const SPTree *sptree2, RTreeSearchOp op, MeosArray *result);
 
 /**
  * Cursor for a nearest-neighbour scan of an in-memory space-partitioning index
@@ -430,6 +602,15 @@ extern SPNNCursor *sptree_nn_cursor_open(const SPTree *sptree, const void *query
 extern bool sptree_nn_cursor_next(SPNNCursor *cursor, int64 *id_out, double *dist_out);
 extern void sptree_nn_cursor_close(SPNNCursor *cursor);
 
+/**
+ * Cursor for a search of an in-memory space-partitioning index
+ */
+typedef struct SPSearchCursor SPSearchCursor;
+
+extern SPSearchCursor *sptree_search_cursor_open(const SPTree *sptree, RTreeSearchOp op, const void *query);
+extern bool sptree_search_cursor_next(SPSearchCursor *cursor, int64 *id_out);
+extern void sptree_search_cursor_close(SPSearchCursor *cursor);
+
 /*****************************************************************************
  * Initialization of the MEOS library
  *****************************************************************************/
@@ -1447,6 +1628,7 @@ extern int *tint_values(const Temporal *temp, int *count);
 extern int64 *tbigint_values(const Temporal *temp, int32 *count);
 extern double tnumber_avg_value(const Temporal *temp);
 extern double tnumber_integral(const Temporal *temp);
+extern double tnumber_integral_at_tstzspan(const Temporal *temp, const Span *s);
 extern double tnumber_twavg(const Temporal *temp);
 extern SpanSet *tnumber_valuespans(const Temporal *temp);
 extern text *ttext_end_value(const Temporal *temp);
@@ -611,6 +611,47 @@ extern bool stbox_le(const STBox *box1, const STBox *box2);
 extern bool stbox_lt(const STBox *box1, const STBox *box2);
 extern bool stbox_ne(const STBox *box1, const STBox *box2);
 
+/* Grid index functions */
+
+/**
+ * Structure for the in-memory grid index of spatiotemporal boxes
+ */
+typedef struct STGrid STGrid;
+
+/**
+ * Cursor for a nearest-neighbour scan of an in-memory grid index
+ */
+typedef struct STGridNNCursor STGridNNCursor;
+
+extern STGrid *stgrid_create(double xsize, double ysize, double zsize, const Interval *duration, const GSERIALIZED *sorigin, TimestampTz torigin);
+extern void stgrid_free(STGrid *grid);
+extern int stgrid_count(const STGrid *grid);
+extern bool stgrid_insert(STGrid *grid, const STBox *box, int64 id);
+extern bool stgrid_insert_temporal(STGrid *grid, const Temporal *temp, int64 id);
+extern bool stgrid_delete(STGrid *grid, const STBox *box, int64 id);
+extern int stgrid_search(const STGrid *grid, RTreeSearchOp op, const STBox *query, MeosArray *result);
+extern STGridNNCursor *stgrid_nn_cursor_open(const STGrid *grid, const STBox *query);
+extern bool stgrid_nn_cursor_next(STGridNNCursor *cursor, int64 *id_out, double *dist_out);
+extern void stgrid_nn_cursor_close(STGridNNCursor *cursor);
+
+/* Packed temporal point sequence functions */
+
+/**
+ * Structure for the packed encoding of temporal point sequences
+ */
+typedef struct TPointSeqPacked TPointSeqPacked;
+
+extern TPointSeqPacked *tpointseq_packed_make(const double *xcoords, const double *ycoords, const double *zcoords, const TimestampTz *times, int count, int32_t srid, bool geodetic, bool lower_inc, bool upper_inc, interpType interp);
+extern TPointSeqPacked *tpointseq_to_packed(const TSequence *seq);
+extern TSequence *tpointseq_from_packed(const TPointSeqPacked *pseq);
+extern int tpointseq_packed_num_instants(const TPointSeqPacked *pseq);
+extern size_t tpointseq_packed_mem_size(const TPointSeqPacked *pseq);
+extern TInstant *tpointseq_packed_instant_n(const TPointSeqPacked *pseq, int n);
+extern bool tpointseq_packed_value_at_timestamptz(const TPointSeqPacked *pseq, TimestampTz t, bool strict, GSERIALIZED **result);
+extern double tpointseq_packed_length(const TPointSeqPacked *pseq);
+extern TSequence *tpointseq_packed_speed(const TPointSeqPacked *pseq);
+extern double nad_tpointseq_packed_geo(const TPointSeqPacked *pseq, const GSERIALIZED *gs);
+
 /*****************************************************************************
  * Functions for temporal geometries/geographies
  *****************************************************************************/
@@ -687,6 +728,7 @@ extern Temporal *tpoint_get_y(const Temporal *temp);
 extern Temporal *tpoint_get_z(const Temporal *temp);
 extern bool tpoint_is_simple(const Temporal *temp);
 extern double tpoint_length(const Temporal *temp);
+extern double tpoint_length_at_tstzspan(const Temporal *temp, const Span *s);
 extern Temporal *tpoint_speed(const Temporal *temp);
 extern GSERIALIZED *tpoint_trajectory(const Temporal *temp, bool unary_union);
 extern GSERIALIZED *tpoint_twcentroid(const Temporal *temp);
@@ -952,6 +952,15 @@ extern bool ensure_bbox_temporal_compatible(MeosType bboxtype,
 extern void *bbox_temporal_split_boxes(MeosType bboxtype, size_t boxsize,
   const Temporal *temp, int maxboxes, int *count);
 
+/* Functions on in-memory indexes of generic bounding boxes */
+
+extern RTree *rtree_create(MeosType bboxtype);
+extern RTree *rtree_create_layout(MeosType bboxtype, RTreeLayout layout);
+extern RTree *rtree_create_config(MeosType bboxtype, RTreeLayout layout, int capacity, RTreeSplit split);
+extern RTreeForest *rtree_forest_create(MeosType bboxtype, const Interval *duration, TimestampTz torigin);
+extern SPTree *sptree_create(MeosType bboxtype, SPTreeKind kind);
+extern SPTree *sptree_create_config(MeosType bboxtype, SPTreeKind kind, int bucketsize);
+
 /* Set functions for set and span types */
 
 extern void bbox_union_span_span(const Span *s1, const Span *s2, Span *result);
@@ -1176,6 +1185,7 @@ extern TimestampTz tsequence_start_timestamptz(const TSequence *seq);
 extern SpanSet *tsequence_time(const TSequence *seq);
 extern TimestampTz *tsequence_timestamps(const TSequence *seq, int *count);
 extern bool tsequence_value_at_timestamptz(const TSequence *seq, TimestampTz t, bool strict, Datum *result);
+extern bool tsequencecomp_value_at_timestamptz(const TSequenceComp *cseq, TimestampTz t, bool strict, Datum *result);
 extern Datum *tsequence_values_p(const TSequence *seq, int *count);
 extern Interval *tsequenceset_duration(const TSequenceSet *ss, bool boundspan);
 extern TimestampTz tsequenceset_end_timestamptz(const TSequenceSet *ss);
@@ -172,6 +172,10 @@
  * @defgroup meos_internal_box_set Set functions
  * @ingroup meos_internal_box
  * @brief Set functions for box types
+ *
+ * @defgroup meos_internal_box_index Index functions
+ * @ingroup meos_internal_box
+ * @brief Functions on in-memory indexes of generic bounding boxes
   */
 
 /*****************************************************************************/
@@ -0,0 +1,104 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @brief In-memory inverted index for set types
+ */
+
+#ifndef __SET_INDEX_H__
+#define __SET_INDEX_H__
+
+/* MEOS */
+#include <meos.h>
+
+/*****************************************************************************
+ * SetIndex
+ *****************************************************************************/
+
+/**
+ * @brief Number of documents of a block of a posting list
+ */
+#define SETINDEX_BLOCK 128
+
+/**
+ * @brief Block of a posting list
+ * @details The first document of a block is kept in the block, and the other
+ * ones are encoded in the bytes of the posting list as the variable-length
+ * differences with the previous document, so that a block can be decoded
+ * without the previous ones
+ */
+typedef struct
+{
+  int32 first;             /**< First document of the block */
+  int32 offset;            /**< Offset of the block in the bytes */
+} SetPostingBlock;
+
+/**
+ * @brief Posting list of an element, i.e., a slot of the hash table of the
+ * elements
+ * @details The documents of a posting list are the numbers of the sets
+ * containing the element, in increasing order. An empty slot has no blocks.
+ */
+typedef struct
+{
+  Datum value;              /**< Element */
+  uint32 hash;              /**< Hash of the element */
+  int count;                /**< Number of documents */
+  int32 last;               /**< Last document */
+  int size;                 /**< Number of bytes in use */
+  int capacity;             /**< Allocated capacity of @p bytes */
+  uint8 *bytes;             /**< Encoded differences between the documents */
+  int nblocks;              /**< Number of blocks */
+  int blockcap;             /**< Allocated capacity of @p blocks */
+  SetPostingBlock *blocks;  /**< Array of blocks */
+} SetPosting;
+
+/**
+ * @brief In-memory inverted index for set types
+ * @details The sets are numbered in the order of insertion, these numbers
+ * being the documents of the posting lists, and the posting lists are kept in
+ * an open-addressing hash table keyed by the elements
+ */
+struct SetIndex
+{
+  Set *sample;              /**< Copy of the first set inserted, against which
+                                 the other sets are validated, @p NULL for an
+                                 empty index */
+  int count;                /**< Number of sets */
+  int capacity;             /**< Allocated capacity of @p ids and @p sizes */
+  int64 *ids;               /**< Identifier of every set */
+  int *sizes;               /**< Number of elements of every set */
+  SetPosting *postings;     /**< Hash table of the posting lists */
+  int npostings;            /**< Number of posting lists */
+  int postcap;              /**< Number of slots of @p postings, a power of 2 */
+};
+
+/*****************************************************************************/
+
+#endif /* __SET_INDEX_H__ */
@@ -40,6 +40,7 @@
 #include <meos.h>
 #include "temporal/meos_catalog.h"
 #include "temporal/temporal.h"
+#include "temporal/tsequence.h"
 
 /*****************************************************************************/
 
@@ -101,6 +102,10 @@ extern int tcontseq_at_tstzspanset1(const TSequence *seq, const SpanSet *ss,
 extern int tcontseq_minus_tstzspanset_iter(const TSequence *seq, const SpanSet *ss,
   TSequence **result);
 extern TSequence *tcontseq_at_tstzspan(const TSequence *seq, const Span *s);
+extern bool tcontseq_at_tstzspan_view(const TSequence *seq, const Span *s,
+  TSequenceView *view);
+extern double tcontseq_at_tstzspan_view_sum(const Temporal *temp,
+  const Span *s, double (*func)(const TSequenceView *));
 extern TInstant *tcontseq_at_timestamptz(const TSequence *seq, TimestampTz t);
 extern TSequenceSet *tcontseq_restrict_tstzspanset(const TSequence *seq,
   const SpanSet *ss, bool atfunc);
@@ -43,9 +43,19 @@
  * RTree
  *****************************************************************************/
 
+/* Maximum capacity of a node, which is also the default one */
 #define MAXITEMS 64
+/* Minimum capacity of a node */
+#define RTREE_MIN_CAPACITY 4
 #define MINITEMS_PERCENTAGE 10
-#define MINITEMS ((MAXITEMS) * (MINITEMS_PERCENTAGE) / 100 + 1)
+/* Minimum number of entries of a node other than the root */
+#define MINITEMS(capacity) ((capacity) * (MINITEMS_PERCENTAGE) / 100 + 1)
+/* Percentage of the entries of a leaf reinserted by the R* split policy */
+#define REINSERT_PERCENTAGE 30
+/* The entries of a node are selected by a 64-bit mask */
+#if MAXITEMS > 64
+  #error "MAXITEMS must not exceed 64"
+#endif
 
 /**
  * @brief Enumeration that defines the node types for an RTree.
@@ -73,10 +83,51 @@ typedef struct RTreeNode
   char boxes[];
 } RTreeNode;
 
+/* Number of snapshots of a concurrent RTree that can be open at once */
+#define RTREE_MAX_SNAPSHOTS 128
+
+/**
+ * @brief Node or version of a concurrent RTree replaced by an insertion,
+ * which is freed once no snapshot can reach it
+ */
+typedef struct
+{
+  void *ptr;             /**< Node or version */
+  uint64 epoch;          /**< Epoch in which it was replaced */
+} RTreeRetired;
+
+/**
+ * @brief State of an RTree in the concurrent mode
+ * @details The single writer inserts by copying the nodes on the insertion
+ * path, publishes the new version of the tree by swapping @p current, and
+ * then opens a new epoch. A snapshot announces in a slot the epoch in which it
+ * is opened before reading @p current, so that a node replaced in an epoch is
+ * freed once every open snapshot announced a later epoch. The fields read by
+ * the snapshots, @p current, @p epoch, and @p slots, are accessed atomically.
+ */
+typedef struct RTreeShared
+{
+  struct RTree *current;   /**< Version of the tree read by new snapshots */
+  uint64 epoch;            /**< Current epoch, starting at 1 */
+  uint64 slots[RTREE_MAX_SNAPSHOTS];  /**< Epoch of each open snapshot, 0 for
+                                           a free slot */
+  RTreeNode **owned;       /**< Nodes that the insertion in progress created
+                                or copied, which it may modify */
+  int nowned;              /**< Number of owned nodes */
+  int ownedcap;            /**< Allocated capacity of @p owned */
+  RTreeRetired *retired;   /**< Nodes and versions waiting to be freed */
+  int nretired;            /**< Number of retired nodes and versions */
+  int retiredcap;          /**< Allocated capacity of @p retired */
+} RTreeShared;
+
 /**
  * @brief Rtree in-memory index basic structure.
  * @details It works based on Span, TBox and STBox. 
- * - The spliting criteria is based on the largest axis. 
+ * - The capacity of the nodes is chosen when the tree is created, up to
+ *   @p MAXITEMS entries, the arrays of children and ids of a node being
+ *   always sized for @p MAXITEMS.
+ * - The spliting criteria is chosen when the tree is created: the largest
+ *   axis, R*-tree, or Guttman's linear split.
  * - The inserting criteria is based on least enlarging square.
  * - The get axis function makes it ease to implement with X,Y,Z and time or any
  *   combination that you may want.
@@ -86,11 +137,23 @@ struct RTree
   size_t bboxsize;       /**< Size of the bouding box */
   MeosType bboxtype;     /**< Type of the bouding box */
   int dims;
+  RTreeLayout layout;    /**< Layout of the nodes */
+  int maxitems;          /**< Capacity of the nodes */
+  int minitems;          /**< Minimum number of entries of a node */
+  RTreeSplit split;      /**< Algorithm splitting the nodes */
   RTreeNode *root;
+  const char *base;      /**< Start of the file mapping of a tree opened by
+                              #rtree_open, @p NULL for a tree in memory */
+  size_t mapsize;        /**< Size of the file mapping */
+  RTreeShared *shared;   /**< State of the concurrent mode, @p NULL for a
+                              tree without concurrent readers */
   double (*get_axis)(const void *, int, bool);
   void (*bbox_expand)(const void *, void *);
   bool (*bbox_contains)(const void *, const void *);
   bool (*bbox_overlaps)(const void *, const void *);
+  uint64 (*axis_mask)(const double *, const double *, int, double, double,
+    bool);               /**< Kernel testing the bounds of an axis, selected
+                              for the instruction set of the processor */
   char box[];
 };
 
@@ -101,6 +164,66 @@ struct RTree
 #define RTREE_NODE_BBOX_N(node, n) ( (void *)( \
   ((char *) &((node)->boxes)) + (n) * (node)->bboxsize ) )
 
+/**
+ * @brief Return a pointer to the bounds of the axes of a node of an RTree with
+ * the @p RTREE_LAYOUT_AXES layout
+ * @details They follow the bounding boxes as, for every axis, the array of the
+ * lower bounds and the array of the upper bounds of the entries, with as many
+ * doubles as the capacity of the nodes
+ */
+#define RTREE_NODE_AXES(rtree, node) ( (double *)( \
+  ((char *) &((node)->boxes)) + (rtree)->maxitems * (node)->bboxsize ) )
+
+/**
+ * @brief Return true if the nodes of an RTree have a quantized layout
+ */
+#define RTREE_QUANTIZED(rtree) ( (rtree)->layout == RTREE_LAYOUT_QUANT8 || \
+  (rtree)->layout == RTREE_LAYOUT_QUANT16 )
+
+/**
+ * @brief Return a pointer to the codes of the bounds of the entries of a node
+ * of an RTree with a quantized layout
+ * @details Such a node stores a single bounding box, its own, followed by, for
+ * every axis, the array of the lower codes and the array of the upper codes
+ * of the entries, with as many codes as the capacity of the nodes
+ */
+#define RTREE_NODE_CODES(node) ( (void *)( \
+  ((char *) &((node)->boxes)) + (node)->bboxsize ) )
+
+/**
+ * @brief Return a pointer to the n-th child of an inner node
+ * @details In a tree mapped from a file the slot of a child holds its offset
+ * from the start of the mapping instead of its address
+ */
+#define RTREE_NODE_CHILD_N(rtree, node, n) ( (rtree)->base ? \
+  (RTreeNode *) ((rtree)->base + (node)->ids[n]) : (node)->nodes[n] )
+
+/**
+ * @brief Time bucket of a time-partitioned forest of RTrees
+ */
+typedef struct
+{
+  TimestampTz start;     /**< Start of the time range of the bucket */
+  TimestampTz tmax;      /**< Latest end time of the boxes of the bucket */
+  bool frozen;           /**< True when the tree is packed and read-only */
+  RTree *rtree;          /**< Tree of the boxes starting in the bucket */
+} RTreeBucket;
+
+/**
+ * @brief Time-partitioned forest of RTrees
+ * @details The buckets are kept in increasing order of start time
+ */
+struct RTreeForest
+{
+  MeosType bboxtype;     /**< Type of the bouding box */
+  size_t bboxsize;       /**< Size of the bouding box */
+  int64 tunits;          /**< Duration of the buckets in microseconds */
+  TimestampTz torigin;   /**< Origin of the buckets */
+  int count;             /**< Number of buckets */
+  int capacity;          /**< Allocated capacity of the bucket array */
+  RTreeBucket *buckets;  /**< Array of buckets */
+};
+
 /*****************************************************************************/
 
 #endif /* __TEMPORAL_RTREE__ */
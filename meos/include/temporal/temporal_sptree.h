@@ -49,25 +49,74 @@
  */
 #define SPTREE_NODEBOX_MAXSIZE 512
 
+/**
+ * @brief Maximum number of boxes of a leaf bucket
+ */
+#define SPTREE_MAX_BUCKET 256
+
+/**
+ * @brief Size in bytes of a block of the arena of the nodes of an SPTree
+ */
+#define SPTREE_ARENA_BLOCKSIZE (64 * 1024)
+
 /**
  * @brief Node of an in-memory space-partitioning tree
- * @details A node is a stored bounding box (the @p centroid) that splits the
- * space into @p nchild children; the box lives in the flexible tail. An empty
- * child slot is a @p NULL pointer.
+ * @details A node is either an inner node or, for a tree with leaf buckets, a
+ * leaf bucket. An inner node is a stored bounding box (the @p centroid) that
+ * splits the space into @p nchild children; the box lives in the flexible
+ * tail. An empty child slot is a @p NULL pointer. A leaf bucket has no
+ * children and stores up to @p bucketsize boxes and their ids in the flexible
+ * tail, which are scanned linearly.
  */
 typedef struct SPNode
 {
   int64 id;                   /**< Identifier of the box stored at this node */
-  struct SPNode **children;   /**< Array of @p nchild child pointers */
-  char centroid[];            /**< The bounding box of this node */
+  struct SPNode **children;   /**< Array of @p nchild child pointers, @p NULL
+                                   for a leaf bucket */
+  int count;                  /**< Number of boxes of a leaf bucket */
+  bool deleted;               /**< True for an inner node whose box was
+                                   deleted, which still partitions the space
+                                   for its children */
+  char centroid[];            /**< The bounding box of this node, or the
+                                   boxes of a leaf bucket */
 } SPNode;
 
+/**
+ * @brief Return true if a node of an SPTree is a leaf bucket
+ */
+#define SPNODE_IS_BUCKET(node) ((node)->children == NULL)
+
+/**
+ * @brief Return a pointer to the n-th box of a leaf bucket
+ */
+#define SPNODE_BOX_N(sptree, node, n) \
+  ((void *) ((node)->centroid + (size_t) (n) * (sptree)->boxsize))
+
+/**
+ * @brief Return a pointer to the array of the ids of a leaf bucket
+ * @details They follow the boxes, sized for @p bucketsize entries
+ */
+#define SPNODE_IDS(sptree, node) ((int64 *) ((char *) (node) + \
+  MAXALIGN(sizeof(SPNode) + (size_t) (sptree)->bucketsize * (sptree)->boxsize)))
+
+/**
+ * @brief Block of the arena from which the nodes of an SPTree are allocated
+ */
+typedef struct SPArenaBlock
+{
+  struct SPArenaBlock *next;  /**< Previously allocated block */
+  size_t size;                /**< Size of @p data */
+  size_t used;                /**< Number of bytes of @p data allocated */
+  char data[];                /**< Memory of the nodes */
+} SPArenaBlock;
+
 /**
  * @brief In-memory space-partitioning index (quad-tree or k-d tree)
- * @details Works on Span and TBox. Each node is a data box that partitions the
- * space; the family-specific geometry (quadrant assignment, child region, and
- * consistency tests) is provided through function pointers, reusing the same
- * routines as the SP-GiST operator classes.
+ * @details Works on Span, TBox, and STBox. Each node is a data box that
+ * partitions the space, or a leaf bucket of boxes when the tree has leaf
+ * buckets; the family-specific geometry (quadrant assignment, child region,
+ * and consistency tests) is provided through function pointers, reusing the
+ * same routines as the SP-GiST operator classes.
  */
 struct SPTree
 {
@@ -85,7 +134,17 @@ struct SPTree
                              the search prunes the subtrees holding the
                              matches. */
   SPTreeKind kind;      /**< Quad-tree or k-d tree */
+  int bucketsize;       /**< Capacity of the leaf buckets, 0 for a tree
+                             without leaf buckets */
   SPNode *root;         /**< Root node, or @p NULL when empty */
+  SPArenaBlock *arena;  /**< Arena holding the nodes of a tree in memory */
+  SPNode *freebuckets;  /**< Leaf buckets released by a split, linked through
+                             their first box, reused by the next ones */
+  SPNode *freenodes;    /**< Inner nodes released by a deletion, linked in
+                             the same way */
+  const char *base;     /**< Start of the file mapping of a tree opened by
+                             #sptree_open, @p NULL for a tree in memory */
+  size_t mapsize;       /**< Size of the file mapping */
   int (*box_dims)(const void *box);  /**< Dimensions of a box, or @p NULL when
                                           fixed at creation */
   void (*project)(const void *in, void *out);  /**< Project an incoming box
@@ -101,6 +160,8 @@ struct SPTree
     int level, void *next);
   bool (*inner_consistent)(const void *nodebox, const void *query,
     RTreeSearchOp op);
+  void (*nodebox_cover)(const void *nodebox, void *box);  /**< Smallest box
+                                          containing every box of a region */
   bool (*leaf_consistent)(const void *key, const void *query, RTreeSearchOp op);
 };
 
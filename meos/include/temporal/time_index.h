@@ -0,0 +1,74 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @brief Static in-memory index of time ranges
+ */
+
+#ifndef __TIME_INDEX_H__
+#define __TIME_INDEX_H__
+
+/* MEOS */
+#include <meos.h>
+
+/*****************************************************************************
+ * TimeIndex
+ *****************************************************************************/
+
+/**
+ * @brief Entry of a static index of time ranges
+ */
+typedef struct
+{
+  Span period;           /**< Time range of the entry */
+  TimestampTz maxupper;  /**< Latest upper bound of the entries of the subtree
+                              of the implicit tree rooted at the entry */
+  int64 id;              /**< Identifier of the time range */
+} TimeIndexEntry;
+
+/**
+ * @brief Static in-memory index of time ranges
+ * @details The entries are sorted by lower bound and the sorted array is read
+ * as an implicit binary search tree: the entries at the even positions are
+ * the leaves, and an entry at level `k` is at a position whose `k` lowest
+ * bits are set and whose bit `k` is unset, its children being `2^(k-1)`
+ * positions before and after it. Each entry keeps the latest upper bound of
+ * its subtree, so that a search prunes the subtrees ending before the query.
+ */
+struct TimeIndex
+{
+  int count;                 /**< Number of entries */
+  int height;                /**< Level of the root of the implicit tree, -1
+                                  for an empty index */
+  TimeIndexEntry *entries;   /**< Array of entries sorted by lower bound */
+};
+
+/*****************************************************************************/
+
+#endif /* __TIME_INDEX_H__ */
@@ -47,6 +47,13 @@
 extern void tinstant_set(TInstant *inst, Datum value, TimestampTz t);
 extern double tnumberinst_double(const TInstant *inst);
 
+/* Constructor functions */
+
+extern bool tinstant_make_valid(Datum value, MeosType temptype);
+extern size_t tinstant_make_size(Datum value, MeosType temptype);
+extern void tinstant_make_in_place(Datum value, MeosType temptype,
+  TimestampTz t, TInstant *result);
+
 /* Input/output functions */
 
 extern char *tinstant_to_string(const TInstant *inst, int maxdd,
@@ -43,6 +43,54 @@
 
 /*****************************************************************************/
 
+/**
+ * Structure to represent a read-only view of consecutive instants of a
+ * temporal sequence without copying them. The instants of the parent may be
+ * preceded and followed by an instant that does not belong to it, such as the
+ * ones obtained by interpolation when restricting the sequence to a time span.
+ */
+typedef struct
+{
+  const TSequence *seq; /**< Parent sequence */
+  TInstant *start;      /**< Instant before those of the parent, or NULL */
+  TInstant *end;        /**< Instant after those of the parent, or NULL */
+  int from;             /**< Index of the first instant of the parent */
+  int count;            /**< Total number of instants of the view */
+  Span period;          /**< Time span of the view */
+} TSequenceView;
+
+/**
+ * @brief Return the n-th instant of a temporal sequence view
+ * @pre The argument @p index is less than the number of instants in the view
+ */
+#define TSEQUENCEVIEW_INST_N(view, index) ( \
+  ((view)->start && (index) == 0) ? (const TInstant *) (view)->start : \
+  ((view)->end && (index) == (view)->count - 1) ? \
+    (const TInstant *) (view)->end : \
+  TSEQUENCE_INST_N((view)->seq, \
+    (view)->from + (index) - ((view)->start ? 1 : 0)) )
+
+/**
+ * Structure to construct a temporal sequence by appending its instants
+ * directly into the memory of the result, which is expanded when needed.
+ * The instants are normalized and the bounding box is expanded as they are
+ * appended.
+ */
+typedef struct
+{
+  TSequence *seq;       /**< Sequence being built, or NULL if empty */
+  MeosType temptype;    /**< Temporal type of the result */
+  interpType interp;    /**< Interpolation of the result */
+  bool normalize;       /**< True if the result is normalized */
+  int maxcount;         /**< Initial maximum number of instants */
+  size_t used;          /**< Number of bytes used by the instants */
+  bool hasbox;          /**< True if there are inner instants */
+  bool error;           /**< True if an error occurred */
+  bboxunion box;        /**< Bounding box of the inner instants */
+} TSequenceBuilder;
+
+/*****************************************************************************/
+
 /* Collinear function */
 
 extern bool float_collinear(double x1, double x2, double x3, double ratio);
@@ -143,9 +191,29 @@ extern TSequenceSet *tstepseq_to_linear(const TSequence *seq);
 extern int tsequence_segments_iter(const TSequence *seq, TSequence **result);
 extern int tsequence_timestamps_iter(const TSequence *seq, TimestampTz *times);
 
+/* View functions */
+
+extern void tsequenceview_set(const TSequence *seq, int from, int to,
+  bool lower_inc, bool upper_inc, TSequenceView *view);
+extern TSequence *tsequenceview_to_tsequence(const TSequenceView *view);
+extern void tsequenceview_free(TSequenceView *view);
+
+/* Builder functions */
+
+extern void tsequencebuilder_init(TSequenceBuilder *builder,
+  MeosType temptype, interpType interp, int maxcount, bool normalize);
+extern bool tsequencebuilder_append(TSequenceBuilder *builder, Datum value,
+  TimestampTz t);
+extern bool tsequencebuilder_repeat_prev_value(TSequenceBuilder *builder);
+extern const TInstant *tsequencebuilder_last(const TSequenceBuilder *builder);
+extern TSequence *tsequencebuilder_finish(TSequenceBuilder *builder,
+  bool lower_inc, bool upper_inc);
+extern void tsequencebuilder_free(TSequenceBuilder *builder);
+
 /* Local Aggregate Functions */
 
 extern double tnumberseq_cont_twavg(const TSequence *seq);
+extern double tnumberseqview_integral(const TSequenceView *view);
 
 /*****************************************************************************/
 
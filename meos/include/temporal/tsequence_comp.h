@@ -0,0 +1,111 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @brief Compressed encoding of temporal sequences
+ */
+
+#ifndef __TSEQUENCE_COMP_H__
+#define __TSEQUENCE_COMP_H__
+
+/* MEOS */
+#include <meos.h>
+
+/*****************************************************************************
+ * TSequenceComp
+ *****************************************************************************/
+
+/**
+ * @brief Number of instants of a block of a compressed temporal sequence
+ */
+#define TSEQUENCECOMP_BLOCK_SIZE 128
+
+/**
+ * @brief Maximum number of digits of the quantized values of a compressed
+ * temporal sequence
+ */
+#define TSEQUENCECOMP_MAX_PRECISION 15
+
+/**
+ * @brief Header of a block of a compressed temporal sequence
+ * @details A block is encoded independently of the others, starting with the
+ * uncompressed values of its first instant, so that it can be decoded
+ * without the previous blocks.
+ */
+typedef struct
+{
+  TimestampTz t;         /**< Timestamp of the first instant of the block */
+  int32 count;           /**< Number of instants of the block */
+  uint32 offset;         /**< Offset of the block in the encoded data */
+} TSequenceCompBlock;
+
+/**
+ * @brief Compressed temporal sequence
+ * @details The timestamps are encoded as deltas of deltas and the values,
+ * i.e., the floats or the coordinates of the points, either as the XOR of
+ * consecutive values, which is lossless, or as deltas of deltas of the
+ * values quantized to a number of decimal digits. Both are written as
+ * variable-length bit codes, which take a single bit for a regular sampling
+ * or a constant value. The instants are split into blocks of
+ * #TSEQUENCECOMP_BLOCK_SIZE instants whose headers follow the struct, then
+ * comes the encoded data of the blocks.
+ */
+struct TSequenceComp
+{
+  int32 vl_len_;        /**< Varlena header (do not touch directly!) */
+  uint8 temptype;       /**< Temporal type */
+  int8 precision;       /**< Number of decimal digits of the quantized
+                             values, -1 for lossless values */
+  int16 flags;          /**< Flags as those of a temporal sequence */
+  int32 count;          /**< Number of instants */
+  int32 nblocks;        /**< Number of blocks */
+  int32 srid;           /**< SRID of the points, if any */
+  int32 padding;        /**< Not used */
+  Span period;          /**< Time span of the sequence, which gives its
+                             bounds */
+  /* variable-length data follows */
+};
+
+/**
+ * @brief Return a pointer to the array of block headers of a compressed
+ * temporal sequence
+ */
+#define TSEQUENCECOMP_BLOCKS(cseq) ( (TSequenceCompBlock *)( \
+  ((char *) (cseq)) + sizeof(TSequenceComp) ) )
+
+/**
+ * @brief Return a pointer to the encoded data of a compressed temporal
+ * sequence
+ */
+#define TSEQUENCECOMP_DATA(cseq) ( (uint8 *)( \
+  TSEQUENCECOMP_BLOCKS(cseq) + (cseq)->nblocks ) )
+
+/*****************************************************************************/
+
+#endif /* __TSEQUENCE_COMP_H__ */
@@ -0,0 +1,989 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief In-memory grid index for spatiotemporal boxes
+ * @details For dense streams of points in a bounded area, e.g., the instants
+ * of temporal points, a fixed space-time grid is cheaper than a tree: a box is
+ * stored in the cells of the grid it covers, found by hashing their
+ * coordinates, so that an insertion or a deletion of a point costs a constant
+ * time and never restructures the index. The cells are the tiles of
+ * #stbox_get_space_time_tile for the same sizes and origins. A search visits
+ * the cells covered by the query, and the nearest-neighbour cursor visits the
+ * cells by rings of increasing distance around those of the query.
+ */
+
+#include "geo/stbox_grid.h"
+
+/* C */
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+/* PostgreSQL */
+#include <postgres.h>
+#include <utils/float.h>
+#include <utils/timestamp.h>
+/* MEOS */
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+#include <meos_internal_geo.h>
+#include "temporal/temporal.h"
+#include "temporal/temporal_tile.h"
+#include "geo/geo_funcs.h"
+#include "geo/stbox.h"
+
+/*****************************************************************************
+ * Cells
+ *****************************************************************************/
+
+/**
+ * @brief Return the coordinate of the cell of a value in a spatial dimension
+ */
+static inline int64
+stgrid_coord(double value, double size, double origin)
+{
+  return (int64) llround((float_get_bin(value, size, origin) - origin) / size);
+}
+
+/**
+ * @brief Return the coordinate of the cell of a timestamp
+ */
+static inline int64
+stgrid_tcoord(const STGrid *grid, TimestampTz t)
+{
+  return (timestamptz_bin_start(t, grid->tunits, grid->torigin) -
+    grid->torigin) / grid->tunits;
+}
+
+/**
+ * @brief Compute the range of the cells covered by a box
+ * @details A dimension missing from the box covers the extent of the grid
+ */
+static void
+stgrid_box_cells(const STGrid *grid, const STBox *box, int64 *lo, int64 *hi)
+{
+  memcpy(lo, grid->lo, sizeof(grid->lo));
+  memcpy(hi, grid->hi, sizeof(grid->hi));
+  if (MEOS_FLAGS_GET_X(box->flags))
+  {
+    lo[0] = stgrid_coord(box->xmin, grid->xsize, grid->xorigin);
+    hi[0] = stgrid_coord(box->xmax, grid->xsize, grid->xorigin);
+    lo[1] = stgrid_coord(box->ymin, grid->ysize, grid->yorigin);
+    hi[1] = stgrid_coord(box->ymax, grid->ysize, grid->yorigin);
+    if (MEOS_FLAGS_GET_Z(grid->flags))
+    {
+      lo[2] = stgrid_coord(box->zmin, grid->zsize, grid->zorigin);
+      hi[2] = stgrid_coord(box->zmax, grid->zsize, grid->zorigin);
+    }
+  }
+  if (grid->tunits && MEOS_FLAGS_GET_T(box->flags))
+  {
+    lo[3] = stgrid_tcoord(grid, DatumGetTimestampTz(box->period.lower));
+    hi[3] = stgrid_tcoord(grid, DatumGetTimestampTz(box->period.upper));
+  }
+  return;
+}
+
+/**
+ * @brief Return the hash of the coordinates of a cell
+ */
+static inline uint64
+stgrid_hash(const int64 *key)
+{
+  uint64 h = 0;
+  for (int d = 0; d < STGRID_DIMS; d++)
+  {
+    h ^= (uint64) key[d];
+    h *= UINT64CONST(0x9E3779B97F4A7C15);
+    h ^= h >> 32;
+  }
+  return h;
+}
+
+/**
+ * @brief Return the slot of a cell in the hash table, or -1 if the cell is
+ * empty
+ */
+static int
+stgrid_cell_find(const STGrid *grid, const int64 *key)
+{
+  if (! grid->cellcap)
+    return -1;
+  int mask = grid->cellcap - 1;
+  /* The table is at most half full, so the probe reaches an empty slot */
+  for (int i = (int) (stgrid_hash(key) & mask); ; i = (i + 1) & mask)
+  {
+    const STGridCell *cell = &grid->cells[i];
+    if (! cell->entries)
+      return -1;
+    if (memcmp(cell->key, key, sizeof(cell->key)) == 0)
+      return i;
+  }
+}
+
+/**
+ * @brief Resize the hash table of the cells
+ */
+static void
+stgrid_cells_resize(STGrid *grid, int cellcap)
+{
+  STGridCell *old = grid->cells;
+  int oldcap = grid->cellcap;
+  grid->cells = palloc0(sizeof(STGridCell) * cellcap);
+  grid->cellcap = cellcap;
+  int mask = cellcap - 1;
+  for (int i = 0; i < oldcap; i++)
+  {
+    if (! old[i].entries)
+      continue;
+    int j = (int) (stgrid_hash(old[i].key) & mask);
+    while (grid->cells[j].entries)
+      j = (j + 1) & mask;
+    grid->cells[j] = old[i];
+  }
+  if (old)
+    pfree(old);
+  return;
+}
+
+/**
+ * @brief Return a cell of the grid, adding it when it is empty
+ */
+static STGridCell *
+stgrid_cell_get(STGrid *grid, const int64 *key)
+{
+  int i = stgrid_cell_find(grid, key);
+  if (i >= 0)
+    return &grid->cells[i];
+  if ((grid->ncells + 1) * 2 > grid->cellcap)
+    stgrid_cells_resize(grid, grid->cellcap ? grid->cellcap * 2 : 64);
+  int mask = grid->cellcap - 1;
+  i = (int) (stgrid_hash(key) & mask);
+  while (grid->cells[i].entries)
+    i = (i + 1) & mask;
+  STGridCell *cell = &grid->cells[i];
+  memcpy(cell->key, key, sizeof(cell->key));
+  cell->count = 0;
+  cell->capacity = 4;
+  cell->entries = palloc(sizeof(int) * cell->capacity);
+  grid->ncells++;
+  return cell;
+}
+
+/**
+ * @brief Remove an empty cell from the hash table
+ * @details The cells that follow it in the probe sequence are shifted back so
+ * that the table needs no tombstones
+ */
+static void
+stgrid_cell_remove(STGrid *grid, int i)
+{
+  pfree(grid->cells[i].entries);
+  memset(&grid->cells[i], 0, sizeof(STGridCell));
+  grid->ncells--;
+  int mask = grid->cellcap - 1;
+  for (int j = (i + 1) & mask; grid->cells[j].entries; j = (j + 1) & mask)
+  {
+    int k = (int) (stgrid_hash(grid->cells[j].key) & mask);
+    /* A cell whose home slot is cyclically in (i, j] stays where it is */
+    if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+      continue;
+    grid->cells[i] = grid->cells[j];
+    memset(&grid->cells[j], 0, sizeof(STGridCell));
+    i = j;
+  }
+  return;
+}
+
+/**
+ * @brief Iterate over the cells of a range, the last coordinate varying
+ * fastest
+ * @return False when the range is exhausted
+ */
+static bool
+stgrid_range_next(const int64 *lo, const int64 *hi, int64 *key)
+{
+  for (int d = STGRID_DIMS - 1; d >= 0; d--)
+  {
+    if (key[d] < hi[d])
+    {
+      key[d]++;
+      return true;
+    }
+    key[d] = lo[d];
+  }
+  return false;
+}
+
+/*****************************************************************************
+ * Creation
+ *****************************************************************************/
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Return a new in-memory grid index for spatiotemporal boxes
+ * @details The cells of the grid are the tiles returned by
+ * #stbox_get_space_time_tile for the same arguments. The boxes stored in the
+ * grid must have the SRID and the dimensionality of the origin, and a time
+ * dimension when the grid has one.
+ * @param[in] xsize,ysize,zsize Size of the corresponding dimension
+ * @param[in] duration Size of the time dimension as an interval, may be
+ * `NULL` for a grid without time dimension
+ * @param[in] sorigin Origin for the space dimension
+ * @param[in] torigin Origin for the time dimension
+ * @return The grid, or `NULL` on error
+ */
+STGrid *
+stgrid_create(double xsize, double ysize, double zsize,
+  const Interval *duration, const GSERIALIZED *sorigin, TimestampTz torigin)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(sorigin, NULL);
+  if (! ensure_positive_datum(Float8GetDatum(xsize), T_FLOAT8) ||
+      ! ensure_positive_datum(Float8GetDatum(ysize), T_FLOAT8) ||
+      ! ensure_positive_datum(Float8GetDatum(zsize), T_FLOAT8) ||
+      ! ensure_not_empty(sorigin) || ! ensure_point_type(sorigin) ||
+      ! ensure_not_geodetic_geo(sorigin))
+    return NULL;
+  if (duration && ! ensure_positive_duration(duration))
+    return NULL;
+
+  STGrid *result = palloc0(sizeof(STGrid));
+  result->xsize = xsize;
+  result->ysize = ysize;
+  result->zsize = zsize;
+  result->tunits = duration ? interval_units(duration) : 0;
+  result->torigin = torigin;
+  result->srid = gserialized_get_srid(sorigin);
+  bool hasz = (bool) FLAGS_GET_Z(sorigin->gflags);
+  MEOS_FLAGS_SET_X(result->flags, true);
+  MEOS_FLAGS_SET_Z(result->flags, hasz);
+  MEOS_FLAGS_SET_T(result->flags, duration != NULL);
+  if (hasz)
+  {
+    const POINT3DZ *p = GSERIALIZED_POINT3DZ_P(sorigin);
+    result->xorigin = p->x;
+    result->yorigin = p->y;
+    result->zorigin = p->z;
+  }
+  else
+  {
+    const POINT2D *p = GSERIALIZED_POINT2D_P(sorigin);
+    result->xorigin = p->x;
+    result->yorigin = p->y;
+  }
+  return result;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Free an in-memory grid index
+ * @param[in] grid The grid to free
+ */
+void
+stgrid_free(STGrid *grid)
+{
+  if (! grid)
+    return;
+  for (int i = 0; i < grid->cellcap; i++)
+  {
+    if (grid->cells[i].entries)
+      pfree(grid->cells[i].entries);
+  }
+  if (grid->cells)
+    pfree(grid->cells);
+  if (grid->entries)
+    pfree(grid->entries);
+  pfree(grid);
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Return the number of entries of an in-memory grid index
+ * @param[in] grid The grid
+ */
+int
+stgrid_count(const STGrid *grid)
+{
+  return grid->count;
+}
+
+/*****************************************************************************
+ * Insertion and deletion
+ *****************************************************************************/
+
+/**
+ * @brief Ensure that a box can be compared with the boxes of a grid
+ * @param[in] grid The grid
+ * @param[in] box The box
+ * @param[in] stored True for a box to store, which must have every dimension
+ * of the grid
+ */
+static bool
+ensure_valid_stgrid_stbox(const STGrid *grid, const STBox *box, bool stored)
+{
+  if (stored && (! ensure_has_X(T_STBOX, box->flags) ||
+      (grid->tunits && ! ensure_has_T(T_STBOX, box->flags))))
+    return false;
+  if (MEOS_FLAGS_GET_X(box->flags) && (! ensure_not_geodetic(box->flags) ||
+      ! ensure_same_srid(grid->srid, box->srid) ||
+      ! ensure_same_spatial_dimensionality(grid->flags, box->flags)))
+    return false;
+  return true;
+}
+
+/**
+ * @brief Add an entry to a cell of the grid
+ */
+static void
+stgrid_cell_add(STGrid *grid, const int64 *key, int entry)
+{
+  STGridCell *cell = stgrid_cell_get(grid, key);
+  if (cell->count == cell->capacity)
+  {
+    cell->capacity *= 2;
+    cell->entries = repalloc(cell->entries, sizeof(int) * cell->capacity);
+  }
+  cell->entries[cell->count++] = entry;
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Insert a spatiotemporal box into an in-memory grid index
+ * @details The box is stored in every cell it covers, so that the insertion
+ * of a point costs a constant time.
+ * @param[in] grid The grid
+ * @param[in] box The box to insert
+ * @param[in] id The id associated with the box
+ * @return False on error, e.g., when the box covers more than
+ * #STGRID_MAX_BOX_CELLS cells
+ */
+bool
+stgrid_insert(STGrid *grid, const STBox *box, int64 id)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(grid, false); VALIDATE_NOT_NULL(box, false);
+  if (! ensure_valid_stgrid_stbox(grid, box, true))
+    return false;
+
+  int64 lo[STGRID_DIMS], hi[STGRID_DIMS];
+  stgrid_box_cells(grid, box, lo, hi);
+  double ncells = 1.0;
+  for (int d = 0; d < STGRID_DIMS; d++)
+    ncells *= (double) (hi[d] - lo[d] + 1);
+  if (ncells > STGRID_MAX_BOX_CELLS)
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "The box covers too many cells of the grid");
+    return false;
+  }
+
+  if (grid->count == grid->capacity)
+  {
+    grid->capacity = grid->capacity ? grid->capacity * 2 : 64;
+    grid->entries = grid->entries ?
+      repalloc(grid->entries, sizeof(STGridEntry) * grid->capacity) :
+      palloc(sizeof(STGridEntry) * grid->capacity);
+  }
+  int n = grid->count++;
+  STGridEntry *entry = &grid->entries[n];
+  memcpy(&entry->box, box, sizeof(STBox));
+  entry->id = id;
+  memcpy(entry->lo, lo, sizeof(lo));
+  memcpy(entry->hi, hi, sizeof(hi));
+
+  /* Extend the extent of the grid */
+  for (int d = 0; d < STGRID_DIMS; d++)
+  {
+    if (n == 0 || lo[d] < grid->lo[d])
+      grid->lo[d] = lo[d];
+    if (n == 0 || hi[d] > grid->hi[d])
+      grid->hi[d] = hi[d];
+  }
+
+  int64 key[STGRID_DIMS];
+  memcpy(key, lo, sizeof(key));
+  do
+    stgrid_cell_add(grid, key, n);
+  while (stgrid_range_next(lo, hi, key));
+  return true;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Insert a temporal value into an in-memory grid index using its
+ * bounding box
+ * @param[in] grid The grid
+ * @param[in] temp The temporal value
+ * @param[in] id The id associated with the value
+ * @return False on error
+ */
+bool
+stgrid_insert_temporal(STGrid *grid, const Temporal *temp, int64 id)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(grid, false);
+  if (! ensure_bbox_temporal_compatible(T_STBOX, temp))
+    return false;
+  STBox box;
+  temporal_set_bbox(temp, &box);
+  return stgrid_insert(grid, &box, id);
+}
+
+/**
+ * @brief Replace an entry by another one in the cells of the latter
+ * @param[in] grid The grid
+ * @param[in] from The position of the entry to replace
+ * @param[in] to The new position, or -1 to remove the entry from its cells
+ */
+static void
+stgrid_cells_replace(STGrid *grid, int from, int to)
+{
+  const STGridEntry *entry = &grid->entries[from];
+  int64 key[STGRID_DIMS];
+  memcpy(key, entry->lo, sizeof(key));
+  do
+  {
+    int i = stgrid_cell_find(grid, key);
+    assert(i >= 0);
+    STGridCell *cell = &grid->cells[i];
+    for (int j = 0; j < cell->count; j++)
+    {
+      if (cell->entries[j] != from)
+        continue;
+      if (to >= 0)
+        cell->entries[j] = to;
+      else
+        cell->entries[j] = cell->entries[--cell->count];
+      break;
+    }
+    if (cell->count == 0)
+      stgrid_cell_remove(grid, i);
+  } while (stgrid_range_next(entry->lo, entry->hi, key));
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Delete an entry from an in-memory grid index
+ * @details The entry is identified by its id together with its box, which is
+ * looked up in the first cell it covers. The last entry of the grid takes its
+ * place.
+ * @param[in] grid The grid
+ * @param[in] box The box with which the entry was inserted
+ * @param[in] id The id of the entry
+ * @return True if the entry was found and deleted, false otherwise
+ */
+bool
+stgrid_delete(STGrid *grid, const STBox *box, int64 id)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(grid, false); VALIDATE_NOT_NULL(box, false);
+  if (! grid->count || ! ensure_valid_stgrid_stbox(grid, box, true))
+    return false;
+
+  int64 lo[STGRID_DIMS], hi[STGRID_DIMS];
+  stgrid_box_cells(grid, box, lo, hi);
+  int i = stgrid_cell_find(grid, lo);
+  if (i < 0)
+    return false;
+  const STGridCell *cell = &grid->cells[i];
+  int n = -1;
+  for (int j = 0; j < cell->count; j++)
+  {
+    const STGridEntry *entry = &grid->entries[cell->entries[j]];
+    if (entry->id == id && same_stbox_stbox(&entry->box, box))
+    {
+      n = cell->entries[j];
+      break;
+    }
+  }
+  if (n < 0)
+    return false;
+
+  stgrid_cells_replace(grid, n, -1);
+  int last = --grid->count;
+  if (n < last)
+  {
+    stgrid_cells_replace(grid, last, n);
+    grid->entries[n] = grid->entries[last];
+  }
+  return true;
+}
+
+/*****************************************************************************
+ * Search
+ *****************************************************************************/
+
+/**
+ * @brief Return true if a stored box satisfies a search
+ */
+static bool
+stgrid_leaf_consistent(const STBox *key, const STBox *query, RTreeSearchOp op)
+{
+  if (op == RTREE_CONTAINS)
+    return contains_stbox_stbox(key, query);
+  if (op == RTREE_CONTAINED_BY)
+    return contains_stbox_stbox(query, key);
+  return overlaps_stbox_stbox(key, query);
+}
+
+/**
+ * @brief Collect the entries of a cell satisfying a search
+ * @details An entry covering several cells of the range is collected only in
+ * the first of them, i.e., the cell whose coordinates are the largest of the
+ * first cell of the entry and the first cell of the range
+ */
+static void
+stgrid_cell_search(const STGrid *grid, const STGridCell *cell,
+  const int64 *lo, RTreeSearchOp op, const STBox *query, MeosArray *result)
+{
+  for (int j = 0; j < cell->count; j++)
+  {
+    const STGridEntry *entry = &grid->entries[cell->entries[j]];
+    bool first = true;
+    for (int d = 0; d < STGRID_DIMS && first; d++)
+      first = (Max(entry->lo[d], lo[d]) == cell->key[d]);
+    if (first && stgrid_leaf_consistent(&entry->box, query, op))
+      meos_array_add(result, (void *) &entry->id);
+  }
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Search an in-memory grid index with a spatiotemporal box, collecting
+ * matching ids into a MeosArray
+ * @details Only the cells covered by the query are visited, or the cells in
+ * use when they are fewer. A dimension missing from the query covers the
+ * extent of the grid. The result array is reset before the search.
+ * @param[in] grid The grid to query
+ * @param[in] op The search operation, as for #rtree_search
+ * @param[in] query The box that serves as query
+ * @param[out] result MeosArray of int to collect matching ids
+ * @return Number of matching ids, -1 on error
+ */
+int
+stgrid_search(const STGrid *grid, RTreeSearchOp op, const STBox *query,
+  MeosArray *result)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(grid, -1); VALIDATE_NOT_NULL(query, -1);
+  VALIDATE_NOT_NULL(result, -1);
+  meos_array_reset(result);
+  if (! ensure_valid_stgrid_stbox(grid, query, false))
+    return -1;
+  if (! grid->count)
+    return 0;
+
+  /* Restrict the cells of the query to the extent of the grid */
+  int64 lo[STGRID_DIMS], hi[STGRID_DIMS];
+  stgrid_box_cells(grid, query, lo, hi);
+  double ncells = 1.0;
+  for (int d = 0; d < STGRID_DIMS; d++)
+  {
+    lo[d] = Max(lo[d], grid->lo[d]);
+    hi[d] = Min(hi[d], grid->hi[d]);
+    if (lo[d] > hi[d])
+      return 0;
+    ncells *= (double) (hi[d] - lo[d] + 1);
+  }
+
+  if (ncells > grid->ncells)
+  {
+    /* Scan the cells in use instead of probing more cells than there are */
+    for (int i = 0; i < grid->cellcap; i++)
+    {
+      const STGridCell *cell = &grid->cells[i];
+      if (! cell->entries)
+        continue;
+      bool inside = true;
+      for (int d = 0; d < STGRID_DIMS && inside; d++)
+        inside = (cell->key[d] >= lo[d] && cell->key[d] <= hi[d]);
+      if (inside)
+        stgrid_cell_search(grid, cell, lo, op, query, result);
+    }
+  }
+  else
+  {
+    int64 key[STGRID_DIMS];
+    memcpy(key, lo, sizeof(key));
+    do
+    {
+      int i = stgrid_cell_find(grid, key);
+      if (i >= 0)
+        stgrid_cell_search(grid, &grid->cells[i], lo, op, query, result);
+    } while (stgrid_range_next(lo, hi, key));
+  }
+  return meos_array_count(result);
+}
+
+/*****************************************************************************
+ * Nearest-neighbour cursor
+ *
+ * The cells are visited by rings around the cells covered by the query: ring
+ * r holds the cells at a Chebyshev distance r from them in the spatial
+ * dimensions. A box at distance d from the query has its nearest point in a
+ * cell of ring at most d / s + 1, where s is the smallest size of the tiles,
+ * so once the ring r is visited, every box nearer than r * s has been seen
+ * and the candidates up to that distance are produced from a priority queue.
+ * The distance is the one of #nad_stbox_stbox, as for #rtree_nn_cursor_open,
+ * and the boxes at an infinite distance, i.e., whose time extent is disjoint
+ * from the one of the query, are produced last.
+ *****************************************************************************/
+
+/**
+ * @brief Candidate of the nearest-neighbour cursor
+ */
+typedef struct
+{
+  double dist;    /**< Distance from the query to the box */
+  int64 id;       /**< Identifier of the box */
+} STGridNNEntry;
+
+/**
+ * @brief Incremental nearest-neighbour cursor over a grid
+ */
+struct STGridNNCursor
+{
+  const STGrid *grid;       /**< Indexed grid (borrowed, not owned) */
+  STBox query;              /**< Private copy of the query box */
+  int64 lo[STGRID_DIMS];    /**< First cell of the query, the time dimension
+                                 being restricted to the extent of the grid */
+  int64 hi[STGRID_DIMS];    /**< Last cell of the query */
+  double cellsize;          /**< Smallest size of the tiles */
+  int ring;                 /**< Next ring to visit */
+  double bound;             /**< Distance below which every box was seen */
+  bool rings_done;          /**< True when the rings cover the grid */
+  bool swept;               /**< True when the infinite distances were added */
+  STGridNNEntry *heap;      /**< Binary min-heap keyed by distance */
+  int count;                /**< Number of entries in the heap */
+  int capacity;             /**< Allocated capacity of the heap */
+};
+
+/**
+ * @brief Push a candidate onto the heap of a cursor, growing it if needed
+ */
+static void
+stgrid_nn_heap_push(STGridNNCursor *cursor, double dist, int64 id)
+{
+  if (cursor->count == cursor->capacity)
+  {
+    cursor->capacity *= 2;
+    cursor->heap = repalloc(cursor->heap,
+      sizeof(STGridNNEntry) * cursor->capacity);
+  }
+  int i = cursor->count++;
+  while (i > 0)
+  {
+    int parent = (i - 1) / 2;
+    if (cursor->heap[parent].dist <= dist)
+      break;
+    cursor->heap[i] = cursor->heap[parent];
+    i = parent;
+  }
+  cursor->heap[i].dist = dist;
+  cursor->heap[i].id = id;
+  return;
+}
+
+/**
+ * @brief Pop the nearest candidate from the heap of a cursor
+ */
+static STGridNNEntry
+stgrid_nn_heap_pop(STGridNNCursor *cursor)
+{
+  STGridNNEntry result = cursor->heap[0];
+  STGridNNEntry last = cursor->heap[--cursor->count];
+  int i = 0;
+  while (true)
+  {
+    int child = 2 * i + 1;
+    if (child >= cursor->count)
+      break;
+    if (child + 1 < cursor->count &&
+        cursor->heap[child + 1].dist < cursor->heap[child].dist)
+      child++;
+    if (last.dist <= cursor->heap[child].dist)
+      break;
+    cursor->heap[i] = cursor->heap[child];
+    i = child;
+  }
+  if (cursor->count > 0)
+    cursor->heap[i] = last;
+  return result;
+}
+
+/**
+ * @brief Add the candidates of a cell of a ring
+ * @details An entry covering several cells is added only from the one of its
+ * cells nearest to the cells of the query
+ */
+static void
+stgrid_nn_cell(STGridNNCursor *cursor, const STGridCell *cell)
+{
+  const STGrid *grid = cursor->grid;
+  for (int j = 0; j < cell->count; j++)
+  {
+    const STGridEntry *entry = &grid->entries[cell->entries[j]];
+    bool first = true;
+    for (int d = 0; d < STGRID_DIMS && first; d++)
+    {
+      int64 c = entry->hi[d] < cursor->lo[d] ? entry->hi[d] :
+        Max(entry->lo[d], cursor->lo[d]);
+      first = (c == cell->key[d]);
+    }
+    if (! first)
+      continue;
+    double dist = nad_stbox_stbox(&cursor->query, &entry->box);
+    if (dist < DBL_MAX)
+      stgrid_nn_heap_push(cursor, dist, entry->id);
+  }
+  return;
+}
+
+/**
+ * @brief Add the candidates of a column of cells of a ring, i.e., of every
+ * time cell of the query at given spatial coordinates
+ */
+static void
+stgrid_nn_visit(STGridNNCursor *cursor, int64 x, int64 y, int64 z)
+{
+  const STGrid *grid = cursor->grid;
+  int64 key[STGRID_DIMS] = {x, y, z, 0};
+  for (key[3] = cursor->lo[3]; key[3] <= cursor->hi[3]; key[3]++)
+  {
+    int i = stgrid_cell_find(grid, key);
+    if (i >= 0)
+      stgrid_nn_cell(cursor, &grid->cells[i]);
+  }
+  return;
+}
+
+/**
+ * @brief Add the candidates of the cells in use from a ring on, which ends
+ * the visit of the rings
+ * @details The cells of the rings visited so far are skipped, as well as
+ * those outside the time cells of the query
+ */
+static void
+stgrid_nn_sweep(STGridNNCursor *cursor)
+{
+  const STGrid *grid = cursor->grid;
+  for (int i = 0; i < grid->cellcap; i++)
+  {
+    const STGridCell *cell = &grid->cells[i];
+    if (! cell->entries || cell->key[3] < cursor->lo[3] ||
+        cell->key[3] > cursor->hi[3])
+      continue;
+    /* Ring of the cell, i.e., its Chebyshev distance to the query cells */
+    int64 ring = 0;
+    for (int d = 0; d < 3; d++)
+    {
+      if (cell->key[d] < cursor->lo[d])
+        ring = Max(ring, cursor->lo[d] - cell->key[d]);
+      else if (cell->key[d] > cursor->hi[d])
+        ring = Max(ring, cell->key[d] - cursor->hi[d]);
+    }
+    if (ring >= cursor->ring)
+      stgrid_nn_cell(cursor, cell);
+  }
+  cursor->rings_done = true;
+  return;
+}
+
+/**
+ * @brief Visit the next ring of cells of a cursor
+ * @details When the ring spans more cells than those in use, as happens for
+ * sparse data, or when it is outside the extent of the grid, as happens for a
+ * query far from the data, the cells in use are scanned instead of probing
+ * every cell of the ring and of the following ones
+ */
+static void
+stgrid_nn_ring(STGridNNCursor *cursor)
+{
+  const STGrid *grid = cursor->grid;
+  int64 r = cursor->ring;
+  int64 elo[3], ehi[3], clo[3], chi[3];
+  bool done = true, outside = false;
+  double ncells = (double) (cursor->hi[3] - cursor->lo[3] + 1);
+  for (int d = 0; d < 3; d++)
+  {
+    elo[d] = cursor->lo[d] - r;
+    ehi[d] = cursor->hi[d] + r;
+    clo[d] = Max(elo[d], grid->lo[d]);
+    chi[d] = Min(ehi[d], grid->hi[d]);
+    done &= (elo[d] <= grid->lo[d] && ehi[d] >= grid->hi[d]);
+    outside |= (clo[d] > chi[d]);
+    ncells *= (double) (chi[d] - clo[d] + 1);
+  }
+  /* A ring outside the extent of the grid would be followed by as many empty
+   * rings as there are cells between the query and the grid */
+  if (outside || ncells > grid->ncells)
+  {
+    stgrid_nn_sweep(cursor);
+    return;
+  }
+  bool hasz = MEOS_FLAGS_GET_Z(grid->flags);
+  for (int64 x = clo[0]; x <= chi[0]; x++)
+  {
+    bool xshell = (r == 0 || x == elo[0] || x == ehi[0]);
+    for (int64 y = clo[1]; y <= chi[1]; y++)
+    {
+      bool yshell = xshell || y == elo[1] || y == ehi[1];
+      if (! hasz)
+      {
+        if (yshell)
+          stgrid_nn_visit(cursor, x, y, 0);
+        else if (y < ehi[1] - 1)
+          /* Jump over the inside of the ring */
+          y = ehi[1] - 1;
+        continue;
+      }
+      for (int64 z = clo[2]; z <= chi[2]; z++)
+      {
+        if (yshell || z == elo[2] || z == ehi[2])
+          stgrid_nn_visit(cursor, x, y, z);
+        else if (z < ehi[2] - 1)
+          z = ehi[2] - 1;
+      }
+    }
+  }
+  cursor->bound = (double) r * cursor->cellsize;
+  cursor->ring++;
+  cursor->rings_done = done;
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Open a nearest-neighbour cursor over an in-memory grid index
+ * @details The cursor produces the ids by increasing distance to the query,
+ * as #rtree_nn_cursor_open. It borrows the grid, which must not be modified
+ * while the cursor is open.
+ * @param[in] grid The grid to query
+ * @param[in] query The box that serves as query, which must have a spatial
+ * dimension
+ * @return The cursor, to be closed with #stgrid_nn_cursor_close, or `NULL` on
+ * error
+ */
+STGridNNCursor *
+stgrid_nn_cursor_open(const STGrid *grid, const STBox *query)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(grid, NULL); VALIDATE_NOT_NULL(query, NULL);
+  if (! ensure_has_X(T_STBOX, query->flags) ||
+      ! ensure_valid_stgrid_stbox(grid, query, false))
+    return NULL;
+
+  STGridNNCursor *cursor = palloc0(sizeof(STGridNNCursor));
+  cursor->grid = grid;
+  memcpy(&cursor->query, query, sizeof(STBox));
+  stgrid_box_cells(grid, query, cursor->lo, cursor->hi);
+  /* Only the time cells of the query can hold boxes at a finite distance */
+  cursor->lo[3] = Max(cursor->lo[3], grid->lo[3]);
+  cursor->hi[3] = Min(cursor->hi[3], grid->hi[3]);
+  cursor->cellsize = Min(grid->xsize, grid->ysize);
+  if (MEOS_FLAGS_GET_Z(grid->flags))
+    cursor->cellsize = Min(cursor->cellsize, grid->zsize);
+  /* No box is at a finite distance when the query is outside the time extent
+   * of the grid */
+  cursor->rings_done = (grid->count == 0 || cursor->lo[3] > cursor->hi[3]);
+  cursor->swept = (grid->count == 0);
+  cursor->capacity = 64;
+  cursor->heap = palloc(sizeof(STGridNNEntry) * cursor->capacity);
+  return cursor;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Advance a nearest-neighbour cursor to the next closest id
+ * @details An id whose box has no valid distance to the query, i.e., whose
+ * time extent is disjoint from the one of the query, is reported last with an
+ * infinite distance.
+ * @param[in] cursor The cursor previously opened with #stgrid_nn_cursor_open
+ * @param[out] id_out Receives the id of the next neighbour, or @p NULL
+ * @param[out] dist_out Receives the distance of the next neighbour, or @p NULL
+ * @return @p true if a neighbour was produced, @p false once exhausted
+ */
+bool
+stgrid_nn_cursor_next(STGridNNCursor *cursor, int64 *id_out, double *dist_out)
+{
+  assert(cursor);
+  while (true)
+  {
+    if (cursor->count > 0 &&
+        (cursor->rings_done || cursor->heap[0].dist <= cursor->bound))
+    {
+      STGridNNEntry entry = stgrid_nn_heap_pop(cursor);
+      if (id_out)
+        *id_out = entry.id;
+      if (dist_out)
+        *dist_out = entry.dist;
+      return true;
+    }
+    if (! cursor->rings_done)
+      stgrid_nn_ring(cursor);
+    else if (! cursor->swept)
+    {
+      /* The boxes at an infinite distance come after all the others */
+      const STGrid *grid = cursor->grid;
+      for (int i = 0; i < grid->count; i++)
+      {
+        if (nad_stbox_stbox(&cursor->query, &grid->entries[i].box) == DBL_MAX)
+          stgrid_nn_heap_push(cursor, get_float8_infinity(),
+            grid->entries[i].id);
+      }
+      cursor->swept = true;
+    }
+    else
+      return false;
+  }
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Close a nearest-neighbour cursor and free its resources
+ * @param[in] cursor The cursor to close; @p NULL is ignored
+ */
+void
+stgrid_nn_cursor_close(STGridNNCursor *cursor)
+{
+  if (! cursor)
+    return;
+  pfree(cursor->heap);
+  pfree(cursor);
+  return;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,598 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief Packed encoding of temporal point sequences
+ * @details A temporal point sequence stores every instant as a serialized
+ * instant with its own header, timestamp, and serialized point, reached
+ * through the array of offsets of the sequence. The packed encoding keeps
+ * instead the timestamps and the coordinates in contiguous arrays after a
+ * single header giving the SRID and the flags, which takes about a third of
+ * the bytes and allows the functions below to scan the instants without
+ * following pointers. The conversion from and to temporal sequences is
+ * lossless. The functions on geodetic coordinates whose result depends on the
+ * spheroid, i.e., the length, the speed, and the distance, are computed on
+ * the corresponding temporal sequence.
+ */
+
+#include "geo/tpoint_packed.h"
+
+/* C */
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+/* PostgreSQL */
+#include <postgres.h>
+#include <varatt.h>
+#include <utils/timestamp.h>
+/* PostGIS */
+#include <liblwgeom.h>
+/* MEOS */
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+#include <meos_internal_geo.h>
+#include "temporal/span.h"
+#include "temporal/temporal.h"
+#include "geo/geo_funcs.h"
+#include "geo/tgeo_spatialfuncs.h"
+
+#include <pgtypes.h>
+
+/*****************************************************************************
+ * Constructor functions
+ *****************************************************************************/
+
+/**
+ * @brief Return a packed temporal point sequence whose arrays are to be
+ * filled by the caller
+ */
+static TPointSeqPacked *
+tpointseq_packed_alloc(int count, int16 flags, int32_t srid, MeosType temptype,
+  TimestampTz lower, TimestampTz upper, bool lower_inc, bool upper_inc)
+{
+  int ndims = MEOS_FLAGS_GET_Z(flags) ? 3 : 2;
+  size_t size = sizeof(TPointSeqPacked) +
+    (sizeof(TimestampTz) + sizeof(double) * ndims) * count;
+  TPointSeqPacked *result = palloc0(size);
+  SET_VARSIZE(result, size);
+  result->temptype = (uint8) temptype;
+  result->flags = flags;
+  result->count = count;
+  result->srid = srid;
+  span_set(TimestampTzGetDatum(lower), TimestampTzGetDatum(upper), lower_inc,
+    upper_inc, T_TIMESTAMPTZ, T_TSTZSPAN, &result->period);
+  return result;
+}
+
+/**
+ * @ingroup meos_geo_constructor
+ * @brief Return a packed temporal point sequence from arrays of coordinates,
+ * one per dimension, and timestamps
+ * @param[in] xcoords Array of x coordinates
+ * @param[in] ycoords Array of y coordinates
+ * @param[in] zcoords Array of z coordinates, may be @p NULL
+ * @param[in] times Array of timestamps
+ * @param[in] count Number of elements in the arrays
+ * @param[in] srid SRID of the spatial coordinates
+ * @param[in] geodetic True for tgeogpoint, false for tgeompoint
+ * @param[in] lower_inc,upper_inc True if the respective bound is inclusive
+ * @param[in] interp Interpolation
+ * @return On error return @p NULL
+ * @note The arguments are those of #tpointseq_make_coords, but the sequence
+ * is not normalized
+ */
+TPointSeqPacked *
+tpointseq_packed_make(const double *xcoords, const double *ycoords,
+  const double *zcoords, const TimestampTz *times, int count, int32_t srid,
+  bool geodetic, bool lower_inc, bool upper_inc, interpType interp)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(xcoords, NULL); VALIDATE_NOT_NULL(ycoords, NULL);
+  VALIDATE_NOT_NULL(times, NULL);
+  MeosType temptype = geodetic ? T_TGEOGPOINT : T_TGEOMPOINT;
+  if (! ensure_positive(count) || ! ensure_valid_interp(temptype, interp))
+    return NULL;
+  if (count == 1 && (! lower_inc || ! upper_inc))
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "Instant sequence must have inclusive bounds");
+    return NULL;
+  }
+  bool hasz = (zcoords != NULL);
+  if (interp == STEP && count > 1 && ! upper_inc &&
+    (xcoords[count - 1] != xcoords[count - 2] ||
+     ycoords[count - 1] != ycoords[count - 2] ||
+     (hasz && zcoords[count - 1] != zcoords[count - 2])))
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "Invalid end value for temporal sequence with step interpolation");
+    return NULL;
+  }
+  for (int i = 1; i < count; i++)
+  {
+    if (times[i - 1] >= times[i])
+    {
+      char *t1 = pg_timestamptz_out(times[i - 1]);
+      char *t2 = pg_timestamptz_out(times[i]);
+      meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+        "Timestamps for temporal value must be increasing: %s, %s", t1, t2);
+      return NULL;
+    }
+  }
+
+  int16 flags = 0;
+  MEOS_FLAGS_SET_CONTINUOUS(flags, true);
+  MEOS_FLAGS_SET_INTERP(flags, interp);
+  MEOS_FLAGS_SET_X(flags, true);
+  MEOS_FLAGS_SET_Z(flags, hasz);
+  MEOS_FLAGS_SET_T(flags, true);
+  MEOS_FLAGS_SET_GEODETIC(flags, geodetic);
+  TPointSeqPacked *result = tpointseq_packed_alloc(count, flags, srid,
+    temptype, times[0], times[count - 1], lower_inc, upper_inc);
+  memcpy(TPOINTSEQ_PACKED_TIMES(result), times, sizeof(TimestampTz) * count);
+  memcpy(TPOINTSEQ_PACKED_X(result), xcoords, sizeof(double) * count);
+  memcpy(TPOINTSEQ_PACKED_Y(result), ycoords, sizeof(double) * count);
+  if (hasz)
+    memcpy(TPOINTSEQ_PACKED_Z(result), zcoords, sizeof(double) * count);
+  return result;
+}
+
+/*****************************************************************************
+ * Conversion functions
+ *****************************************************************************/
+
+/**
+ * @ingroup meos_geo_conversion
+ * @brief Return a temporal point sequence converted to the packed encoding
+ * @param[in] seq Temporal point sequence
+ * @return On error return @p NULL
+ * @see #tpointseq_from_packed
+ */
+TPointSeqPacked *
+tpointseq_to_packed(const TSequence *seq)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(seq, NULL);
+  if (! ensure_tpoint_type(seq->temptype) ||
+      ! ensure_temporal_isof_subtype((Temporal *) seq, TSEQUENCE))
+    return NULL;
+
+  TPointSeqPacked *result = tpointseq_packed_alloc(seq->count, seq->flags,
+    tspatial_srid((Temporal *) seq), seq->temptype, seq->period.lower,
+    seq->period.upper, seq->period.lower_inc, seq->period.upper_inc);
+  TimestampTz *times = TPOINTSEQ_PACKED_TIMES(result);
+  double *x = TPOINTSEQ_PACKED_X(result);
+  double *y = TPOINTSEQ_PACKED_Y(result);
+  bool hasz = MEOS_FLAGS_GET_Z(seq->flags);
+  double *z = hasz ? TPOINTSEQ_PACKED_Z(result) : NULL;
+  for (int i = 0; i < seq->count; i++)
+  {
+    const TInstant *inst = TSEQUENCE_INST_N(seq, i);
+    Datum value = tinstant_value_p(inst);
+    times[i] = inst->t;
+    if (hasz)
+    {
+      const POINT3DZ *p = DATUM_POINT3DZ_P(value);
+      x[i] = p->x; y[i] = p->y; z[i] = p->z;
+    }
+    else
+    {
+      const POINT2D *p = DATUM_POINT2D_P(value);
+      x[i] = p->x; y[i] = p->y;
+    }
+  }
+  return result;
+}
+
+/**
+ * @ingroup meos_geo_conversion
+ * @brief Return a packed temporal point sequence converted to a temporal
+ * sequence
+ * @param[in] pseq Packed temporal point sequence
+ * @return On error return @p NULL
+ * @see #tpointseq_to_packed
+ */
+TSequence *
+tpointseq_from_packed(const TPointSeqPacked *pseq)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(pseq, NULL);
+  return tpointseq_make_coords(TPOINTSEQ_PACKED_X(pseq),
+    TPOINTSEQ_PACKED_Y(pseq),
+    MEOS_FLAGS_GET_Z(pseq->flags) ? TPOINTSEQ_PACKED_Z(pseq) : NULL,
+    TPOINTSEQ_PACKED_TIMES(pseq), pseq->count, pseq->srid,
+    MEOS_FLAGS_GET_GEODETIC(pseq->flags), pseq->period.lower_inc,
+    pseq->period.upper_inc, MEOS_FLAGS_GET_INTERP(pseq->flags), NORMALIZE_NO);
+}
+
+/*****************************************************************************
+ * Accessor functions
+ *****************************************************************************/
+
+/**
+ * @brief Return the n-th point of a packed temporal point sequence
+ * @pre The argument @p n is less than the number of instants (0-based)
+ */
+static GSERIALIZED *
+tpointseq_packed_point_n(const TPointSeqPacked *pseq, int n)
+{
+  bool hasz = MEOS_FLAGS_GET_Z(pseq->flags);
+  return geopoint_make(TPOINTSEQ_PACKED_X(pseq)[n],
+    TPOINTSEQ_PACKED_Y(pseq)[n], hasz ? TPOINTSEQ_PACKED_Z(pseq)[n] : 0.0,
+    hasz, MEOS_FLAGS_GET_GEODETIC(pseq->flags), pseq->srid);
+}
+
+/**
+ * @ingroup meos_geo_accessor
+ * @brief Return the number of instants of a packed temporal point sequence
+ * @param[in] pseq Packed temporal point sequence
+ * @return On error return -1
+ */
+int
+tpointseq_packed_num_instants(const TPointSeqPacked *pseq)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(pseq, -1);
+  return pseq->count;
+}
+
+/**
+ * @ingroup meos_geo_accessor
+ * @brief Return the size in bytes of a packed temporal point sequence
+ * @param[in] pseq Packed temporal point sequence
+ * @return On error return 0
+ * @see #temporal_mem_size
+ */
+size_t
+tpointseq_packed_mem_size(const TPointSeqPacked *pseq)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(pseq, 0);
+  return VARSIZE(pseq);
+}
+
+/**
+ * @ingroup meos_geo_accessor
+ * @brief Return the n-th instant of a packed temporal point sequence
+ * @param[in] pseq Packed temporal point sequence
+ * @param[in] n Number (1-based)
+ * @return On error or if the number is out of range return @p NULL
+ * @see #temporal_instant_n
+ */
+TInstant *
+tpointseq_packed_instant_n(const TPointSeqPacked *pseq, int n)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(pseq, NULL);
+  if (n < 1 || n > pseq->count)
+    return NULL;
+  GSERIALIZED *point = tpointseq_packed_point_n(pseq, n - 1);
+  return tinstant_make_free(PointerGetDatum(point), pseq->temptype,
+    TPOINTSEQ_PACKED_TIMES(pseq)[n - 1]);
+}
+
+/**
+ * @brief Return the index of the last instant of a packed temporal point
+ * sequence whose timestamp is less than or equal to a timestamp
+ * @pre The timestamp is not before the first instant
+ */
+static int
+tpointseq_packed_find_timestamptz(const TPointSeqPacked *pseq, TimestampTz t)
+{
+  const TimestampTz *times = TPOINTSEQ_PACKED_TIMES(pseq);
+  int first = 0, last = pseq->count - 1;
+  while (first < last)
+  {
+    int middle = first + (last - first + 1) / 2;
+    if (times[middle] <= t)
+      first = middle;
+    else
+      last = middle - 1;
+  }
+  return first;
+}
+
+/**
+ * @ingroup meos_geo_accessor
+ * @brief Return in the last argument the value of a packed temporal point
+ * sequence at a timestamptz
+ * @param[in] pseq Packed temporal point sequence
+ * @param[in] t Timestamp
+ * @param[in] strict True if inclusive/exclusive bounds are taken into account
+ * @param[out] result Resulting point
+ * @return Return true if the timestamp is contained in the sequence
+ * @see #tgeo_value_at_timestamptz
+ */
+bool
+tpointseq_packed_value_at_timestamptz(const TPointSeqPacked *pseq,
+  TimestampTz t, bool strict, GSERIALIZED **result)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(pseq, false); VALIDATE_NOT_NULL(result, false);
+
+  const TimestampTz *times = TPOINTSEQ_PACKED_TIMES(pseq);
+  interpType interp = MEOS_FLAGS_GET_INTERP(pseq->flags);
+  /* Return the value even when the timestamp is at an exclusive bound */
+  bool atbound = ! strict && interp != DISCRETE &&
+    (t == times[0] || t == times[pseq->count - 1]);
+  if (! atbound && ! contains_span_timestamptz(&pseq->period, t))
+    return false;
+
+  int n = tpointseq_packed_find_timestamptz(pseq, t);
+  if (times[n] == t)
+  {
+    *result = tpointseq_packed_point_n(pseq, n);
+    return true;
+  }
+  if (interp == DISCRETE)
+    return false;
+  if (interp == STEP)
+  {
+    *result = tpointseq_packed_point_n(pseq, n);
+    return true;
+  }
+
+  /* Linear interpolation within the segment */
+  bool hasz = MEOS_FLAGS_GET_Z(pseq->flags);
+  const double *x = TPOINTSEQ_PACKED_X(pseq);
+  const double *y = TPOINTSEQ_PACKED_Y(pseq);
+  const double *z = hasz ? TPOINTSEQ_PACKED_Z(pseq) : NULL;
+  if (x[n] == x[n + 1] && y[n] == y[n + 1] && (! hasz || z[n] == z[n + 1]))
+  {
+    *result = tpointseq_packed_point_n(pseq, n);
+    return true;
+  }
+  long double ratio = (long double) (t - times[n]) /
+    (long double) (times[n + 1] - times[n]);
+  if (MEOS_FLAGS_GET_GEODETIC(pseq->flags))
+  {
+    GSERIALIZED *start = tpointseq_packed_point_n(pseq, n);
+    GSERIALIZED *end = tpointseq_packed_point_n(pseq, n + 1);
+    *result = DatumGetGserializedP(pointsegm_interpolate(
+      PointerGetDatum(start), PointerGetDatum(end), ratio));
+    pfree(start); pfree(end);
+    return true;
+  }
+  /* The interpolation of #pointsegm_interpolate */
+  *result = geopoint_make(
+    x[n] + (double) ((long double) (x[n + 1] - x[n]) * ratio),
+    y[n] + (double) ((long double) (y[n + 1] - y[n]) * ratio),
+    hasz ? z[n] + (double) ((long double) (z[n + 1] - z[n]) * ratio) : 0.0,
+    hasz, false, pseq->srid);
+  return true;
+}
+
+/*****************************************************************************
+ * Length and speed functions
+ *****************************************************************************/
+
+/**
+ * @brief Return the Euclidean distance between two instants of a packed
+ * temporal point sequence
+ */
+static inline double
+tpointseq_packed_dist(const double *x, const double *y, const double *z,
+  int i, int j)
+{
+  double dx = x[i] - x[j], dy = y[i] - y[j];
+  if (! z)
+    return sqrt(dx * dx + dy * dy);
+  double dz = z[i] - z[j];
+  return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/**
+ * @ingroup meos_geo_accessor
+ * @brief Return the length traversed by a packed temporal point sequence
+ * @param[in] pseq Packed temporal point sequence
+ * @return On error return @p DBL_MAX
+ * @see #tpoint_length
+ */
+double
+tpointseq_packed_length(const TPointSeqPacked *pseq)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(pseq, DBL_MAX);
+  if (! MEOS_FLAGS_LINEAR_INTERP(pseq->flags) || pseq->count == 1)
+    return 0.0;
+  if (MEOS_FLAGS_GET_GEODETIC(pseq->flags))
+  {
+    TSequence *seq = tpointseq_from_packed(pseq);
+    double result = tpointseq_length(seq);
+    pfree(seq);
+    return result;
+  }
+
+  const double *x = TPOINTSEQ_PACKED_X(pseq);
+  const double *y = TPOINTSEQ_PACKED_Y(pseq);
+  const double *z = MEOS_FLAGS_GET_Z(pseq->flags) ?
+    TPOINTSEQ_PACKED_Z(pseq) : NULL;
+  double result = 0.0;
+  for (int i = 1; i < pseq->count; i++)
+    result += tpointseq_packed_dist(x, y, z, i - 1, i);
+  return result;
+}
+
+/**
+ * @ingroup meos_geo_accessor
+ * @brief Return the speed of a packed temporal point sequence
+ * @param[in] pseq Packed temporal point sequence
+ * @return On error return @p NULL, an instantaneous sequence has no speed
+ * @see #tpoint_speed
+ */
+TSequence *
+tpointseq_packed_speed(const TPointSeqPacked *pseq)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(pseq, NULL);
+  if (! MEOS_FLAGS_LINEAR_INTERP(pseq->flags))
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "The temporal value must have linear interpolation");
+    return NULL;
+  }
+  if (pseq->count == 1)
+    return NULL;
+  if (MEOS_FLAGS_GET_GEODETIC(pseq->flags))
+  {
+    TSequence *seq = tpointseq_from_packed(pseq);
+    TSequence *result = (TSequence *) tpoint_speed((Temporal *) seq);
+    pfree(seq);
+    return result;
+  }
+
+  /* Same computation as #tsequence_derivative */
+  const TimestampTz *times = TPOINTSEQ_PACKED_TIMES(pseq);
+  const double *x = TPOINTSEQ_PACKED_X(pseq);
+  const double *y = TPOINTSEQ_PACKED_Y(pseq);
+  const double *z = MEOS_FLAGS_GET_Z(pseq->flags) ?
+    TPOINTSEQ_PACKED_Z(pseq) : NULL;
+  TInstant **instants = palloc(sizeof(TInstant *) * pseq->count);
+  double speed = 0.0;
+  for (int i = 0; i < pseq->count - 1; i++)
+  {
+    bool same = x[i] == x[i + 1] && y[i] == y[i + 1] &&
+      (! z || z[i] == z[i + 1]);
+    speed = same ? 0.0 : tpointseq_packed_dist(x, y, z, i, i + 1) /
+      ((double)(times[i + 1] - times[i]) / 1000000);
+    instants[i] = tinstant_make(Float8GetDatum(speed), T_TFLOAT, times[i]);
+  }
+  instants[pseq->count - 1] = tinstant_make(Float8GetDatum(speed), T_TFLOAT,
+    times[pseq->count - 1]);
+  /* The resulting sequence has step interpolation */
+  return tsequence_make_free(instants, pseq->count, pseq->period.lower_inc,
+    pseq->period.upper_inc, STEP, NORMALIZE);
+}
+
+/*****************************************************************************
+ * Distance functions
+ *****************************************************************************/
+
+/**
+ * @brief Return the squared Euclidean distance between a point and the
+ * segment of a packed temporal point sequence starting at an instant
+ */
+static double
+tpointseq_packed_segm_dist2(const double *x, const double *y, const double *z,
+  int i, const POINT3DZ *p)
+{
+  double dx = x[i + 1] - x[i], dy = y[i + 1] - y[i];
+  double dz = z ? z[i + 1] - z[i] : 0.0;
+  double px = p->x - x[i], py = p->y - y[i];
+  double pz = z ? p->z - z[i] : 0.0;
+  double len2 = dx * dx + dy * dy + dz * dz;
+  double f = (len2 == 0.0) ? 0.0 : (px * dx + py * dy + pz * dz) / len2;
+  if (f < 0.0)
+    f = 0.0;
+  else if (f > 1.0)
+    f = 1.0;
+  double ex = px - f * dx, ey = py - f * dy, ez = pz - f * dz;
+  return ex * ex + ey * ey + ez * ez;
+}
+
+/**
+ * @ingroup meos_geo_dist
+ * @brief Return the nearest approach distance between a packed temporal
+ * point sequence and a geometry/geography
+ * @param[in] pseq Packed temporal point sequence
+ * @param[in] gs Geometry/geography
+ * @return On error return @p DBL_MAX
+ * @note Only the distance of a planar sequence to a point is computed on the
+ * arrays of coordinates, the other cases being computed by #nad_tgeo_geo
+ */
+double
+nad_tpointseq_packed_geo(const TPointSeqPacked *pseq, const GSERIALIZED *gs)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(pseq, DBL_MAX); VALIDATE_NOT_NULL(gs, DBL_MAX);
+  bool hasz = MEOS_FLAGS_GET_Z(pseq->flags);
+  if (! ensure_same_srid(pseq->srid, gserialized_get_srid(gs)))
+    return DBL_MAX;
+  if (hasz != (bool) FLAGS_GET_Z(gs->gflags))
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "Operation on mixed 2D/3D dimensions");
+    return DBL_MAX;
+  }
+  if (MEOS_FLAGS_GET_GEODETIC(pseq->flags) !=
+      (bool) FLAGS_GET_GEODETIC(gs->gflags))
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "Operation on mixed planar and geodetic coordinates");
+    return DBL_MAX;
+  }
+  if (gserialized_is_empty(gs))
+    return DBL_MAX;
+
+  if (MEOS_FLAGS_GET_GEODETIC(pseq->flags) ||
+      gserialized_get_type(gs) != POINTTYPE)
+  {
+    TSequence *seq = tpointseq_from_packed(pseq);
+    double result = nad_tgeo_geo((Temporal *) seq, gs);
+    pfree(seq);
+    return result;
+  }
+
+  POINT3DZ p;
+  if (hasz)
+    p = *GSERIALIZED_POINT3DZ_P(gs);
+  else
+  {
+    const POINT2D *p2d = GSERIALIZED_POINT2D_P(gs);
+    p.x = p2d->x; p.y = p2d->y; p.z = 0.0;
+  }
+  const double *x = TPOINTSEQ_PACKED_X(pseq);
+  const double *y = TPOINTSEQ_PACKED_Y(pseq);
+  const double *z = hasz ? TPOINTSEQ_PACKED_Z(pseq) : NULL;
+  double result = DBL_MAX;
+  if (MEOS_FLAGS_LINEAR_INTERP(pseq->flags) && pseq->count > 1)
+  {
+    for (int i = 0; i < pseq->count - 1; i++)
+    {
+      double d = tpointseq_packed_segm_dist2(x, y, z, i, &p);
+      if (d < result)
+        result = d;
+    }
+  }
+  else
+  {
+    for (int i = 0; i < pseq->count; i++)
+    {
+      double dx = x[i] - p.x, dy = y[i] - p.y, dz = z ? z[i] - p.z : 0.0;
+      double d = dx * dx + dy * dy + dz * dz;
+      if (d < result)
+        result = d;
+    }
+  }
+  return sqrt(result);
+}
+
+/*****************************************************************************/
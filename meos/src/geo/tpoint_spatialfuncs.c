@@ -48,7 +48,9 @@
 #include <meos_internal.h>
 #include <meos_internal_geo.h>
 #include "temporal/lifting.h"
+#include "temporal/span.h"
 #include "temporal/temporal_compops.h"
+#include "temporal/temporal_restrict.h"
 #include "temporal/tnumber_mathfuncs.h"
 #include "temporal/tsequence.h"
 #include "temporal/type_util.h"
@@ -2078,17 +2080,18 @@ tpoint_as_mvtgeom(const Temporal *temp, const STBox *bounds, int32_t extent,
 
 /**
  * @brief Return the length traversed by a temporal geometry point sequence
+ * view
  * @pre The temporal point has linear interpolation
  */
 static double
-tpointseq_length_2d(const TSequence *seq)
+tpointseqview_length_2d(const TSequenceView *view)
 {
   double result = 0.0;
-  Datum start = tinstant_value_p(TSEQUENCE_INST_N(seq, 0));
+  Datum start = tinstant_value_p(TSEQUENCEVIEW_INST_N(view, 0));
   const POINT2D *p1 = DATUM_POINT2D_P(start);
-  for (int i = 1; i < seq->count; i++)
+  for (int i = 1; i < view->count; i++)
   {
-    Datum end = tinstant_value_p(TSEQUENCE_INST_N(seq, i));
+    Datum end = tinstant_value_p(TSEQUENCEVIEW_INST_N(view, i));
     const POINT2D *p2 = DATUM_POINT2D_P(end);
     result += sqrt( ((p1->x - p2->x) * (p1->x - p2->x)) +
       ((p1->y - p2->y) * (p1->y - p2->y)) );
@@ -2099,17 +2102,18 @@ tpointseq_length_2d(const TSequence *seq)
 
 /**
  * @brief Return the length traversed by a temporal geometry point sequence
+ * view
  * @pre The temporal point has linear interpolation
  */
 static double
-tpointseq_length_3d(const TSequence *seq)
+tpointseqview_length_3d(const TSequenceView *view)
 {
   double result = 0.0;
-  Datum start = tinstant_value_p(TSEQUENCE_INST_N(seq, 0));
+  Datum start = tinstant_value_p(TSEQUENCEVIEW_INST_N(view, 0));
   const POINT3DZ *p1 = DATUM_POINT3DZ_P(start);
-  for (int i = 1; i < seq->count; i++)
+  for (int i = 1; i < view->count; i++)
   {
-    Datum end = tinstant_value_p(TSEQUENCE_INST_N(seq, i));
+    Datum end = tinstant_value_p(TSEQUENCEVIEW_INST_N(view, i));
     const POINT3DZ *p2 = DATUM_POINT3DZ_P(end);
     result += sqrt( ((p1->x - p2->x)*(p1->x - p2->x)) +
       ((p1->y - p2->y)*(p1->y - p2->y)) +
@@ -2119,6 +2123,39 @@ tpointseq_length_3d(const TSequence *seq)
   return result;
 }
 
+/**
+ * @brief Return the length traversed by a temporal point sequence view
+ * @param[in] view Temporal sequence view
+ * @note For geodetic points the view is converted into a sequence since the
+ * length is computed from the trajectory
+ */
+double
+tpointseqview_length(const TSequenceView *view)
+{
+  assert(view); assert(tpoint_type(view->seq->temptype));
+  assert(MEOS_FLAGS_LINEAR_INTERP(view->seq->flags));
+  if (view->count == 1)
+    return 0;
+
+  int16 flags = view->seq->flags;
+  if (! MEOS_FLAGS_GET_GEODETIC(flags))
+  {
+    return MEOS_FLAGS_GET_Z(flags) ?
+      tpointseqview_length_3d(view) : tpointseqview_length_2d(view);
+  }
+  else
+  {
+    TSequence *seq = tsequenceview_to_tsequence(view);
+    /* We are sure that the trajectory is a line, set the flag to do not
+     * apply the unary union function to remove redundant part of the geometry,
+     * e.g., when the temporal point traverses a line segment more than once */
+    GSERIALIZED *traj = tpointseq_linear_trajectory(seq, UNARY_UNION_NO);
+    double result = geog_length(traj, true);
+    pfree(traj); pfree(seq);
+    return result;
+  }
+}
+
 /**
  * @ingroup meos_internal_geo_accessor
  * @brief Return the length traversed by a temporal point sequence
@@ -2133,12 +2170,7 @@ tpointseq_length(const TSequence *seq)
   if (seq->count == 1)
     return 0;
 
-  if (! MEOS_FLAGS_GET_GEODETIC(seq->flags))
-  {
-    return MEOS_FLAGS_GET_Z(seq->flags) ?
-      tpointseq_length_3d(seq) : tpointseq_length_2d(seq);
-  }
-  else
+  if (MEOS_FLAGS_GET_GEODETIC(seq->flags))
   {
     /* We are sure that the trajectory is a line, set the flag to do not
      * apply the unary union function to remove redundant part of the geometry,
@@ -2148,6 +2180,10 @@ tpointseq_length(const TSequence *seq)
     pfree(traj);
     return result;
   }
+  TSequenceView view;
+  tsequenceview_set(seq, 0, seq->count - 1, seq->period.lower_inc,
+    seq->period.upper_inc, &view);
+  return tpointseqview_length(&view);
 }
 
 /**
@@ -2189,6 +2225,29 @@ tpoint_length(const Temporal *temp)
     return tpointseqset_length((TSequenceSet *) temp);
 }
 
+/**
+ * @ingroup meos_geo_accessor
+ * @brief Return the length traversed by a temporal point sequence (set)
+ * restricted to a timestamptz span
+ * @details The result is equal to the length of the result of
+ * #temporal_at_tstzspan but the restriction is not constructed, the length
+ * is computed on views of the composing sequences of the temporal point
+ * @param[in] temp Temporal point
+ * @param[in] s Timestamp span
+ * @return On error return @p DBL_MAX
+ */
+double
+tpoint_length_at_tstzspan(const Temporal *temp, const Span *s)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_TPOINT(temp, DBL_MAX); VALIDATE_TSTZSPAN(s, DBL_MAX);
+
+  assert(temptype_subtype(temp->subtype));
+  if (! MEOS_FLAGS_LINEAR_INTERP(temp->flags))
+    return 0.0;
+  return tcontseq_at_tstzspan_view_sum(temp, s, &tpointseqview_length);
+}
+
 /**
  * @ingroup meos_geo_accessor
  * @brief Return the speed of a temporal point sequence (set)
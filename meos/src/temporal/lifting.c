@@ -453,19 +453,14 @@ tfunc_tinstant(const TInstant *inst, LiftedFunctionInfo *lfinfo)
 #define MEOS_ADAPTIVE_MAX_DEPTH 16
 
 /**
- * @brief Append a lifted result instant to a growing buffer, doubling the
- * capacity as needed
+ * @brief Append a lifted result value to a sequence builder and free it
  */
 static void
 tfunc_adaptive_emit(Datum resvalue, MeosType restype, TimestampTz t,
-  TInstant ***buf, int *buf_n, int *buf_cap)
+  TSequenceBuilder *builder)
 {
-  if (*buf_n == *buf_cap)
-  {
-    *buf_cap *= 2;
-    *buf = repalloc(*buf, sizeof(TInstant *) * (*buf_cap));
-  }
-  (*buf)[(*buf_n)++] = tinstant_make_free(resvalue, restype, t);
+  tsequencebuilder_append(builder, resvalue, t);
+  DATUM_FREE(resvalue, temptype_basetype(restype));
 }
 
 /**
@@ -487,13 +482,12 @@ tfunc_adaptive_emit(Datum resvalue, MeosType restype, TimestampTz t,
  * @param[in] basetype Base type of the input (a continuous float)
  * @param[in] lfinfo Information about the lifted function
  * @param[in] depth Current recursion depth
- * @param[in,out] buf,buf_n,buf_cap Growing result-instant buffer
+ * @param[in,out] builder Builder of the result sequence
  */
 static void
 tfunc_adaptive_bisect(Datum value1, Datum value2, TimestampTz t1,
   TimestampTz t2, MeosType temptype, MeosType basetype,
-  LiftedFunctionInfo *lfinfo, int depth, TInstant ***buf, int *buf_n,
-  int *buf_cap)
+  LiftedFunctionInfo *lfinfo, int depth, TSequenceBuilder *builder)
 {
   assert(basetype == T_FLOAT8);
   /* Argument span across the segment — the radian analog of the rotation
@@ -505,8 +499,8 @@ tfunc_adaptive_bisect(Datum value1, Datum value2, TimestampTz t1,
     /* The argument barely moves across [t1, t2], so the lifted chord is a
      * good approximation: emit only the segment endpoint t2 (t1 was emitted
      * by the caller). */
-    tfunc_adaptive_emit(lfunc_base(value2, lfinfo), lfinfo->restype, t2, buf,
-      buf_n, buf_cap);
+    tfunc_adaptive_emit(lfunc_base(value2, lfinfo), lfinfo->restype, t2,
+      builder);
     return;
   }
   /* Bisect: interpolate the argument at the midpoint, recurse on the left
@@ -516,9 +510,9 @@ tfunc_adaptive_bisect(Datum value1, Datum value2, TimestampTz t1,
   Datum vm = tsegment_value_at_timestamptz(value1, value2, temptype, t1, t2,
     tm);
   tfunc_adaptive_bisect(value1, vm, t1, tm, temptype, basetype, lfinfo,
-    depth + 1, buf, buf_n, buf_cap);
+    depth + 1, builder);
   tfunc_adaptive_bisect(vm, value2, tm, t2, temptype, basetype, lfinfo,
-    depth + 1, buf, buf_n, buf_cap);
+    depth + 1, builder);
   DATUM_FREE(vm, basetype);
 }
 
@@ -539,15 +533,15 @@ static TSequence *
 tfunc_tlinearseq_adaptive(const TSequence *seq, LiftedFunctionInfo *lfinfo)
 {
   MeosType basetype = temptype_basetype(seq->temptype);
-  /* Generous initial capacity; the buffer doubles on demand */
-  int buf_cap = seq->count * 4;
-  TInstant **instants = palloc(sizeof(TInstant *) * buf_cap);
-  int ninsts = 0;
+  /* Generous initial capacity; the builder doubles it on demand */
+  TSequenceBuilder builder;
+  tsequencebuilder_init(&builder, lfinfo->restype, LINEAR, seq->count * 4,
+    NORMALIZE);
   const TInstant *inst1 = TSEQUENCE_INST_N(seq, 0);
   Datum value1 = tinstant_value_p(inst1);
   /* Emit the first instant */
   tfunc_adaptive_emit(lfunc_base(value1, lfinfo), lfinfo->restype, inst1->t,
-    &instants, &ninsts, &buf_cap);
+    &builder);
   for (int i = 1; i < seq->count; i++)
   {
     const TInstant *inst2 = TSEQUENCE_INST_N(seq, i);
@@ -555,15 +549,15 @@ tfunc_tlinearseq_adaptive(const TSequence *seq, LiftedFunctionInfo *lfinfo)
     if (datum_eq(value1, value2, basetype))
       /* Constant segment: just emit the endpoint */
       tfunc_adaptive_emit(lfunc_base(value2, lfinfo), lfinfo->restype,
-        inst2->t, &instants, &ninsts, &buf_cap);
+        inst2->t, &builder);
     else
       tfunc_adaptive_bisect(value1, value2, inst1->t, inst2->t,
-        seq->temptype, basetype, lfinfo, 0, &instants, &ninsts, &buf_cap);
+        seq->temptype, basetype, lfinfo, 0, &builder);
     inst1 = inst2;
     value1 = value2;
   }
-  return tsequence_make_free(instants, ninsts, seq->period.lower_inc,
-    seq->period.upper_inc, LINEAR, NORMALIZE);
+  return tsequencebuilder_finish(&builder, seq->period.lower_inc,
+    seq->period.upper_inc);
 }
 
 /**
@@ -582,15 +576,19 @@ tfunc_tlinearseq_turnpt(const TSequence *seq, LiftedFunctionInfo *lfinfo)
 {
   MeosType basetype = temptype_basetype(seq->temptype);
   MeosType resbasetype = temptype_basetype(lfinfo->restype);
-  TInstant **instants = palloc(sizeof(TInstant *) * seq->count * 3);
-  int ninsts = 0;
+  TSequenceBuilder builder;
+  tsequencebuilder_init(&builder, lfinfo->restype, LINEAR, seq->count * 3,
+    NORMALIZE);
   const TInstant *inst1 = TSEQUENCE_INST_N(seq, 0);
   Datum value1 = tinstant_value_p(inst1);
+  Datum res;
   for (int i = 1; i < seq->count; i++)
   {
     const TInstant *inst2 = TSEQUENCE_INST_N(seq, i);
     Datum value2 = tinstant_value_p(inst2);
-    instants[ninsts++] = tfunc_tinstant(inst1, lfinfo);
+    res = lfunc_base(value1, lfinfo);
+    tsequencebuilder_append(&builder, res, inst1->t);
+    DATUM_FREE(res, resbasetype);
     /* Skip densification on constant segments */
     if (! datum_eq(value1, value2, basetype))
     {
@@ -601,15 +599,15 @@ tfunc_tlinearseq_turnpt(const TSequence *seq, LiftedFunctionInfo *lfinfo)
       {
         Datum tpvalue = tsegment_value_at_timestamptz(value1, value2,
           inst1->temptype, inst1->t, inst2->t, tpt1);
-        Datum res = lfunc_base(tpvalue, lfinfo);
-        instants[ninsts++] = tinstant_make(res, lfinfo->restype, tpt1);
+        res = lfunc_base(tpvalue, lfinfo);
+        tsequencebuilder_append(&builder, res, tpt1);
         DATUM_FREE(tpvalue, basetype); DATUM_FREE(res, resbasetype);
         if (found > 1)
         {
           tpvalue = tsegment_value_at_timestamptz(value1, value2,
             inst1->temptype, inst1->t, inst2->t, tpt2);
           res = lfunc_base(tpvalue, lfinfo);
-          instants[ninsts++] = tinstant_make(res, lfinfo->restype, tpt2);
+          tsequencebuilder_append(&builder, res, tpt2);
           DATUM_FREE(tpvalue, basetype); DATUM_FREE(res, resbasetype);
         }
       }
@@ -617,9 +615,11 @@ tfunc_tlinearseq_turnpt(const TSequence *seq, LiftedFunctionInfo *lfinfo)
     inst1 = inst2;
     value1 = value2;
   }
-  instants[ninsts++] = tfunc_tinstant(inst1, lfinfo);
-  return tsequence_make_free(instants, ninsts, seq->period.lower_inc,
-    seq->period.upper_inc, LINEAR, NORMALIZE);
+  res = lfunc_base(value1, lfinfo);
+  tsequencebuilder_append(&builder, res, inst1->t);
+  DATUM_FREE(res, resbasetype);
+  return tsequencebuilder_finish(&builder, seq->period.lower_inc,
+    seq->period.upper_inc);
 }
 
 /**
@@ -640,15 +640,15 @@ tfunc_tlinearseq_set(const TSequence *seq, LiftedFunctionInfo *lfinfo)
 {
   MeosType basetype = temptype_basetype(seq->temptype);
   /* The number of turning points per segment is not bounded a priori (a segment
-   * may span many periods), so grow the buffer on demand. */
-  int buf_cap = seq->count * 4;
-  TInstant **instants = palloc(sizeof(TInstant *) * buf_cap);
-  int ninsts = 0;
+   * may span many periods), so the builder grows on demand. */
+  TSequenceBuilder builder;
+  tsequencebuilder_init(&builder, lfinfo->restype, LINEAR, seq->count * 4,
+    NORMALIZE);
   const TInstant *inst1 = TSEQUENCE_INST_N(seq, 0);
   Datum value1 = tinstant_value_p(inst1);
   /* Emit the first instant */
   tfunc_adaptive_emit(lfunc_base(value1, lfinfo), lfinfo->restype, inst1->t,
-    &instants, &ninsts, &buf_cap);
+    &builder);
   for (int i = 1; i < seq->count; i++)
   {
     const TInstant *inst2 = TSEQUENCE_INST_N(seq, i);
@@ -663,7 +663,7 @@ tfunc_tlinearseq_set(const TSequence *seq, LiftedFunctionInfo *lfinfo)
         Datum tpvalue = tsegment_value_at_timestamptz(value1, value2,
           inst1->temptype, inst1->t, inst2->t, tps[j]);
         tfunc_adaptive_emit(lfunc_base(tpvalue, lfinfo), lfinfo->restype,
-          tps[j], &instants, &ninsts, &buf_cap);
+          tps[j], &builder);
         DATUM_FREE(tpvalue, basetype);
       }
       if (tps)
@@ -671,12 +671,12 @@ tfunc_tlinearseq_set(const TSequence *seq, LiftedFunctionInfo *lfinfo)
     }
     /* Emit the segment endpoint */
     tfunc_adaptive_emit(lfunc_base(value2, lfinfo), lfinfo->restype, inst2->t,
-      &instants, &ninsts, &buf_cap);
+      &builder);
     inst1 = inst2;
     value1 = value2;
   }
-  return tsequence_make_free(instants, ninsts, seq->period.lower_inc,
-    seq->period.upper_inc, LINEAR, NORMALIZE);
+  return tsequencebuilder_finish(&builder, seq->period.lower_inc,
+    seq->period.upper_inc);
 }
 
 /**
@@ -702,25 +702,28 @@ tfunc_tsequence(const TSequence *seq, LiftedFunctionInfo *lfinfo)
   if (lfinfo->tpfn_adaptive && interp == LINEAR)
     return tfunc_tlinearseq_adaptive(seq, lfinfo);
 
-  /* Plain per-instant lift */
-  TInstant **instants = palloc(sizeof(TInstant *) * seq->count);
-  for (int i = 0; i < seq->count; i++)
-    instants[i] = tfunc_tinstant(TSEQUENCE_INST_N(seq, i), lfinfo);
   /* Honor reslinear when the input is LINEAR and the producer declared the
    * result is not.  Same idiom as tfunc_tsequence_base. */
   if (interp == LINEAR && ! lfinfo->reslinear)
     interp = STEP;
+  /* Plain per-instant lift */
+  MeosType resbasetype = temptype_basetype(lfinfo->restype);
+  TSequenceBuilder builder;
+  tsequencebuilder_init(&builder, lfinfo->restype, interp, seq->count,
+    NORMALIZE);
+  for (int i = 0; i < seq->count; i++)
+  {
+    const TInstant *inst = TSEQUENCE_INST_N(seq, i);
+    Datum res = lfunc_base(tinstant_value_p(inst), lfinfo);
+    tsequencebuilder_append(&builder, res, inst->t);
+    DATUM_FREE(res, resbasetype);
+  }
   /* The last two values of sequences with step interpolation and exclusive
    * upper bound must be equal */
   if (! seq->period.upper_inc && interp == STEP && seq->count >= 2)
-  {
-    TInstant *inst = instants[seq->count - 1];
-    Datum value = tinstant_value_p(instants[seq->count - 2]);
-    instants[seq->count - 1] = tinstant_make(value, lfinfo->restype, inst->t);
-    pfree(inst);
-  }
-  return tsequence_make_free(instants, seq->count, seq->period.lower_inc,
-    seq->period.upper_inc, interp, NORMALIZE);
+    tsequencebuilder_repeat_prev_value(&builder);
+  return tsequencebuilder_finish(&builder, seq->period.lower_inc,
+    seq->period.upper_inc);
 }
 
 /**
@@ -822,27 +825,29 @@ TSequence *
 tfunc_tsequence_base(const TSequence *seq, Datum value,
   LiftedFunctionInfo *lfinfo)
 {
-  TInstant **instants = palloc(sizeof(TInstant *) * seq->count);
-  for (int i = 0; i < seq->count; i++)
-    instants[i] = tfunc_tinstant_base(TSEQUENCE_INST_N(seq, i), value, lfinfo);
   /* Set the interpolation depending on the one of the sequence and the result
    * as stated in the `lfinfo` structure */
   interpType interp = MEOS_FLAGS_GET_INTERP(seq->flags);
   if (interp == LINEAR && ! lfinfo->reslinear)
     interp = STEP;
+  MeosType resbasetype = temptype_basetype(lfinfo->restype);
+  TSequenceBuilder builder;
+  tsequencebuilder_init(&builder, lfinfo->restype, interp, seq->count,
+    NORMALIZE);
+  for (int i = 0; i < seq->count; i++)
+  {
+    const TInstant *inst = TSEQUENCE_INST_N(seq, i);
+    Datum res = tfunc_base_base(tinstant_value_p(inst), value, lfinfo);
+    tsequencebuilder_append(&builder, res, inst->t);
+    DATUM_FREE(res, resbasetype);
+  }
   /* The last two values of sequences with step interpolation and exclusive
      upper bound must be equal */
   if (! seq->period.upper_inc && interp == STEP)
-  {
-    TInstant *inst = instants[seq->count - 1];
-    value = tinstant_value_p(instants[seq->count - 2]);
-    instants[seq->count - 1] = tinstant_make(value, lfinfo->restype,
-      instants[seq->count - 1]->t);
-    pfree(inst);
-  }
+    tsequencebuilder_repeat_prev_value(&builder);
   /* Create the result */
-  return tsequence_make_free(instants, seq->count, seq->period.lower_inc,
-    seq->period.upper_inc, interp, NORMALIZE);
+  return tsequencebuilder_finish(&builder, seq->period.lower_inc,
+    seq->period.upper_inc);
 }
 
 /**
@@ -860,17 +865,21 @@ tfunc_tlinearseq_base_turnpt(const TSequence *seq, Datum value,
 {
   MeosType basetype = temptype_basetype(seq->temptype);
   MeosType resbasetype = temptype_basetype(lfinfo->restype);
-  int ninsts = 0;
-  TInstant **instants = palloc(sizeof(TInstant *) * seq->count * 3);
   const TInstant *inst1 = TSEQUENCE_INST_N(seq, 0);
   Datum value1 = tinstant_value_p(inst1);
   interpType interp = MEOS_FLAGS_GET_INTERP(seq->flags);
+  TSequenceBuilder builder;
+  tsequencebuilder_init(&builder, lfinfo->restype, interp, seq->count * 3,
+    NORMALIZE);
+  Datum res;
   for (int i = 1; i < seq->count; i++)
   {
     /* Each iteration of the loop adds between one and two instants */
     const TInstant *inst2 = TSEQUENCE_INST_N(seq, i);
     Datum value2 = tinstant_value_p(inst2);
-    instants[ninsts++] = tfunc_tinstant_base(inst1, value, lfinfo);
+    res = tfunc_base_base(value1, value, lfinfo);
+    tsequencebuilder_append(&builder, res, inst1->t);
+    DATUM_FREE(res, resbasetype);
     /* If not constant segment and linear compute the function on the potential
        intermediate turning points before adding the new instant */
     if (lfinfo->tpfn_base && interp == LINEAR &&
@@ -884,8 +893,8 @@ tfunc_tlinearseq_base_turnpt(const TSequence *seq, Datum value,
       {
         tpvalue = tsegment_value_at_timestamptz(value1, value2, 
           inst1->temptype, inst1->t, inst2->t, tpt1);
-        Datum res = tfunc_base_base(tpvalue, value, lfinfo);
-        instants[ninsts++] = tinstant_make(res, lfinfo->restype, tpt1);
+        res = tfunc_base_base(tpvalue, value, lfinfo);
+        tsequencebuilder_append(&builder, res, tpt1);
         DATUM_FREE(tpvalue, basetype); DATUM_FREE(res, resbasetype);
         /* Account for the second turning point if any */
         if (found > 1)
@@ -893,7 +902,7 @@ tfunc_tlinearseq_base_turnpt(const TSequence *seq, Datum value,
           tpvalue = tsegment_value_at_timestamptz(value1, value2, 
             inst1->temptype, inst1->t, inst2->t, tpt2);
           res = tfunc_base_base(tpvalue, value, lfinfo);
-          instants[ninsts++] = tinstant_make(res, lfinfo->restype, tpt2);
+          tsequencebuilder_append(&builder, res, tpt2);
           DATUM_FREE(tpvalue, basetype); DATUM_FREE(res, resbasetype);
         }
       }
@@ -901,9 +910,11 @@ tfunc_tlinearseq_base_turnpt(const TSequence *seq, Datum value,
     inst1 = inst2;
     value1 = value2;
   }
-  instants[ninsts++] = tfunc_tinstant_base(inst1, value, lfinfo);
-  result[0] = tsequence_make_free(instants, ninsts, seq->period.lower_inc,
-    seq->period.upper_inc, interp, NORMALIZE);
+  res = tfunc_base_base(value1, value, lfinfo);
+  tsequencebuilder_append(&builder, res, inst1->t);
+  DATUM_FREE(res, resbasetype);
+  result[0] = tsequencebuilder_finish(&builder, seq->period.lower_inc,
+    seq->period.upper_inc);
   return 1;
 }
 
@@ -1489,7 +1500,10 @@ tfunc_tcontseq_tcontseq_single(const TSequence *seq1, const TSequence *seq2,
   TimestampTz upper = DatumGetTimestampTz(inter->upper);
   interpType interp1 = MEOS_FLAGS_GET_INTERP(seq1->flags);
   interpType interp2 = MEOS_FLAGS_GET_INTERP(seq2->flags);
-  int i = 0, j = 0, ninsts = 0, nfree = 0;
+  interpType interp = Min(interp1, interp2);
+  if (interp == LINEAR && ! lfinfo->reslinear)
+    interp = STEP;
+  int i = 0, j = 0, nfree = 0;
   if (inst1->t < lower)
   {
     i = tcontseq_find_timestamptz(seq1, inter->lower) + 1;
@@ -1501,8 +1515,10 @@ tfunc_tcontseq_tcontseq_single(const TSequence *seq1, const TSequence *seq2,
     inst2 = (TInstant *) TSEQUENCE_INST_N(seq2, j);
   }
   int count = (seq1->count - i + seq2->count - j) * 3;
-  TInstant **instants = palloc(sizeof(TInstant *) * count);
   TInstant **tofree = palloc(sizeof(TInstant *) * count);
+  TSequenceBuilder builder;
+  tsequencebuilder_init(&builder, lfinfo->restype, interp, count, NORMALIZE);
+  bool first = true;
   Datum value;
   while (i < seq1->count && j < seq2->count &&
     (inst1->t <= upper || inst2->t <= upper))
@@ -1532,7 +1548,7 @@ tfunc_tcontseq_tcontseq_single(const TSequence *seq1, const TSequence *seq2,
     }
     /* If not the first instant compute the function on the potential
        turning point before adding the new instants */
-    if (lfinfo->tpfn_temp && ninsts > 0)
+    if (lfinfo->tpfn_temp && ! first)
     {
       Datum start1 = tinstant_value_p(prev1);
       Datum end1 = tinstant_value_p(inst1);
@@ -1550,8 +1566,7 @@ tfunc_tcontseq_tcontseq_single(const TSequence *seq1, const TSequence *seq2,
         tpvalue2 = tsegment_value_at_timestamptz(start2, end2, prev1->temptype,
           prev1->t, inst1->t, tpt1);
         tpresult = tfunc_base_base(tpvalue1, tpvalue2, lfinfo);
-        instants[ninsts++] = tinstant_make_free(tpresult, lfinfo->restype,
-          tpt1);
+        tsequencebuilder_append(&builder, tpresult, tpt1);
         DATUM_FREE(tpvalue1, basetype); DATUM_FREE(tpvalue2, basetype);
         DATUM_FREE(tpresult, basetype_res);
       }
@@ -1563,8 +1578,7 @@ tfunc_tcontseq_tcontseq_single(const TSequence *seq1, const TSequence *seq2,
         tpvalue2 = tsegment_value_at_timestamptz(start2, end2, prev1->temptype,
           prev1->t, inst1->t, tpt2);
         tpresult = tfunc_base_base(tpvalue1, tpvalue2, lfinfo);
-        instants[ninsts++] = tinstant_make_free(tpresult, lfinfo->restype,
-          tpt2);
+        tsequencebuilder_append(&builder, tpresult, tpt2);
         DATUM_FREE(tpvalue1, basetype); DATUM_FREE(tpvalue2, basetype);
         DATUM_FREE(tpresult, basetype_res);
       }
@@ -1572,7 +1586,9 @@ tfunc_tcontseq_tcontseq_single(const TSequence *seq1, const TSequence *seq2,
     /* Compute the function on the synchronized instants */
     value = tfunc_base_base(tinstant_value_p(inst1), tinstant_value_p(inst2),
       lfinfo);
-    instants[ninsts++] = tinstant_make_free(value, lfinfo->restype, inst1->t);
+    tsequencebuilder_append(&builder, value, inst1->t);
+    DATUM_FREE(value, basetype_res);
+    first = false;
     if (i == seq1->count || j == seq2->count)
       break;
     prev1 = inst1;
@@ -1580,23 +1596,15 @@ tfunc_tcontseq_tcontseq_single(const TSequence *seq1, const TSequence *seq2,
     inst1 = (TInstant *) TSEQUENCE_INST_N(seq1, i);
     inst2 = (TInstant *) TSEQUENCE_INST_N(seq2, j);
   }
-  /* We are sure that ninsts != 0 due to the period intersection test above */
+  /* We are sure that the builder is not empty due to the period intersection
+     test above */
   /* The last two values of sequences with step interpolation and exclusive
      upper bound must be equal */
-  if (! lfinfo->reslinear && ! inter->upper_inc && ninsts > 1)
-  {
-    tofree[nfree++] = instants[ninsts - 1];
-    value = tinstant_value_p(instants[ninsts - 2]);
-    instants[ninsts - 1] = tinstant_make(value, lfinfo->restype,
-      instants[ninsts - 1]->t);
-  }
+  if (! lfinfo->reslinear && ! inter->upper_inc)
+    tsequencebuilder_repeat_prev_value(&builder);
   pfree_array((void **) tofree, nfree);
-  interpType interp = Min(MEOS_FLAGS_GET_INTERP(seq1->flags),
-    MEOS_FLAGS_GET_INTERP(seq2->flags));
-  if (interp == LINEAR && ! lfinfo->reslinear)
-    interp = STEP;
-  result[0] = tsequence_make_free(instants, ninsts, inter->lower_inc,
-    inter->upper_inc, interp, NORMALIZE);
+  result[0] = tsequencebuilder_finish(&builder, inter->lower_inc,
+    inter->upper_inc);
   return 1;
 }
 
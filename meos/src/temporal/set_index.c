@@ -0,0 +1,548 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief In-memory inverted index for set types
+ * @details The index maps every element of the sets to its posting list, i.e.,
+ * the ordered numbers of the sets containing it, which answers the searches
+ * of the GIN indexes of the set types: a set contains the query when it
+ * appears in the posting lists of all the elements of the query, overlaps the
+ * query when it appears in one of them, and is contained in the query when it
+ * appears in as many of them as it has elements. The posting lists are
+ * compressed as variable-length differences between consecutive sets, cut
+ * into blocks whose first set is kept aside, so that an intersection skips
+ * the blocks that cannot hold the sets it looks for.
+ */
+
+#include "temporal/set_index.h"
+
+/* C */
+#include <assert.h>
+#include <limits.h>
+/* PostgreSQL */
+#include <postgres.h>
+/* MEOS */
+#include <meos.h>
+#include <meos_internal.h>
+#include "temporal/set.h"
+#include "temporal/type_util.h"
+
+/* Document standing for an exhausted posting list */
+#define SETINDEX_END INT32_MAX
+
+/*****************************************************************************
+ * Posting lists
+ *****************************************************************************/
+
+/**
+ * @brief Append a document to a posting list
+ * @details The documents are appended in increasing order
+ */
+static void
+posting_append(SetPosting *posting, int32 doc)
+{
+  if (posting->count % SETINDEX_BLOCK == 0)
+  {
+    /* Start a new block */
+    if (posting->nblocks == posting->blockcap)
+    {
+      posting->blockcap = posting->blockcap ? posting->blockcap * 2 : 1;
+      posting->blocks = posting->blocks ?
+        repalloc(posting->blocks, sizeof(SetPostingBlock) * posting->blockcap) :
+        palloc(sizeof(SetPostingBlock) * posting->blockcap);
+    }
+    posting->blocks[posting->nblocks].first = doc;
+    posting->blocks[posting->nblocks++].offset = posting->size;
+  }
+  else
+  {
+    /* A difference takes at most five bytes of seven bits */
+    if (posting->size + 5 > posting->capacity)
+    {
+      posting->capacity = Max(posting->capacity * 2, 16);
+      posting->bytes = posting->bytes ?
+        repalloc(posting->bytes, posting->capacity) :
+        palloc(posting->capacity);
+    }
+    uint32 delta = (uint32) (doc - posting->last);
+    while (delta >= 0x80)
+    {
+      posting->bytes[posting->size++] = (uint8) (delta | 0x80);
+      delta >>= 7;
+    }
+    posting->bytes[posting->size++] = (uint8) delta;
+  }
+  posting->last = doc;
+  posting->count++;
+  return;
+}
+
+/**
+ * @brief Iterator over the documents of a posting list
+ */
+typedef struct
+{
+  const SetPosting *posting;  /**< Posting list */
+  int block;                  /**< Block of the current document */
+  int pos;                    /**< Position of the current document */
+  int offset;                 /**< Offset of the difference of the next one */
+  int32 doc;                  /**< Current document, @p SETINDEX_END once the
+                                   posting list is exhausted */
+} SetPostingIter;
+
+/**
+ * @brief Position an iterator at the first document of a block
+ */
+static void
+posting_iter_block(SetPostingIter *it, int block)
+{
+  it->block = block;
+  it->pos = block * SETINDEX_BLOCK;
+  it->offset = it->posting->blocks[block].offset;
+  it->doc = it->posting->blocks[block].first;
+  return;
+}
+
+/**
+ * @brief Initialize an iterator at the first document of a posting list
+ */
+static void
+posting_iter_init(SetPostingIter *it, const SetPosting *posting)
+{
+  it->posting = posting;
+  posting_iter_block(it, 0);
+  return;
+}
+
+/**
+ * @brief Advance an iterator to the next document
+ */
+static void
+posting_iter_next(SetPostingIter *it)
+{
+  const SetPosting *posting = it->posting;
+  if (++it->pos >= posting->count)
+  {
+    it->doc = SETINDEX_END;
+    return;
+  }
+  if (it->pos % SETINDEX_BLOCK == 0)
+  {
+    posting_iter_block(it, it->block + 1);
+    return;
+  }
+  uint32 delta = 0;
+  int shift = 0;
+  uint8 byte;
+  do
+  {
+    byte = posting->bytes[it->offset++];
+    delta |= (uint32) (byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  it->doc += (int32) delta;
+  return;
+}
+
+/**
+ * @brief Advance an iterator to the first document greater than or equal to
+ * a target
+ * @details The blocks starting at most at the target are skipped by a binary
+ * search on their first documents, without decoding them
+ */
+static void
+posting_iter_seek(SetPostingIter *it, int32 target)
+{
+  if (it->doc >= target)
+    return;
+  const SetPosting *posting = it->posting;
+  /* Find the last block starting at most at the target */
+  int lo = it->block, hi = posting->nblocks - 1;
+  while (lo < hi)
+  {
+    int mid = lo + (hi - lo + 1) / 2;
+    if (posting->blocks[mid].first <= target)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  if (lo > it->block)
+    posting_iter_block(it, lo);
+  while (it->doc < target)
+    posting_iter_next(it);
+  return;
+}
+
+/*****************************************************************************
+ * Hash table of the posting lists
+ *****************************************************************************/
+
+/**
+ * @brief Return the slot of the posting list of an element in the hash table,
+ * or -1 if the element is not in the index
+ */
+static int
+setindex_find(const SetIndex *sindex, Datum value, uint32 hash)
+{
+  if (! sindex->postcap)
+    return -1;
+  MeosType basetype = sindex->sample->basetype;
+  int mask = sindex->postcap - 1;
+  /* The table is at most half full, so the probe reaches an empty slot */
+  for (int i = (int) (hash & mask); ; i = (i + 1) & mask)
+  {
+    const SetPosting *posting = &sindex->postings[i];
+    if (! posting->blocks)
+      return -1;
+    if (posting->hash == hash && datum_eq(posting->value, value, basetype))
+      return i;
+  }
+}
+
+/**
+ * @brief Resize the hash table of the posting lists
+ */
+static void
+setindex_resize(SetIndex *sindex, int postcap)
+{
+  SetPosting *old = sindex->postings;
+  int oldcap = sindex->postcap;
+  sindex->postings = palloc0(sizeof(SetPosting) * postcap);
+  sindex->postcap = postcap;
+  int mask = postcap - 1;
+  for (int i = 0; i < oldcap; i++)
+  {
+    if (! old[i].blocks)
+      continue;
+    int j = (int) (old[i].hash & mask);
+    while (sindex->postings[j].blocks)
+      j = (j + 1) & mask;
+    sindex->postings[j] = old[i];
+  }
+  if (old)
+    pfree(old);
+  return;
+}
+
+/**
+ * @brief Return the posting list of an element, adding an empty one when the
+ * element is not in the index
+ */
+static SetPosting *
+setindex_get(SetIndex *sindex, Datum value)
+{
+  uint32 hash = datum_hash(value, sindex->sample->basetype);
+  int i = setindex_find(sindex, value, hash);
+  if (i >= 0)
+    return &sindex->postings[i];
+  if ((sindex->npostings + 1) * 2 > sindex->postcap)
+    setindex_resize(sindex, sindex->postcap ? sindex->postcap * 2 : 64);
+  int mask = sindex->postcap - 1;
+  i = (int) (hash & mask);
+  while (sindex->postings[i].blocks)
+    i = (i + 1) & mask;
+  SetPosting *posting = &sindex->postings[i];
+  memset(posting, 0, sizeof(SetPosting));
+  posting->value = datum_copy(value, sindex->sample->basetype);
+  posting->hash = hash;
+  /* A posting list in use always has a block */
+  posting->blockcap = 1;
+  posting->blocks = palloc(sizeof(SetPostingBlock));
+  sindex->npostings++;
+  return posting;
+}
+
+/*****************************************************************************
+ * Creation and insertion
+ *****************************************************************************/
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Return a new in-memory inverted index for sets
+ * @details The type of the sets of the index is the one of the first set
+ * inserted
+ */
+SetIndex *
+setindex_create(void)
+{
+  return palloc0(sizeof(SetIndex));
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Free an in-memory inverted index for sets
+ * @param[in] sindex The index to free
+ */
+void
+setindex_free(SetIndex *sindex)
+{
+  if (! sindex)
+    return;
+  bool byvalue = ! sindex->sample ||
+    basetype_byvalue(sindex->sample->basetype);
+  for (int i = 0; i < sindex->postcap; i++)
+  {
+    SetPosting *posting = &sindex->postings[i];
+    if (! posting->blocks)
+      continue;
+    if (! byvalue)
+      pfree(DatumGetPointer(posting->value));
+    if (posting->bytes)
+      pfree(posting->bytes);
+    pfree(posting->blocks);
+  }
+  if (sindex->postings)
+    pfree(sindex->postings);
+  if (sindex->ids)
+  {
+    pfree(sindex->ids);
+    pfree(sindex->sizes);
+  }
+  if (sindex->sample)
+    pfree(sindex->sample);
+  pfree(sindex);
+  return;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Return the number of sets of an in-memory inverted index
+ * @param[in] sindex The index
+ */
+int
+setindex_count(const SetIndex *sindex)
+{
+  return sindex->count;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Insert a set into an in-memory inverted index
+ * @param[in] sindex The index
+ * @param[in] s The set, of the type and the SRID of the sets of the index
+ * @param[in] id The id of the set
+ * @return True on success, false on error
+ */
+bool
+setindex_insert(SetIndex *sindex, const Set *s, int64 id)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(sindex, false); VALIDATE_NOT_NULL(s, false);
+  if (sindex->sample && ! ensure_valid_set_set(sindex->sample, s))
+    return false;
+  if (sindex->count == INT32_MAX - 1)
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "An inverted index cannot hold more sets");
+    return false;
+  }
+  if (! sindex->sample)
+    sindex->sample = set_copy(s);
+
+  if (sindex->count == sindex->capacity)
+  {
+    sindex->capacity = sindex->capacity ? sindex->capacity * 2 : 64;
+    sindex->ids = sindex->ids ?
+      repalloc(sindex->ids, sizeof(int64) * sindex->capacity) :
+      palloc(sizeof(int64) * sindex->capacity);
+    sindex->sizes = sindex->sizes ?
+      repalloc(sindex->sizes, sizeof(int) * sindex->capacity) :
+      palloc(sizeof(int) * sindex->capacity);
+  }
+  int32 doc = sindex->count++;
+  sindex->ids[doc] = id;
+  sindex->sizes[doc] = s->count;
+  /* The elements of a set are distinct, so a document is appended once to
+   * each posting list */
+  for (int i = 0; i < s->count; i++)
+    posting_append(setindex_get(sindex, SET_VAL_N(s, i)), doc);
+  return true;
+}
+
+/*****************************************************************************
+ * Search
+ *****************************************************************************/
+
+/**
+ * @brief Comparator of documents
+ */
+static int
+doc_cmp(const void *a, const void *b)
+{
+  int32 x = *(const int32 *) a, y = *(const int32 *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Comparator of posting lists by increasing number of documents
+ */
+static int
+posting_count_cmp(const void *a, const void *b)
+{
+  const SetPosting *p1 = *(const SetPosting **) a;
+  const SetPosting *p2 = *(const SetPosting **) b;
+  return (p1->count > p2->count) - (p1->count < p2->count);
+}
+
+/**
+ * @brief Collect the sets appearing in all the posting lists
+ * @details The posting lists are intersected by leapfrogging from the
+ * shortest one: every other posting list seeks the current candidate, and a
+ * posting list that overshoots it gives the next candidate
+ */
+static void
+setindex_intersect(const SetIndex *sindex, const SetPosting **postings,
+  int count, MeosArray *result)
+{
+  qsort(postings, (size_t) count, sizeof(SetPosting *), posting_count_cmp);
+  SetPostingIter *its = palloc(sizeof(SetPostingIter) * count);
+  for (int i = 0; i < count; i++)
+    posting_iter_init(&its[i], postings[i]);
+  while (its[0].doc != SETINDEX_END)
+  {
+    int32 doc = its[0].doc;
+    bool all = true;
+    for (int i = 1; i < count; i++)
+    {
+      posting_iter_seek(&its[i], doc);
+      if (its[i].doc != doc)
+      {
+        all = false;
+        doc = its[i].doc;
+        break;
+      }
+    }
+    if (all)
+    {
+      meos_array_add(result, (void *) &sindex->ids[doc]);
+      posting_iter_next(&its[0]);
+    }
+    else
+      posting_iter_seek(&its[0], doc);
+  }
+  pfree(its);
+  return;
+}
+
+/**
+ * @brief Collect the sets appearing in at least one of the posting lists, or
+ * in as many of them as they have elements when @p contained is true
+ * @details The documents of the posting lists are merged by sorting them, so
+ * that the number of posting lists in which a set appears is the length of
+ * its run
+ */
+static void
+setindex_union(const SetIndex *sindex, const SetPosting **postings,
+  int count, bool contained, MeosArray *result)
+{
+  int total = 0;
+  for (int i = 0; i < count; i++)
+    total += postings[i]->count;
+  int32 *docs = palloc(sizeof(int32) * Max(total, 1));
+  int n = 0;
+  for (int i = 0; i < count; i++)
+  {
+    SetPostingIter it;
+    for (posting_iter_init(&it, postings[i]); it.doc != SETINDEX_END;
+        posting_iter_next(&it))
+      docs[n++] = it.doc;
+  }
+  qsort(docs, (size_t) n, sizeof(int32), doc_cmp);
+  for (int i = 0; i < n; )
+  {
+    int j = i + 1;
+    while (j < n && docs[j] == docs[i])
+      j++;
+    if (! contained || j - i == sindex->sizes[docs[i]])
+      meos_array_add(result, (void *) &sindex->ids[docs[i]]);
+    i = j;
+  }
+  pfree(docs);
+  return;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Search an in-memory inverted index with a set, collecting the ids of
+ * the matching sets into a MeosArray
+ * @details The ids are collected in the order of insertion of the sets. A
+ * search of the sets containing a value is a search of the sets containing
+ * the singleton set of the value. The result array is reset before the
+ * search.
+ * @param[in] sindex The index to query
+ * @param[in] op The search operation: @p RTREE_OVERLAPS finds the sets that
+ * overlap the query, @p RTREE_CONTAINS the sets that contain the query, and
+ * @p RTREE_CONTAINED_BY the sets contained by the query
+ * @param[in] query The set that serves as query
+ * @param[out] result MeosArray of int to collect matching ids (created by the
+ * caller with `meos_array_create(sizeof(int64))`)
+ * @return Number of matching ids, -1 on error
+ */
+int
+setindex_search(const SetIndex *sindex, RTreeSearchOp op, const Set *query,
+  MeosArray *result)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(sindex, -1); VALIDATE_NOT_NULL(query, -1);
+  VALIDATE_NOT_NULL(result, -1);
+  meos_array_reset(result);
+  if (! sindex->sample)
+    return 0;
+  if (! ensure_valid_set_set(sindex->sample, query))
+    return -1;
+
+  /* Posting lists of the elements of the query that are in the index */
+  const SetPosting **postings = palloc(sizeof(SetPosting *) * query->count);
+  int count = 0;
+  for (int i = 0; i < query->count; i++)
+  {
+    Datum value = SET_VAL_N(query, i);
+    int k = setindex_find(sindex, value,
+      datum_hash(value, sindex->sample->basetype));
+    if (k >= 0)
+      postings[count++] = &sindex->postings[k];
+    else if (op == RTREE_CONTAINS)
+    {
+      /* No set contains an element that is not in the index */
+      count = 0;
+      break;
+    }
+  }
+  if (count > 0)
+  {
+    if (op == RTREE_CONTAINS)
+      setindex_intersect(sindex, postings, count, result);
+    else
+      setindex_union(sindex, postings, count, op == RTREE_CONTAINED_BY,
+        result);
+  }
+  pfree(postings);
+  return meos_array_count(result);
+}
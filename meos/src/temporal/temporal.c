@@ -50,7 +50,9 @@
 #include "temporal/doxygen_meos.h"
 #include "temporal/lifting.h"
 #include <pgtypes.h>
+#include "temporal/span.h"
 #include "temporal/temporal_boxops.h"
+#include "temporal/temporal_restrict.h"
 #include "temporal/temporal_tile.h"
 #include "temporal/tinstant.h"
 #include "temporal/tsequence.h"
@@ -3461,6 +3463,29 @@ tnumber_integral(const Temporal *temp)
   }
 }
 
+/**
+ * @ingroup meos_temporal_accessor
+ * @brief Return the integral (area under the curve) of a temporal number
+ * restricted to a timestamptz span
+ * @details The result is equal to the integral of the result of
+ * #temporal_at_tstzspan but the restriction is not constructed, the integral
+ * is computed on views of the composing sequences of the temporal number
+ * @param[in] temp Temporal value
+ * @param[in] s Timestamp span
+ * @return On error return @p DBL_MAX
+ */
+double
+tnumber_integral_at_tstzspan(const Temporal *temp, const Span *s)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_TNUMBER(temp, DBL_MAX); VALIDATE_TSTZSPAN(s, DBL_MAX);
+
+  assert(temptype_subtype(temp->subtype));
+  if (temp->subtype == TINSTANT || MEOS_FLAGS_DISCRETE_INTERP(temp->flags))
+    return 0.0;
+  return tcontseq_at_tstzspan_view_sum(temp, s, &tnumberseqview_integral);
+}
+
 /**
  * @ingroup meos_temporal_accessor
  * @brief Return the time-weighted average of a temporal number
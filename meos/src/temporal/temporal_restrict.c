@@ -2432,46 +2432,41 @@ tcontseq_minus_tstzset_iter(const TSequence *seq, const Set *s,
 
   /* General case */
   interpType interp = MEOS_FLAGS_GET_INTERP(seq->flags);
-  TInstant **instants = palloc(sizeof(TInstant *) * seq->count);
-  TInstant **tofree = palloc(sizeof(TInstant *) * Min(s->count, seq->count));
+  MeosType basetype = temptype_basetype(seq->temptype);
+  TSequenceBuilder builder;
+  tsequencebuilder_init(&builder, seq->temptype, interp, seq->count,
+    NORMALIZE_NO);
   bool lower_inc = seq->period.lower_inc;
   int i = 0,    /* current instant of the argument sequence */
     j = 0,      /* current timestamp of the argument timestamp set */
-    nseqs = 0,  /* current number of new sequences */
-    ninsts = 0, /* number of instants in the currently constructed sequence */
-    nfree = 0;  /* number of instants to free */
+    nseqs = 0;  /* current number of new sequences */
   while (i < seq->count && j < s->count)
   {
     const TInstant *inst = TSEQUENCE_INST_N(seq, i);
     TimestampTz t = DatumGetTimestampTz(SET_VAL_N(s, j));
+    /* Last instant of the currently constructed sequence, if any */
+    const TInstant *last = tsequencebuilder_last(&builder);
     Datum value;
     if (inst->t < t)
     {
-      instants[ninsts++] = (TInstant *) inst;
+      tsequencebuilder_append(&builder, tinstant_value_p(inst), inst->t);
       i++; /* advance instants */
     }
     else if (inst->t == t)
     {
       /* Close the current sequence */
-      if (ninsts > 0)
+      if (last)
       {
-        if (interp == LINEAR)
-          instants[ninsts++] = (TInstant *) inst;
-        else /* interp == STEP */
-        {
-          /* Take the value of the previous instant */
-          value = tinstant_value_p(instants[ninsts - 1]);
-          instants[ninsts] = tinstant_make(value, inst->temptype, inst->t);
-          tofree[nfree++] = instants[ninsts++];
-        }
-        result[nseqs++] = tsequence_make(instants, ninsts, lower_inc, false,
-          interp, NORMALIZE_NO);
-        ninsts = 0;
+        /* For step interpolation take the value of the previous instant */
+        value = (interp == LINEAR) ?
+          tinstant_value_p(inst) : tinstant_value_p(last);
+        tsequencebuilder_append(&builder, value, inst->t);
+        result[nseqs++] = tsequencebuilder_finish(&builder, lower_inc, false);
       }
       /* If it is not the last instant start a new sequence */
       if (i < seq->count - 1)
       {
-        instants[ninsts++] = (TInstant *) inst;
+        tsequencebuilder_append(&builder, tinstant_value_p(inst), inst->t);
         lower_inc = false;
       }
       i++; /* advance instants */
@@ -2479,45 +2474,35 @@ tcontseq_minus_tstzset_iter(const TSequence *seq, const Set *s,
     }
     else /* inst->t > t */
     {
-      if (ninsts > 0)
+      if (last)
       {
         /* Close the current sequence */
         if (interp == LINEAR)
-        {
           /* Interpolate */
-          Datum startvalue = tinstant_value_p(instants[ninsts - 1]);
-          Datum endvalue = tinstant_value_p(inst);
-          value = tsegment_value_at_timestamptz(startvalue, endvalue,
-            inst->temptype, instants[ninsts - 1]->t, inst->t, t);
-        }
+          value = tsegment_value_at_timestamptz(tinstant_value_p(last),
+            tinstant_value_p(inst), inst->temptype, last->t, inst->t, t);
         else
           /* Take the value of the previous instant */
-          value = tinstant_value_p(instants[ninsts - 1]);
-        instants[ninsts] = tinstant_make(value, inst->temptype, t);
-        tofree[nfree] = instants[ninsts++];
-        result[nseqs++] = tsequence_make(instants, ninsts, lower_inc, false,
-          interp, NORMALIZE_NO);
+          value = datum_copy(tinstant_value_p(last), basetype);
+        tsequencebuilder_append(&builder, value, t);
+        result[nseqs++] = tsequencebuilder_finish(&builder, lower_inc, false);
         /* Restart a new sequence */
-        instants[0] = tofree[nfree++];
-        ninsts = 1;
+        tsequencebuilder_append(&builder, value, t);
+        DATUM_FREE(value, basetype);
         lower_inc = false;
       }
       j++; /* advance timestamps */
     }
   }
   /* Compute the sequence after the timestamp set */
-  if (i < seq->count)
+  for (; i < seq->count; i++)
   {
-    for (j = i; j < seq->count; j++)
-      instants[ninsts++] = (TInstant *) TSEQUENCE_INST_N(seq, j);
-  }
-  if (ninsts > 0)
-  {
-    result[nseqs++] = tsequence_make(instants, ninsts, lower_inc,
-      seq->period.upper_inc, interp, NORMALIZE_NO);
+    const TInstant *inst = TSEQUENCE_INST_N(seq, i);
+    tsequencebuilder_append(&builder, tinstant_value_p(inst), inst->t);
   }
-  pfree_array((void **) tofree, nfree);
-  pfree(instants);
+  if (tsequencebuilder_last(&builder))
+    result[nseqs++] = tsequencebuilder_finish(&builder, lower_inc,
+      seq->period.upper_inc);
   return nseqs;
 }
 
@@ -2537,45 +2522,62 @@ tcontseq_minus_tstzset(const TSequence *seq, const Set *s)
 /*****************************************************************************/
 
 /**
- * @brief Restrict a continuous temporal sequence to a timestamptz span
+ * @brief Set a view of a continuous temporal sequence restricted to a
+ * timestamptz span
+ * @details The view points to the instants of the sequence located inside
+ * the span, only the instants at the bounds of the span are constructed.
+ * This avoids copying all the instants of the sequence when the restriction
+ * is passed to a read-only function such as #tnumberseqview_integral.
+ * @param[in] seq Temporal sequence
+ * @param[in] s Span
+ * @param[out] view Result, whose constructed instants are freed with
+ * #tsequenceview_free
+ * @return Return false if the sequence and the span do not overlap
  */
-TSequence *
-tcontseq_at_tstzspan(const TSequence *seq, const Span *s)
+bool
+tcontseq_at_tstzspan_view(const TSequence *seq, const Span *s,
+  TSequenceView *view)
 {
-  assert(seq); assert(s);
+  assert(seq); assert(s); assert(view);
   assert(MEOS_FLAGS_GET_INTERP(seq->flags) != DISCRETE);
 
   /* Bounding box test */
   Span inter;
   if (! inter_span_span(&seq->period, s, &inter))
-    return NULL;
+    return false;
 
   /* Instantaneous sequence */
   if (seq->count == 1)
-    return tsequence_copy(seq);
+  {
+    tsequenceview_set(seq, 0, 0, true, true, view);
+    return true;
+  }
 
   /* General case */
   interpType interp = MEOS_FLAGS_GET_INTERP(seq->flags);
-  TSequence *result;
+  view->seq = seq;
+  view->period = inter;
   /* Intersecting period is instantaneous */
   if (inter.lower == inter.upper)
   {
-    TInstant *inst = tcontseq_at_timestamptz(seq, inter.lower);
-    result = tinstant_as_tsequence(inst, interp);
-    pfree(inst);
-    return result;
+    view->start = tcontseq_at_timestamptz(seq, inter.lower);
+    view->end = NULL;
+    view->from = 0;
+    view->count = 1;
+    return true;
   }
 
   int n = tcontseq_find_timestamptz(seq, inter.lower);
   /* If the lower bound of the intersecting period is exclusive */
   if (n == -1)
     n = 0;
-  TInstant **instants = palloc(sizeof(TInstant *) * (seq->count - n));
   /* Compute the value at the beginning of the intersecting period */
   const TInstant *inst1 = TSEQUENCE_INST_N(seq, n);
   const TInstant *inst2 = TSEQUENCE_INST_N(seq, n + 1);
-  instants[0] = tsegment_at_timestamptz(inst1, inst2, interp, inter.lower);
-  int ninsts = 1;
+  view->start = tsegment_at_timestamptz(inst1, inst2, interp, inter.lower);
+  view->from = n + 1;
+  /* Number of instants of the sequence that are in the view */
+  int ninsts = 0;
   for (int i = n + 2; i < seq->count; i++)
   {
     /* If the end of the intersecting period is between inst1 and inst2 */
@@ -2588,25 +2590,94 @@ tcontseq_at_tstzspan(const TSequence *seq, const Span *s)
     /* If the intersecting period contains inst1 */
     if (DatumGetTimestampTz(inter.lower) <= inst1->t &&
         inst1->t <= DatumGetTimestampTz(inter.upper))
-      instants[ninsts++] = (TInstant *) inst1;
+      ninsts++;
   }
   /* The last two values of sequences with step interpolation and
    * exclusive upper bound must be equal */
   if (interp == LINEAR || inter.upper_inc)
-    instants[ninsts++] = tsegment_at_timestamptz(inst1, inst2, interp,
-      inter.upper);
+    view->end = tsegment_at_timestamptz(inst1, inst2, interp, inter.upper);
   else
   {
-    Datum value = tinstant_value_p(instants[ninsts - 1]);
-    instants[ninsts++] = tinstant_make(value, seq->temptype, inter.upper);
+    const TInstant *last = ninsts ?
+      TSEQUENCE_INST_N(seq, view->from + ninsts - 1) : view->start;
+    view->end = tinstant_make(tinstant_value_p(last), seq->temptype,
+      inter.upper);
   }
-  /* Since by definition the sequence is normalized it is not necessary to
-   * normalize the projection of the sequence to the period */
-  result = tsequence_make(instants, ninsts, inter.lower_inc, inter.upper_inc,
-    interp, NORMALIZE_NO);
+  view->count = ninsts + 2;
+  return true;
+}
 
-  pfree(instants[0]); pfree(instants[ninsts - 1]); pfree(instants);
+/**
+ * @brief Return the sum of a function applied to the views of the composing
+ * sequences of a continuous temporal sequence (set) restricted to a
+ * timestamptz span
+ * @param[in] temp Temporal sequence (set) with continuous interpolation
+ * @param[in] s Span
+ * @param[in] func Function applied to the views
+ * @note The result is 0 when the temporal value and the span do not overlap
+ */
+double
+tcontseq_at_tstzspan_view_sum(const Temporal *temp, const Span *s,
+  double (*func)(const TSequenceView *))
+{
+  assert(temp); assert(s); assert(func);
+  assert(temp->subtype == TSEQUENCE || temp->subtype == TSEQUENCESET);
+  assert(MEOS_FLAGS_GET_INTERP(temp->flags) != DISCRETE);
+  double result = 0.0;
+  TSequenceView view;
+  if (temp->subtype == TSEQUENCE)
+  {
+    if (tcontseq_at_tstzspan_view((const TSequence *) temp, s, &view))
+    {
+      result = func(&view);
+      tsequenceview_free(&view);
+    }
+    return result;
+  }
 
+  const TSequenceSet *ss = (const TSequenceSet *) temp;
+  /* Bounding box test */
+  if (! overlaps_span_span(&ss->period, s))
+    return result;
+  int loc;
+  tsequenceset_find_timestamptz(ss, DatumGetTimestampTz(s->lower), &loc);
+  for (int i = loc; i < ss->count; i++)
+  {
+    const TSequence *seq = TSEQUENCESET_SEQ_N(ss, i);
+    if (! tcontseq_at_tstzspan_view(seq, s, &view))
+    {
+      /* The sequence is after the span */
+      if (DatumGetTimestampTz(seq->period.lower) >=
+          DatumGetTimestampTz(s->upper))
+        break;
+      continue;
+    }
+    result += func(&view);
+    tsequenceview_free(&view);
+  }
+  return result;
+}
+
+/**
+ * @brief Restrict a continuous temporal sequence to a timestamptz span
+ */
+TSequence *
+tcontseq_at_tstzspan(const TSequence *seq, const Span *s)
+{
+  assert(seq); assert(s);
+  assert(MEOS_FLAGS_GET_INTERP(seq->flags) != DISCRETE);
+
+  /* Instantaneous sequence */
+  if (seq->count == 1)
+    return overlaps_span_span(&seq->period, s) ? tsequence_copy(seq) : NULL;
+
+  TSequenceView view;
+  if (! tcontseq_at_tstzspan_view(seq, s, &view))
+    return NULL;
+  /* Since by definition the sequence is normalized it is not necessary to
+   * normalize the projection of the sequence to the period */
+  TSequence *result = tsequenceview_to_tsequence(&view);
+  tsequenceview_free(&view);
   return result;
 }
 
@@ -34,8 +34,33 @@
  */
 
 /* C */
+#include <float.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stdio.h>
+#if MEOS
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+#if MEOS && ! defined(NO_PTHREAD)
+  #include <pthread.h>
+#endif
+/* Vector instructions for the nodes with the RTREE_LAYOUT_AXES layout, AVX2
+ * being selected at run time and NEON being part of the AArch64 baseline */
+#if defined(__x86_64__) && defined(__GNUC__)
+  #define RTREE_AVX2 1
+  #include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  #define RTREE_NEON 1
+  #include <arm_neon.h>
+#endif
+/* PostgreSQL */
+#include <postgres.h>
+#include "port/pg_bitutils.h"
+#include <utils/float.h>
+#include <utils/timestamp.h>
 /* MEOS */
 #include <meos.h>
 #include <meos_geo.h>
@@ -48,6 +73,7 @@
 #include "temporal/span.h"
 #include "temporal/tbox.h"
 #include "temporal/temporal.h"
+#include "temporal/temporal_tile.h"
 #include "temporal/type_util.h"
 #include "temporal/temporal_rtree.h"
 
@@ -330,978 +356,3577 @@ bbox_overlaps_tpcbox(const void *box1, const void *box2)
  *****************************************************************************/
 
 /**
- * @brief Creates a new RTree node
- * @param[in] node_type Type of the node
- * @param[in] bboxsize Bounding box size 
- * @return Pointer to the newly created node
+ * @brief Return the size of a node of an RTree with a given layout
+ * @details A node with the @p RTREE_LAYOUT_AXES layout also holds two arrays
+ * of bounds per axis after the bounding boxes, while a node with a quantized
+ * layout holds its own bounding box followed by two arrays of codes per axis
  */
-static RTreeNode *
-node_make(RTreeNodeType node_type, size_t bboxsize)
+static size_t
+node_size_layout(const RTree *rtree, RTreeLayout layout)
 {
-  size_t bboxes_size = bboxsize * MAXITEMS;
-  RTreeNode *node = palloc0(sizeof(RTreeNode) + bboxes_size);
-  node->node_type = node_type;
-  node->bboxsize = bboxsize;
-  node->count = 0;
-  return node;
+  size_t naxes = 2 * (size_t) Max(rtree->dims, 0) * rtree->maxitems;
+  if (layout == RTREE_LAYOUT_QUANT8 || layout == RTREE_LAYOUT_QUANT16)
+    return sizeof(RTreeNode) + rtree->bboxsize + naxes *
+      (layout == RTREE_LAYOUT_QUANT8 ? sizeof(uint8) : sizeof(uint16));
+  size_t size = sizeof(RTreeNode) + rtree->maxitems * rtree->bboxsize;
+  if (layout == RTREE_LAYOUT_AXES)
+    size += naxes * sizeof(double);
+  return size;
 }
 
 /**
- * @brief Return the length of a bounding box along a given axis as a double
- * @param[in] rtree Pointer to the RTree structure containing the function to
- * retrieve axis values
- * @param[in] box Pointer to the bounding box for which the axis length is to
- * be calculated
- * @param[in] axis The given axis (e.g., 0, 1, 2) along which to compute the
- * length
+ * @brief Return the size of a node of an RTree
  */
-static inline double
-get_axis_length(const RTree *rtree, const void *box, int axis)
+static size_t
+rtree_node_size(const RTree *rtree)
 {
-  return rtree->get_axis(box, axis, true) - rtree->get_axis(box, axis, false);
+  return node_size_layout(rtree, rtree->layout);
 }
 
+/*****************************************************************************
+ * Copy-on-write of the nodes of a concurrent RTree
+ *****************************************************************************/
+
 /**
- * @brief Return the length, area, or volume of a bounding box
- * @details The function iterates over all dimensions defined in the RTree
- * multiplying the lengths of the box along each axis
- * @param[in] rtree Pointer to the RTree structure, which provides the number
- * of dimensions and the method for retrieving axis lengths
- * @param[in] box Pointer to the bounding box
+ * @brief Retire a node or a version of a concurrent RTree replaced in the
+ * current epoch
  */
-static double
-box_area(const RTree *rtree, const void *box)
+static void
+rtree_retire(RTreeShared *shared, void *ptr)
 {
-  double result = 1.0;
-  for (int i = 0; i < rtree->dims; ++i)
-    result *= get_axis_length(rtree, box, i);
-  return result;
+  if (shared->nretired == shared->retiredcap)
+  {
+    shared->retiredcap = shared->retiredcap ? shared->retiredcap * 2 : 64;
+    shared->retired = shared->retired ?
+      repalloc(shared->retired, sizeof(RTreeRetired) * shared->retiredcap) :
+      palloc(sizeof(RTreeRetired) * shared->retiredcap);
+  }
+  shared->retired[shared->nretired].ptr = ptr;
+  shared->retired[shared->nretired++].epoch =
+    __atomic_load_n(&shared->epoch, __ATOMIC_SEQ_CST);
+  return;
 }
 
 /**
- * @brief Return the length, area, or volume of the union of two bounding
- * boxes
- * @details The function first creates a new bounding box that is the union of
- * the two input boxes, then calculates the length, area, or volume of this
- * union box using the given RTree's dimensions
- * @param[in] box1,box2 Pointers to the bounding boxes
- * @param[in] rtree Pointer to the RTree structure, which provides the number
- * of dimensions and the method for the computation
+ * @brief Record a node that the insertion in progress into a concurrent RTree
+ * created or copied
  */
-static double
-unioned_area(const RTree *rtree, const void *box1, const void *box2)
+static void
+rtree_own(RTreeShared *shared, RTreeNode *node)
 {
-  /* Use a stack buffer large enough for any MEOS bounding box type */
-  char union_buf[sizeof(STBox)];
-  memcpy(union_buf, box1, rtree->bboxsize);
-  rtree->bbox_expand(box2, union_buf);
-  return box_area(rtree, union_buf);
+  if (shared->nowned == shared->ownedcap)
+  {
+    shared->ownedcap = shared->ownedcap ? shared->ownedcap * 2 : 16;
+    shared->owned = shared->owned ?
+      repalloc(shared->owned, sizeof(RTreeNode *) * shared->ownedcap) :
+      palloc(sizeof(RTreeNode *) * shared->ownedcap);
+  }
+  shared->owned[shared->nowned++] = node;
+  return;
 }
 
 /**
- * @brief Return the child node that requires the least enlargement to
- * accommodate a new bounding box
- * @details The function iterates through the child nodes of a given node to
- * determine which child node's bounding box would need the least enlargement
- * to include a new bounding box. The function calculates the area of each
- * node's bounding box before and after union with the new bounding box and
- * selects the one with the smallest area increase.
- * @param[in] node Pointer to the node containing the child nodes
- * @param[in] box Pointer to the bounding box that is being inserted
- * or considered
- * @param[in] rtree Pointer to the RTree structure, which provides the method
- * for calculating areas
- * @return The index of the child node that requires the least enlargement
+ * @brief Return a node of a concurrent RTree that the insertion in progress
+ * may modify
+ * @details This is the node itself when the insertion created or copied it.
+ * Otherwise the node may be read by the snapshots, so it is copied and
+ * retired, since the next version of the tree reaches the copy instead.
  */
-static int
-node_choose_least_enlargement(const RTree *rtree, const RTreeNode *node,
-  const void *box)
+static RTreeNode *
+node_cow(const RTree *rtree, RTreeNode *node)
 {
-  int result = 0;
-  double previous_enlargement = INFINITY;
-  for (int i = 0; i < node->count; ++i)
+  RTreeShared *shared = rtree->shared;
+  for (int i = 0; i < shared->nowned; i++)
   {
-    double union_area = unioned_area(rtree, RTREE_NODE_BBOX_N(node, i), box);
-    double area = box_area(rtree, RTREE_NODE_BBOX_N(node, i));
-    double enlarge_area = union_area - area;
-    if (enlarge_area < previous_enlargement)
-    {
-      result = i;
-      previous_enlargement = enlarge_area;
-    }
+    if (shared->owned[i] == node)
+      return node;
   }
-  return result;
+  size_t size = rtree_node_size(rtree);
+  RTreeNode *copy = palloc(size);
+  memcpy(copy, node, size);
+  rtree_retire(shared, node);
+  rtree_own(shared, copy);
+  return copy;
 }
 
 /**
- * @brief Returns the best child node for inserting a new bounding box in an
- * RTree
- * @details The function determines the most suitable child node within a node
- * for inserting a new bounding box. It first checks if the new box can be
- * added to any child node without requiring the expansion of its bounding box.
- * If none of the child nodes can accommodate the new bounding box without
- * expansion, the function falls back to selecting the node that requires the
- * least enlargement.
- * @param[in] rtree Pointer to the RTree structure, providing access to the
- * overall RTree configuration
- * @param[in] box Pointer to the bounding box that is being inserted
- * @param[in] node Pointer to the node containing the child nodes
- * @return The index of the chosen child node for insertion
+ * @brief Free the retired nodes and versions of a concurrent RTree that no
+ * open snapshot can reach, or all of them when @p all is true
+ * @details A snapshot reaches the nodes of the version it read, which were
+ * retired at the earliest in the epoch it announced
  */
-static int
-node_choose(const RTree *rtree, const void *box, const RTreeNode *node)
+static void
+rtree_reclaim(RTreeShared *shared, bool all)
 {
-  /* Check if the bounding box can be added without expanding any rectangle */
-  for (int i = 0; i < node->count; ++i)
+  uint64 oldest = __atomic_load_n(&shared->epoch, __ATOMIC_SEQ_CST);
+  for (int i = 0; i < RTREE_MAX_SNAPSHOTS; i++)
   {
-    if (rtree->bbox_contains(RTREE_NODE_BBOX_N(node, i), box))
-      return i;
+    uint64 epoch = __atomic_load_n(&shared->slots[i], __ATOMIC_SEQ_CST);
+    if (epoch && epoch < oldest)
+      oldest = epoch;
   }
-  /* Fallback to "least enlargement" */
-  return node_choose_least_enlargement(rtree, node, box);
+  int n = 0;
+  for (int i = 0; i < shared->nretired; i++)
+  {
+    if (all || shared->retired[i].epoch < oldest)
+      pfree(shared->retired[i].ptr);
+    else
+      shared->retired[n++] = shared->retired[i];
+  }
+  shared->nretired = n;
+  return;
 }
 
 /**
- * @brief Return the bounding box that encloses all bounding boxes in an RTree
- * node
- * @details The function takes the destination bounding box and change it to the
- * minimal bounding box enclosing all bounding boxes within a given RTree node
- * @param[in] rtree Pointer to the RTree structure
- * @param[in] node Pointer to the node containing the bounding boxes
- * @param[out] box bounding box that will be expanded
+ * @brief Publish the version of a concurrent RTree left by an insertion
+ * @details The version is a copy of the structure of the tree, which the new
+ * snapshots read instead of the tree that the writer modifies. A new epoch is
+ * then opened, and the nodes and versions that the snapshots can no longer
+ * reach are freed.
  */
 static void
-node_box_calculate(const RTree *rtree, const RTreeNode *node, void *box)
+rtree_publish(RTree *rtree)
 {
-  memcpy(box, RTREE_NODE_BBOX_N(node, 0), rtree->bboxsize);
-  for (int i = 1; i < node->count; ++i)
-    rtree->bbox_expand(RTREE_NODE_BBOX_N(node, i), box);
+  RTreeShared *shared = rtree->shared;
+  size_t size = sizeof(RTree) + rtree->bboxsize;
+  RTree *version = palloc(size);
+  memcpy(version, rtree, size);
+  version->shared = NULL;
+  RTree *old = __atomic_exchange_n(&shared->current, version,
+    __ATOMIC_SEQ_CST);
+  if (old)
+    rtree_retire(shared, old);
+  shared->nowned = 0;
+  __atomic_add_fetch(&shared->epoch, 1, __ATOMIC_SEQ_CST);
+  rtree_reclaim(shared, false);
   return;
 }
 
+/*****************************************************************************/
+
 /**
- * @brief Return the axis with the largest length in a bounding box
- * @details The function determines the axis of a bounding box that has the
- * largest length by comparing the lengths of the bounding box along each
- * dimension defined in the RTree
- * @param[in] box Pointer to the bounding box whose largest axis is to be
- * determined.
- * @param[in] rtree Pointer to the RTree structure, which provides the method
- * for calculating axis lengths and defines the number of dimensions.
- * @return The index of the axis with the largest length.
+ * @brief Creates a new RTree node
+ * @param[in] rtree The RTree, whose dimensions must be known
+ * @param[in] node_type Type of the node
+ * @return Pointer to the newly created node
  */
-static int
-box_largest_axis(const RTree *rtree, const void *box)
+static RTreeNode *
+node_make(const RTree *rtree, RTreeNodeType node_type)
 {
-  int largest_axis = 0;
-  double previous_largest = get_axis_length(rtree, box, 0);
-  for (int i = 1; i < rtree->dims; ++i)
-  {
-    if (previous_largest < get_axis_length(rtree, box, i))
-    {
-      previous_largest = get_axis_length(rtree, box, i);
-      largest_axis = i;
-    }
-  }
-  return largest_axis;
+  RTreeNode *node = palloc0(rtree_node_size(rtree));
+  node->node_type = node_type;
+  node->bboxsize = rtree->bboxsize;
+  node->count = 0;
+  /* The insertion into a concurrent tree may modify the nodes it creates */
+  if (rtree->shared)
+    rtree_own(rtree->shared, node);
+  return node;
 }
 
 /**
- * @brief Moves a bounding box from one RTree node to another.
- * @details Changes the information from one node into another.
- * @param[in] from Pointer to the node from which the bounding box is
- * being moved.
- * @param[in] index The index of the bounding box in the `from` node that is to
- * be moved.
- * @param[in] into Pointer to the node where the bounding box is being moved
- * to.
+ * @brief Frees the memory allocated for an RTree node
+ * @details The function recursively frees the memory of an RTree node.
+ * If the node is a branch node, it first recursively frees all child nodes.
+ * After handling the child nodes, it frees the memory allocated for the
+ * bounding boxes and the arrays of boxes and child nodes within the current
+ * node. Finally, it frees the memory allocated for the node itself.
+ * @param[in] node Pointer to the node to be freed
  */
 static void
-node_move_box_at_index_into(RTreeNode *from, int index, RTreeNode *into)
+node_free(RTreeNode *node)
 {
-  memcpy(RTREE_NODE_BBOX_N(into, into->count), RTREE_NODE_BBOX_N(from, index),
-    from->bboxsize);
-  memcpy(RTREE_NODE_BBOX_N(from, index),
-    RTREE_NODE_BBOX_N(from, from->count - 1), from->bboxsize);
-  if (from->node_type == RTREE_LEAF)
-  {
-    into->ids[into->count] = from->ids[index];
-    from->ids[index] = from->ids[from->count - 1];
-  }
-  else
+  if (node->node_type == RTREE_INNER)
   {
-    into->nodes[into->count] = from->nodes[index];
-    from->nodes[index] = from->nodes[from->count - 1];
+    for (int i = 0; i < node->count; ++i)
+      node_free(node->nodes[i]);
   }
-  from->count--;
-  into->count++;
-  return;
+  pfree(node);
 }
 
 /**
- * @brief Swaps two bounding boxes and their associated data within an RTree node.
- * @details The function exchanges the positions of two bounding boxes within a
- * single RTree node. If the node is a leaf, it also swaps the associated IDs.
- * For internal nodes, it swaps the pointers to child nodes. The function is
- * useful for reordering elements within a node.
- * @param[in] rtree Pointer to the RTree structure
- * @param[in,out] node Pointer to the node containing the
- * bounding boxes and associated data.
- * @param[in] i The index of the first bounding box to be swapped.
- * @param[in] j The index of the second bounding box to be swapped.
+ * @brief Ensure that an RTree can be modified, i.e., that it is not mapped
+ * read-only from a file by #rtree_open
  */
-static void
-node_swap(const RTree *rtree, RTreeNode *node, int i, int j)
+static bool
+ensure_rtree_not_mapped(const RTree *rtree)
 {
-  /* Use a stack buffer large enough for any MEOS bounding box type */
-  char buf[sizeof(STBox)];
-  memcpy(buf, RTREE_NODE_BBOX_N(node, i), rtree->bboxsize);
-  memcpy(RTREE_NODE_BBOX_N(node, i), RTREE_NODE_BBOX_N(node, j),
-    rtree->bboxsize);
-  memcpy(RTREE_NODE_BBOX_N(node, j), buf, rtree->bboxsize);
-  if (node->node_type == RTREE_LEAF)
+  if (! rtree->base)
+    return true;
+  meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+    "An RTree opened from a file cannot be modified");
+  return false;
+}
+
+/**
+ * @brief Ensure that an RTree stores exact bounding boxes, i.e., that its
+ * nodes do not have a quantized layout
+ */
+static bool
+ensure_rtree_not_quantized(const RTree *rtree)
+{
+  if (! RTREE_QUANTIZED(rtree))
+    return true;
+  meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+    "The operation is not supported by an RTree with quantized nodes");
+  return false;
+}
+
+/**
+ * @brief Ensure that an RTree is not in the concurrent mode, in which only
+ * insertions are supported
+ */
+static bool
+ensure_rtree_not_concurrent(const RTree *rtree)
+{
+  if (! rtree->shared)
+    return true;
+  meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+    "The operation is not supported by an RTree in the concurrent mode");
+  return false;
+}
+
+/*****************************************************************************
+ * Per-axis node layout
+ *
+ * With the @p RTREE_LAYOUT_AXES layout a node stores, besides its array of
+ * bounding boxes, the lower and the upper bounds of its entries on every axis
+ * as contiguous arrays of doubles. A search then tests an axis of all the
+ * entries of a node at once with vector instructions, obtaining a bitmask of
+ * the entries that may qualify, instead of calling the box predicate through
+ * a function pointer for each entry. Since the bounds are converted to double
+ * and compared as closed intervals, the mask is a superset of the qualifying
+ * entries, which are then confirmed with the predicate of the box type. An
+ * axis that a stored box does not have is stored with a lower bound greater
+ * than the upper one, and neither this axis of the entry nor an axis that the
+ * query does not have is tested, as done by the predicates. The arrays are
+ * kept up to date by #node_set_axes and #node_sync_axes whenever the boxes of
+ * a node change.
+ *****************************************************************************/
+
+/* Maximum number of axes of a bounding box */
+#define RTREE_MAX_AXES 4
+
+/**
+ * @brief Return a span bound as a double
+ */
+static inline double
+bound_double(Datum d, MeosType basetype)
+{
+  if (basetype == T_TIMESTAMPTZ)
+    return (double) DatumGetTimestampTz(d);
+  return datum_double(d, basetype);
+}
+
+/**
+ * @brief Get the bounds of a bounding box on an axis, in the axis order of
+ * the @p get_axis function of the RTree
+ * @return False if the box does not have the axis
+ */
+static bool
+bbox_axis_bounds(const RTree *rtree, const void *box, int axis, double *lower,
+  double *upper)
+{
+  const Span *span = NULL;
+  if (span_type(rtree->bboxtype))
+    span = (const Span *) box;
+  else if (rtree->bboxtype == T_TBOX)
   {
-    int64 tmp = node->ids[i];
-    node->ids[i] = node->ids[j];
-    node->ids[j] = tmp;
+    const TBox *tbox = (const TBox *) box;
+    if (axis == 0 && ! MEOS_FLAGS_GET_X(tbox->flags))
+      return false;
+    if (axis == 1 && ! MEOS_FLAGS_GET_T(tbox->flags))
+      return false;
+    span = (axis == 0) ? &tbox->span : &tbox->period;
   }
-  else
+  else /* T_STBOX or T_TPCBOX, which shares the STBox prefix layout */
   {
-    RTreeNode *tree = node->nodes[i];
-    node->nodes[i] = node->nodes[j];
-    node->nodes[j] = tree;
+    const STBox *stbox = (const STBox *) box;
+    if (axis == 2)
+    {
+      if (! MEOS_FLAGS_GET_T(stbox->flags))
+        return false;
+      span = &stbox->period;
+    }
+    else if (axis == 3)
+    {
+      if (! MEOS_FLAGS_GET_Z(stbox->flags))
+        return false;
+      *lower = stbox->zmin; *upper = stbox->zmax;
+      return true;
+    }
+    else
+    {
+      if (! MEOS_FLAGS_GET_X(stbox->flags))
+        return false;
+      *lower = (axis == 0) ? stbox->xmin : stbox->ymin;
+      *upper = (axis == 0) ? stbox->xmax : stbox->ymax;
+      return true;
+    }
   }
-  return;
+  *lower = bound_double(span->lower, span->basetype);
+  *upper = bound_double(span->upper, span->basetype);
+  return true;
 }
 
 /**
- * @brief Sort the bounding boxes within an RTree node using the QuickSort
- * algorithm
- * @details The function recursively sorts the bounding boxes within a given
- * range in an RTree node along a particular axis. It uses the QuickSort
- * algorithm to order the bounding boxes based on their axis values, either
- * upper or lower, as provided by the `get_axis` function in the RTree
- * structure.
- * @param[in] rtree Pointer to the RTree structure which provides the function
- * for retrieving axis values
- * @param[in,out] node Pointer to the node containing the bounding boxes to be
- * sorted
- * @param[in] index The axis index along which to sort the bounding boxes
- * @param[in] upper A Boolean indicating whether to sort by upper or lower
- * axis value
- * @param[in] s The starting index of the range to be sorted in the
- * `node->boxes` array
- * @param[in] e The ending index (exclusive) of the range to be sorted in the
- * `node->boxes` array
+ * @brief Store the bounds of the n-th entry of a node into its axis arrays
  */
 static void
-node_qsort(const RTree *rtree, RTreeNode *node, int index, bool upper, int s,
-  int e)
+node_set_axes(const RTree *rtree, RTreeNode *node, int n)
 {
-  int num_boxes = e - s;
-  if (num_boxes < 2)
+  if (rtree->layout != RTREE_LAYOUT_AXES)
     return;
-
-  int left = 0;
-  int right = num_boxes - 1;
-  int pivot = num_boxes / 2;
-  node_swap(rtree, node, s + pivot, s + right);
-  for (int i = 0; i < num_boxes; ++i)
+  double *axes = RTREE_NODE_AXES(rtree, node);
+  const void *box = RTREE_NODE_BBOX_N(node, n);
+  for (int a = 0; a < rtree->dims; a++)
   {
-    if (rtree->get_axis(RTREE_NODE_BBOX_N(node, right + s), index, upper) >
-        rtree->get_axis(RTREE_NODE_BBOX_N(node, s + i), index, upper))
+    double *lower = &axes[(2 * a) * rtree->maxitems + n];
+    double *upper = &axes[(2 * a + 1) * rtree->maxitems + n];
+    if (! bbox_axis_bounds(rtree, box, a, lower, upper))
     {
-      node_swap(rtree, node, s + i, s + left);
-      left++;
+      *lower = get_float8_infinity();
+      *upper = -get_float8_infinity();
     }
   }
-  node_swap(rtree, node, s + left, s + right);
-  node_qsort(rtree, node, index, upper, s, s + left);
-  node_qsort(rtree, node, index, upper, s + left + 1, e);
   return;
 }
 
 /**
- * @brief Sort the bounding boxes in an RTree node along a given axis using
- * QuickSort
- * @param[in] rtree Pointer to the RTree structure, which provides the function
- * for retrieving axis values
- * @param[in,out] node Pointer to the node containing the bounding boxes to be
- * sorted
- * @param[in] index The axis index along which to sort the bounding boxes
- * @param[in] upper A boolean that indicates whether to sort by the upper or
- * lower axis value
+ * @brief Store the bounds of all the entries of a node into its axis arrays
  */
 static void
-node_sort_axis(const RTree *rtree, RTreeNode *node, int index, bool upper)
+node_sync_axes(const RTree *rtree, RTreeNode *node)
 {
-  node_qsort(rtree, node, index, upper, 0, node->count);
+  if (rtree->layout != RTREE_LAYOUT_AXES)
+    return;
+  for (int i = 0; i < node->count; i++)
+    node_set_axes(rtree, node, i);
   return;
 }
 
 /**
- * @brief Splits an RTree node and redistributes its bounding boxes between two
- * nodes
- * @details The function splits an RTree node into two nodes by distributing
- * the bounding boxes based on the axis with the largest length. The bounding
- * boxes are moved to either the original node or a new right node, depending
- * on their position relative to the splitting axis. After the initial split,
- * the function ensures that both nodes have at least a minimum number of
- * bounding boxes by redistributing the bounding boxes if necessary. If the
- * node is a branch node, it also sorts both nodes by the first axis.
- * @param[in] rtree Pointer to the RTree structure, which provides methods for
- * retrieving axis values and determining dimensions
- * @param[in] node Pointer to the node to be split
- * @param[in] box Pointer to the bounding box used to guide the split
- * @param[out] right_out Pointer to a pointer where the new RTreeNode (right
- * node) will be stored
+ * @brief Return the bitmask of the entries whose bounds on an axis satisfy
+ * `lower <= a && upper >= b`, or `lower >= a && upper <= b` when @p inside is
+ * true, or that do not have the axis, i.e., `lower > upper`
+ * @param[in] lower,upper Arrays of bounds of the entries
+ * @param[in] count Number of entries
+ * @param[in] a,b Bounds of the query
+ * @param[in] inside True when testing that the entries are inside the query
  */
-static void
-node_split(RTree *rtree, RTreeNode *node, void *box, RTreeNode **right_out)
+static uint64
+axis_mask_scalar(const double *lower, const double *upper, int count,
+  double a, double b, bool inside)
 {
-  /* Split through the largest axis */
-  int largest_axis = box_largest_axis(rtree, box);
-  RTreeNode *right = node_make(node->node_type, rtree->bboxsize);
-  for (int i = 0; i < node->count; ++i)
+  uint64 mask = 0;
+  for (int i = 0; i < count; i++)
   {
-    double min_dist =
-      rtree->get_axis(RTREE_NODE_BBOX_N(node, i), largest_axis, false) -
-      rtree->get_axis(box, largest_axis, false);
-    double max_dist =
-      rtree->get_axis(box, largest_axis, true) -
-      rtree->get_axis(RTREE_NODE_BBOX_N(node, i), largest_axis, true);
-    /* Move to the right */
-    if (max_dist < min_dist)
-      node_move_box_at_index_into(node, i--, right);
+    bool ok = lower[i] > upper[i] ||
+      (inside ? (lower[i] >= a && upper[i] <= b) :
+        (lower[i] <= a && upper[i] >= b));
+    mask |= (uint64) ok << i;
   }
+  return mask;
+}
 
-  /* Make sure that both left and right nodes have at least MINITEMS by moving
-   * data into underflowed nodes */
-  if (node->count < MINITEMS)
-  {
-    /* Reverse sort by min axis */
-    node_sort_axis(rtree, right, largest_axis, false);
-    do
-    {
-      node_move_box_at_index_into(right, right->count - 1, node);
-    } while (node->count < MINITEMS);
-  }
-  else if (right->count < MINITEMS)
+#if RTREE_AVX2
+/**
+ * @brief Return the bitmask of the entries whose bounds on an axis satisfy
+ * the condition, testing four entries per instruction with AVX2
+ * @see axis_mask_scalar
+ */
+__attribute__((target("avx2")))
+static uint64
+axis_mask_avx2(const double *lower, const double *upper, int count,
+  double a, double b, bool inside)
+{
+  __m256d va = _mm256_set1_pd(a);
+  __m256d vb = _mm256_set1_pd(b);
+  uint64 mask = 0;
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
   {
-    /* Reverse sort by max axis */
-    node_sort_axis(rtree, node, largest_axis, true);
-    do
-    {
-      node_move_box_at_index_into(node, node->count - 1, right);
-    } while (right->count < MINITEMS);
+    __m256d lo = _mm256_loadu_pd(lower + i);
+    __m256d up = _mm256_loadu_pd(upper + i);
+    __m256d cmp = inside ?
+      _mm256_and_pd(_mm256_cmp_pd(lo, va, _CMP_GE_OQ),
+        _mm256_cmp_pd(up, vb, _CMP_LE_OQ)) :
+      _mm256_and_pd(_mm256_cmp_pd(lo, va, _CMP_LE_OQ),
+        _mm256_cmp_pd(up, vb, _CMP_GE_OQ));
+    cmp = _mm256_or_pd(cmp, _mm256_cmp_pd(lo, up, _CMP_GT_OQ));
+    mask |= (uint64) _mm256_movemask_pd(cmp) << i;
   }
-  if (node->node_type == RTREE_INNER)
+  if (i < count)
+    mask |= axis_mask_scalar(lower + i, upper + i, count - i, a, b, inside)
+      << i;
+  return mask;
+}
+#endif /* RTREE_AVX2 */
+
+#if RTREE_NEON
+/**
+ * @brief Return the bitmask of the entries whose bounds on an axis satisfy
+ * the condition, testing two entries per instruction with NEON
+ * @see axis_mask_scalar
+ */
+static uint64
+axis_mask_neon(const double *lower, const double *upper, int count,
+  double a, double b, bool inside)
+{
+  float64x2_t va = vdupq_n_f64(a);
+  float64x2_t vb = vdupq_n_f64(b);
+  uint64 mask = 0;
+  int i = 0;
+  for (; i + 2 <= count; i += 2)
   {
-    node_sort_axis(rtree, node, 0, false);
-    node_sort_axis(rtree, right, 0, false);
+    float64x2_t lo = vld1q_f64(lower + i);
+    float64x2_t up = vld1q_f64(upper + i);
+    uint64x2_t cmp = inside ?
+      vandq_u64(vcgeq_f64(lo, va), vcleq_f64(up, vb)) :
+      vandq_u64(vcleq_f64(lo, va), vcgeq_f64(up, vb));
+    cmp = vorrq_u64(cmp, vcgtq_f64(lo, up));
+    mask |= ((vgetq_lane_u64(cmp, 0) & 1) |
+      ((vgetq_lane_u64(cmp, 1) & 1) << 1)) << i;
   }
-  *right_out = right;
+  if (i < count)
+    mask |= axis_mask_scalar(lower + i, upper + i, count - i, a, b, inside)
+      << i;
+  return mask;
+}
+#endif /* RTREE_NEON */
+
+/**
+ * @brief Set the kernel testing the bounds of an axis for the instruction set
+ * of the processor
+ */
+static void
+rtree_set_axis_mask(RTree *rtree)
+{
+  rtree->axis_mask = &axis_mask_scalar;
+#if RTREE_AVX2
+  if (__builtin_cpu_supports("avx2"))
+    rtree->axis_mask = &axis_mask_avx2;
+#elif RTREE_NEON
+  rtree->axis_mask = &axis_mask_neon;
+#endif
   return;
 }
 
 /**
- * @brief Inserts a new bounding box into an RTree node and handles node
- * splitting if necessary
- * @details If the node is a leaf and already contains the maximum number of
- * items (`MAXITEMS`), the function sets the `split` flag to `true` to indicate
- * that the node needs to be split. For non-leaf nodes, the function determines
- * the appropriate child node for insertion and recursively inserts the
- * bounding box. If splitting occurs, the function handles the split and
- * updates the parent node's bounding boxes.
- * @param[in] rtree Pointer to the RTree structure that provides axis value
- * retrieval and node splitting functions
- * @param[in] node_bounding_box Pointer to the bounding bounding box of all the
- * bounding boxes in `node`
- * @param[in] node Pointer to the node where the bounding box is being
- * inserted
- * @param[in] new_box Pointer to the bounding box to be inserted
- * @param[in] id Identifier associated with the new bounding box (used only for
- * leaf nodes)
- * @param[out] split Pointer to a boolean flag that indicates if the node was
- * split during insertion
+ * @brief Bounds of a query on the axes it has
+ */
+typedef struct
+{
+  int naxes;                      /**< Number of axes of the query */
+  int axis[RTREE_MAX_AXES];       /**< Axes of the query */
+  double lower[RTREE_MAX_AXES];   /**< Lower bound on each axis */
+  double upper[RTREE_MAX_AXES];   /**< Upper bound on each axis */
+} RTreeAxesQuery;
+
+/**
+ * @brief Get the bounds of a query on the axes it has
  */
 static void
-node_insert(RTree *rtree, void *node_bounding_box, RTreeNode *node,
-  void *new_box, int64 id, bool *split)
+axes_query_init(const RTree *rtree, const void *query, RTreeAxesQuery *q)
 {
-  if (node->node_type == RTREE_LEAF)
-  {
-    if (node->count == MAXITEMS)
-    {
-      *split = true;
-      return;
-    }
-    int index = node->count;
-    memcpy(RTREE_NODE_BBOX_N(node, index), new_box, rtree->bboxsize);
-    node->ids[index] = id;
-    node->count++;
-    *split = false;
-    return;
-  }
-  int insertion_node = node_choose(rtree, new_box, node);
-  node_insert(rtree, RTREE_NODE_BBOX_N(node, insertion_node),
-    (RTreeNode *) node->nodes[insertion_node], new_box, id, split);
-  if (! *split)
-  {
-    rtree->bbox_expand(new_box, RTREE_NODE_BBOX_N(node, insertion_node));
-    *split = false;
-    return;
-  }
-  if (node->count == MAXITEMS)
+  q->naxes = 0;
+  for (int a = 0; a < rtree->dims; a++)
   {
-    *split = true;
-    return;
+    if (bbox_axis_bounds(rtree, query, a, &q->lower[q->naxes],
+        &q->upper[q->naxes]))
+      q->axis[q->naxes++] = a;
   }
-  RTreeNode *right;
-  node_split(rtree, node->nodes[insertion_node],
-    RTREE_NODE_BBOX_N(node, insertion_node), &right);
-  node_box_calculate(rtree, node->nodes[insertion_node],
-    RTREE_NODE_BBOX_N(node, insertion_node));
-  node_box_calculate(rtree, right, RTREE_NODE_BBOX_N(node, node->count));
-  node->nodes[node->count] = right;
-  node->count++;
-  node_insert(rtree, node_bounding_box, node, new_box, id, split);
   return;
 }
 
-
 /**
- * @brief Return true if a leaf entry is consistent with the search query
- * @details This is the exact predicate applied at leaf level.
- * @param[in] rtree Pointer to the RTree structure
- * @param[in] key The bounding box of the leaf entry
- * @param[in] query The bounding box that serves as query
- * @param[in] op The search operation
+ * @brief Return the bitmask of the entries of a node that may satisfy a
+ * search operation, which is exact up to the conversion of the bounds to
+ * double and to closed intervals
+ * @param[in] rtree The RTree
+ * @param[in] node The node
+ * @param[in] q The bounds of the query
+ * @param[in] op The operation: @p RTREE_OVERLAPS for entries overlapping the
+ * query, @p RTREE_CONTAINS for entries containing the query, and
+ * @p RTREE_CONTAINED_BY for entries contained in the query
  */
-static bool
-leaf_consistent(const RTree *rtree, const void *key, const void *query,
-  RTreeSearchOp op)
+static uint64
+node_axes_mask(const RTree *rtree, const RTreeNode *node,
+  const RTreeAxesQuery *q, RTreeSearchOp op)
 {
-  switch (op)
+  uint64 mask = (node->count == 64) ? ~UINT64CONST(0) :
+    (UINT64CONST(1) << node->count) - 1;
+  const double *axes = RTREE_NODE_AXES(rtree, node);
+  for (int k = 0; k < q->naxes && mask; k++)
   {
-    case RTREE_OVERLAPS:
-      return rtree->bbox_overlaps(key, query);
-    case RTREE_CONTAINS:
-      return rtree->bbox_contains(key, query);
-    case RTREE_CONTAINED_BY:
-      return rtree->bbox_contains(query, key);
+    const double *lower = &axes[(2 * q->axis[k]) * rtree->maxitems];
+    const double *upper = &axes[(2 * q->axis[k] + 1) * rtree->maxitems];
+    if (op == RTREE_OVERLAPS)
+      mask &= rtree->axis_mask(lower, upper, node->count, q->upper[k],
+        q->lower[k], false);
+    else
+      mask &= rtree->axis_mask(lower, upper, node->count, q->lower[k],
+        q->upper[k], op == RTREE_CONTAINED_BY);
   }
-  return false;
+  return mask;
 }
 
+/*****************************************************************************
+ * Quantized node layout
+ *
+ * With the @p RTREE_LAYOUT_QUANT8 and @p RTREE_LAYOUT_QUANT16 layouts a node
+ * stores a single exact bounding box, its own, and the bounds of its entries
+ * on every axis as 8- or 16-bit codes on a regular grid spanning the box of
+ * the node, so that an entry takes a few bytes per axis instead of a whole
+ * bounding box. Code `c` stands for `lower + c * step` where `step` is the
+ * length of the axis of the node divided by the largest code, the first and
+ * the last code standing for the exact bounds of the node. A lower bound is
+ * rounded down and an upper bound is rounded up, so that the decoded entry
+ * contains the exact one, and each code is chosen as tight as possible, so
+ * that the exact bound lies between the decoded bound and the next grid
+ * point. The tests of the entries are thus conservative: a search returns
+ * every entry satisfying it together with a few entries close to the query,
+ * to be confirmed by the caller on the exact boxes. An entry without an axis
+ * that its node has, and all the entries of a node without an axis, are
+ * stored with a lower code greater than the upper one, and that axis is not
+ * tested, as done by the predicates for an axis that a box does not have.
+ *
+ * The nodes are quantized by #rtree_load once each level of the tree is
+ * packed, so that the tree is read-only: such a tree can be searched with
+ * #rtree_search, the search cursor, and saved and opened again, but not
+ * modified, joined, or searched with the batch and nearest-neighbour
+ * functions, which need the exact boxes.
+ *****************************************************************************/
+
 /**
- * @brief Return true if an inner node is consistent with the search query
- * @details This is a looser check used for pruning subtrees during traversal.
- * @param[in] rtree Pointer to the RTree structure
- * @param[in] key The bounding box of the inner node
- * @param[in] query The bounding box that serves as query
- * @param[in] op The search operation
+ * @brief Return the largest code of an RTree with a quantized layout
  */
-static bool
-inner_consistent(const RTree *rtree, const void *key, const void *query,
-  RTreeSearchOp op)
+static inline uint32
+rtree_maxcode(RTreeLayout layout)
 {
-  switch (op)
+  return (layout == RTREE_LAYOUT_QUANT8) ? UINT8_MAX : UINT16_MAX;
+}
+
+/**
+ * @brief Return the k-th code of a node with a quantized layout
+ */
+static inline uint32
+node_code_get(RTreeLayout layout, const RTreeNode *node, int k)
+{
+  if (layout == RTREE_LAYOUT_QUANT8)
+    return ((const uint8 *) RTREE_NODE_CODES(node))[k];
+  return ((const uint16 *) RTREE_NODE_CODES(node))[k];
+}
+
+/**
+ * @brief Set the k-th code of a node with a quantized layout
+ */
+static inline void
+node_code_set(RTreeLayout layout, RTreeNode *node, int k, uint32 code)
+{
+  if (layout == RTREE_LAYOUT_QUANT8)
+    ((uint8 *) RTREE_NODE_CODES(node))[k] = (uint8) code;
+  else
+    ((uint16 *) RTREE_NODE_CODES(node))[k] = (uint16) code;
+  return;
+}
+
+/**
+ * @brief Return the value of a code on an axis of a node
+ * @param[in] lower,upper Bounds of the node on the axis
+ * @param[in] step Distance between two consecutive codes
+ * @param[in] code The code
+ * @param[in] maxcode The largest code
+ */
+static inline double
+quant_decode(double lower, double upper, double step, uint32 code,
+  uint32 maxcode)
+{
+  if (code == 0)
+    return lower;
+  if (code >= maxcode)
+    return upper;
+  return lower + code * step;
+}
+
+/**
+ * @brief Return the code of a bound on an axis of a node
+ * @details A lower bound is encoded by the largest code whose value is at
+ * most the bound, and an upper bound by the smallest code whose value is at
+ * least the bound. The estimate given by the division is corrected by
+ * comparing the decoded values with the bound, so that the result does not
+ * depend on the rounding of the floating-point operations.
+ * @param[in] lower,upper Bounds of the node on the axis
+ * @param[in] step Distance between two consecutive codes
+ * @param[in] maxcode The largest code
+ * @param[in] value The bound, which is between @p lower and @p upper
+ * @param[in] up True for an upper bound
+ */
+static uint32
+quant_encode(double lower, double upper, double step, uint32 maxcode,
+  double value, bool up)
+{
+  double pos = (value - lower) / step;
+  uint32 code = (pos <= 0) ? 0 : (pos >= maxcode) ? maxcode :
+    (uint32) (up ? ceil(pos) : floor(pos));
+  if (up)
   {
-    case RTREE_OVERLAPS:
-    case RTREE_CONTAINED_BY:
-      return rtree->bbox_overlaps(key, query);
-    case RTREE_CONTAINS:
-      return rtree->bbox_contains(key, query);
+    while (code < maxcode &&
+        quant_decode(lower, upper, step, code, maxcode) < value)
+      code++;
+    while (code > 0 &&
+        quant_decode(lower, upper, step, code - 1, maxcode) >= value)
+      code--;
   }
-  return false;
+  else
+  {
+    while (code > 0 && quant_decode(lower, upper, step, code, maxcode) > value)
+      code--;
+    while (code < maxcode &&
+        quant_decode(lower, upper, step, code + 1, maxcode) <= value)
+      code++;
+  }
+  return code;
 }
 
 /**
- * @brief Searches recursively a node looking for hits with a query
- * @param[in] rtree Pointer to the RTree structure
- * @param[in] node The node to be searched
- * @param[in] op The search operation (overlaps, contains, or contained by)
- * @param[in] query The bounding box that serves as query
- * @param[out] result MeosArray to collect matching IDs
+ * @brief Return a node with a quantized layout having the entries of a node
+ * with the @p RTREE_LAYOUT_BOXES layout, which is freed
+ * @details The children of an inner node are moved to the new node
+ * @param[in] rtree The RTree
+ * @param[in] layout The quantized layout
+ * @param[in] node The node, whose bounding boxes are exact
+ * @param[in] box The bounding box of the node
  */
-static void
-node_search(const RTree *rtree, const RTreeNode *node, RTreeSearchOp op,
-  const void *query, MeosArray *result)
+static RTreeNode *
+node_quantize(const RTree *rtree, RTreeLayout layout, RTreeNode *node,
+  const void *box)
 {
-  for (int i = 0; i < node->count; ++i)
+  RTreeNode *result = palloc0(node_size_layout(rtree, layout));
+  result->bboxsize = node->bboxsize;
+  result->count = node->count;
+  result->node_type = node->node_type;
+  memcpy(result->ids, node->ids, sizeof(int64) * node->count);
+  memcpy(RTREE_NODE_BBOX_N(result, 0), box, rtree->bboxsize);
+  uint32 maxcode = rtree_maxcode(layout);
+  for (int a = 0; a < rtree->dims; a++)
   {
-    if (node->node_type == RTREE_LEAF)
+    double lower, upper;
+    bool axis = bbox_axis_bounds(rtree, box, a, &lower, &upper);
+    double step = (upper - lower) / maxcode;
+    for (int i = 0; i < node->count; i++)
     {
-      if (leaf_consistent(rtree, RTREE_NODE_BBOX_N(node, i), query, op))
+      /* An axis that is not tested */
+      uint32 locode = maxcode, upcode = 0;
+      double lo, hi;
+      if (axis && isfinite(step) &&
+          bbox_axis_bounds(rtree, RTREE_NODE_BBOX_N(node, i), a, &lo, &hi))
       {
-        int64 id = node->ids[i];
-        meos_array_add(result, &id);
+        if (step == 0)
+        {
+          /* All the codes stand for the single value of the node */
+          locode = 0;
+          upcode = maxcode;
+        }
+        else
+        {
+          locode = quant_encode(lower, upper, step, maxcode, lo, false);
+          upcode = quant_encode(lower, upper, step, maxcode, hi, true);
+          /* Several codes may have the same value for a tiny step */
+          if (locode > upcode)
+            locode = upcode;
+        }
       }
-    }
-    else
-    {
-      if (inner_consistent(rtree, RTREE_NODE_BBOX_N(node, i), query, op))
-        node_search(rtree, node->nodes[i], op, query, result);
+      node_code_set(layout, result, (2 * a) * rtree->maxitems + i, locode);
+      node_code_set(layout, result, (2 * a + 1) * rtree->maxitems + i,
+        upcode);
     }
   }
-  return;
+  pfree(node);
+  return result;
 }
 
 /**
- * @brief Report the qualifying entry pairs of two nodes, descending both trees
- * @details A node does not store its own bounding box, so each node is visited
- * together with the box its parent holds for it; the roots are visited with a
+ * @brief Return the bitmask of the entries of a node with a quantized layout
+ * that may satisfy a search operation
+ * @details The exact lower bound of an entry lies between the value of its
+ * code and the value of the next code, and the exact upper bound between the
+ * value of the previous code and the value of its code, so an entry can be
+ * contained in the query only if these values allow it
+ * @param[in] rtree The RTree
+ * @param[in] node The node
+ * @param[in] q The bounds of the query
+ * @param[in] op The operation, as for #node_axes_mask
+ */
+static uint64
+node_quant_mask(const RTree *rtree, const RTreeNode *node,
+  const RTreeAxesQuery *q, RTreeSearchOp op)
+{
+  uint64 mask = (node->count == 64) ? ~UINT64CONST(0) :
+    (UINT64CONST(1) << node->count) - 1;
+  uint32 maxcode = rtree_maxcode(rtree->layout);
+  for (int k = 0; k < q->naxes && mask; k++)
+  {
+    int a = q->axis[k];
+    double lower, upper;
+    if (! bbox_axis_bounds(rtree, RTREE_NODE_BBOX_N(node, 0), a, &lower,
+        &upper))
+      continue;
+    double step = (upper - lower) / maxcode;
+    double qlo = q->lower[k], qhi = q->upper[k];
+    for (int i = 0; i < node->count; i++)
+    {
+      uint32 locode = node_code_get(rtree->layout, node,
+        (2 * a) * rtree->maxitems + i);
+      uint32 upcode = node_code_get(rtree->layout, node,
+        (2 * a + 1) * rtree->maxitems + i);
+      if (locode > upcode)
+        continue;
+      bool ok;
+      if (op == RTREE_OVERLAPS)
+        ok = quant_decode(lower, upper, step, locode, maxcode) <= qhi &&
+          quant_decode(lower, upper, step, upcode, maxcode) >= qlo;
+      else if (op == RTREE_CONTAINS)
+        ok = quant_decode(lower, upper, step, locode, maxcode) <= qlo &&
+          quant_decode(lower, upper, step, upcode, maxcode) >= qhi;
+      else /* op == RTREE_CONTAINED_BY */
+        ok = quant_decode(lower, upper, step, Min(locode + 1, maxcode),
+            maxcode) >= qlo &&
+          quant_decode(lower, upper, step, upcode ? upcode - 1 : 0,
+            maxcode) <= qhi;
+      if (! ok)
+        mask &= ~(UINT64CONST(1) << i);
+    }
+  }
+  return mask;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief Return the length of a bounding box along a given axis as a double
+ * @param[in] rtree Pointer to the RTree structure containing the function to
+ * retrieve axis values
+ * @param[in] box Pointer to the bounding box for which the axis length is to
+ * be calculated
+ * @param[in] axis The given axis (e.g., 0, 1, 2) along which to compute the
+ * length
+ */
+static inline double
+get_axis_length(const RTree *rtree, const void *box, int axis)
+{
+  return rtree->get_axis(box, axis, true) - rtree->get_axis(box, axis, false);
+}
+
+/**
+ * @brief Return the length, area, or volume of a bounding box
+ * @details The function iterates over all dimensions defined in the RTree
+ * multiplying the lengths of the box along each axis
+ * @param[in] rtree Pointer to the RTree structure, which provides the number
+ * of dimensions and the method for retrieving axis lengths
+ * @param[in] box Pointer to the bounding box
+ */
+static double
+box_area(const RTree *rtree, const void *box)
+{
+  double result = 1.0;
+  for (int i = 0; i < rtree->dims; ++i)
+    result *= get_axis_length(rtree, box, i);
+  return result;
+}
+
+/**
+ * @brief Return the length, area, or volume of the union of two bounding
+ * boxes
+ * @details The function first creates a new bounding box that is the union of
+ * the two input boxes, then calculates the length, area, or volume of this
+ * union box using the given RTree's dimensions
+ * @param[in] box1,box2 Pointers to the bounding boxes
+ * @param[in] rtree Pointer to the RTree structure, which provides the number
+ * of dimensions and the method for the computation
+ */
+static double
+unioned_area(const RTree *rtree, const void *box1, const void *box2)
+{
+  /* Use a stack buffer large enough for any MEOS bounding box type */
+  bboxunion union_buf;
+  memcpy(&union_buf, box1, rtree->bboxsize);
+  rtree->bbox_expand(box2, &union_buf);
+  return box_area(rtree, &union_buf);
+}
+
+/**
+ * @brief Return the child node that requires the least enlargement to
+ * accommodate a new bounding box
+ * @details The function iterates through the child nodes of a given node to
+ * determine which child node's bounding box would need the least enlargement
+ * to include a new bounding box. The function calculates the area of each
+ * node's bounding box before and after union with the new bounding box and
+ * selects the one with the smallest area increase.
+ * @param[in] node Pointer to the node containing the child nodes
+ * @param[in] box Pointer to the bounding box that is being inserted
+ * or considered
+ * @param[in] rtree Pointer to the RTree structure, which provides the method
+ * for calculating areas
+ * @return The index of the child node that requires the least enlargement
+ */
+static int
+node_choose_least_enlargement(const RTree *rtree, const RTreeNode *node,
+  const void *box)
+{
+  int result = 0;
+  double previous_enlargement = INFINITY;
+  for (int i = 0; i < node->count; ++i)
+  {
+    double union_area = unioned_area(rtree, RTREE_NODE_BBOX_N(node, i), box);
+    double area = box_area(rtree, RTREE_NODE_BBOX_N(node, i));
+    double enlarge_area = union_area - area;
+    if (enlarge_area < previous_enlargement)
+    {
+      result = i;
+      previous_enlargement = enlarge_area;
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Returns the best child node for inserting a new bounding box in an
+ * RTree
+ * @details The function determines the most suitable child node within a node
+ * for inserting a new bounding box. It first checks if the new box can be
+ * added to any child node without requiring the expansion of its bounding box.
+ * If none of the child nodes can accommodate the new bounding box without
+ * expansion, the function falls back to selecting the node that requires the
+ * least enlargement.
+ * @param[in] rtree Pointer to the RTree structure, providing access to the
+ * overall RTree configuration
+ * @param[in] box Pointer to the bounding box that is being inserted
+ * @param[in] node Pointer to the node containing the child nodes
+ * @return The index of the chosen child node for insertion
+ */
+static int
+node_choose(const RTree *rtree, const void *box, const RTreeNode *node)
+{
+  /* Check if the bounding box can be added without expanding any rectangle */
+  for (int i = 0; i < node->count; ++i)
+  {
+    if (rtree->bbox_contains(RTREE_NODE_BBOX_N(node, i), box))
+      return i;
+  }
+  /* Fallback to "least enlargement" */
+  return node_choose_least_enlargement(rtree, node, box);
+}
+
+/**
+ * @brief Return the bounding box that encloses all bounding boxes in an RTree
+ * node
+ * @details The function takes the destination bounding box and change it to the
+ * minimal bounding box enclosing all bounding boxes within a given RTree node
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] node Pointer to the node containing the bounding boxes
+ * @param[out] box bounding box that will be expanded
+ */
+static void
+node_box_calculate(const RTree *rtree, const RTreeNode *node, void *box)
+{
+  memcpy(box, RTREE_NODE_BBOX_N(node, 0), rtree->bboxsize);
+  for (int i = 1; i < node->count; ++i)
+    rtree->bbox_expand(RTREE_NODE_BBOX_N(node, i), box);
+  return;
+}
+
+/**
+ * @brief Return the axis with the largest length in a bounding box
+ * @details The function determines the axis of a bounding box that has the
+ * largest length by comparing the lengths of the bounding box along each
+ * dimension defined in the RTree
+ * @param[in] box Pointer to the bounding box whose largest axis is to be
+ * determined.
+ * @param[in] rtree Pointer to the RTree structure, which provides the method
+ * for calculating axis lengths and defines the number of dimensions.
+ * @return The index of the axis with the largest length.
+ */
+static int
+box_largest_axis(const RTree *rtree, const void *box)
+{
+  int largest_axis = 0;
+  double previous_largest = get_axis_length(rtree, box, 0);
+  for (int i = 1; i < rtree->dims; ++i)
+  {
+    if (previous_largest < get_axis_length(rtree, box, i))
+    {
+      previous_largest = get_axis_length(rtree, box, i);
+      largest_axis = i;
+    }
+  }
+  return largest_axis;
+}
+
+/**
+ * @brief Moves a bounding box from one RTree node to another.
+ * @details Changes the information from one node into another.
+ * @param[in] from Pointer to the node from which the bounding box is
+ * being moved.
+ * @param[in] index The index of the bounding box in the `from` node that is to
+ * be moved.
+ * @param[in] into Pointer to the node where the bounding box is being moved
+ * to.
+ */
+static void
+node_move_box_at_index_into(RTreeNode *from, int index, RTreeNode *into)
+{
+  memcpy(RTREE_NODE_BBOX_N(into, into->count), RTREE_NODE_BBOX_N(from, index),
+    from->bboxsize);
+  memcpy(RTREE_NODE_BBOX_N(from, index),
+    RTREE_NODE_BBOX_N(from, from->count - 1), from->bboxsize);
+  if (from->node_type == RTREE_LEAF)
+  {
+    into->ids[into->count] = from->ids[index];
+    from->ids[index] = from->ids[from->count - 1];
+  }
+  else
+  {
+    into->nodes[into->count] = from->nodes[index];
+    from->nodes[index] = from->nodes[from->count - 1];
+  }
+  from->count--;
+  into->count++;
+  return;
+}
+
+/**
+ * @brief Swaps two bounding boxes and their associated data within an RTree node.
+ * @details The function exchanges the positions of two bounding boxes within a
+ * single RTree node. If the node is a leaf, it also swaps the associated IDs.
+ * For internal nodes, it swaps the pointers to child nodes. The function is
+ * useful for reordering elements within a node.
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in,out] node Pointer to the node containing the
+ * bounding boxes and associated data.
+ * @param[in] i The index of the first bounding box to be swapped.
+ * @param[in] j The index of the second bounding box to be swapped.
+ */
+static void
+node_swap(const RTree *rtree, RTreeNode *node, int i, int j)
+{
+  /* Use a stack buffer large enough for any MEOS bounding box type */
+  bboxunion buf;
+  memcpy(&buf, RTREE_NODE_BBOX_N(node, i), rtree->bboxsize);
+  memcpy(RTREE_NODE_BBOX_N(node, i), RTREE_NODE_BBOX_N(node, j),
+    rtree->bboxsize);
+  memcpy(RTREE_NODE_BBOX_N(node, j), &buf, rtree->bboxsize);
+  if (node->node_type == RTREE_LEAF)
+  {
+    int64 tmp = node->ids[i];
+    node->ids[i] = node->ids[j];
+    node->ids[j] = tmp;
+  }
+  else
+  {
+    RTreeNode *tree = node->nodes[i];
+    node->nodes[i] = node->nodes[j];
+    node->nodes[j] = tree;
+  }
+  return;
+}
+
+/**
+ * @brief Sort the bounding boxes within an RTree node using the QuickSort
+ * algorithm
+ * @details The function recursively sorts the bounding boxes within a given
+ * range in an RTree node along a particular axis. It uses the QuickSort
+ * algorithm to order the bounding boxes based on their axis values, either
+ * upper or lower, as provided by the `get_axis` function in the RTree
+ * structure.
+ * @param[in] rtree Pointer to the RTree structure which provides the function
+ * for retrieving axis values
+ * @param[in,out] node Pointer to the node containing the bounding boxes to be
+ * sorted
+ * @param[in] index The axis index along which to sort the bounding boxes
+ * @param[in] upper A Boolean indicating whether to sort by upper or lower
+ * axis value
+ * @param[in] s The starting index of the range to be sorted in the
+ * `node->boxes` array
+ * @param[in] e The ending index (exclusive) of the range to be sorted in the
+ * `node->boxes` array
+ */
+static void
+node_qsort(const RTree *rtree, RTreeNode *node, int index, bool upper, int s,
+  int e)
+{
+  int num_boxes = e - s;
+  if (num_boxes < 2)
+    return;
+
+  int left = 0;
+  int right = num_boxes - 1;
+  int pivot = num_boxes / 2;
+  node_swap(rtree, node, s + pivot, s + right);
+  for (int i = 0; i < num_boxes; ++i)
+  {
+    if (rtree->get_axis(RTREE_NODE_BBOX_N(node, right + s), index, upper) >
+        rtree->get_axis(RTREE_NODE_BBOX_N(node, s + i), index, upper))
+    {
+      node_swap(rtree, node, s + i, s + left);
+      left++;
+    }
+  }
+  node_swap(rtree, node, s + left, s + right);
+  node_qsort(rtree, node, index, upper, s, s + left);
+  node_qsort(rtree, node, index, upper, s + left + 1, e);
+  return;
+}
+
+/**
+ * @brief Sort the bounding boxes in an RTree node along a given axis using
+ * QuickSort
+ * @param[in] rtree Pointer to the RTree structure, which provides the function
+ * for retrieving axis values
+ * @param[in,out] node Pointer to the node containing the bounding boxes to be
+ * sorted
+ * @param[in] index The axis index along which to sort the bounding boxes
+ * @param[in] upper A boolean that indicates whether to sort by the upper or
+ * lower axis value
+ */
+static void
+node_sort_axis(const RTree *rtree, RTreeNode *node, int index, bool upper)
+{
+  node_qsort(rtree, node, index, upper, 0, node->count);
+  return;
+}
+
+/**
+ * @brief Return the margin of a bounding box, i.e., the sum of its lengths
+ * along every axis
+ */
+static double
+box_margin(const RTree *rtree, const void *box)
+{
+  double result = 0.0;
+  for (int i = 0; i < rtree->dims; ++i)
+    result += get_axis_length(rtree, box, i);
+  return result;
+}
+
+/**
+ * @brief Return the length, area, or volume of the intersection of two
+ * bounding boxes, 0 if they do not intersect
+ */
+static double
+box_overlap_area(const RTree *rtree, const void *box1, const void *box2)
+{
+  double result = 1.0;
+  for (int i = 0; i < rtree->dims; ++i)
+  {
+    double lower = Max(rtree->get_axis(box1, i, false),
+      rtree->get_axis(box2, i, false));
+    double upper = Min(rtree->get_axis(box1, i, true),
+      rtree->get_axis(box2, i, true));
+    if (upper <= lower)
+      return 0.0;
+    result *= upper - lower;
+  }
+  return result;
+}
+
+/**
+ * @brief Split a node along the axis with the largest length
+ * @details The bounding boxes are moved to either the original node or the
+ * right node, depending on their position relative to the splitting axis.
+ * After the initial split, the function ensures that both nodes have at least
+ * a minimum number of bounding boxes by redistributing the bounding boxes if
+ * necessary.
+ * @param[in] rtree Pointer to the RTree structure, which provides methods for
+ * retrieving axis values and determining dimensions
+ * @param[in] node Pointer to the node to be split
+ * @param[in] box Pointer to the bounding box used to guide the split
+ * @param[out] right Node receiving the entries moved out of @p node
+ */
+static void
+node_split_largest_axis(RTree *rtree, RTreeNode *node, void *box,
+  RTreeNode *right)
+{
+  /* Split through the largest axis */
+  int largest_axis = box_largest_axis(rtree, box);
+  for (int i = 0; i < node->count; ++i)
+  {
+    double min_dist =
+      rtree->get_axis(RTREE_NODE_BBOX_N(node, i), largest_axis, false) -
+      rtree->get_axis(box, largest_axis, false);
+    double max_dist =
+      rtree->get_axis(box, largest_axis, true) -
+      rtree->get_axis(RTREE_NODE_BBOX_N(node, i), largest_axis, true);
+    /* Move to the right */
+    if (max_dist < min_dist)
+      node_move_box_at_index_into(node, i--, right);
+  }
+
+  /* Make sure that both left and right nodes have at least the minimum number
+   * of entries by moving data into underflowed nodes */
+  if (node->count < rtree->minitems)
+  {
+    /* Reverse sort by min axis */
+    node_sort_axis(rtree, right, largest_axis, false);
+    do
+    {
+      node_move_box_at_index_into(right, right->count - 1, node);
+    } while (node->count < rtree->minitems);
+  }
+  else if (right->count < rtree->minitems)
+  {
+    /* Reverse sort by max axis */
+    node_sort_axis(rtree, node, largest_axis, true);
+    do
+    {
+      node_move_box_at_index_into(node, node->count - 1, right);
+    } while (right->count < rtree->minitems);
+  }
+  return;
+}
+
+/**
+ * @brief Compute the bounding boxes of the first and of the last entries of a
+ * node
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] node The node
+ * @param[out] first Array whose i-th box encloses the entries 0 to i
+ * @param[out] last Array whose i-th box encloses the entries i to count - 1
+ */
+static void
+node_group_boxes(const RTree *rtree, const RTreeNode *node, char *first,
+  char *last)
+{
+  size_t size = rtree->bboxsize;
+  int count = node->count;
+  memcpy(first, RTREE_NODE_BBOX_N(node, 0), size);
+  for (int i = 1; i < count; ++i)
+  {
+    memcpy(first + i * size, first + (i - 1) * size, size);
+    rtree->bbox_expand(RTREE_NODE_BBOX_N(node, i), first + i * size);
+  }
+  memcpy(last + (count - 1) * size, RTREE_NODE_BBOX_N(node, count - 1), size);
+  for (int i = count - 2; i >= 0; --i)
+  {
+    memcpy(last + i * size, last + (i + 1) * size, size);
+    rtree->bbox_expand(RTREE_NODE_BBOX_N(node, i), last + i * size);
+  }
+  return;
+}
+
+/**
+ * @brief Split a node as in the R*-tree
+ * @details For every axis, the entries are sorted by their lower and by their
+ * upper bound, and every distribution of the sorted entries into two groups
+ * of at least the minimum number of entries is considered. The split axis is
+ * the one minimizing the sum of the margins of the groups of all its
+ * distributions, and the distribution on this axis is the one minimizing the
+ * overlap of the two groups, then the sum of their areas.
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] node Pointer to the node to be split
+ * @param[out] right Node receiving the entries moved out of @p node
+ */
+static void
+node_split_rstar(RTree *rtree, RTreeNode *node, RTreeNode *right)
+{
+  int count = node->count, m = rtree->minitems;
+  size_t size = rtree->bboxsize;
+  char *first = palloc(size * count), *last = palloc(size * count);
+
+  /* Choose the axis whose distributions have the least margin */
+  int axis = 0;
+  double best_margin = INFINITY;
+  for (int a = 0; a < rtree->dims; ++a)
+  {
+    double margin = 0.0;
+    for (int upper = 0; upper < 2; ++upper)
+    {
+      node_sort_axis(rtree, node, a, upper);
+      node_group_boxes(rtree, node, first, last);
+      for (int k = m; k <= count - m; ++k)
+        margin += box_margin(rtree, first + (k - 1) * size) +
+          box_margin(rtree, last + k * size);
+    }
+    if (margin < best_margin)
+    {
+      best_margin = margin;
+      axis = a;
+    }
+  }
+
+  /* Choose the distribution with the least overlap, then the least area */
+  int best_k = m;
+  bool best_upper = false;
+  double best_overlap = INFINITY, best_area = INFINITY;
+  for (int upper = 0; upper < 2; ++upper)
+  {
+    node_sort_axis(rtree, node, axis, upper);
+    node_group_boxes(rtree, node, first, last);
+    for (int k = m; k <= count - m; ++k)
+    {
+      const void *box1 = first + (k - 1) * size, *box2 = last + k * size;
+      double overlap = box_overlap_area(rtree, box1, box2);
+      double area = box_area(rtree, box1) + box_area(rtree, box2);
+      if (overlap < best_overlap ||
+          (overlap == best_overlap && area < best_area))
+      {
+        best_overlap = overlap;
+        best_area = area;
+        best_k = k;
+        best_upper = upper;
+      }
+    }
+  }
+  node_sort_axis(rtree, node, axis, best_upper);
+  while (node->count > best_k)
+    node_move_box_at_index_into(node, node->count - 1, right);
+  pfree(first); pfree(last);
+  return;
+}
+
+/**
+ * @brief Split a node with Guttman's linear algorithm
+ * @details The two seeds are the entries the farthest apart along some axis,
+ * relative to the length of the node on that axis. Every other entry then
+ * goes to the group whose box it enlarges the least, unless the other group
+ * needs all the entries left to reach the minimum number of entries.
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] node Pointer to the node to be split
+ * @param[in] box Pointer to the bounding box of the node
+ * @param[out] right Node receiving the entries moved out of @p node
+ */
+static void
+node_split_linear(RTree *rtree, RTreeNode *node, const void *box,
+  RTreeNode *right)
+{
+  int count = node->count, m = rtree->minitems;
+
+  /* Pick the seeds */
+  int seed1 = 0, seed2 = 1;
+  double best = -INFINITY;
+  for (int a = 0; a < rtree->dims; ++a)
+  {
+    /* Entries with the highest lower bound and with the lowest upper bound */
+    int high = 0, low = 0;
+    for (int i = 1; i < count; ++i)
+    {
+      if (rtree->get_axis(RTREE_NODE_BBOX_N(node, i), a, false) >
+          rtree->get_axis(RTREE_NODE_BBOX_N(node, high), a, false))
+        high = i;
+      if (rtree->get_axis(RTREE_NODE_BBOX_N(node, i), a, true) <
+          rtree->get_axis(RTREE_NODE_BBOX_N(node, low), a, true))
+        low = i;
+    }
+    if (high == low)
+      continue;
+    double sep = rtree->get_axis(RTREE_NODE_BBOX_N(node, high), a, false) -
+      rtree->get_axis(RTREE_NODE_BBOX_N(node, low), a, true);
+    double length = get_axis_length(rtree, box, a);
+    if (length > 0.0)
+      sep /= length;
+    if (sep > best)
+    {
+      best = sep;
+      seed1 = low;
+      seed2 = high;
+    }
+  }
+
+  /* Assign the other entries to the group of either seed */
+  bool *toright = palloc0(sizeof(bool) * count);
+  /* Use stack buffers large enough for any MEOS bounding box type */
+  bboxunion box1, box2;
+  memcpy(&box1, RTREE_NODE_BBOX_N(node, seed1), rtree->bboxsize);
+  memcpy(&box2, RTREE_NODE_BBOX_N(node, seed2), rtree->bboxsize);
+  toright[seed2] = true;
+  int n1 = 1, n2 = 1;
+  for (int i = 0; i < count; ++i)
+  {
+    if (i == seed1 || i == seed2)
+      continue;
+    const void *entry = RTREE_NODE_BBOX_N(node, i);
+    int left = count - n1 - n2;
+    bool second;
+    if (n1 + left <= m)
+      second = false;
+    else if (n2 + left <= m)
+      second = true;
+    else
+    {
+      double area1 = box_area(rtree, &box1), area2 = box_area(rtree, &box2);
+      double enlarge1 = unioned_area(rtree, &box1, entry) - area1;
+      double enlarge2 = unioned_area(rtree, &box2, entry) - area2;
+      if (enlarge1 != enlarge2)
+        second = enlarge2 < enlarge1;
+      else if (area1 != area2)
+        second = area2 < area1;
+      else
+        second = n2 < n1;
+    }
+    if (second)
+    {
+      rtree->bbox_expand(entry, &box2);
+      toright[i] = true;
+      n2++;
+    }
+    else
+    {
+      rtree->bbox_expand(entry, &box1);
+      n1++;
+    }
+  }
+  /* Moving an entry brings the last one into its place, which has already
+   * been visited when going downwards */
+  for (int i = count - 1; i >= 0; --i)
+  {
+    if (toright[i])
+      node_move_box_at_index_into(node, i, right);
+  }
+  pfree(toright);
+  return;
+}
+
+/**
+ * @brief Splits an RTree node and redistributes its bounding boxes between two
+ * nodes
+ * @details The entries are distributed with the split algorithm of the tree.
+ * If the node is a branch node, it also sorts both nodes by the first axis.
+ * @param[in] rtree Pointer to the RTree structure, which provides methods for
+ * retrieving axis values and determining dimensions
+ * @param[in] node Pointer to the node to be split
+ * @param[in] box Pointer to the bounding box of the node
+ * @param[out] right_out Pointer to a pointer where the new RTreeNode (right
+ * node) will be stored
+ */
+static void
+node_split(RTree *rtree, RTreeNode *node, void *box, RTreeNode **right_out)
+{
+  RTreeNode *right = node_make(rtree, node->node_type);
+  if (rtree->split == RTREE_SPLIT_RSTAR)
+    node_split_rstar(rtree, node, right);
+  else if (rtree->split == RTREE_SPLIT_LINEAR)
+    node_split_linear(rtree, node, box, right);
+  else
+    node_split_largest_axis(rtree, node, box, right);
+  if (node->node_type == RTREE_INNER)
+  {
+    node_sort_axis(rtree, node, 0, false);
+    node_sort_axis(rtree, right, 0, false);
+  }
+  node_sync_axes(rtree, node);
+  node_sync_axes(rtree, right);
+  *right_out = right;
+  return;
+}
+
+/**
+ * @brief Entries evicted from an overflowing leaf by the R*-tree split
+ * algorithm, which are inserted again once the insertion is complete
+ */
+typedef struct
+{
+  bool allowed;       /**< Whether an overflow may still be treated by
+                           evicting entries */
+  bool shrunk;        /**< Whether a leaf on the insertion path lost entries,
+                           so that the boxes of its ancestors are recomputed */
+  MeosArray *boxes;   /**< Boxes of the evicted entries */
+  MeosArray *ids;     /**< Ids of the evicted entries */
+} RTreeReinsert;
+
+/**
+ * @brief Evict from a full leaf the entries whose centre is the farthest from
+ * the centre of the leaf
+ * @details The evicted entries are stored from the closest to the farthest,
+ * the order of the close reinsert of the R*-tree
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] node The leaf
+ * @param[in] box The bounding box of the leaf
+ * @param[out] re Structure receiving the evicted entries
+ */
+static void
+node_evict(const RTree *rtree, RTreeNode *node, const void *box,
+  RTreeReinsert *re)
+{
+  int count = node->count;
+  int evict = Max(count * REINSERT_PERCENTAGE / 100, 1);
+  /* Sort the positions of the entries by distance to the centre */
+  double *dist = palloc(sizeof(double) * count);
+  int *order = palloc(sizeof(int) * count);
+  for (int i = 0; i < count; ++i)
+  {
+    const void *entry = RTREE_NODE_BBOX_N(node, i);
+    dist[i] = 0.0;
+    for (int a = 0; a < rtree->dims; ++a)
+    {
+      double d = (rtree->get_axis(entry, a, false) +
+        rtree->get_axis(entry, a, true) - rtree->get_axis(box, a, false) -
+        rtree->get_axis(box, a, true)) / 2.0;
+      dist[i] += d * d;
+    }
+    order[i] = i;
+  }
+  for (int i = 1; i < count; ++i)
+  {
+    int pos = order[i], j = i;
+    for (; j > 0 && dist[order[j - 1]] > dist[pos]; --j)
+      order[j] = order[j - 1];
+    order[j] = pos;
+  }
+
+  /* Keep the closest entries in the node */
+  size_t size = rtree->bboxsize;
+  char *boxes = palloc(size * count);
+  int64 *ids = palloc(sizeof(int64) * count);
+  memcpy(boxes, RTREE_NODE_BBOX_N(node, 0), size * count);
+  memcpy(ids, node->ids, sizeof(int64) * count);
+  for (int k = 0; k < count; ++k)
+  {
+    const void *entry = boxes + order[k] * size;
+    if (k < count - evict)
+    {
+      memcpy(RTREE_NODE_BBOX_N(node, k), entry, size);
+      node->ids[k] = ids[order[k]];
+    }
+    else
+    {
+      meos_array_add(re->boxes, (void *) entry);
+      meos_array_add(re->ids, &ids[order[k]]);
+    }
+  }
+  node->count = count - evict;
+  node_sync_axes(rtree, node);
+  pfree(dist); pfree(order); pfree(boxes); pfree(ids);
+  return;
+}
+
+/**
+ * @brief Inserts a new bounding box into an RTree node and handles node
+ * splitting if necessary
+ * @details If the node is a leaf and already contains the maximum number of
+ * items, the function sets the `split` flag to `true` to indicate that the
+ * node needs to be split. With the R*-tree split algorithm, the first leaf
+ * overflowing during an insertion evicts some of its entries instead, which
+ * are inserted again afterwards. For non-leaf nodes, the function determines
+ * the appropriate child node for insertion and recursively inserts the
+ * bounding box. If splitting occurs, the function handles the split and
+ * updates the parent node's bounding boxes.
+ * @param[in] rtree Pointer to the RTree structure that provides axis value
+ * retrieval and node splitting functions
+ * @param[in] node_bounding_box Pointer to the bounding bounding box of all the
+ * bounding boxes in `node`
+ * @param[in] node Pointer to the node where the bounding box is being
+ * inserted
+ * @param[in] new_box Pointer to the bounding box to be inserted
+ * @param[in] id Identifier associated with the new bounding box (used only for
+ * leaf nodes)
+ * @param[in,out] re Entries evicted for reinsertion, `NULL` when overflows are
+ * always treated by splitting
+ * @param[out] split Pointer to a boolean flag that indicates if the node was
+ * split during insertion
+ */
+static void
+node_insert(RTree *rtree, void *node_bounding_box, RTreeNode *node,
+  void *new_box, int64 id, RTreeReinsert *re, bool *split)
+{
+  if (node->node_type == RTREE_LEAF)
+  {
+    if (node->count == rtree->maxitems)
+    {
+      if (! re || ! re->allowed)
+      {
+        *split = true;
+        return;
+      }
+      node_evict(rtree, node, node_bounding_box, re);
+      re->allowed = false;
+      re->shrunk = true;
+    }
+    int index = node->count;
+    memcpy(RTREE_NODE_BBOX_N(node, index), new_box, rtree->bboxsize);
+    node->ids[index] = id;
+    node->count++;
+    node_set_axes(rtree, node, index);
+    *split = false;
+    return;
+  }
+  int insertion_node = node_choose(rtree, new_box, node);
+  /* The snapshots of a concurrent tree may be reading the child */
+  if (rtree->shared)
+    node->nodes[insertion_node] = node_cow(rtree,
+      node->nodes[insertion_node]);
+  node_insert(rtree, RTREE_NODE_BBOX_N(node, insertion_node),
+    (RTreeNode *) node->nodes[insertion_node], new_box, id, re, split);
+  if (! *split)
+  {
+    if (re && re->shrunk)
+      node_box_calculate(rtree, node->nodes[insertion_node],
+        RTREE_NODE_BBOX_N(node, insertion_node));
+    else
+      rtree->bbox_expand(new_box, RTREE_NODE_BBOX_N(node, insertion_node));
+    node_set_axes(rtree, node, insertion_node);
+    *split = false;
+    return;
+  }
+  if (node->count == rtree->maxitems)
+  {
+    *split = true;
+    return;
+  }
+  RTreeNode *right;
+  node_split(rtree, node->nodes[insertion_node],
+    RTREE_NODE_BBOX_N(node, insertion_node), &right);
+  node_box_calculate(rtree, node->nodes[insertion_node],
+    RTREE_NODE_BBOX_N(node, insertion_node));
+  node_box_calculate(rtree, right, RTREE_NODE_BBOX_N(node, node->count));
+  node->nodes[node->count] = right;
+  node->count++;
+  node_set_axes(rtree, node, insertion_node);
+  node_set_axes(rtree, node, node->count - 1);
+  node_insert(rtree, node_bounding_box, node, new_box, id, re, split);
+  return;
+}
+
+
+/**
+ * @brief Return true if a leaf entry is consistent with the search query
+ * @details This is the exact predicate applied at leaf level.
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] key The bounding box of the leaf entry
+ * @param[in] query The bounding box that serves as query
+ * @param[in] op The search operation
+ */
+static bool
+leaf_consistent(const RTree *rtree, const void *key, const void *query,
+  RTreeSearchOp op)
+{
+  switch (op)
+  {
+    case RTREE_OVERLAPS:
+      return rtree->bbox_overlaps(key, query);
+    case RTREE_CONTAINS:
+      return rtree->bbox_contains(key, query);
+    case RTREE_CONTAINED_BY:
+      return rtree->bbox_contains(query, key);
+  }
+  return false;
+}
+
+/**
+ * @brief Return true if an inner node is consistent with the search query
+ * @details This is a looser check used for pruning subtrees during traversal.
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] key The bounding box of the inner node
+ * @param[in] query The bounding box that serves as query
+ * @param[in] op The search operation
+ */
+static bool
+inner_consistent(const RTree *rtree, const void *key, const void *query,
+  RTreeSearchOp op)
+{
+  switch (op)
+  {
+    case RTREE_OVERLAPS:
+    case RTREE_CONTAINED_BY:
+      return rtree->bbox_overlaps(key, query);
+    case RTREE_CONTAINS:
+      return rtree->bbox_contains(key, query);
+  }
+  return false;
+}
+
+/**
+ * @brief Searches recursively a node looking for hits with a query
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] node The node to be searched
+ * @param[in] op The search operation (overlaps, contains, or contained by)
+ * @param[in] query The bounding box that serves as query
+ * @param[out] result MeosArray to collect matching IDs
+ * @param[in,out] cost Counters of the cost of the search, may be `NULL`
+ */
+static void
+node_search(const RTree *rtree, const RTreeNode *node, RTreeSearchOp op,
+  const void *query, MeosArray *result, RTreeSearchCost *cost)
+{
+  if (cost)
+  {
+    if (node->node_type == RTREE_LEAF)
+      cost->leaves++;
+    else
+      cost->inner_nodes++;
+    cost->entries += node->count;
+  }
+  for (int i = 0; i < node->count; ++i)
+  {
+    if (node->node_type == RTREE_LEAF)
+    {
+      if (leaf_consistent(rtree, RTREE_NODE_BBOX_N(node, i), query, op))
+      {
+        int64 id = node->ids[i];
+        meos_array_add(result, &id);
+      }
+    }
+    else
+    {
+      if (inner_consistent(rtree, RTREE_NODE_BBOX_N(node, i), query, op))
+        node_search(rtree, RTREE_NODE_CHILD_N(rtree, node, i), op, query,
+          result, cost);
+    }
+  }
+  return;
+}
+
+/**
+ * @brief Searches recursively a node of an RTree with the
+ * @p RTREE_LAYOUT_AXES layout looking for hits with a query
+ * @details The entries selected by the vector test of the bounds of the node
+ * are confirmed with the predicate of the box type, and only these count as
+ * tested entries in the cost of the search
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] node The node to be searched
+ * @param[in] op The search operation (overlaps, contains, or contained by)
+ * @param[in] query The bounding box that serves as query
+ * @param[in] q The bounds of the query
+ * @param[out] result MeosArray to collect matching IDs
+ * @param[in,out] cost Counters of the cost of the search, may be `NULL`
+ */
+static void
+node_search_axes(const RTree *rtree, const RTreeNode *node, RTreeSearchOp op,
+  const void *query, const RTreeAxesQuery *q, MeosArray *result,
+  RTreeSearchCost *cost)
+{
+  bool leaf = (node->node_type == RTREE_LEAF);
+  /* The inner entries are tested as in #inner_consistent */
+  RTreeSearchOp maskop = (leaf || op == RTREE_CONTAINS) ? op : RTREE_OVERLAPS;
+  uint64 mask = node_axes_mask(rtree, node, q, maskop);
+  if (cost)
+  {
+    if (leaf)
+      cost->leaves++;
+    else
+      cost->inner_nodes++;
+  }
+  while (mask)
+  {
+    int i = pg_rightmost_one_pos64(mask);
+    mask &= mask - 1;
+    if (cost)
+      cost->entries++;
+    if (leaf)
+    {
+      if (leaf_consistent(rtree, RTREE_NODE_BBOX_N(node, i), query, op))
+      {
+        int64 id = node->ids[i];
+        meos_array_add(result, &id);
+      }
+    }
+    else if (inner_consistent(rtree, RTREE_NODE_BBOX_N(node, i), query, op))
+      node_search_axes(rtree, RTREE_NODE_CHILD_N(rtree, node, i), op, query,
+        q, result, cost);
+  }
+  return;
+}
+
+/**
+ * @brief Searches recursively a node of an RTree with a quantized layout
+ * looking for candidates for a query
+ * @details The entries are tested on their decoded bounds, which contain the
+ * exact ones, so the ids collected are a superset of those satisfying the
+ * search. Every entry of a visited node counts as tested in the cost of the
+ * search.
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] node The node to be searched
+ * @param[in] op The search operation (overlaps, contains, or contained by)
+ * @param[in] q The bounds of the query
+ * @param[out] result MeosArray to collect the candidate IDs
+ * @param[in,out] cost Counters of the cost of the search, may be `NULL`
+ */
+static void
+node_search_quant(const RTree *rtree, const RTreeNode *node, RTreeSearchOp op,
+  const RTreeAxesQuery *q, MeosArray *result, RTreeSearchCost *cost)
+{
+  bool leaf = (node->node_type == RTREE_LEAF);
+  /* The inner entries are tested as in #inner_consistent */
+  RTreeSearchOp maskop = (leaf || op == RTREE_CONTAINS) ? op : RTREE_OVERLAPS;
+  uint64 mask = node_quant_mask(rtree, node, q, maskop);
+  if (cost)
+  {
+    if (leaf)
+      cost->leaves++;
+    else
+      cost->inner_nodes++;
+    cost->entries += node->count;
+  }
+  while (mask)
+  {
+    int i = pg_rightmost_one_pos64(mask);
+    mask &= mask - 1;
+    if (leaf)
+    {
+      int64 id = node->ids[i];
+      meos_array_add(result, &id);
+    }
+    else
+      node_search_quant(rtree, RTREE_NODE_CHILD_N(rtree, node, i), op, q,
+        result, cost);
+  }
+  return;
+}
+
+/**
+ * @brief Report the qualifying entry pairs of two nodes, descending both trees
+ * @details A node does not store its own bounding box, so each node is visited
+ * together with the box its parent holds for it; the roots are visited with a
  * null box, which prunes nothing. Only one side descends at a time when the
  * other is a leaf: iterating a leaf's boxes and recursing with that same leaf
  * would visit its entries once per box.
  *
- * Subtrees are pruned by overlap whatever @p op is, since one entry contains or
- * is contained by another only if their boxes overlap, so a node pair whose
- * boxes are disjoint holds no qualifying pair below it.
- * @param[in] rtree1,rtree2 The RTrees being joined
- * @param[in] node1,node2 The nodes to be joined
- * @param[in] box1,box2 The boxes the parents hold for @p node1 and @p node2,
- * `NULL` for a root
- * @param[in] op The join operation
- * @param[out] result MeosArray collecting the two ids of each pair
+ * Subtrees are pruned by overlap whatever @p op is, since one entry contains or
+ * is contained by another only if their boxes overlap, so a node pair whose
+ * boxes are disjoint holds no qualifying pair below it.
+ * @param[in] rtree1,rtree2 The RTrees being joined
+ * @param[in] node1,node2 The nodes to be joined
+ * @param[in] box1,box2 The boxes the parents hold for @p node1 and @p node2,
+ * `NULL` for a root
+ * @param[in] op The join operation
+ * @param[out] result MeosArray collecting the two ids of each pair
+ */
+static void
+node_join(const RTree *rtree1, const RTreeNode *node1, const void *box1,
+  const RTree *rtree2, const RTreeNode *node2, const void *box2,
+  RTreeSearchOp op, MeosArray *result)
+{
+  if (box1 && box2 && ! rtree1->bbox_overlaps(box1, box2))
+    return;
+
+  bool leaf1 = (node1->node_type == RTREE_LEAF);
+  bool leaf2 = (node2->node_type == RTREE_LEAF);
+  if (leaf1 && leaf2)
+  {
+    for (int i = 0; i < node1->count; ++i)
+    {
+      const void *key = RTREE_NODE_BBOX_N(node1, i);
+      for (int j = 0; j < node2->count; ++j)
+      {
+        if (leaf_consistent(rtree1, key, RTREE_NODE_BBOX_N(node2, j), op))
+        {
+          int64 id1 = node1->ids[i];
+          int64 id2 = node2->ids[j];
+          meos_array_add(result, &id1);
+          meos_array_add(result, &id2);
+        }
+      }
+    }
+  }
+  else if (! leaf1 && leaf2)
+  {
+    for (int i = 0; i < node1->count; ++i)
+      node_join(rtree1, RTREE_NODE_CHILD_N(rtree1, node1, i),
+        RTREE_NODE_BBOX_N(node1, i), rtree2, node2, box2, op, result);
+  }
+  else if (leaf1 && ! leaf2)
+  {
+    for (int j = 0; j < node2->count; ++j)
+      node_join(rtree1, node1, box1, rtree2,
+        RTREE_NODE_CHILD_N(rtree2, node2, j), RTREE_NODE_BBOX_N(node2, j), op,
+        result);
+  }
+  else
+  {
+    for (int i = 0; i < node1->count; ++i)
+      for (int j = 0; j < node2->count; ++j)
+        node_join(rtree1, RTREE_NODE_CHILD_N(rtree1, node1, i),
+          RTREE_NODE_BBOX_N(node1, i), rtree2,
+          RTREE_NODE_CHILD_N(rtree2, node2, j), RTREE_NODE_BBOX_N(node2, j),
+          op, result);
+  }
+  return;
+}
+
+/**
+ * @ingroup meos_internal_box_index
+ * @brief Creates an RTree index.
+ * @param[in] bboxtype The MeosType of the elements to index.
+ * @return RTree initialized.
+ */
+RTree *
+rtree_create(MeosType bboxtype)
+{
+  return rtree_create_layout(bboxtype, RTREE_LAYOUT_BOXES);
+}
+
+/**
+ * @ingroup meos_internal_box_index
+ * @brief Creates an RTree index with a given node layout
+ * @details With the @p RTREE_LAYOUT_AXES layout the nodes also store the
+ * bounds of every axis in contiguous arrays that the searches scan with the
+ * vector instructions of the processor (AVX2 or NEON, with a scalar fallback),
+ * at the price of larger nodes and of slower insertions.
+ *
+ * With the @p RTREE_LAYOUT_QUANT8 and @p RTREE_LAYOUT_QUANT16 layouts the
+ * nodes store the bounds of their entries as 8- or 16-bit codes relative to
+ * the box of the node, rounded outwards, which makes the nodes several times
+ * smaller. Such a tree is filled by #rtree_load and is read-only, and its
+ * searches return candidates, i.e., every entry satisfying the search and a
+ * few entries close to the query, which the caller confirms on the exact
+ * boxes.
+ * @param[in] bboxtype The MeosType of the elements to index.
+ * @param[in] layout The layout of the nodes
+ * @return RTree initialized.
+ */
+RTree *
+rtree_create_layout(MeosType bboxtype, RTreeLayout layout)
+{
+  return rtree_create_config(bboxtype, layout, MAXITEMS,
+    RTREE_SPLIT_LARGEST_AXIS);
+}
+
+/**
+ * @ingroup meos_internal_box_index
+ * @brief Creates an RTree index with a given node layout, node capacity, and
+ * split algorithm
+ * @details Small nodes suit small trees and those whose nodes must fit in a
+ * few cache lines, while large nodes make shallower trees for large data
+ * sets. The R*-tree split algorithm builds the tightest nodes and the linear
+ * one is the cheapest; #rtree_search_cost measures the effect of these
+ * choices on the searches of an application.
+ * @param[in] bboxtype The MeosType of the elements to index.
+ * @param[in] layout The layout of the nodes
+ * @param[in] capacity The maximum number of entries of a node, from 4 to 64
+ * @param[in] split The algorithm splitting the nodes
+ * @return RTree initialized, `NULL` if the capacity is out of range
+ */
+RTree *
+rtree_create_config(MeosType bboxtype, RTreeLayout layout, int capacity,
+  RTreeSplit split)
+{
+  assert(span_type(bboxtype) || bboxtype == T_TBOX || bboxtype == T_STBOX
+#if POINTCLOUD
+    || bboxtype == T_TPCBOX
+#endif
+    );
+  if (capacity < RTREE_MIN_CAPACITY || capacity > MAXITEMS)
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "The capacity of the nodes of an RTree must be between %d and %d",
+      RTREE_MIN_CAPACITY, MAXITEMS);
+    return NULL;
+  }
+  size_t bboxsize = bbox_get_size(bboxtype);
+  RTree *rtree = palloc0(sizeof(RTree) + bboxsize);
+  if (span_type(bboxtype))
+  {
+    rtree->dims = 1;
+    rtree->get_axis = &get_axis_span;
+    rtree->bbox_expand = &bbox_expand_span;
+    rtree->bbox_contains = &bbox_contains_span;
+    rtree->bbox_overlaps = &bbox_overlaps_span;
+  }
+  else if (bboxtype == T_TBOX)
+  {
+    rtree->dims = 2;
+    rtree->get_axis = &get_axis_tbox;
+    rtree->bbox_expand = &bbox_expand_tbox;
+    rtree->bbox_contains = &bbox_contains_tbox;
+    rtree->bbox_overlaps = &bbox_overlaps_tbox;
+  }
+#if POINTCLOUD
+  else if (bboxtype == T_TPCBOX)
+  {
+    /* dims set at first-insert time, like STBox (Z presence
+     * determined dynamically) */
+    rtree->dims = -1;
+    rtree->get_axis = &get_axis_tpcbox;
+    rtree->bbox_expand = &bbox_expand_tpcbox;
+    rtree->bbox_contains = &bbox_contains_tpcbox;
+    rtree->bbox_overlaps = &bbox_overlaps_tpcbox;
+  }
+#endif
+  else /* bboxtype == T_STBOX */
+  {
+    /* To be set when the first node is created since it is not known yet
+     * whether there is a Z dimension or not */
+    rtree->dims = -1;
+    rtree->get_axis = &get_axis_stbox;
+    rtree->bbox_expand = &bbox_expand_stbox;
+    rtree->bbox_contains = &bbox_contains_stbox;
+    rtree->bbox_overlaps = &bbox_overlaps_stbox;
+  }
+  rtree->bboxtype = bboxtype;
+  rtree->bboxsize = bboxsize;
+  rtree->layout = layout;
+  rtree->maxitems = capacity;
+  rtree->minitems = MINITEMS(capacity);
+  rtree->split = split;
+  rtree_set_axis_mask(rtree);
+  return rtree;
+}
+
+/**
+ * @ingroup meos_misc
+ * @brief Creates an RTree index for integer spans
+ * @return RTree initialized
+ */
+RTree *
+rtree_create_intspan()
+{
+  return rtree_create(T_INTSPAN);
+}
+
+/**
+ * @ingroup meos_misc
+ * @brief Creates an RTree index for big integer spans
+ * @return RTree initialized
+ */
+RTree *
+rtree_create_bigintspan()
+{
+  return rtree_create(T_BIGINTSPAN);
+}
+
+/**
+ * @ingroup meos_misc
+ * @brief Creates an RTree index for float spans
+ * @return RTree initialized
+ */
+RTree *
+rtree_create_floatspan()
+{
+  return rtree_create(T_FLOATSPAN);
+}
+
+/**
+ * @ingroup meos_misc
+ * @brief Creates an RTree index for temporal boxes
+ * @return RTree initialized
+ */
+RTree *
+rtree_create_datespan()
+{
+  return rtree_create(T_DATESPAN);
+}
+
+/**
+ * @ingroup meos_misc
+ * @brief Creates an RTree index for temporal boxes
+ * @return RTree initialized
+ */
+RTree *
+rtree_create_tstzspan()
+{
+  return rtree_create(T_TSTZSPAN);
+}
+
+/**
+ * @ingroup meos_misc
+ * @brief Creates an RTree index for temporal boxes
+ * @return RTree initialized
+ */
+RTree *
+rtree_create_tbox()
+{
+  return rtree_create(T_TBOX);
+}
+
+/**
+ * @ingroup meos_misc
+ * @brief Creates an RTree index for spatiotemporal boxes
+ * @return RTree initialized
+ */
+RTree *
+rtree_create_stbox()
+{
+  return rtree_create(T_STBOX);
+}
+
+#if POINTCLOUD
+/**
+ * @ingroup meos_pointcloud_box
+ * @brief Create an in-memory RTree index for the @c tpcbox bounding-box
+ *   type.  Pair with @ref rtree_insert / @ref rtree_insert_temporal to
+ *   populate, @ref rtree_search / @ref rtree_search_temporal to query.
+ * @return RTree initialized.
+ */
+RTree *
+rtree_create_tpcbox()
+{
+  return rtree_create(T_TPCBOX);
+}
+#endif
+
+/*****************************************************************************
+ * Hilbert curve
+ *****************************************************************************/
+
+/**
+ * @brief Return the position on the Hilbert curve of a point with @p dims
+ * coordinates of @p bits bits each
+ * @details Skilling's transform of the coordinates into the transposed
+ * Hilbert index, whose bits are then interleaved from the most significant
+ * one. The coordinates are overwritten.
+ */
+static uint64
+hilbert_key(uint32 *x, int dims, int bits)
+{
+  uint32 m = (uint32) 1 << (bits - 1);
+  /* Inverse undo */
+  for (uint32 q = m; q > 1; q >>= 1)
+  {
+    uint32 p = q - 1;
+    for (int i = 0; i < dims; i++)
+    {
+      if (x[i] & q)
+        x[0] ^= p;
+      else
+      {
+        uint32 t = (x[0] ^ x[i]) & p;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+  /* Gray encode */
+  for (int i = 1; i < dims; i++)
+    x[i] ^= x[i - 1];
+  uint32 t = 0;
+  for (uint32 q = m; q > 1; q >>= 1)
+  {
+    if (x[dims - 1] & q)
+      t ^= q - 1;
+  }
+  for (int i = 0; i < dims; i++)
+    x[i] ^= t;
+  uint64 key = 0;
+  for (int b = bits - 1; b >= 0; b--)
+  {
+    for (int i = 0; i < dims; i++)
+      key = (key << 1) | ((x[i] >> b) & 1);
+  }
+  return key;
+}
+
+/**
+ * @brief Return the Hilbert key of the centre of a box in the extent of an
+ * RTree
+ */
+static uint64
+rtree_hilbert_key(const RTree *rtree, const void *box)
+{
+  int bits = Min(64 / rtree->dims, 32);
+  double scale = (double) ((((uint64) 1) << bits) - 1);
+  uint32 x[4];
+  for (int a = 0; a < rtree->dims; a++)
+  {
+    double lower = rtree->get_axis(rtree->box, a, false);
+    double upper = rtree->get_axis(rtree->box, a, true);
+    double centre = (rtree->get_axis(box, a, false) +
+      rtree->get_axis(box, a, true)) / 2.0;
+    double f = (centre - lower) / (upper - lower);
+    /* Queries may extend beyond the tree, and flat or infinite extents give
+     * no position */
+    if (! (f > 0.0))
+      f = 0.0;
+    else if (f > 1.0)
+      f = 1.0;
+    x[a] = (uint32) (f * scale);
+  }
+  return hilbert_key(x, rtree->dims, bits);
+}
+
+/*****************************************************************************
+ * STR bulk load
+ *****************************************************************************/
+
+typedef struct
+{
+  void *box;          /**< bbox of the item (leaf: caller's; inner: owned MBR) */
+  int64 id;           /**< leaf payload */
+  RTreeNode *child;   /**< inner payload */
+  int ord;            /**< position of the item in its level, breaks the ties
+                           of the sort so that the packing is deterministic */
+  uint64 key;         /**< Hilbert key of the centre of the box, for a load
+                           in the order of the Hilbert curve */
+} STRItem;
+
+/* Axis of the sort, -1 sorting on the Hilbert key */
+typedef struct { const RTree *tree; int axis; } STRCtx;
+
+static int
+str_cmp(const void *a, const void *b, void *arg)
+{
+  const STRCtx *c = (const STRCtx *) arg;
+  const STRItem *ia = (const STRItem *) a;
+  const STRItem *ib = (const STRItem *) b;
+  if (c->axis < 0)
+  {
+    if (ia->key != ib->key)
+      return ia->key < ib->key ? -1 : 1;
+    return (ia->ord > ib->ord) - (ia->ord < ib->ord);
+  }
+  double ca = (c->tree->get_axis(ia->box, c->axis, false) +
+               c->tree->get_axis(ia->box, c->axis, true)) / 2.0;
+  double cb = (c->tree->get_axis(ib->box, c->axis, false) +
+               c->tree->get_axis(ib->box, c->axis, true)) / 2.0;
+  if (ca != cb)
+    return (ca > cb) - (ca < cb);
+  /* Equal centres are ordered by position, which makes the order total: any
+   * sorting algorithm, sequential or parallel, then yields the same packing */
+  return (ia->ord > ib->ord) - (ia->ord < ib->ord);
+}
+
+/**
+ * @brief Fill nodes to capacity with items in their order, storing them from
+ * @p out onwards
+ */
+static void
+str_pack_nodes(const RTree *rtree, const STRItem *items, int count, bool leaf,
+  RTreeNode **out)
+{
+  int maxitems = rtree->maxitems;
+  for (int p = 0; p < count; p += maxitems)
+  {
+    int plen = (count - p < maxitems) ? count - p : maxitems;
+    RTreeNode *node = node_make(rtree, leaf ? RTREE_LEAF : RTREE_INNER);
+    for (int k = 0; k < plen; k++)
+    {
+      const STRItem *it = &items[p + k];
+      memcpy(RTREE_NODE_BBOX_N(node, k), it->box, rtree->bboxsize);
+      if (leaf)
+        node->ids[k] = it->id;
+      else
+        node->nodes[k] = it->child;
+    }
+    node->count = plen;
+    node_sync_axes(rtree, node);
+    *out++ = node;
+  }
+  return;
+}
+
+/**
+ * @brief Pack a slice of items, already sorted on axis 0, into nodes
+ * @details Sorts the slice on axis 1 and fills nodes to capacity, storing them
+ * from @p out onwards
+ */
+static void
+str_pack_slice(const RTree *rtree, STRItem *items, int count, bool leaf,
+  RTreeNode **out)
+{
+  if (rtree->dims > 1)
+  {
+    STRCtx ctx; ctx.tree = rtree; ctx.axis = 1;
+    qsort_arg(items, (size_t) count, sizeof(STRItem), str_cmp, &ctx);
+  }
+  str_pack_nodes(rtree, items, count, leaf, out);
+  return;
+}
+
+#if MEOS && ! defined(NO_PTHREAD)
+/*****************************************************************************
+ * Parallel STR bulk load
+ *
+ * The two costly steps of a level are the sort of all the items on axis 0 and,
+ * once cut into slices, the sort and packing of every slice. The first is a
+ * merge sort whose runs are sorted by one thread each and then merged pairwise,
+ * one thread per pair. The slices are independent, and since a slice holds a
+ * multiple of the node capacity items the position of its first node is known in
+ * advance, so each thread packs a range of slices straight into the level.
+ * The comparison being a total order, the result is the sequential one.
+ *****************************************************************************/
+
+/**
+ * @brief Task of a thread of the parallel bulk load
+ */
+typedef struct
+{
+  const RTree *rtree;   /**< Tree being loaded */
+  STRItem *items;       /**< Items of the task */
+  STRItem *dst;         /**< Merge: destination of the two runs */
+  int count;            /**< Sort: number of items; merge: length of the
+                             first run; pack: number of items of the slices */
+  int count2;           /**< Merge: length of the second run */
+  int axis;             /**< Sort and merge: axis of the sort, -1 sorting on
+                             the Hilbert key */
+  int per_slice;        /**< Pack: number of items of a slice */
+  bool leaf;            /**< Pack: whether leaves are built */
+  RTreeNode **out;      /**< Pack: where the first node is stored */
+} STRTask;
+
+static void *
+str_sort_worker(void *arg)
+{
+  STRTask *task = (STRTask *) arg;
+  STRCtx ctx; ctx.tree = task->rtree; ctx.axis = task->axis;
+  qsort_arg(task->items, (size_t) task->count, sizeof(STRItem), str_cmp, &ctx);
+  return NULL;
+}
+
+static void *
+str_merge_worker(void *arg)
+{
+  STRTask *task = (STRTask *) arg;
+  STRCtx ctx; ctx.tree = task->rtree; ctx.axis = task->axis;
+  STRItem *a = task->items, *b = task->items + task->count;
+  STRItem *aend = b, *bend = b + task->count2;
+  STRItem *dst = task->dst;
+  while (a < aend && b < bend)
+    *dst++ = (str_cmp(b, a, &ctx) < 0) ? *b++ : *a++;
+  while (a < aend)
+    *dst++ = *a++;
+  while (b < bend)
+    *dst++ = *b++;
+  return NULL;
+}
+
+static void *
+str_pack_worker(void *arg)
+{
+  STRTask *task = (STRTask *) arg;
+  RTreeNode **out = task->out;
+  for (int s = 0; s < task->count; s += task->per_slice)
+  {
+    int slen = (task->count - s < task->per_slice) ?
+      task->count - s : task->per_slice;
+    str_pack_slice(task->rtree, task->items + s, slen, task->leaf, out);
+    out += (slen + task->rtree->maxitems - 1) / task->rtree->maxitems;
+  }
+  return NULL;
+}
+
+/**
+ * @brief Run tasks with one thread each and wait for all of them
+ * @details A task whose thread cannot be started is run by the calling thread
+ */
+static void
+str_run_tasks(void *(*worker)(void *), STRTask *tasks, int ntasks)
+{
+  pthread_t *threads = palloc(sizeof(pthread_t) * (size_t) ntasks);
+  bool *started = palloc(sizeof(bool) * (size_t) ntasks);
+  for (int i = 0; i < ntasks; i++)
+    started[i] = (pthread_create(&threads[i], NULL, worker, &tasks[i]) == 0);
+  for (int i = 0; i < ntasks; i++)
+  {
+    if (started[i])
+      pthread_join(threads[i], NULL);
+    else
+      worker(&tasks[i]);
+  }
+  pfree(threads); pfree(started);
+  return;
+}
+
+/**
+ * @brief Sort items on an axis, or on their Hilbert key when @p axis is -1,
+ * with several threads
+ */
+static void
+str_sort_parallel(const RTree *rtree, STRItem *items, int count, int axis,
+  int nthreads)
+{
+  /* Sort one run per thread */
+  int nruns = nthreads;
+  int *bounds = palloc(sizeof(int) * (size_t) (nruns + 1));
+  STRTask *tasks = palloc0(sizeof(STRTask) * (size_t) nruns);
+  for (int i = 0; i <= nruns; i++)
+    bounds[i] = (int) (((int64) count * i) / nruns);
+  for (int i = 0; i < nruns; i++)
+  {
+    tasks[i].rtree = rtree;
+    tasks[i].items = items + bounds[i];
+    tasks[i].count = bounds[i + 1] - bounds[i];
+    tasks[i].axis = axis;
+  }
+  str_run_tasks(&str_sort_worker, tasks, nruns);
+
+  /* Merge adjacent runs pairwise until a single run is left */
+  STRItem *src = items;
+  STRItem *dst = palloc(sizeof(STRItem) * (size_t) count);
+  STRItem *buf = dst;
+  while (nruns > 1)
+  {
+    int npairs = nruns / 2;
+    for (int i = 0; i < npairs; i++)
+    {
+      tasks[i].rtree = rtree;
+      tasks[i].items = src + bounds[2 * i];
+      tasks[i].dst = dst + bounds[2 * i];
+      tasks[i].count = bounds[2 * i + 1] - bounds[2 * i];
+      tasks[i].count2 = bounds[2 * i + 2] - bounds[2 * i + 1];
+      tasks[i].axis = axis;
+    }
+    str_run_tasks(&str_merge_worker, tasks, npairs);
+    /* An odd run out is carried over unchanged */
+    if (nruns % 2)
+      memcpy(dst + bounds[nruns - 1], src + bounds[nruns - 1],
+        sizeof(STRItem) * (size_t) (count - bounds[nruns - 1]));
+    for (int i = 0; i <= npairs; i++)
+      bounds[i] = bounds[2 * i < nruns ? 2 * i : nruns];
+    bounds[(nruns + 1) / 2] = count;
+    nruns = (nruns + 1) / 2;
+    STRItem *tmp = src; src = dst; dst = tmp;
+  }
+  if (src != items)
+    memcpy(items, src, sizeof(STRItem) * (size_t) count);
+  pfree(buf); pfree(tasks); pfree(bounds);
+  return;
+}
+
+/**
+ * @brief Sort and pack the slices of a level with several threads
+ */
+static void
+str_pack_parallel(const RTree *rtree, STRItem *items, int count, bool leaf,
+  int per_slice, RTreeNode **out, int nthreads)
+{
+  int nslices = (count + per_slice - 1) / per_slice;
+  int ntasks = (nslices < nthreads) ? nslices : nthreads;
+  STRTask *tasks = palloc0(sizeof(STRTask) * (size_t) ntasks);
+  for (int i = 0; i < ntasks; i++)
+  {
+    /* Each task receives a contiguous range of whole slices */
+    int first = (int) (((int64) nslices * i) / ntasks);
+    int last = (int) (((int64) nslices * (i + 1)) / ntasks);
+    int start = first * per_slice;
+    int end = (last * per_slice < count) ? last * per_slice : count;
+    tasks[i].rtree = rtree;
+    tasks[i].items = items + start;
+    tasks[i].count = end - start;
+    tasks[i].per_slice = per_slice;
+    tasks[i].leaf = leaf;
+    tasks[i].out = out + start / rtree->maxitems;
+  }
+  str_run_tasks(&str_pack_worker, tasks, ntasks);
+  pfree(tasks);
+  return;
+}
+#endif /* MEOS && ! NO_PTHREAD */
+
+/**
+ * @brief Pack one level of items into nodes, Sort-Tile-Recursive
+ * @details Sorts on the centre of axis 0, cuts into ceil(sqrt(pages)) slices,
+ * sorts each slice on axis 1, then fills nodes to capacity. The packing order
+ * affects tree QUALITY only; validity comes from each parent box being the
+ * union of its children, computed here whatever the ordering.
+ * @param[in] rtree The tree being loaded
+ * @param[in] items Items of the level, reordered by the function
+ * @param[in] count Number of items
+ * @param[in] leaf Whether the nodes built are leaves
+ * @param[in] nthreads Number of threads sorting and packing the level
+ * @param[out] nout Number of nodes built
+ */
+static RTreeNode **
+str_pack_level(RTree *rtree, STRItem *items, int count, bool leaf,
+  int nthreads, int *nout)
+{
+  int maxitems = rtree->maxitems;
+  int pages = (count + maxitems - 1) / maxitems;
+  int slices = (int) ceil(sqrt((double) pages));
+  if (slices < 1) slices = 1;
+  int per_slice = slices * maxitems;
+  RTreeNode **out = palloc(sizeof(RTreeNode *) * (size_t) pages);
+  *nout = pages;
+
+#if MEOS && ! defined(NO_PTHREAD)
+  /* A level of a few nodes is not worth the cost of starting threads */
+  if (nthreads > 1 && pages >= 4 * nthreads)
+  {
+    str_sort_parallel(rtree, items, count, 0, nthreads);
+    str_pack_parallel(rtree, items, count, leaf, per_slice, out, nthreads);
+    return out;
+  }
+#else
+  (void) nthreads;
+#endif /* MEOS && ! NO_PTHREAD */
+
+  STRCtx ctx; ctx.tree = rtree; ctx.axis = 0;
+  qsort_arg(items, (size_t) count, sizeof(STRItem), str_cmp, &ctx);
+  RTreeNode **next = out;
+  for (int s = 0; s < count; s += per_slice)
+  {
+    int slen = (count - s < per_slice) ? count - s : per_slice;
+    str_pack_slice(rtree, items + s, slen, leaf, next);
+    next += (slen + maxitems - 1) / maxitems;
+  }
+  return out;
+}
+
+/**
+ * @brief Pack one level of items into nodes in the order of the Hilbert curve
+ * @details The entries are sorted on the Hilbert key of the centre of their
+ * box and cut into runs of full nodes. The nodes of a level being built in
+ * the order of the curve, the upper levels group consecutive nodes without
+ * sorting them again, as in the Hilbert-packed R-tree of Kamel and Faloutsos.
+ * @param[in] rtree The tree being loaded
+ * @param[in] items Items of the level, reordered by the function
+ * @param[in] count Number of items
+ * @param[in] leaf Whether the nodes built are leaves
+ * @param[in] nthreads Number of threads sorting the entries
+ * @param[out] nout Number of nodes built
+ */
+static RTreeNode **
+hilbert_pack_level(RTree *rtree, STRItem *items, int count, bool leaf,
+  int nthreads, int *nout)
+{
+  int pages = (count + rtree->maxitems - 1) / rtree->maxitems;
+  RTreeNode **out = palloc(sizeof(RTreeNode *) * (size_t) pages);
+  *nout = pages;
+  if (leaf)
+  {
+    for (int i = 0; i < count; i++)
+      items[i].key = rtree_hilbert_key(rtree, items[i].box);
+#if MEOS && ! defined(NO_PTHREAD)
+    if (nthreads > 1 && pages >= 4 * nthreads)
+      str_sort_parallel(rtree, items, count, -1, nthreads);
+    else
+#else
+    (void) nthreads;
+#endif /* MEOS && ! NO_PTHREAD */
+    {
+      STRCtx ctx; ctx.tree = rtree; ctx.axis = -1;
+      qsort_arg(items, (size_t) count, sizeof(STRItem), str_cmp, &ctx);
+    }
+  }
+  str_pack_nodes(rtree, items, count, leaf, out);
+  return out;
+}
+
+/**
+ * @brief Build an RTree from all of its entries at once with a given number
+ * of threads
+ */
+static void
+rtree_load_threads(RTree *rtree, const void *boxes, const int64 *ids,
+  int count, RTreeLoad load, int nthreads)
+{
+  if (! ensure_rtree_not_mapped(rtree) ||
+      ! ensure_rtree_not_concurrent(rtree) || count <= 0)
+    return;
+
+  /* A box type whose dimension count depends on the data carries -1 until the
+   * first box arrives, which for a tree grown by insertion is the first insert */
+  if (rtree->dims < 0)
+    rtree->dims = 3 + MEOS_FLAGS_GET_Z(((const STBox *) boxes)->flags);
+
+  /* The levels of a tree with a quantized layout are packed with exact boxes
+   * and quantized once the boxes of their nodes are known */
+  RTreeLayout layout = rtree->layout;
+  bool quant = RTREE_QUANTIZED(rtree);
+  if (quant)
+    rtree->layout = RTREE_LAYOUT_BOXES;
+
+  STRItem *items = palloc(sizeof(STRItem) * (size_t) count);
+  for (int i = 0; i < count; i++)
+  {
+    items[i].box = (void *) ((const char *) boxes + (size_t) i * rtree->bboxsize);
+    items[i].id = ids[i];
+    items[i].child = NULL;
+    items[i].ord = i;
+    items[i].key = 0;
+  }
+
+  /* The Hilbert keys are computed in the extent of the entries, which is set
+   * again from the root once the tree is built */
+  RTreeNode **(*pack_level)(RTree *, STRItem *, int, bool, int, int *) =
+    (load == RTREE_LOAD_HILBERT) ? &hilbert_pack_level : &str_pack_level;
+  if (load == RTREE_LOAD_HILBERT)
+  {
+    memcpy(rtree->box, boxes, rtree->bboxsize);
+    for (int i = 1; i < count; i++)
+      rtree->bbox_expand(items[i].box, rtree->box);
+  }
+
+  int nnodes;
+  RTreeNode **level = pack_level(rtree, items, count, true, nthreads,
+    &nnodes);
+  pfree(items);
+
+  while (nnodes > 1)
+  {
+    STRItem *up = palloc(sizeof(STRItem) * (size_t) nnodes);
+    for (int i = 0; i < nnodes; i++)
+    {
+      void *mbr = palloc0(rtree->bboxsize);
+      memcpy(mbr, RTREE_NODE_BBOX_N(level[i], 0), rtree->bboxsize);
+      for (int k = 1; k < level[i]->count; k++)
+        rtree->bbox_expand(RTREE_NODE_BBOX_N(level[i], k), mbr);
+      if (quant)
+        level[i] = node_quantize(rtree, layout, level[i], mbr);
+      up[i].box = mbr; up[i].id = 0; up[i].child = level[i]; up[i].ord = i;
+      up[i].key = 0;
+    }
+    int prev = nnodes;
+    RTreeNode **parents = pack_level(rtree, up, prev, false, nthreads,
+      &nnodes);
+    for (int i = 0; i < prev; i++)
+      pfree(up[i].box);
+    pfree(up); pfree(level);
+    level = parents;
+  }
+
+  rtree->root = level[0];
+  memcpy(&rtree->box, RTREE_NODE_BBOX_N(level[0], 0), rtree->bboxsize);
+  for (int k = 1; k < level[0]->count; k++)
+    rtree->bbox_expand(RTREE_NODE_BBOX_N(level[0], k), &rtree->box);
+  if (quant)
+  {
+    rtree->root = node_quantize(rtree, layout, level[0], &rtree->box);
+    rtree->layout = layout;
+  }
+  pfree(level);
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Build an RTree from all of its entries at once
+ * @details Bottom-up Sort-Tile-Recursive packing. The result answers the same
+ * queries as inserting every entry one by one, but the whole set is known in
+ * advance, so nodes are filled to capacity and no node is ever split.
+ *
+ * This is the only way to fill an RTree with the @p RTREE_LAYOUT_QUANT8 or
+ * @p RTREE_LAYOUT_QUANT16 layout, whose nodes are quantized as soon as the
+ * level they belong to is packed.
+ * @param[in] rtree An EMPTY RTree of the appropriate bounding box type
+ * @param[in] boxes Contiguous array of @p count boxes of the tree bbox size
+ * @param[in] ids The id of each box
+ * @param[in] count Number of entries
+ * @see rtree_load_parallel
+ */
+void
+rtree_load(RTree *rtree, const void *boxes, const int64 *ids, int count)
+{
+  rtree_load_threads(rtree, boxes, ids, count, RTREE_LOAD_STR, 1);
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Build an RTree from all of its entries at once using several threads
+ * @details Same Sort-Tile-Recursive packing as #rtree_load, where the sort of
+ * every level and the packing of its independent slices are shared among
+ * @p nthreads threads. Ties in the sort are broken by the position of the
+ * entries, so the tree built is exactly the one #rtree_load builds, node for
+ * node, and every search returns the same ids in the same order.
+ *
+ * The threads allocate the nodes, so an allocator installed with
+ * #meos_initialize_allocator must be thread-safe. When the library is built
+ * without POSIX threads the tree is built by the calling thread.
+ * @param[in] rtree An EMPTY RTree of the appropriate bounding box type
+ * @param[in] boxes Contiguous array of @p count boxes of the tree bbox size
+ * @param[in] ids The id of each box
+ * @param[in] count Number of entries
+ * @param[in] nthreads Number of threads, values `<= 1` build the tree on the
+ * calling thread
+ */
+void
+rtree_load_parallel(RTree *rtree, const void *boxes, const int64 *ids,
+  int count, int nthreads)
+{
+  rtree_load_threads(rtree, boxes, ids, count, RTREE_LOAD_STR,
+    nthreads < 1 ? 1 : nthreads);
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Build an RTree from all of its entries at once with a given packing
+ * strategy and number of threads
+ * @details With @p RTREE_LOAD_STR the tree is the one of #rtree_load_parallel.
+ * With @p RTREE_LOAD_HILBERT the entries are sorted on the position of the
+ * centre of their box on a Hilbert curve over all the axes of the tree, e.g.,
+ * X, Y, Z, and time for spatiotemporal boxes, and packed into full nodes in
+ * that order. Sort-Tile-Recursive cuts the data into slabs of the first axes
+ * only, so that the entries of a node of a long trajectory may be far apart
+ * in time, whereas the Hilbert curve keeps the entries of a node close along
+ * every axis. #rtree_overlap and #rtree_search_cost compare the two
+ * strategies on the data and the queries of an application.
+ * @param[in] rtree An EMPTY RTree of the appropriate bounding box type
+ * @param[in] boxes Contiguous array of @p count boxes of the tree bbox size
+ * @param[in] ids The id of each box
+ * @param[in] count Number of entries
+ * @param[in] load The packing strategy
+ * @param[in] nthreads Number of threads, values `<= 1` build the tree on the
+ * calling thread
+ */
+void
+rtree_load_config(RTree *rtree, const void *boxes, const int64 *ids,
+  int count, RTreeLoad load, int nthreads)
+{
+  if (load != RTREE_LOAD_STR && load != RTREE_LOAD_HILBERT)
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "Unknown load strategy of an RTree: %d", (int) load);
+    return;
+  }
+  rtree_load_threads(rtree, boxes, ids, count, load,
+    nthreads < 1 ? 1 : nthreads);
+  return;
+}
+
+/*****************************************************************************
+ * Statistics
+ *****************************************************************************/
+
+/**
+ * @brief Return the box of an entry of an inner node of an RTree
+ * @details A node with a quantized layout only stores the codes of the boxes
+ * of its entries, whose exact boxes are the own boxes of the children
+ */
+static const void *
+inner_entry_box(const RTree *rtree, const RTreeNode *node, int i)
+{
+  if (RTREE_QUANTIZED(rtree))
+    return RTREE_NODE_BBOX_N(RTREE_NODE_CHILD_N(rtree, node, i), 0);
+  return RTREE_NODE_BBOX_N(node, i);
+}
+
+/**
+ * @brief Return the volume of the intersection of two boxes relative to the
+ * extent of an RTree, or -1 if the boxes do not intersect
+ * @details The axes on which the extent of the tree is flat or infinite do not
+ * take part in the volume
+ */
+static double
+box_overlap_volume(const RTree *rtree, const void *box1, const void *box2)
+{
+  double result = 1.0;
+  for (int a = 0; a < rtree->dims; a++)
+  {
+    double lower = Max(rtree->get_axis(box1, a, false),
+      rtree->get_axis(box2, a, false));
+    double upper = Min(rtree->get_axis(box1, a, true),
+      rtree->get_axis(box2, a, true));
+    if (upper < lower)
+      return -1.0;
+    double extent = get_axis_length(rtree, rtree->box, a);
+    if (extent > 0.0 && isfinite(extent))
+      result *= (upper - lower) / extent;
+  }
+  return result;
+}
+
+/**
+ * @brief Accumulate the overlap of the entries of the inner nodes of a
+ * subtree of an RTree
+ */
+static void
+node_overlap(const RTree *rtree, const RTreeNode *node, RTreeOverlap *stats)
+{
+  if (node->node_type == RTREE_LEAF)
+    return;
+  stats->nodes++;
+  for (int i = 0; i < node->count; i++)
+  {
+    const void *box = inner_entry_box(rtree, node, i);
+    stats->volume += box_overlap_volume(rtree, box, box);
+    for (int j = i + 1; j < node->count; j++)
+    {
+      double volume = box_overlap_volume(rtree, box,
+        inner_entry_box(rtree, node, j));
+      stats->pairs++;
+      if (volume >= 0.0)
+      {
+        stats->overlapping++;
+        stats->overlap += volume;
+      }
+    }
+    node_overlap(rtree, RTREE_NODE_CHILD_N(rtree, node, i), stats);
+  }
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Return the overlap of the nodes of an RTree
+ * @details The statistics are computed over the entries of the inner nodes,
+ * i.e., the boxes of the nodes below the root, since every pair of entries of
+ * a node whose boxes intersect leads a search of their intersection into both
+ * of them. The volumes are relative to the extent of the tree, whose volume
+ * is 1, so that trees of the same data built by different strategies, e.g.,
+ * with #rtree_load_config, compare: the smaller the overlap and the volume,
+ * the fewer nodes a search visits.
+ * @param[in] rtree The RTree
+ * @param[out] stats The statistics, set to zero for an empty tree or a tree
+ * made of a single leaf
+ */
+void
+rtree_overlap(const RTree *rtree, RTreeOverlap *stats)
+{
+  assert(rtree); assert(stats);
+  memset(stats, 0, sizeof(RTreeOverlap));
+  if (rtree->root)
+    node_overlap(rtree, rtree->root, stats);
+  return;
+}
+
+/**
+ * @brief Accumulate the statistics of a subtree of an RTree
+ */
+static void
+node_stats(const RTree *rtree, const RTreeNode *node, int level,
+  RTreeStats *stats)
+{
+  stats->height = Max(stats->height, level);
+  stats->fill += (double) node->count / rtree->maxitems;
+  if (node->node_type == RTREE_LEAF)
+  {
+    stats->leaves++;
+    stats->entries += node->count;
+    return;
+  }
+  stats->inner_nodes++;
+  for (int i = 0; i < node->count; i++)
+    node_stats(rtree, RTREE_NODE_CHILD_N(rtree, node, i), level + 1, stats);
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Return the statistics of an RTree
+ * @details The statistics describe the shape of the tree, e.g., to compare
+ * the node capacities and split algorithms of #rtree_create_config, the
+ * strategies of #rtree_load_config, or the number of boxes per value of
+ * #rtree_insert_temporal_split on the data of an application, while
+ * #rtree_search_cost measures the searches. The overlap is the one of
+ * #rtree_overlap. The memory is the one of the nodes, or the size of the file
+ * mapping for a tree opened by #rtree_open.
+ * @param[in] rtree The RTree
+ * @param[out] stats The statistics
+ */
+void
+rtree_stats(const RTree *rtree, RTreeStats *stats)
+{
+  assert(rtree); assert(stats);
+  memset(stats, 0, sizeof(RTreeStats));
+  stats->memory = sizeof(RTree) + rtree->bboxsize;
+  if (rtree->base)
+    stats->memory += rtree->mapsize;
+  if (! rtree->root)
+    return;
+  node_stats(rtree, rtree->root, 1, stats);
+  int64 nodes = stats->inner_nodes + stats->leaves;
+  stats->fill /= (double) nodes;
+  if (! rtree->base)
+    stats->memory += (size_t) nodes * rtree_node_size(rtree);
+  RTreeOverlap overlap;
+  rtree_overlap(rtree, &overlap);
+  stats->overlap = overlap.overlap;
+  return;
+}
+
+/**
+ * @brief Insert a bounding box into an RTree
+ * @param[in] rtree The RTree
+ * @param[in] box The bounding box to be inserted
+ * @param[in] id The id of the box being inserted
+ * @param[in,out] re Entries evicted for reinsertion, `NULL` when overflows are
+ * always treated by splitting
  */
 static void
-node_join(const RTree *rtree1, const RTreeNode *node1, const void *box1,
-  const RTree *rtree2, const RTreeNode *node2, const void *box2,
-  RTreeSearchOp op, MeosArray *result)
+rtree_insert_entry(RTree *rtree, void *box, int64 id, RTreeReinsert *re)
 {
-  if (box1 && box2 && ! rtree1->bbox_overlaps(box1, box2))
-    return;
-
-  bool leaf1 = (node1->node_type == RTREE_LEAF);
-  bool leaf2 = (node2->node_type == RTREE_LEAF);
-  if (leaf1 && leaf2)
+  while (1)
   {
-    for (int i = 0; i < node1->count; ++i)
+    if (! rtree->root)
     {
-      const void *key = RTREE_NODE_BBOX_N(node1, i);
-      for (int j = 0; j < node2->count; ++j)
-      {
-        if (leaf_consistent(rtree1, key, RTREE_NODE_BBOX_N(node2, j), op))
-        {
-          int64 id1 = node1->ids[i];
-          int64 id2 = node2->ids[j];
-          meos_array_add(result, &id1);
-          meos_array_add(result, &id2);
-        }
-      }
+      if (rtree->dims < 0)
+        rtree->dims = 3 + MEOS_FLAGS_GET_Z(((STBox *) box)->flags);
+      RTreeNode *new_root = node_make(rtree, RTREE_LEAF);
+      rtree->root = new_root;
+      memcpy(rtree->box, box, rtree->bboxsize);
     }
+    if (rtree->shared)
+      rtree->root = node_cow(rtree, rtree->root);
+    /* A root leaf is always split */
+    if (re)
+      re->allowed = (rtree->root->node_type == RTREE_INNER);
+    bool split = false;
+    node_insert(rtree, &rtree->box, rtree->root, box, id, re, &split);
+    if (! split)
+    {
+      if (re && re->shrunk)
+        node_box_calculate(rtree, rtree->root, &rtree->box);
+      else
+        rtree->bbox_expand(box, &rtree->box);
+      return;
+    }
+    RTreeNode *new_root = node_make(rtree, RTREE_INNER);
+    RTreeNode *right;
+    node_split(rtree, rtree->root, &rtree->box, &right);
+
+    node_box_calculate(rtree, rtree->root, RTREE_NODE_BBOX_N(new_root, 0));
+    node_box_calculate(rtree, right, RTREE_NODE_BBOX_N(new_root, 1));
+    new_root->nodes[0] = rtree->root;
+    new_root->nodes[1] = right;
+    rtree->root = new_root;
+    rtree->root->count = 2;
+    node_sync_axes(rtree, new_root);
   }
-  else if (! leaf1 && leaf2)
-  {
-    for (int i = 0; i < node1->count; ++i)
-      node_join(rtree1, node1->nodes[i], RTREE_NODE_BBOX_N(node1, i), rtree2,
-        node2, box2, op, result);
-  }
-  else if (leaf1 && ! leaf2)
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Insert a bounding box into the RTree index.
+ * @note The parameter `id` is used for the search function, when a match
+ * is found the id will be returned. The bounding box will be copied into the
+ * RTRee.
+ * @param[in] rtree The RTree previously initialized
+ * @param[in] box The bounding box to be inserted
+ * @param[in] id The id of the box being inserted
+ */
+void
+rtree_insert(RTree *rtree, void *box, int64 id)
+{
+  if (! ensure_rtree_not_mapped(rtree) ||
+      ! ensure_rtree_not_quantized(rtree))
+    return;
+  if (rtree->shared)
   {
-    for (int j = 0; j < node2->count; ++j)
-      node_join(rtree1, node1, box1, rtree2, node2->nodes[j],
-        RTREE_NODE_BBOX_N(node2, j), op, result);
+    /* The forced reinsertion of the R*-tree modifies nodes outside of the
+     * insertion path, so a concurrent tree only splits */
+    rtree_insert_entry(rtree, box, id, NULL);
+    rtree_publish(rtree);
+    return;
   }
-  else
+  if (rtree->split != RTREE_SPLIT_RSTAR)
   {
-    for (int i = 0; i < node1->count; ++i)
-      for (int j = 0; j < node2->count; ++j)
-        node_join(rtree1, node1->nodes[i], RTREE_NODE_BBOX_N(node1, i), rtree2,
-          node2->nodes[j], RTREE_NODE_BBOX_N(node2, j), op, result);
+    rtree_insert_entry(rtree, box, id, NULL);
+    return;
   }
+  /* The entries evicted by the insertion are inserted again, overflows being
+   * then treated by splitting */
+  RTreeReinsert re;
+  re.allowed = false;
+  re.shrunk = false;
+  re.boxes = meos_array_create((int) rtree->bboxsize);
+  re.ids = meos_array_create(sizeof(int64));
+  rtree_insert_entry(rtree, box, id, &re);
+  int count = meos_array_count(re.ids);
+  for (int i = 0; i < count; i++)
+    rtree_insert_entry(rtree, meos_array_get(re.boxes, i),
+      *(int64 *) meos_array_get(re.ids, i), NULL);
+  meos_array_destroy(re.boxes);
+  meos_array_destroy(re.ids);
   return;
 }
 
+/*****************************************************************************
+ * Concurrent readers
+ *
+ * In the concurrent mode an RTree is modified by a single writer thread while
+ * any number of reader threads search snapshots of it. An insertion copies
+ * the nodes of the insertion path instead of modifying them, so that the
+ * nodes reachable from a published version never change, and publishes the
+ * new version with an atomic swap. A snapshot is opened without any lock and
+ * sees the tree as it was after the last insertion published, whatever the
+ * insertions that follow. The nodes replaced by an insertion are freed by the
+ * writer with epoch-based reclamation, once no open snapshot can reach them.
+ *****************************************************************************/
+
 /**
- * @brief Creates an RTree index.
- * @param[in] bboxtype The MeosType of the elements to index.
- * @return RTree initialized.
+ * @brief Snapshot of a concurrent RTree
  */
-RTree *
-rtree_create(MeosType bboxtype)
+struct RTreeSnapshot
 {
-  assert(span_type(bboxtype) || bboxtype == T_TBOX || bboxtype == T_STBOX
-#if POINTCLOUD
-    || bboxtype == T_TPCBOX
-#endif
-    );
-  size_t bboxsize = bbox_get_size(bboxtype);
-  RTree *rtree = palloc0(sizeof(RTree) + bboxsize);
-  if (span_type(bboxtype))
+  RTreeShared *shared;    /**< State of the concurrent mode of the tree */
+  int slot;               /**< Slot announcing the epoch of the snapshot */
+  const RTree *rtree;     /**< Version of the tree read by the snapshot */
+};
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Set an RTree in the concurrent mode, in which a single writer thread
+ * inserts while reader threads search snapshots of the tree
+ * @details The writer thread inserts with #rtree_insert and its variants and
+ * may search the tree itself, while the other threads search the trees of the
+ * snapshots opened with #rtree_snapshot_open, which never wait for the
+ * writer. A concurrent tree cannot be loaded in bulk, deleted from, or
+ * updated, and the R*-tree split algorithm does not reinsert entries. The
+ * snapshots allocate memory, so an allocator installed with
+ * #meos_initialize_allocator must be thread-safe.
+ * @param[in] rtree The RTree, which is filled beforehand with #rtree_load
+ * when built in bulk
+ * @return True on success, false if the tree is mapped from a file or has
+ * quantized nodes
+ */
+bool
+rtree_set_concurrent(RTree *rtree)
+{
+  assert(rtree);
+  if (! ensure_rtree_not_mapped(rtree) ||
+      ! ensure_rtree_not_quantized(rtree))
+    return false;
+  if (rtree->shared)
+    return true;
+  rtree->shared = palloc0(sizeof(RTreeShared));
+  rtree->shared->epoch = 1;
+  rtree_publish(rtree);
+  return true;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Open a snapshot of an RTree in the concurrent mode
+ * @details The snapshot is the tree after the last insertion published, which
+ * its searches see until it is closed with #rtree_snapshot_close. The nodes
+ * of the snapshot are kept while it is open, so a snapshot is meant to be
+ * held for a query or a batch of queries.
+ * @param[in] rtree The RTree, set in the concurrent mode with
+ * #rtree_set_concurrent
+ * @return The snapshot, `NULL` if the tree is not in the concurrent mode or
+ * if @p RTREE_MAX_SNAPSHOTS snapshots are already open
+ */
+RTreeSnapshot *
+rtree_snapshot_open(const RTree *rtree)
+{
+  assert(rtree);
+  RTreeShared *shared = rtree->shared;
+  if (! shared)
   {
-    rtree->dims = 1;
-    rtree->get_axis = &get_axis_span;
-    rtree->bbox_expand = &bbox_expand_span;
-    rtree->bbox_contains = &bbox_contains_span;
-    rtree->bbox_overlaps = &bbox_overlaps_span;
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "A snapshot requires an RTree in the concurrent mode");
+    return NULL;
   }
-  else if (bboxtype == T_TBOX)
+  /* The epoch is announced before the version is read, so that the writer
+   * keeps the nodes of any version read afterwards */
+  uint64 epoch = __atomic_load_n(&shared->epoch, __ATOMIC_SEQ_CST);
+  for (int i = 0; i < RTREE_MAX_SNAPSHOTS; i++)
   {
-    rtree->dims = 2;
-    rtree->get_axis = &get_axis_tbox;
-    rtree->bbox_expand = &bbox_expand_tbox;
-    rtree->bbox_contains = &bbox_contains_tbox;
-    rtree->bbox_overlaps = &bbox_overlaps_tbox;
+    uint64 expected = 0;
+    if (__atomic_compare_exchange_n(&shared->slots[i], &expected, epoch,
+        false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+      RTreeSnapshot *snapshot = palloc(sizeof(RTreeSnapshot));
+      snapshot->shared = shared;
+      snapshot->slot = i;
+      snapshot->rtree = __atomic_load_n(&shared->current, __ATOMIC_SEQ_CST);
+      return snapshot;
+    }
   }
-#if POINTCLOUD
-  else if (bboxtype == T_TPCBOX)
+  meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+    "An RTree cannot have more than %d open snapshots", RTREE_MAX_SNAPSHOTS);
+  return NULL;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Return the tree of a snapshot of a concurrent RTree
+ * @details The tree is read-only and supports all the searches of an RTree,
+ * e.g., #rtree_search, the cursors, and #rtree_stats, until the snapshot is
+ * closed.
+ * @param[in] snapshot The snapshot
+ */
+const RTree *
+rtree_snapshot_tree(const RTreeSnapshot *snapshot)
+{
+  assert(snapshot);
+  return snapshot->rtree;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Close a snapshot of a concurrent RTree
+ * @details The nodes that only the snapshot was reading are freed by a later
+ * insertion of the writer. The snapshots must be closed before the tree is
+ * freed.
+ * @param[in] snapshot The snapshot
+ */
+void
+rtree_snapshot_close(RTreeSnapshot *snapshot)
+{
+  if (! snapshot)
+    return;
+  __atomic_store_n(&snapshot->shared->slots[snapshot->slot], 0,
+    __ATOMIC_SEQ_CST);
+  pfree(snapshot);
+  return;
+}
+
+/**
+ * @brief Search an RTree with a bounding box, appending the matching IDs to
+ * a MeosArray without resetting it
+ */
+static void
+rtree_search_append(const RTree *rtree, RTreeSearchOp op, const void *query,
+  MeosArray *result, RTreeSearchCost *cost)
+{
+  if (! rtree->root)
+    return;
+  if (rtree->layout == RTREE_LAYOUT_AXES)
   {
-    /* dims set at first-insert time, like STBox (Z presence
-     * determined dynamically) */
-    rtree->dims = -1;
-    rtree->get_axis = &get_axis_tpcbox;
-    rtree->bbox_expand = &bbox_expand_tpcbox;
-    rtree->bbox_contains = &bbox_contains_tpcbox;
-    rtree->bbox_overlaps = &bbox_overlaps_tpcbox;
+    RTreeAxesQuery q;
+    axes_query_init(rtree, query, &q);
+    node_search_axes(rtree, rtree->root, op, query, &q, result, cost);
   }
-#endif
-  else /* bboxtype == T_STBOX */
+  else if (RTREE_QUANTIZED(rtree))
   {
-    /* To be set when the first node is created since it is not known yet
-     * whether there is a Z dimension or not */
-    rtree->dims = -1;
-    rtree->get_axis = &get_axis_stbox;
-    rtree->bbox_expand = &bbox_expand_stbox;
-    rtree->bbox_contains = &bbox_contains_stbox;
-    rtree->bbox_overlaps = &bbox_overlaps_stbox;
+    RTreeAxesQuery q;
+    axes_query_init(rtree, query, &q);
+    node_search_quant(rtree, rtree->root, op, &q, result, cost);
   }
-  rtree->bboxtype = bboxtype;
-  rtree->bboxsize = bboxsize;
-  return rtree;
+  else
+    node_search(rtree, rtree->root, op, query, result, cost);
+  return;
 }
 
 /**
- * @ingroup meos_misc
- * @brief Creates an RTree index for integer spans
- * @return RTree initialized
+ * @ingroup meos_geo_box_index
+ * @brief Search an RTree with a bounding box, collecting matching IDs into
+ * a MeosArray
+ * @details The result array is reset before the search. After the call,
+ * use the returned count and #meos_array_get to read the matching IDs.
+ * The same array can be reused across multiple searches without reallocating.
+ * For a tree with quantized nodes the IDs are candidates, a superset of the
+ * matching ones.
+ * @param[in] rtree The RTree to query
+ * @param[in] op The search operation: @p RTREE_OVERLAPS finds boxes that
+ * overlap the query, @p RTREE_CONTAINS finds boxes that contain the query,
+ * @p RTREE_CONTAINED_BY finds boxes contained by the query
+ * @param[in] query The bounding box that serves as query
+ * @param[out] result MeosArray of int to collect matching IDs (created by the
+ * caller with `meos_array_create(sizeof(int64))`)
+ * @return Number of matching IDs
  */
-RTree *
-rtree_create_intspan()
+int
+rtree_search(const RTree *rtree, RTreeSearchOp op, const void *query,
+  MeosArray *result)
 {
-  return rtree_create(T_INTSPAN);
+  return rtree_search_cost(rtree, op, query, result, NULL);
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Search an RTree with a bounding box as #rtree_search, measuring the
+ * cost of the search
+ * @details The counters of @p cost are incremented by the number of nodes the
+ * search visits, of entries it tests against the query, and of ids it
+ * returns, so that the cost of a workload is obtained by passing the same
+ * structure, set to zero beforehand, to all its searches. This allows, e.g.,
+ * comparing the node capacities and split algorithms of #rtree_create_config
+ * on the queries of an application.
+ * @param[in] rtree The RTree to query
+ * @param[in] op The search operation
+ * @param[in] query The bounding box that serves as query
+ * @param[out] result MeosArray of int to collect matching IDs
+ * @param[in,out] cost Counters of the cost of the searches
+ * @return Number of matching IDs
+ */
+int
+rtree_search_cost(const RTree *rtree, RTreeSearchOp op, const void *query,
+  MeosArray *result, RTreeSearchCost *cost)
+{
+  meos_array_reset(result);
+  rtree_search_append(rtree, op, query, result, cost);
+  int count = meos_array_count(result);
+  if (cost)
+    cost->results += count;
+  return count;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Join two RTrees, collecting the ids of every qualifying pair into a
+ * MeosArray
+ * @details Descends both trees at once, skipping the entries of a subtree pair
+ * whose boxes are disjoint, so a join reads far fewer pairs than querying one
+ * tree once per entry of the other.
+ *
+ * The result array is reset before the join. It receives two ids per pair, the
+ * entry of @p rtree1 followed by the entry of @p rtree2, so pair `k` is read
+ * with #meos_array_get at positions `2 * k` and `2 * k + 1`.
+ * @param[in] rtree1,rtree2 The RTrees to join, of the same bounding box type
+ * @param[in] op The join operation: @p RTREE_OVERLAPS pairs entries that
+ * overlap, @p RTREE_CONTAINS pairs entries of @p rtree1 that contain an entry
+ * of @p rtree2, @p RTREE_CONTAINED_BY pairs entries of @p rtree1 contained by
+ * an entry of @p rtree2
+ * @param[out] result MeosArray of int to collect the ids (created by the caller
+ * with `meos_array_create(sizeof(int64))`)
+ * @return Number of qualifying pairs, half the number of collected ids, -1 if
+ * a tree has quantized nodes
+ */
+int
+rtree_join(const RTree *rtree1, const RTree *rtree2, RTreeSearchOp op,
+  MeosArray *result)
+{
+  assert(rtree1->bboxtype == rtree2->bboxtype);
+  meos_array_reset(result);
+  if (! ensure_rtree_not_quantized(rtree1) ||
+      ! ensure_rtree_not_quantized(rtree2))
+    return -1;
+  if (rtree1->root && rtree2->root)
+    node_join(rtree1, rtree1->root, NULL, rtree2, rtree2->root, NULL, op,
+      result);
+  return meos_array_count(result) / 2;
+}
+
+#if MEOS && ! defined(NO_PTHREAD)
+/*****************************************************************************
+ * Parallel join
+ *
+ * The pairs of subtrees that #node_join would visit are expanded breadth
+ * first from the pair of roots, dropping the pairs whose boxes are disjoint,
+ * until there are enough of them to keep every thread busy. Expanding a pair
+ * replaces it by its children pairs in the order #node_join visits them, so
+ * the list of pairs is in depth-first order. Each thread owns a contiguous
+ * range of pairs that it joins from the front, and an idle thread steals
+ * pairs from the back of the range of another one. Every pair is joined into
+ * its own array, and the arrays are concatenated in the order of the pairs,
+ * so that the result is the one of the sequential join, in the same order.
+ *****************************************************************************/
+
+/**
+ * @brief Pair of subtrees of two RTrees to be joined
+ */
+typedef struct
+{
+  const RTreeNode *node1;   /**< Subtree of the first tree */
+  const void *box1;         /**< Box of @p node1, `NULL` for the root */
+  const RTreeNode *node2;   /**< Subtree of the second tree */
+  const void *box2;         /**< Box of @p node2, `NULL` for the root */
+} RTreeJoinPair;
+
+/**
+ * @brief Add a pair of subtrees to an array of pairs unless their boxes are
+ * disjoint
+ */
+static void
+join_pair_add(const RTree *rtree1, MeosArray *pairs, const RTreeNode *node1,
+  const void *box1, const RTreeNode *node2, const void *box2)
+{
+  if (box1 && box2 && ! rtree1->bbox_overlaps(box1, box2))
+    return;
+  RTreeJoinPair pair;
+  pair.node1 = node1; pair.box1 = box1;
+  pair.node2 = node2; pair.box2 = box2;
+  meos_array_add(pairs, &pair);
+  return;
+}
+
+/**
+ * @brief Return the pairs of subtrees of two RTrees to be joined, expanded
+ * from the roots until there are at least a given number of them or until
+ * they are all pairs of leaves
+ */
+static MeosArray *
+join_pairs_make(const RTree *rtree1, const RTree *rtree2, int target)
+{
+  MeosArray *pairs = meos_array_create(sizeof(RTreeJoinPair));
+  join_pair_add(rtree1, pairs, rtree1->root, NULL, rtree2->root, NULL);
+  bool expanded = true;
+  while (expanded && meos_array_count(pairs) < target)
+  {
+    expanded = false;
+    MeosArray *next = meos_array_create(sizeof(RTreeJoinPair));
+    int count = meos_array_count(pairs);
+    for (int k = 0; k < count; k++)
+    {
+      RTreeJoinPair *p = (RTreeJoinPair *) meos_array_get(pairs, k);
+      bool leaf1 = (p->node1->node_type == RTREE_LEAF);
+      bool leaf2 = (p->node2->node_type == RTREE_LEAF);
+      if (leaf1 && leaf2)
+      {
+        meos_array_add(next, p);
+        continue;
+      }
+      expanded = true;
+      /* Same descent as #node_join */
+      if (! leaf1 && leaf2)
+      {
+        for (int i = 0; i < p->node1->count; ++i)
+          join_pair_add(rtree1, next, RTREE_NODE_CHILD_N(rtree1, p->node1, i),
+            RTREE_NODE_BBOX_N(p->node1, i), p->node2, p->box2);
+      }
+      else if (leaf1 && ! leaf2)
+      {
+        for (int j = 0; j < p->node2->count; ++j)
+          join_pair_add(rtree1, next, p->node1, p->box1,
+            RTREE_NODE_CHILD_N(rtree2, p->node2, j),
+            RTREE_NODE_BBOX_N(p->node2, j));
+      }
+      else
+      {
+        for (int i = 0; i < p->node1->count; ++i)
+          for (int j = 0; j < p->node2->count; ++j)
+            join_pair_add(rtree1, next,
+              RTREE_NODE_CHILD_N(rtree1, p->node1, i),
+              RTREE_NODE_BBOX_N(p->node1, i),
+              RTREE_NODE_CHILD_N(rtree2, p->node2, j),
+              RTREE_NODE_BBOX_N(p->node2, j));
+      }
+    }
+    meos_array_destroy(pairs);
+    pairs = next;
+  }
+  return pairs;
 }
 
 /**
- * @ingroup meos_misc
- * @brief Creates an RTree index for big integer spans
- * @return RTree initialized
+ * @brief Range of pairs owned by a thread of the parallel join
  */
-RTree *
-rtree_create_bigintspan()
+typedef struct
 {
-  return rtree_create(T_BIGINTSPAN);
-}
+  pthread_mutex_t lock;     /**< Protects @p next and @p end */
+  int next;                 /**< First pair not yet taken */
+  int end;                  /**< End of the range */
+} RTreeJoinRange;
 
 /**
- * @ingroup meos_misc
- * @brief Creates an RTree index for float spans
- * @return RTree initialized
+ * @brief State shared by the threads of the parallel join
  */
-RTree *
-rtree_create_floatspan()
+typedef struct
 {
-  return rtree_create(T_FLOATSPAN);
-}
+  const RTree *rtree1;      /**< First tree */
+  const RTree *rtree2;      /**< Second tree */
+  RTreeSearchOp op;         /**< Join operation */
+  MeosArray *pairs;         /**< Pairs of subtrees to join */
+  MeosArray **results;      /**< Result of every pair */
+  RTreeJoinRange *ranges;   /**< Range of pairs of every thread */
+  int nthreads;             /**< Number of threads */
+} RTreeJoinState;
 
 /**
- * @ingroup meos_misc
- * @brief Creates an RTree index for temporal boxes
- * @return RTree initialized
+ * @brief Task of a thread of the parallel join
  */
-RTree *
-rtree_create_datespan()
+typedef struct
 {
-  return rtree_create(T_DATESPAN);
-}
+  RTreeJoinState *state;    /**< Shared state */
+  int self;                 /**< Number of the thread */
+} RTreeJoinTask;
 
 /**
- * @ingroup meos_misc
- * @brief Creates an RTree index for temporal boxes
- * @return RTree initialized
+ * @brief Take the next pair of a thread, or steal the last pair of another
+ * thread when its own range is exhausted
+ * @return The number of the pair, -1 when all the pairs are taken
  */
-RTree *
-rtree_create_tstzspan()
+static int
+join_take(RTreeJoinState *state, int self)
 {
-  return rtree_create(T_TSTZSPAN);
+  RTreeJoinRange *range = &state->ranges[self];
+  int result = -1;
+  pthread_mutex_lock(&range->lock);
+  if (range->next < range->end)
+    result = range->next++;
+  pthread_mutex_unlock(&range->lock);
+  for (int k = 1; k < state->nthreads && result < 0; k++)
+  {
+    RTreeJoinRange *victim = &state->ranges[(self + k) % state->nthreads];
+    pthread_mutex_lock(&victim->lock);
+    if (victim->next < victim->end)
+      result = --victim->end;
+    pthread_mutex_unlock(&victim->lock);
+  }
+  return result;
 }
 
-/**
- * @ingroup meos_misc
- * @brief Creates an RTree index for temporal boxes
- * @return RTree initialized
- */
-RTree *
-rtree_create_tbox()
+static void *
+join_worker(void *arg)
 {
-  return rtree_create(T_TBOX);
+  RTreeJoinTask *task = (RTreeJoinTask *) arg;
+  RTreeJoinState *state = task->state;
+  int k;
+  while ((k = join_take(state, task->self)) >= 0)
+  {
+    const RTreeJoinPair *p = (const RTreeJoinPair *)
+      meos_array_get(state->pairs, k);
+    node_join(state->rtree1, p->node1, p->box1, state->rtree2, p->node2,
+      p->box2, state->op, state->results[k]);
+  }
+  return NULL;
 }
 
 /**
- * @ingroup meos_misc
- * @brief Creates an RTree index for spatiotemporal boxes
- * @return RTree initialized
+ * @brief Join the pairs of subtrees with several threads
  */
-RTree *
-rtree_create_stbox()
+static void
+join_pairs_parallel(RTreeJoinState *state)
 {
-  return rtree_create(T_STBOX);
+  int npairs = meos_array_count(state->pairs);
+  int nthreads = state->nthreads;
+  state->ranges = palloc(sizeof(RTreeJoinRange) * nthreads);
+  RTreeJoinTask *tasks = palloc(sizeof(RTreeJoinTask) * nthreads);
+  pthread_t *threads = palloc(sizeof(pthread_t) * nthreads);
+  bool *started = palloc(sizeof(bool) * nthreads);
+  for (int i = 0; i < nthreads; i++)
+  {
+    pthread_mutex_init(&state->ranges[i].lock, NULL);
+    state->ranges[i].next = (int) (((int64) npairs * i) / nthreads);
+    state->ranges[i].end = (int) (((int64) npairs * (i + 1)) / nthreads);
+    tasks[i].state = state;
+    tasks[i].self = i;
+  }
+  /* The calling thread joins the pairs of the first range, and the pairs of
+   * a thread that cannot be started are stolen by the others */
+  for (int i = 1; i < nthreads; i++)
+    started[i] = (pthread_create(&threads[i], NULL, join_worker,
+      &tasks[i]) == 0);
+  join_worker(&tasks[0]);
+  for (int i = 1; i < nthreads; i++)
+  {
+    if (started[i])
+      pthread_join(threads[i], NULL);
+  }
+  for (int i = 0; i < nthreads; i++)
+    pthread_mutex_destroy(&state->ranges[i].lock);
+  pfree(state->ranges); pfree(tasks); pfree(threads); pfree(started);
+  return;
 }
+#endif /* MEOS && ! NO_PTHREAD */
 
-#if POINTCLOUD
 /**
- * @ingroup meos_pointcloud_box
- * @brief Create an in-memory RTree index for the @c tpcbox bounding-box
- *   type.  Pair with @ref rtree_insert / @ref rtree_insert_temporal to
- *   populate, @ref rtree_search / @ref rtree_search_temporal to query.
- * @return RTree initialized.
+ * @ingroup meos_geo_box_index
+ * @brief Join two RTrees using several threads, collecting the ids of every
+ * qualifying pair into a MeosArray
+ * @details The pairs of subtrees whose boxes overlap are shared among
+ * @p nthreads threads that balance their load by stealing pairs from each
+ * other. The result is exactly the one of #rtree_join, with the same pairs in
+ * the same order.
+ *
+ * The threads allocate the results, so an allocator installed with
+ * #meos_initialize_allocator must be thread-safe. When the library is built
+ * without POSIX threads the join is computed by the calling thread.
+ * @param[in] rtree1,rtree2 The RTrees to join, of the same bounding box type
+ * @param[in] op The join operation, as for #rtree_join
+ * @param[out] result MeosArray of int to collect the ids (created by the caller
+ * with `meos_array_create(sizeof(int64))`)
+ * @param[in] nthreads Number of threads, values `<= 1` compute the join on the
+ * calling thread
+ * @return Number of qualifying pairs, half the number of collected ids, -1 if
+ * a tree has quantized nodes
  */
-RTree *
-rtree_create_tpcbox()
+int
+rtree_join_parallel(const RTree *rtree1, const RTree *rtree2,
+  RTreeSearchOp op, MeosArray *result, int nthreads)
 {
-  return rtree_create(T_TPCBOX);
+  assert(rtree1->bboxtype == rtree2->bboxtype);
+  if (! ensure_rtree_not_quantized(rtree1) ||
+      ! ensure_rtree_not_quantized(rtree2))
+    return -1;
+#if MEOS && ! defined(NO_PTHREAD)
+  if (nthreads <= 1 || ! rtree1->root || ! rtree2->root)
+    return rtree_join(rtree1, rtree2, op, result);
+  meos_array_reset(result);
+  /* Enough pairs for the threads to balance pairs of uneven cost */
+  RTreeJoinState state;
+  state.rtree1 = rtree1;
+  state.rtree2 = rtree2;
+  state.op = op;
+  state.pairs = join_pairs_make(rtree1, rtree2, 16 * nthreads);
+  state.nthreads = nthreads;
+  int npairs = meos_array_count(state.pairs);
+  state.results = palloc(sizeof(MeosArray *) * Max(npairs, 1));
+  for (int k = 0; k < npairs; k++)
+    state.results[k] = meos_array_create(sizeof(int64));
+  join_pairs_parallel(&state);
+  for (int k = 0; k < npairs; k++)
+  {
+    int count = meos_array_count(state.results[k]);
+    for (int i = 0; i < count; i++)
+      meos_array_add(result, meos_array_get(state.results[k], i));
+    meos_array_destroy(state.results[k]);
+  }
+  pfree(state.results);
+  meos_array_destroy(state.pairs);
+  return meos_array_count(result) / 2;
+#else
+  (void) nthreads;
+  return rtree_join(rtree1, rtree2, op, result);
+#endif /* MEOS && ! NO_PTHREAD */
 }
-#endif
 
 /*****************************************************************************
- * STR bulk load (PROTOTYPE, for measurement)
+ * Batched search
+ *
+ * A batch of queries is answered with one traversal of the tree per group of
+ * queries instead of one traversal per query. The queries are first sorted
+ * along a Hilbert curve over the extent of the tree, so that the queries of a
+ * group are close to each other and descend into the same subtrees: a node is
+ * then read once for the whole group, and its entries are tested against the
+ * queries of the group while they are in the cache.
  *****************************************************************************/
 
+/* Number of queries sharing a traversal of the tree */
+#define RTREE_BATCH_SIZE 256
+
+/**
+ * @brief Query of a batch with its position on the Hilbert curve
+ */
 typedef struct
 {
-  void *box;          /**< bbox of the item (leaf: caller's; inner: owned MBR) */
-  int64 id;           /**< leaf payload */
-  RTreeNode *child;   /**< inner payload */
-} STRItem;
-
-typedef struct { const RTree *tree; int axis; } STRCtx;
+  uint64 key;   /**< Hilbert key of the centre of the query */
+  int pos;      /**< Position of the query in the batch */
+} RTreeBatchQuery;
 
-static int
-str_cmp(const void *a, const void *b, void *arg)
+/**
+ * @brief Id found by a batched search with the position of its query
+ */
+typedef struct
 {
-  const STRCtx *c = (const STRCtx *) arg;
-  const STRItem *ia = (const STRItem *) a;
-  const STRItem *ib = (const STRItem *) b;
-  double ca = (c->tree->get_axis(ia->box, c->axis, false) +
-               c->tree->get_axis(ia->box, c->axis, true)) / 2.0;
-  double cb = (c->tree->get_axis(ib->box, c->axis, false) +
-               c->tree->get_axis(ib->box, c->axis, true)) / 2.0;
-  return (ca > cb) - (ca < cb);
-}
+  int64 id;     /**< Id of the entry */
+  int pos;      /**< Position of the query in the batch */
+} RTreeBatchHit;
 
 /**
- * @brief Pack one level of items into nodes, Sort-Tile-Recursive
- * @details Sorts on the centre of axis 0, cuts into ceil(sqrt(pages)) slices,
- * sorts each slice on axis 1, then fills nodes to capacity. The packing order
- * affects tree QUALITY only; validity comes from each parent box being the
- * union of its children, computed here whatever the ordering.
+ * @brief Comparator of the queries of a batch on their Hilbert key, ties
+ * being broken by their position
  */
-static RTreeNode **
-str_pack_level(RTree *rtree, STRItem *items, int count, bool leaf, int *nout)
+static int
+batch_query_cmp(const void *a, const void *b)
 {
-  int pages = (count + MAXITEMS - 1) / MAXITEMS;
-  int slices = (int) ceil(sqrt((double) pages));
-  if (slices < 1) slices = 1;
-  int per_slice = slices * MAXITEMS;
-
-  STRCtx ctx; ctx.tree = rtree; ctx.axis = 0;
-  qsort_arg(items, (size_t) count, sizeof(STRItem), str_cmp, &ctx);
-
-  RTreeNode **out = palloc(sizeof(RTreeNode *) * (size_t) pages);
-  int nnodes = 0;
-  for (int s = 0; s < count; s += per_slice)
-  {
-    int slen = (count - s < per_slice) ? count - s : per_slice;
-    if (rtree->dims > 1)
-    {
-      ctx.axis = 1;
-      qsort_arg(items + s, (size_t) slen, sizeof(STRItem), str_cmp, &ctx);
-    }
-    for (int p = 0; p < slen; p += MAXITEMS)
-    {
-      int plen = (slen - p < MAXITEMS) ? slen - p : MAXITEMS;
-      RTreeNode *node = node_make(leaf ? RTREE_LEAF : RTREE_INNER, rtree->bboxsize);
-      for (int k = 0; k < plen; k++)
-      {
-        STRItem *it = &items[s + p + k];
-        memcpy(RTREE_NODE_BBOX_N(node, k), it->box, rtree->bboxsize);
-        if (leaf)
-          node->ids[k] = it->id;
-        else
-          node->nodes[k] = it->child;
-      }
-      node->count = plen;
-      out[nnodes++] = node;
-    }
-  }
-  *nout = nnodes;
-  return out;
+  const RTreeBatchQuery *qa = (const RTreeBatchQuery *) a;
+  const RTreeBatchQuery *qb = (const RTreeBatchQuery *) b;
+  if (qa->key != qb->key)
+    return qa->key < qb->key ? -1 : 1;
+  return (qa->pos > qb->pos) - (qa->pos < qb->pos);
 }
 
 /**
- * @ingroup meos_geo_box_index
- * @brief Build an RTree from all of its entries at once
- * @details Bottom-up Sort-Tile-Recursive packing. The result answers the same
- * queries as inserting every entry one by one, but the whole set is known in
- * advance, so nodes are filled to capacity and no node is ever split.
- * @param[in] rtree An EMPTY RTree of the appropriate bounding box type
- * @param[in] boxes Contiguous array of @p count boxes of the tree bbox size
- * @param[in] ids The id of each box
- * @param[in] count Number of entries
+ * @brief Return the number of levels of an RTree
  */
-void
-rtree_load(RTree *rtree, const void *boxes, const int64 *ids, int count)
+static int
+rtree_height(const RTree *rtree)
 {
-  if (count <= 0)
-    return;
-
-  /* A box type whose dimension count depends on the data carries -1 until the
-   * first box arrives, which for a tree grown by insertion is the first insert */
-  if (rtree->dims < 0)
-    rtree->dims = 3 + MEOS_FLAGS_GET_Z(((const STBox *) boxes)->flags);
-
-  STRItem *items = palloc(sizeof(STRItem) * (size_t) count);
-  for (int i = 0; i < count; i++)
-  {
-    items[i].box = (void *) ((const char *) boxes + (size_t) i * rtree->bboxsize);
-    items[i].id = ids[i];
-    items[i].child = NULL;
-  }
-
-  int nnodes;
-  RTreeNode **level = str_pack_level(rtree, items, count, true, &nnodes);
-  pfree(items);
-
-  while (nnodes > 1)
-  {
-    STRItem *up = palloc(sizeof(STRItem) * (size_t) nnodes);
-    for (int i = 0; i < nnodes; i++)
-    {
-      void *mbr = palloc0(rtree->bboxsize);
-      memcpy(mbr, RTREE_NODE_BBOX_N(level[i], 0), rtree->bboxsize);
-      for (int k = 1; k < level[i]->count; k++)
-        rtree->bbox_expand(RTREE_NODE_BBOX_N(level[i], k), mbr);
-      up[i].box = mbr; up[i].id = 0; up[i].child = level[i];
-    }
-    int prev = nnodes;
-    RTreeNode **parents = str_pack_level(rtree, up, prev, false, &nnodes);
-    for (int i = 0; i < prev; i++)
-      pfree(up[i].box);
-    pfree(up); pfree(level);
-    level = parents;
-  }
-
-  rtree->root = level[0];
-  memcpy(&rtree->box, RTREE_NODE_BBOX_N(level[0], 0), rtree->bboxsize);
-  for (int k = 1; k < level[0]->count; k++)
-    rtree->bbox_expand(RTREE_NODE_BBOX_N(level[0], k), &rtree->box);
-  pfree(level);
-  return;
+  int height = 1;
+  for (const RTreeNode *node = rtree->root; node->node_type == RTREE_INNER;
+      node = RTREE_NODE_CHILD_N(rtree, node, 0))
+    height++;
+  return height;
 }
 
-
 /**
- * @ingroup meos_geo_box_index
- * @brief Insert a bounding box into the RTree index.
- * @note The parameter `id` is used for the search function, when a match
- * is found the id will be returned. The bounding box will be copied into the
- * RTRee.
- * @param[in] rtree The RTree previously initialized
- * @param[in] box The bounding box to be inserted
- * @param[in] id The id of the box being inserted
+ * @brief Searches recursively a node of an RTree with a group of queries
+ * @param[in] rtree Pointer to the RTree structure
+ * @param[in] node The node to be searched
+ * @param[in] op The search operation (overlaps, contains, or contained by)
+ * @param[in] queries Contiguous array of the queries of the batch
+ * @param[in] group Positions of the queries consistent with the node
+ * @param[in] count Number of queries in @p group
+ * @param[in] scratch Room for the positions of the queries of the children,
+ * @p RTREE_BATCH_SIZE per level below the node
+ * @param[out] hits MeosArray collecting the ids found with their query
  */
-void
-rtree_insert(RTree *rtree, void *box, int64 id)
+static void
+node_search_batch(const RTree *rtree, const RTreeNode *node,
+  RTreeSearchOp op, const char *queries, const int *group, int count,
+  int *scratch, MeosArray *hits)
 {
-  while (1)
+  size_t size = rtree->bboxsize;
+  for (int i = 0; i < node->count; ++i)
   {
-    if (! rtree->root)
+    const void *box = RTREE_NODE_BBOX_N(node, i);
+    if (node->node_type == RTREE_LEAF)
     {
-      RTreeNode *new_root = node_make(RTREE_LEAF, rtree->bboxsize);
-      if (rtree->dims < 0)
-        rtree->dims = 3 + MEOS_FLAGS_GET_Z(((STBox *) box)->flags);
-      rtree->root = new_root;
-      memcpy(rtree->box, box, rtree->bboxsize);
+      for (int j = 0; j < count; j++)
+      {
+        if (leaf_consistent(rtree, box, queries + (size_t) group[j] * size,
+            op))
+        {
+          RTreeBatchHit hit;
+          hit.id = node->ids[i];
+          hit.pos = group[j];
+          meos_array_add(hits, &hit);
+        }
+      }
     }
-    bool split = false;
-    node_insert(rtree, &rtree->box, rtree->root, box, id, &split);
-    if (! split)
+    else
     {
-      rtree->bbox_expand(box, &rtree->box);
-      return;
+      int nsub = 0;
+      for (int j = 0; j < count; j++)
+      {
+        if (inner_consistent(rtree, box, queries + (size_t) group[j] * size,
+            op))
+          scratch[nsub++] = group[j];
+      }
+      if (nsub > 0)
+        node_search_batch(rtree, RTREE_NODE_CHILD_N(rtree, node, i), op,
+          queries, scratch, nsub, scratch + RTREE_BATCH_SIZE, hits);
     }
-    RTreeNode *new_root = node_make(RTREE_INNER, rtree->bboxsize);
-    RTreeNode *right;
-    node_split(rtree, rtree->root, &rtree->box, &right);
-
-    node_box_calculate(rtree, rtree->root, RTREE_NODE_BBOX_N(new_root, 0));
-    node_box_calculate(rtree, right, RTREE_NODE_BBOX_N(new_root, 1));
-    new_root->nodes[0] = rtree->root;
-    new_root->nodes[1] = right;
-    rtree->root = new_root;
-    rtree->root->count = 2;
-  }
-  return;
-}
-
-/**
- * @ingroup meos_geo_box_index
- * @brief Search an RTree with a bounding box, collecting matching IDs into
- * a MeosArray
- * @details The result array is reset before the search. After the call,
- * use the returned count and #meos_array_get to read the matching IDs.
- * The same array can be reused across multiple searches without reallocating.
- * @param[in] rtree The RTree to query
- * @param[in] op The search operation: @p RTREE_OVERLAPS finds boxes that
- * overlap the query, @p RTREE_CONTAINS finds boxes that contain the query,
- * @p RTREE_CONTAINED_BY finds boxes contained by the query
- * @param[in] query The bounding box that serves as query
- * @param[out] result MeosArray of int to collect matching IDs (created by the
- * caller with `meos_array_create(sizeof(int64))`)
- * @return Number of matching IDs
- */
-int
-rtree_search(const RTree *rtree, RTreeSearchOp op, const void *query,
-  MeosArray *result)
-{
-  meos_array_reset(result);
-  if (rtree->root)
-    node_search(rtree, rtree->root, op, query, result);
-  return meos_array_count(result);
+  }
+  return;
 }
 
 /**
  * @ingroup meos_geo_box_index
- * @brief Join two RTrees, collecting the ids of every qualifying pair into a
- * MeosArray
- * @details Descends both trees at once, skipping the entries of a subtree pair
- * whose boxes are disjoint, so a join reads far fewer pairs than querying one
- * tree once per entry of the other.
+ * @brief Search an RTree with a batch of bounding boxes, collecting the
+ * matching IDs of every query into a MeosArray
+ * @details The queries are sorted along a Hilbert curve and searched in groups
+ * of neighbouring queries, every group descending the tree once, so that a
+ * node needed by several queries of a group is read once instead of once per
+ * query.
  *
- * The result array is reset before the join. It receives two ids per pair, the
- * entry of @p rtree1 followed by the entry of @p rtree2, so pair `k` is read
- * with #meos_array_get at positions `2 * k` and `2 * k + 1`.
- * @param[in] rtree1,rtree2 The RTrees to join, of the same bounding box type
- * @param[in] op The join operation: @p RTREE_OVERLAPS pairs entries that
- * overlap, @p RTREE_CONTAINS pairs entries of @p rtree1 that contain an entry
- * of @p rtree2, @p RTREE_CONTAINED_BY pairs entries of @p rtree1 contained by
- * an entry of @p rtree2
- * @param[out] result MeosArray of int to collect the ids (created by the caller
- * with `meos_array_create(sizeof(int64))`)
- * @return Number of qualifying pairs, half the number of collected ids
+ * The result arrays are reset before the search. The IDs matching query `q`
+ * are those of @p result from position `offsets[q]` up to `offsets[q + 1]`
+ * excluded, in the order in which #rtree_search collects them, so that
+ * @p offsets receives `count + 1` positions.
+ * @param[in] rtree The RTree to query
+ * @param[in] op The search operation, as for #rtree_search
+ * @param[in] queries Contiguous array of @p count boxes of the tree bbox size
+ * @param[in] count Number of queries
+ * @param[out] result MeosArray of int to collect the matching IDs (created by
+ * the caller with `meos_array_create(sizeof(int64))`)
+ * @param[out] offsets MeosArray to collect the position in @p result of the
+ * first ID of every query (created by the caller with
+ * `meos_array_create(sizeof(int))`)
+ * @return Number of matching IDs of all the queries, -1 if the tree has
+ * quantized nodes
  */
 int
-rtree_join(const RTree *rtree1, const RTree *rtree2, RTreeSearchOp op,
-  MeosArray *result)
+rtree_search_batch(const RTree *rtree, RTreeSearchOp op, const void *queries,
+  int count, MeosArray *result, MeosArray *offsets)
 {
-  assert(rtree1->bboxtype == rtree2->bboxtype);
+  assert(rtree); assert(result); assert(offsets);
   meos_array_reset(result);
-  if (rtree1->root && rtree2->root)
-    node_join(rtree1, rtree1->root, NULL, rtree2, rtree2->root, NULL, op,
-      result);
-  return meos_array_count(result) / 2;
+  meos_array_reset(offsets);
+  if (! ensure_rtree_not_quantized(rtree))
+    return -1;
+  count = Max(count, 0);
+  MeosArray *hits = meos_array_create(sizeof(RTreeBatchHit));
+  if (rtree->root && count > 0)
+  {
+    assert(queries);
+    RTreeBatchQuery *order = palloc(sizeof(RTreeBatchQuery) * (size_t) count);
+    for (int q = 0; q < count; q++)
+    {
+      order[q].key = rtree_hilbert_key(rtree,
+        (const char *) queries + (size_t) q * rtree->bboxsize);
+      order[q].pos = q;
+    }
+    qsort(order, (size_t) count, sizeof(RTreeBatchQuery), batch_query_cmp);
+    /* One group of positions per level, the first one for the root */
+    int *scratch = palloc(sizeof(int) * RTREE_BATCH_SIZE *
+      (size_t) (rtree_height(rtree) + 1));
+    for (int start = 0; start < count; start += RTREE_BATCH_SIZE)
+    {
+      int n = Min(count - start, RTREE_BATCH_SIZE);
+      for (int j = 0; j < n; j++)
+        scratch[j] = order[start + j].pos;
+      node_search_batch(rtree, rtree->root, op, (const char *) queries,
+        scratch, n, scratch + RTREE_BATCH_SIZE, hits);
+    }
+    pfree(scratch);
+    pfree(order);
+  }
+
+  /* Group the ids per query, a query being searched by a single traversal
+   * its ids are found in the order of #rtree_search */
+  int nhits = meos_array_count(hits);
+  int *next = palloc0(sizeof(int) * (size_t) (count + 1));
+  for (int i = 0; i < nhits; i++)
+    next[((RTreeBatchHit *) meos_array_get(hits, i))->pos + 1]++;
+  for (int q = 0; q < count; q++)
+    next[q + 1] += next[q];
+  for (int q = 0; q <= count; q++)
+    meos_array_add(offsets, &next[q]);
+  int64 *ids = palloc(sizeof(int64) * (size_t) (nhits + 1));
+  for (int i = 0; i < nhits; i++)
+  {
+    RTreeBatchHit *hit = (RTreeBatchHit *) meos_array_get(hits, i);
+    ids[next[hit->pos]++] = hit->id;
+  }
+  for (int i = 0; i < nhits; i++)
+    meos_array_add(result, &ids[i]);
+  pfree(ids);
+  pfree(next);
+  meos_array_destroy(hits);
+  return nhits;
 }
 
 /**
@@ -1495,6 +4120,428 @@ rtree_search_temporal_dedup(const RTree *rtree, RTreeSearchOp op,
   return meos_array_count(result);
 }
 
+/*****************************************************************************
+ * Deletion and update
+ *
+ * An entry is located by descending every child whose box contains the box of
+ * the entry, and is removed from its leaf. On the way back up the tree is
+ * condensed as in Guttman's CondenseTree: a node left with fewer than the
+ * minimum number of entries is unlinked from its parent and the leaf entries
+ * of its subtree are inserted again once the removal is complete, while the
+ * box every other ancestor holds is recomputed so that it stays tight. A root left with a
+ * single child is replaced by that child.
+ *****************************************************************************/
+
+/**
+ * @brief Return true if two bounding boxes of the RTree's box type are equal
+ */
+static inline bool
+bbox_same(const RTree *rtree, const void *box1, const void *box2)
+{
+  return rtree->bbox_contains(box1, box2) && rtree->bbox_contains(box2, box1);
+}
+
+/**
+ * @brief Remove the entry at a given position of a node, moving the last entry
+ * into its place
+ */
+static void
+node_remove_at(RTreeNode *node, int index)
+{
+  int last = node->count - 1;
+  if (index != last)
+  {
+    memcpy(RTREE_NODE_BBOX_N(node, index), RTREE_NODE_BBOX_N(node, last),
+      node->bboxsize);
+    if (node->node_type == RTREE_LEAF)
+      node->ids[index] = node->ids[last];
+    else
+      node->nodes[index] = node->nodes[last];
+  }
+  node->count--;
+  return;
+}
+
+/**
+ * @brief Collect the leaf entries of a subtree
+ * @param[in] node Root of the subtree
+ * @param[out] boxes,ids MeosArrays receiving the boxes and the ids
+ */
+static void
+node_collect(const RTreeNode *node, MeosArray *boxes, MeosArray *ids)
+{
+  for (int i = 0; i < node->count; ++i)
+  {
+    if (node->node_type == RTREE_LEAF)
+    {
+      int64 id = node->ids[i];
+      meos_array_add(boxes, RTREE_NODE_BBOX_N(node, i));
+      meos_array_add(ids, &id);
+    }
+    else
+      node_collect(node->nodes[i], boxes, ids);
+  }
+  return;
+}
+
+/**
+ * @brief Remove an entry from the subtree rooted at a node, condensing the
+ * subtree on the way back up
+ * @param[in] rtree The RTree
+ * @param[in] node The node being visited
+ * @param[in] box,id The box and the id of the entry
+ * @param[out] boxes,ids MeosArrays receiving the entries to insert again
+ * @return True if the entry was found and removed
+ */
+static bool
+node_delete(RTree *rtree, RTreeNode *node, const void *box, int64 id,
+  MeosArray *boxes, MeosArray *ids)
+{
+  if (node->node_type == RTREE_LEAF)
+  {
+    for (int i = 0; i < node->count; ++i)
+    {
+      if (node->ids[i] == id &&
+          bbox_same(rtree, RTREE_NODE_BBOX_N(node, i), box))
+      {
+        node_remove_at(node, i);
+        node_sync_axes(rtree, node);
+        return true;
+      }
+    }
+    return false;
+  }
+  for (int i = 0; i < node->count; ++i)
+  {
+    if (! rtree->bbox_contains(RTREE_NODE_BBOX_N(node, i), box))
+      continue;
+    RTreeNode *child = node->nodes[i];
+    if (! node_delete(rtree, child, box, id, boxes, ids))
+      continue;
+    if (child->count < rtree->minitems)
+    {
+      /* Underflow: eliminate the child and keep its entries for reinsertion */
+      node_collect(child, boxes, ids);
+      node_free(child);
+      node_remove_at(node, i);
+      node_sync_axes(rtree, node);
+    }
+    else
+    {
+      node_box_calculate(rtree, child, RTREE_NODE_BBOX_N(node, i));
+      node_set_axes(rtree, node, i);
+    }
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Delete an entry from an RTree
+ * @details The entry is identified by its id together with its box, so that
+ * an id inserted with several boxes, as #rtree_insert_temporal_split does,
+ * loses only the given one. A node left with fewer than the minimum number of
+ * entries is removed and its entries are inserted again, and the boxes of the
+ * ancestors of the entry are shrunk to their new extent.
+ * @param[in] rtree The RTree
+ * @param[in] box The bounding box with which the entry was inserted
+ * @param[in] id The id of the entry
+ * @return True if the entry was found and deleted, false otherwise
+ * @see rtree_update
+ */
+bool
+rtree_delete(RTree *rtree, const void *box, int64 id)
+{
+  if (! ensure_rtree_not_mapped(rtree) ||
+      ! ensure_rtree_not_quantized(rtree) ||
+      ! ensure_rtree_not_concurrent(rtree) || ! rtree->root)
+    return false;
+  MeosArray *boxes = meos_array_create((int) rtree->bboxsize);
+  MeosArray *ids = meos_array_create(sizeof(int64));
+  bool found = node_delete(rtree, rtree->root, box, id, boxes, ids);
+  if (found)
+  {
+    /* Shorten the tree while the root is an inner node with a single child */
+    while (rtree->root->node_type == RTREE_INNER && rtree->root->count == 1)
+    {
+      RTreeNode *root = rtree->root;
+      rtree->root = root->nodes[0];
+      pfree(root);
+    }
+    if (rtree->root->count == 0)
+    {
+      node_free(rtree->root);
+      rtree->root = NULL;
+    }
+    else
+      node_box_calculate(rtree, rtree->root, &rtree->box);
+    /* Insert again the entries of the eliminated nodes */
+    int count = meos_array_count(ids);
+    for (int i = 0; i < count; i++)
+      rtree_insert(rtree, meos_array_get(boxes, i),
+        *(int64 *) meos_array_get(ids, i));
+  }
+  meos_array_destroy(boxes);
+  meos_array_destroy(ids);
+  return found;
+}
+
+/**
+ * @brief Replace in place the box of an entry of the subtree rooted at a node
+ * @details The box is overwritten only when it stays within the box that the
+ * parent holds for the leaf, @p nodebox, or when the leaf is the root, so that
+ * no ancestor needs to grow. The boxes of the ancestors are then recomputed,
+ * which shrinks them when the entry moved inwards.
+ * @param[in] rtree The RTree
+ * @param[in] node The node being visited
+ * @param[in] nodebox The box the parent holds for @p node, `NULL` for the root
+ * @param[in] oldbox,newbox The current and the new box of the entry
+ * @param[in] id The id of the entry
+ * @return True if the box of the entry was replaced
+ */
+static bool
+node_update(RTree *rtree, RTreeNode *node, const void *nodebox,
+  const void *oldbox, const void *newbox, int64 id)
+{
+  if (node->node_type == RTREE_LEAF)
+  {
+    if (nodebox && ! rtree->bbox_contains(nodebox, newbox))
+      return false;
+    for (int i = 0; i < node->count; ++i)
+    {
+      if (node->ids[i] == id &&
+          bbox_same(rtree, RTREE_NODE_BBOX_N(node, i), oldbox))
+      {
+        memcpy(RTREE_NODE_BBOX_N(node, i), newbox, rtree->bboxsize);
+        node_set_axes(rtree, node, i);
+        return true;
+      }
+    }
+    return false;
+  }
+  for (int i = 0; i < node->count; ++i)
+  {
+    void *childbox = RTREE_NODE_BBOX_N(node, i);
+    if (rtree->bbox_contains(childbox, oldbox) &&
+        node_update(rtree, node->nodes[i], childbox, oldbox, newbox, id))
+    {
+      node_box_calculate(rtree, node->nodes[i], childbox);
+      node_set_axes(rtree, node, i);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Replace the box of an entry of an RTree
+ * @details When the new box lies within the box of the leaf holding the entry,
+ * which is the common case of an object moving a little, the entry is updated
+ * in place. Otherwise the entry is deleted with #rtree_delete and inserted
+ * again with the new box.
+ * @param[in] rtree The RTree
+ * @param[in] oldbox The bounding box with which the entry was inserted
+ * @param[in] newbox The new bounding box of the entry
+ * @param[in] id The id of the entry
+ * @return True if the entry was found and updated, false otherwise, in which
+ * case the tree is unchanged
+ */
+bool
+rtree_update(RTree *rtree, const void *oldbox, const void *newbox, int64 id)
+{
+  if (! ensure_rtree_not_mapped(rtree) ||
+      ! ensure_rtree_not_quantized(rtree) ||
+      ! ensure_rtree_not_concurrent(rtree) || ! rtree->root)
+    return false;
+  if (node_update(rtree, rtree->root, NULL, oldbox, newbox, id))
+  {
+    node_box_calculate(rtree, rtree->root, &rtree->box);
+    return true;
+  }
+  if (! rtree_delete(rtree, oldbox, id))
+    return false;
+  rtree_insert(rtree, (void *) newbox, id);
+  return true;
+}
+
+/*****************************************************************************
+ * Search cursor
+ *
+ * The depth-first traversal of #rtree_search made incremental: the cursor
+ * keeps one frame per level of the tree with the next entry of the node to
+ * examine, so that its memory is bounded by the height of the tree whatever
+ * the number of matches, and the ids are produced in the order in which
+ * #rtree_search collects them. A caller that stops consuming, e.g. to honour
+ * a `LIMIT`, does not visit the rest of the tree.
+ *****************************************************************************/
+
+/**
+ * @brief Frame of the traversal of the search cursor
+ */
+typedef struct
+{
+  const RTreeNode *node;  /**< Node being visited */
+  int next;               /**< Next entry of the node to examine */
+  uint64 mask;            /**< Entries still to examine with the
+                               @p RTREE_LAYOUT_AXES and quantized layouts */
+} RTreeSearchFrame;
+
+/**
+ * @brief Incremental search cursor over an RTree
+ */
+struct RTreeSearchCursor
+{
+  const RTree *rtree;       /**< Indexed RTree (borrowed, not owned) */
+  RTreeSearchOp op;         /**< Search operation */
+  void *query;              /**< Private copy of the query bounding box */
+  RTreeAxesQuery q;         /**< Bounds of the query on the axes it has */
+  RTreeSearchFrame *stack;  /**< Frames of the nodes being visited */
+  int depth;                /**< Number of frames */
+  int capacity;             /**< Allocated capacity of the stack */
+};
+
+/**
+ * @brief Push a node onto the stack of a search cursor
+ */
+static void
+search_cursor_push(RTreeSearchCursor *cursor, const RTreeNode *node)
+{
+  if (cursor->depth == cursor->capacity)
+  {
+    cursor->capacity *= 2;
+    cursor->stack = repalloc(cursor->stack,
+      (size_t) cursor->capacity * sizeof(RTreeSearchFrame));
+  }
+  RTreeSearchFrame *frame = &cursor->stack[cursor->depth++];
+  frame->node = node;
+  frame->next = 0;
+  frame->mask = 0;
+  /* The inner entries are tested as in #inner_consistent */
+  RTreeSearchOp maskop = (node->node_type == RTREE_LEAF ||
+    cursor->op == RTREE_CONTAINS) ? cursor->op : RTREE_OVERLAPS;
+  if (cursor->rtree->layout == RTREE_LAYOUT_AXES)
+    frame->mask = node_axes_mask(cursor->rtree, node, &cursor->q, maskop);
+  else if (RTREE_QUANTIZED(cursor->rtree))
+    frame->mask = node_quant_mask(cursor->rtree, node, &cursor->q, maskop);
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Open a cursor that yields the ids of an RTree satisfying a search
+ * operation with a query bounding box
+ * @details Repeated calls to #rtree_search_cursor_next return the ids that
+ * #rtree_search would collect, in the same order, without materializing them:
+ * the memory of the cursor is bounded by the height of the tree. The caller
+ * may stop at any time, e.g., after `k` ids, and the rest of the tree is not
+ * visited. The query box is copied into the cursor, so the caller may free or
+ * reuse it immediately. The tree must not be modified while the cursor is
+ * open. Close the cursor with #rtree_search_cursor_close.
+ * @param[in] rtree The RTree to query
+ * @param[in] op The search operation, as for #rtree_search
+ * @param[in] query The query bounding box of type @p rtree->bboxtype
+ * @return A cursor to be freed with #rtree_search_cursor_close
+ */
+RTreeSearchCursor *
+rtree_search_cursor_open(const RTree *rtree, RTreeSearchOp op,
+  const void *query)
+{
+  assert(rtree); assert(query);
+  RTreeSearchCursor *cursor = palloc0(sizeof(RTreeSearchCursor));
+  cursor->rtree = rtree;
+  cursor->op = op;
+  cursor->query = palloc(rtree->bboxsize);
+  memcpy(cursor->query, query, rtree->bboxsize);
+  if (rtree->layout == RTREE_LAYOUT_AXES || RTREE_QUANTIZED(rtree))
+    axes_query_init(rtree, cursor->query, &cursor->q);
+  cursor->capacity = 16;
+  cursor->stack = palloc((size_t) cursor->capacity *
+    sizeof(RTreeSearchFrame));
+  cursor->depth = 0;
+  if (rtree->root)
+    search_cursor_push(cursor, rtree->root);
+  return cursor;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Advance a search cursor to the next id satisfying the search
+ * @param[in] cursor The cursor previously opened with
+ * #rtree_search_cursor_open
+ * @param[out] id_out Receives the id, or @p NULL
+ * @return @p true if an id was produced, @p false once exhausted
+ */
+bool
+rtree_search_cursor_next(RTreeSearchCursor *cursor, int64 *id_out)
+{
+  assert(cursor);
+  const RTree *rtree = cursor->rtree;
+  bool quant = RTREE_QUANTIZED(rtree);
+  bool axes = (rtree->layout == RTREE_LAYOUT_AXES) || quant;
+  while (cursor->depth > 0)
+  {
+    RTreeSearchFrame *frame = &cursor->stack[cursor->depth - 1];
+    const RTreeNode *node = frame->node;
+    int i;
+    if (axes && frame->mask)
+    {
+      i = pg_rightmost_one_pos64(frame->mask);
+      frame->mask &= frame->mask - 1;
+    }
+    else if (! axes && frame->next < node->count)
+      i = frame->next++;
+    else
+    {
+      /* The node is exhausted */
+      cursor->depth--;
+      continue;
+    }
+    /* The entries of a quantized node selected by the mask are candidates */
+    if (quant)
+    {
+      if (node->node_type == RTREE_INNER)
+      {
+        search_cursor_push(cursor, RTREE_NODE_CHILD_N(rtree, node, i));
+        continue;
+      }
+      if (id_out)
+        *id_out = node->ids[i];
+      return true;
+    }
+    const void *box = RTREE_NODE_BBOX_N(node, i);
+    if (node->node_type == RTREE_LEAF)
+    {
+      if (leaf_consistent(rtree, box, cursor->query, cursor->op))
+      {
+        if (id_out)
+          *id_out = node->ids[i];
+        return true;
+      }
+    }
+    else if (inner_consistent(rtree, box, cursor->query, cursor->op))
+      search_cursor_push(cursor, RTREE_NODE_CHILD_N(rtree, node, i));
+  }
+  return false;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Close a search cursor and free its resources
+ * @param[in] cursor The cursor to close; @p NULL is ignored
+ */
+void
+rtree_search_cursor_close(RTreeSearchCursor *cursor)
+{
+  if (! cursor)
+    return;
+  pfree(cursor->stack);
+  pfree(cursor->query);
+  pfree(cursor);
+  return;
+}
+
 /*****************************************************************************
  * Nearest-neighbour (kNN) cursor
  *
@@ -1528,16 +4575,25 @@ rtree_search_temporal_dedup(const RTree *rtree, RTreeSearchOp op,
 static double
 rtree_bbox_distance(const RTree *rtree, const void *query, const void *box)
 {
+  /* The sentinels of the box distances for disjoint time extents are
+   * reported as an infinite distance */
   if (rtree->bboxtype == T_TBOX)
-    return distance_double(nad_tbox_tbox((const TBox *) query,
-      (const TBox *) box), ((const TBox *) query)->span.basetype);
-  if (rtree->bboxtype == T_STBOX)
-    return nad_stbox_stbox((const STBox *) query, (const STBox *) box);
+  {
+    MeosType basetype = ((const TBox *) query)->span.basetype;
+    Datum dist = nad_tbox_tbox((const TBox *) query, (const TBox *) box);
+    return dist == distance_sentinel(basetype) ? get_float8_infinity() :
+      distance_double(dist, basetype);
+  }
+  if (rtree->bboxtype == T_STBOX
 #if POINTCLOUD
-  if (rtree->bboxtype == T_TPCBOX)
     /* TPCBox shares the STBox prefix layout (see get_axis_tpcbox) */
-    return nad_stbox_stbox((const STBox *) query, (const STBox *) box);
+    || rtree->bboxtype == T_TPCBOX
 #endif
+    )
+  {
+    double dist = nad_stbox_stbox((const STBox *) query, (const STBox *) box);
+    return dist == DBL_MAX ? get_float8_infinity() : dist;
+  }
   /* Span types: the one-dimensional gap between the two spans, zero when they
    * overlap, read through the box's axis accessor */
   double qlo = rtree->get_axis(query, 0, false);
@@ -1556,12 +4612,15 @@ rtree_bbox_distance(const RTree *rtree, const void *query, const void *box)
  * @details An entry is either a tree node still to be expanded
  * (@p is_leaf_entry false, @p node set) or a leaf id ready to be emitted
  * (@p is_leaf_entry true, @p id set), keyed by @p dist, the distance from the
- * query box to the entry's bounding box.
+ * query box to the entry's bounding box. With a refine function a leaf id is
+ * first keyed by its box distance and pushed again keyed by its exact
+ * distance (@p exact true) when it reaches the top of the heap.
  */
 typedef struct RTreeNNEntry
 {
   double dist;             /**< Distance from the query to the entry's box */
   bool is_leaf_entry;      /**< True for an emittable id, false for a node */
+  bool exact;              /**< True when @p dist of a leaf id is final */
   int64 id;                /**< Leaf id (when @p is_leaf_entry) */
   const RTreeNode *node;   /**< Tree node to expand (when not @p is_leaf_entry) */
 } RTreeNNEntry;
@@ -1576,6 +4635,13 @@ struct RTreeNNCursor
   RTreeNNEntry *heap;     /**< Binary min-heap keyed by distance */
   int count;              /**< Number of entries currently in the heap */
   int capacity;           /**< Allocated capacity of the heap array */
+  RTreeRefineFn refine;   /**< Exact distance of an id, @p NULL when the box
+                               distance is final */
+  void *arg;              /**< Argument of @p refine */
+  Temporal *temp;         /**< Private copy of the query of a cursor opened
+                               by #rtree_nn_cursor_open_tgeo */
+  RTreeLookupFn lookup;   /**< Temporal value of an id for @p temp */
+  void *lookup_arg;       /**< Argument of @p lookup */
 };
 
 /**
@@ -1656,12 +4722,15 @@ nn_heap_pop(RTreeNNCursor *cursor)
  * `|=|`). Close the cursor with #rtree_nn_cursor_close.
  * @param[in] rtree The RTree to query
  * @param[in] query The query bounding box of type @p rtree->bboxtype
- * @return A cursor to be freed with #rtree_nn_cursor_close
+ * @return A cursor to be freed with #rtree_nn_cursor_close, @p NULL if the
+ * tree has quantized nodes
  */
 RTreeNNCursor *
 rtree_nn_cursor_open(const RTree *rtree, const void *query)
 {
   assert(rtree); assert(query);
+  if (! ensure_rtree_not_quantized(rtree))
+    return NULL;
   RTreeNNCursor *cursor = palloc0(sizeof(RTreeNNCursor));
   cursor->rtree = rtree;
   cursor->query = palloc(rtree->bboxsize);
@@ -1675,6 +4744,7 @@ rtree_nn_cursor_open(const RTree *rtree, const void *query)
     RTreeNNEntry root_entry;
     root_entry.dist = 0.0;
     root_entry.is_leaf_entry = false;
+    root_entry.exact = false;
     root_entry.id = 0;
     root_entry.node = rtree->root;
     nn_heap_push(cursor, root_entry);
@@ -1682,14 +4752,105 @@ rtree_nn_cursor_open(const RTree *rtree, const void *query)
   return cursor;
 }
 
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Open a nearest-neighbour cursor that yields the ids stored in an
+ * RTree in order of increasing exact distance to a query
+ * @details As #rtree_nn_cursor_open, where the distance of an id is the one
+ * computed by @p refine, e.g., the nearest approach distance between the
+ * query trip and the trip of the id, instead of the distance between their
+ * boxes. The box distance is used as a lower bound of the exact distance:
+ * an id is refined only when its box distance is smaller than the exact
+ * distance of every id refined so far and the box distance of every entry
+ * not yet refined, and is produced once its exact distance is the smallest.
+ * Therefore the first `k` ids returned are the true `k` nearest neighbours
+ * and @p refine is called for the candidates that may be among them only.
+ * @param[in] rtree The RTree to query
+ * @param[in] query The query bounding box of type @p rtree->bboxtype
+ * @param[in] refine Function returning the exact distance of an id to the
+ * query, which must not be smaller than the distance between the box of the
+ * id and @p query, where @p DBL_MAX, the infinity of the distance functions
+ * of MEOS, is reported as an infinite distance
+ * @param[in] arg Argument passed to @p refine
+ * @return A cursor to be freed with #rtree_nn_cursor_close, @p NULL if the
+ * tree has quantized nodes
+ */
+RTreeNNCursor *
+rtree_nn_cursor_open_refine(const RTree *rtree, const void *query,
+  RTreeRefineFn refine, void *arg)
+{
+  assert(refine);
+  RTreeNNCursor *cursor = rtree_nn_cursor_open(rtree, query);
+  if (! cursor)
+    return NULL;
+  cursor->refine = refine;
+  cursor->arg = arg;
+  return cursor;
+}
+
+/**
+ * @brief Return the nearest approach distance between the query of a
+ * nearest-neighbour cursor opened by #rtree_nn_cursor_open_tgeo and the
+ * temporal value of an id
+ */
+static double
+nn_refine_tgeo(int64 id, void *arg)
+{
+  RTreeNNCursor *cursor = (RTreeNNCursor *) arg;
+  const Temporal *temp = cursor->lookup(id, cursor->lookup_arg);
+  return temp ? nad_tgeo_tgeo(cursor->temp, temp) : DBL_MAX;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Open a nearest-neighbour cursor that yields the ids stored in an
+ * RTree of spatiotemporal boxes in order of increasing nearest approach
+ * distance between their temporal geo and a query temporal geo
+ * @details As #rtree_nn_cursor_open_refine with the query box of @p temp,
+ * the exact distance of an id being #nad_tgeo_tgeo between @p temp and the
+ * temporal value returned by @p lookup. An id for which @p lookup returns
+ * @p NULL, or whose time frame does not intersect the one of @p temp, is
+ * reported last with an infinite distance. The query is copied into the
+ * cursor, so the caller may free it immediately.
+ * @param[in] rtree The RTree of spatiotemporal boxes to query
+ * @param[in] temp The query temporal geo
+ * @param[in] lookup Function returning the temporal geo of an id, which
+ * remains owned by the caller
+ * @param[in] arg Argument passed to @p lookup
+ * @return A cursor to be freed with #rtree_nn_cursor_close, @p NULL on error
+ */
+RTreeNNCursor *
+rtree_nn_cursor_open_tgeo(const RTree *rtree, const Temporal *temp,
+  RTreeLookupFn lookup, void *arg)
+{
+  assert(rtree); assert(temp); assert(lookup);
+  if (! ensure_tgeo_type_all(temp->temptype) ||
+      ! ensure_bbox_temporal_compatible(rtree->bboxtype, temp))
+    return NULL;
+  /* Use a stack buffer large enough for any MEOS bounding box type */
+  bboxunion buf;
+  memset(&buf, 0, sizeof(buf));
+  temporal_set_bbox(temp, &buf);
+  RTreeNNCursor *cursor = rtree_nn_cursor_open(rtree, &buf);
+  if (! cursor)
+    return NULL;
+  cursor->temp = temporal_copy(temp);
+  cursor->lookup = lookup;
+  cursor->lookup_arg = arg;
+  cursor->refine = &nn_refine_tgeo;
+  cursor->arg = cursor;
+  return cursor;
+}
+
 /**
  * @ingroup meos_geo_box_index
  * @brief Advance a nearest-neighbour cursor to the next closest id
  * @details Returns the next id in order of increasing distance to the query
  * box. When @p id_out or @p dist_out is not @p NULL it receives the id and its
- * distance. An id whose box has no valid distance to the query (e.g. disjoint
- * time extents for temporal box types) is reported last with an infinite
- * distance.
+ * distance, which is the exact distance for a cursor opened by
+ * #rtree_nn_cursor_open_refine or #rtree_nn_cursor_open_tgeo. An id whose box
+ * has no valid distance to the query (e.g. disjoint time extents for temporal
+ * box types) is reported last with an infinite distance.
  * @param[in] cursor The cursor previously opened with #rtree_nn_cursor_open
  * @param[out] id_out Receives the id of the next neighbour, or @p NULL
  * @param[out] dist_out Receives the distance of the next neighbour, or @p NULL
@@ -1702,6 +4863,17 @@ rtree_nn_cursor_next(RTreeNNCursor *cursor, int64 *id_out, double *dist_out)
   while (cursor->count > 0)
   {
     RTreeNNEntry entry = nn_heap_pop(cursor);
+    if (entry.is_leaf_entry && ! entry.exact && cursor->refine)
+    {
+      /* The box distance is a lower bound of the exact distance, the id is
+       * pushed again at its exact distance, which cannot be smaller */
+      entry.dist = cursor->refine(entry.id, cursor->arg);
+      if (entry.dist == DBL_MAX)
+        entry.dist = get_float8_infinity();
+      entry.exact = true;
+      nn_heap_push(cursor, entry);
+      continue;
+    }
     if (entry.is_leaf_entry)
     {
       /* A leaf id reached the top of the heap: nothing unexpanded is closer */
@@ -1718,6 +4890,7 @@ rtree_nn_cursor_next(RTreeNNCursor *cursor, int64 *id_out, double *dist_out)
       RTreeNNEntry child;
       child.dist = rtree_bbox_distance(cursor->rtree, cursor->query,
         RTREE_NODE_BBOX_N(node, i));
+      child.exact = false;
       if (node->node_type == RTREE_LEAF)
       {
         child.is_leaf_entry = true;
@@ -1728,7 +4901,7 @@ rtree_nn_cursor_next(RTreeNNCursor *cursor, int64 *id_out, double *dist_out)
       {
         child.is_leaf_entry = false;
         child.id = 0;
-        child.node = node->nodes[i];
+        child.node = RTREE_NODE_CHILD_N(cursor->rtree, node, i);
       }
       nn_heap_push(cursor, child);
     }
@@ -1748,42 +4921,680 @@ rtree_nn_cursor_close(RTreeNNCursor *cursor)
     return;
   pfree(cursor->heap);
   pfree(cursor->query);
+  if (cursor->temp)
+    pfree(cursor->temp);
   pfree(cursor);
   return;
 }
 
+#if MEOS
+/*****************************************************************************
+ * File serialization
+ *
+ * An RTree is saved as a header, followed by the bounding box of the whole
+ * tree and by the nodes in breadth-first order, so that the upper levels that
+ * every search visits are packed at the start of the file. A node keeps its
+ * in-memory layout, except that the slot of a child holds the offset of the
+ * child from the start of the file instead of its address. The file is thus
+ * position independent: it is mapped read-only and searched in place without
+ * any relocation, and the processes opening the same file share its pages
+ * through the page cache. The file is in the byte order and layout of the
+ * platform that wrote it, which the header records and checks.
+ *****************************************************************************/
+
+#define RTREE_FILE_MAGIC "MEOSRTR"
+#define RTREE_FILE_VERSION 1
+
 /**
- * @brief Frees the memory allocated for an RTree node
- * @details The function recursively frees the memory of an RTree node.
- * If the node is a branch node, it first recursively frees all child nodes.
- * After handling the child nodes, it frees the memory allocated for the
- * bounding boxes and the arrays of boxes and child nodes within the current
- * node. Finally, it frees the memory allocated for the node itself.
- * @param[in] node Pointer to the node to be freed
+ * @brief Header of an RTree file
  */
-static void
-node_free(RTreeNode *node)
+typedef struct
 {
-  if (node->node_type == RTREE_INNER)
+  char magic[8];       /**< Identifies an RTree file */
+  uint32 version;      /**< Version of the file layout */
+  uint32 nodesize;     /**< Size of a node, which depends on the platform */
+  int32 bboxtype;      /**< Type of the bounding box */
+  int32 dims;          /**< Number of dimensions of the tree */
+  int32 layout;        /**< Layout of the nodes */
+  int32 capacity;      /**< Capacity of the nodes */
+  uint64 size;         /**< Size of the file */
+  uint64 root;         /**< Offset of the root node, 0 for an empty tree */
+} RTreeFileHeader;
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Save an RTree into a file that can be opened with #rtree_open
+ * @details The tree is written with offsets instead of pointers, so that the
+ * file can be mapped into memory and searched in place.
+ * @param[in] rtree The RTree
+ * @param[in] filename The name of the file, which is overwritten if it exists
+ * @return True on success, false if the file cannot be written
+ * @see rtree_open
+ */
+bool
+rtree_save(const RTree *rtree, const char *filename)
+{
+  assert(rtree); assert(filename);
+  size_t nodesize = rtree_node_size(rtree);
+  size_t start = MAXALIGN(sizeof(RTreeFileHeader) + rtree->bboxsize);
+
+  /* Number the nodes in breadth-first order */
+  int capacity = MAXITEMS, nnodes = 0;
+  const RTreeNode **queue = palloc(sizeof(RTreeNode *) * capacity);
+  if (rtree->root)
+    queue[nnodes++] = rtree->root;
+  for (int k = 0; k < nnodes; k++)
   {
-    for (int i = 0; i < node->count; ++i)
-      node_free(node->nodes[i]);
+    const RTreeNode *node = queue[k];
+    if (node->node_type == RTREE_LEAF)
+      continue;
+    if (nnodes + node->count > capacity)
+    {
+      capacity *= 2;
+      queue = repalloc(queue, sizeof(RTreeNode *) * capacity);
+    }
+    for (int i = 0; i < node->count; i++)
+      queue[nnodes++] = RTREE_NODE_CHILD_N(rtree, node, i);
   }
-  pfree(node);
+
+  FILE *file = fopen(filename, "wb");
+  if (! file)
+  {
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR,
+      "Cannot open the file \"%s\" for writing", filename);
+    pfree(queue);
+    return false;
+  }
+  char *buf = palloc0(Max(start, nodesize));
+  RTreeFileHeader *header = (RTreeFileHeader *) buf;
+  memcpy(header->magic, RTREE_FILE_MAGIC, sizeof(header->magic));
+  header->version = RTREE_FILE_VERSION;
+  header->nodesize = (uint32) nodesize;
+  header->bboxtype = (int32) rtree->bboxtype;
+  header->dims = (int32) rtree->dims;
+  header->layout = (int32) rtree->layout;
+  header->capacity = (int32) rtree->maxitems;
+  header->size = (uint64) (start + (size_t) nnodes * nodesize);
+  header->root = nnodes ? (uint64) start : 0;
+  memcpy(buf + sizeof(RTreeFileHeader), rtree->box, rtree->bboxsize);
+  bool ok = (fwrite(buf, start, 1, file) == 1);
+
+  /* The children of the nodes follow each other in the breadth-first order */
+  int next = 1;
+  RTreeNode *copy = (RTreeNode *) buf;
+  for (int k = 0; k < nnodes && ok; k++)
+  {
+    const RTreeNode *node = queue[k];
+    memset(buf, 0, nodesize);
+    copy->bboxsize = node->bboxsize;
+    copy->count = node->count;
+    copy->node_type = node->node_type;
+    /* A quantized node stores its own box followed by the codes */
+    if (RTREE_QUANTIZED(rtree))
+      memcpy(RTREE_NODE_BBOX_N(copy, 0), RTREE_NODE_BBOX_N(node, 0),
+        nodesize - offsetof(RTreeNode, boxes));
+    else
+      memcpy(RTREE_NODE_BBOX_N(copy, 0), RTREE_NODE_BBOX_N(node, 0),
+        node->count * node->bboxsize);
+    for (int i = 0; i < node->count; i++)
+      copy->ids[i] = (node->node_type == RTREE_LEAF) ? node->ids[i] :
+        (int64) (start + (size_t) next++ * nodesize);
+    if (rtree->layout == RTREE_LAYOUT_AXES)
+    {
+      for (int a = 0; a < 2 * rtree->dims; a++)
+        memcpy(&RTREE_NODE_AXES(rtree, copy)[a * rtree->maxitems],
+          &RTREE_NODE_AXES(rtree, node)[a * rtree->maxitems],
+          node->count * sizeof(double));
+    }
+    ok = (fwrite(buf, nodesize, 1, file) == 1);
+  }
+  if (fclose(file) != 0)
+    ok = false;
+  if (! ok)
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR, "Cannot write the file \"%s\"",
+      filename);
+  pfree(buf);
+  pfree(queue);
+  return ok;
+}
+
+/**
+ * @brief Return true if the nodes of a mapped RTree file are consistent, i.e.,
+ * every child slot holds the offset of a node of the file stored after its
+ * parent
+ * @details The nodes follow the header and the box of the tree one after the
+ * other, so that the offset of a node is a multiple of the node size from
+ * there. A child being stored after its parent, as in the breadth-first order
+ * of #rtree_save, rules out cycles.
+ */
+static bool
+rtree_file_valid(const RTree *rtree, const char *base, size_t size,
+  uint64 root)
+{
+  size_t nodesize = rtree_node_size(rtree);
+  size_t start = MAXALIGN(sizeof(RTreeFileHeader) + rtree->bboxsize);
+  if (size < start || (size - start) % nodesize != 0)
+    return false;
+  if (root == 0)
+    return size == start;
+  if (root != start)
+    return false;
+  for (size_t offset = start; offset < size; offset += nodesize)
+  {
+    const RTreeNode *node = (const RTreeNode *) (base + offset);
+    if (node->bboxsize != rtree->bboxsize || node->count < 0 ||
+        node->count > rtree->maxitems ||
+        (node->node_type != RTREE_LEAF && node->node_type != RTREE_INNER))
+      return false;
+    if (node->node_type == RTREE_LEAF)
+      continue;
+    for (int i = 0; i < node->count; i++)
+    {
+      int64 child = node->ids[i];
+      if (child <= (int64) offset || (uint64) child >= (uint64) size ||
+          ((size_t) child - start) % nodesize != 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Open an RTree saved by #rtree_save
+ * @details The file is mapped read-only into memory and the tree is searched
+ * in place, so that the pages of the file are shared with the other
+ * processes mapping it. The nodes are checked when the file is opened, so
+ * that a truncated or corrupted file is rejected instead of being read out of
+ * bounds. The tree can be searched with #rtree_search, #rtree_join,
+ * #rtree_search_temporal, and the nearest-neighbour cursor, but not modified.
+ * The file must not be modified while it is open, and the mapping is released
+ * by #rtree_free.
+ * @param[in] filename The name of the file
+ * @return The RTree, or `NULL` if the file cannot be mapped or is not an RTree
+ * file written on the same platform
+ * @see rtree_save
+ */
+RTree *
+rtree_open(const char *filename)
+{
+  assert(filename);
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+  {
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR, "Cannot open the file \"%s\"",
+      filename);
+    return NULL;
+  }
+  struct stat st;
+  char *base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(RTreeFileHeader))
+    base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR, "Cannot map the file \"%s\"",
+      filename);
+    return NULL;
+  }
+
+  const RTreeFileHeader *header = (const RTreeFileHeader *) base;
+  MeosType bboxtype = (MeosType) header->bboxtype;
+  RTree *rtree = NULL;
+  if (memcmp(header->magic, RTREE_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+      header->version == RTREE_FILE_VERSION &&
+      header->size == (uint64) st.st_size &&
+      header->layout >= RTREE_LAYOUT_BOXES &&
+      header->layout <= RTREE_LAYOUT_QUANT16 &&
+      header->capacity >= RTREE_MIN_CAPACITY &&
+      header->capacity <= MAXITEMS &&
+      (span_type(bboxtype) || bboxtype == T_TBOX || bboxtype == T_STBOX
+#if POINTCLOUD
+        || bboxtype == T_TPCBOX
+#endif
+      ))
+  {
+    rtree = rtree_create_config(bboxtype, (RTreeLayout) header->layout,
+      header->capacity, RTREE_SPLIT_LARGEST_AXIS);
+    if (rtree->dims < 0 && (header->dims == 3 || header->dims == 4))
+      rtree->dims = header->dims;
+    if (rtree->dims != header->dims ||
+        header->nodesize != rtree_node_size(rtree))
+    {
+      pfree(rtree);
+      rtree = NULL;
+    }
+  }
+  if (! rtree)
+  {
+    munmap(base, (size_t) st.st_size);
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR,
+      "The file \"%s\" is not an RTree file written on this platform",
+      filename);
+    return NULL;
+  }
+  if (! rtree_file_valid(rtree, base, (size_t) st.st_size, header->root))
+  {
+    pfree(rtree);
+    munmap(base, (size_t) st.st_size);
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR, "The RTree file \"%s\" is corrupted",
+      filename);
+    return NULL;
+  }
+
+  memcpy(rtree->box, base + sizeof(RTreeFileHeader), rtree->bboxsize);
+  rtree->root = header->root ? (RTreeNode *) (base + header->root) : NULL;
+  rtree->base = base;
+  rtree->mapsize = (size_t) st.st_size;
+  return rtree;
 }
+#endif /* MEOS */
 
 /**
  * @ingroup meos_temporal_box_index
  * @brief Frees an RTree
+ * @details For an RTree opened by #rtree_open, the file mapping is released
  * @param[in] rtree The RTree to free
  */
 void
 rtree_free(RTree *rtree)
 {
-  if (rtree->root)
+  /* The nodes of a tree opened from a file live in the file mapping */
+  if (rtree->base)
+  {
+#if MEOS
+    munmap((void *) rtree->base, rtree->mapsize);
+#endif
+  }
+  else if (rtree->root)
     node_free(rtree->root);
+  /* The current version shares its nodes with the tree */
+  if (rtree->shared)
+  {
+    rtree_reclaim(rtree->shared, true);
+    pfree(rtree->shared->current);
+    if (rtree->shared->owned)
+      pfree(rtree->shared->owned);
+    if (rtree->shared->retired)
+      pfree(rtree->shared->retired);
+    pfree(rtree->shared);
+  }
   pfree(rtree);
   return;
 }
 
+/*****************************************************************************
+ * Time-partitioned forest of RTrees
+ *
+ * An append-only stream is indexed by one RTree per time bucket, the bucket
+ * of a box being the bin of #timestamptz_bin_start that contains the start of
+ * its time extent. Every bucket keeps the latest end time of its boxes, so
+ * that a search only visits the buckets whose time range intersects the one
+ * of the query, and whole buckets can be frozen, i.e., repacked and made
+ * read-only, or dropped once expired.
+ *****************************************************************************/
+
+/**
+ * @brief Get the time extent of a bounding box of a forest
+ * @return False when the box has no time dimension
+ */
+static bool
+bbox_time_bounds(MeosType bboxtype, const void *box, TimestampTz *lower,
+  TimestampTz *upper)
+{
+  const Span *period;
+  if (bboxtype == T_TSTZSPAN)
+    period = (const Span *) box;
+  else if (bboxtype == T_TBOX)
+  {
+    if (! MEOS_FLAGS_GET_T(((const TBox *) box)->flags))
+      return false;
+    period = &((const TBox *) box)->period;
+  }
+  else /* bboxtype == T_STBOX */
+  {
+    if (! MEOS_FLAGS_GET_T(((const STBox *) box)->flags))
+      return false;
+    period = &((const STBox *) box)->period;
+  }
+  *lower = DatumGetTimestampTz(period->lower);
+  *upper = DatumGetTimestampTz(period->upper);
+  return true;
+}
+
+/**
+ * @brief Return the position of the bucket of a forest starting at a
+ * timestamp, or the position where it must be inserted
+ */
+static int
+forest_bucket_find(const RTreeForest *forest, TimestampTz start, bool *found)
+{
+  /* Appends go to the latest bucket, which is tested first */
+  int n = forest->count;
+  if (n > 0 && forest->buckets[n - 1].start <= start)
+  {
+    *found = (forest->buckets[n - 1].start == start);
+    return *found ? n - 1 : n;
+  }
+  int lo = 0, hi = n;
+  while (lo < hi)
+  {
+    int mid = lo + (hi - lo) / 2;
+    if (forest->buckets[mid].start < start)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  *found = (lo < n && forest->buckets[lo].start == start);
+  return lo;
+}
+
+/**
+ * @ingroup meos_internal_box_index
+ * @brief Create a time-partitioned forest of RTrees
+ * @param[in] bboxtype The bounding box type of the trees, which must have a
+ * time dimension, i.e., @p T_TSTZSPAN, @p T_TBOX, or @p T_STBOX
+ * @param[in] duration The duration of the buckets
+ * @param[in] torigin The origin of the buckets
+ * @return Forest initialized, `NULL` if the duration is not positive
+ */
+RTreeForest *
+rtree_forest_create(MeosType bboxtype, const Interval *duration,
+  TimestampTz torigin)
+{
+  assert(bboxtype == T_TSTZSPAN || bboxtype == T_TBOX ||
+    bboxtype == T_STBOX);
+  VALIDATE_NOT_NULL(duration, NULL);
+  if (! ensure_positive_duration(duration))
+    return NULL;
+  RTreeForest *forest = palloc0(sizeof(RTreeForest));
+  forest->bboxtype = bboxtype;
+  forest->bboxsize = bbox_get_size(bboxtype);
+  forest->tunits = interval_units(duration);
+  forest->torigin = torigin;
+  forest->capacity = 8;
+  forest->buckets = palloc(sizeof(RTreeBucket) * forest->capacity);
+  return forest;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Create a time-partitioned forest of RTrees for timestamptz spans
+ * @param[in] duration The duration of the buckets
+ * @param[in] torigin The origin of the buckets
+ * @return Forest initialized, `NULL` on error
+ */
+RTreeForest *
+rtree_forest_create_tstzspan(const Interval *duration, TimestampTz torigin)
+{
+  return rtree_forest_create(T_TSTZSPAN, duration, torigin);
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Create a time-partitioned forest of RTrees for temporal boxes
+ * @param[in] duration The duration of the buckets
+ * @param[in] torigin The origin of the buckets
+ * @return Forest initialized, `NULL` on error
+ */
+RTreeForest *
+rtree_forest_create_tbox(const Interval *duration, TimestampTz torigin)
+{
+  return rtree_forest_create(T_TBOX, duration, torigin);
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Create a time-partitioned forest of RTrees for spatiotemporal boxes
+ * @param[in] duration The duration of the buckets
+ * @param[in] torigin The origin of the buckets
+ * @return Forest initialized, `NULL` on error
+ */
+RTreeForest *
+rtree_forest_create_stbox(const Interval *duration, TimestampTz torigin)
+{
+  return rtree_forest_create(T_STBOX, duration, torigin);
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Delete a time-partitioned forest of RTrees
+ * @param[in] forest The forest to free
+ */
+void
+rtree_forest_free(RTreeForest *forest)
+{
+  for (int i = 0; i < forest->count; i++)
+    rtree_free(forest->buckets[i].rtree);
+  pfree(forest->buckets);
+  pfree(forest);
+  return;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Return the number of buckets of a time-partitioned forest of RTrees
+ * @param[in] forest The forest
+ */
+int
+rtree_forest_buckets(const RTreeForest *forest)
+{
+  return forest->count;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Insert a bounding box into a time-partitioned forest of RTrees
+ * @details The box is inserted into the tree of the bucket containing the
+ * start of its time extent, which is created when needed. For a stream in
+ * time order this is the latest bucket, so the inserts only ever descend a
+ * tree holding one bucket of data.
+ * @param[in] forest The forest
+ * @param[in] box The bounding box to be inserted, which must have a time
+ * dimension
+ * @param[in] id The id of the box being inserted
+ * @return False if the box has no time dimension or its bucket is frozen
+ */
+bool
+rtree_forest_insert(RTreeForest *forest, void *box, int64 id)
+{
+  TimestampTz lower, upper;
+  if (! bbox_time_bounds(forest->bboxtype, box, &lower, &upper))
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "The boxes of an RTree forest must have a time dimension");
+    return false;
+  }
+  TimestampTz start = timestamptz_bin_start(lower, forest->tunits,
+    forest->torigin);
+  if (start == DT_NOEND)
+    return false;
+  bool found;
+  int pos = forest_bucket_find(forest, start, &found);
+  if (! found)
+  {
+    if (forest->count == forest->capacity)
+    {
+      forest->capacity *= 2;
+      forest->buckets = repalloc(forest->buckets,
+        sizeof(RTreeBucket) * forest->capacity);
+    }
+    memmove(&forest->buckets[pos + 1], &forest->buckets[pos],
+      sizeof(RTreeBucket) * (forest->count - pos));
+    RTreeBucket *bucket = &forest->buckets[pos];
+    bucket->start = start;
+    bucket->tmax = upper;
+    bucket->frozen = false;
+    bucket->rtree = rtree_create(forest->bboxtype);
+    forest->count++;
+  }
+  RTreeBucket *bucket = &forest->buckets[pos];
+  if (bucket->frozen)
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "Cannot insert into a frozen bucket of an RTree forest");
+    return false;
+  }
+  if (upper > bucket->tmax)
+    bucket->tmax = upper;
+  rtree_insert(bucket->rtree, box, id);
+  return true;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Insert a temporal value into a time-partitioned forest of RTrees
+ * @param[in] forest The forest
+ * @param[in] temp The temporal value to be inserted
+ * @param[in] id The id of the temporal value being inserted
+ * @return False on error
+ */
+bool
+rtree_forest_insert_temporal(RTreeForest *forest, const Temporal *temp,
+  int64 id)
+{
+  if (! ensure_bbox_temporal_compatible(forest->bboxtype, temp))
+    return false;
+  /* Use a stack buffer large enough for any MEOS bounding box type */
+  bboxunion buf;
+  memset(&buf, 0, sizeof(buf));
+  temporal_set_bbox(temp, &buf);
+  return rtree_forest_insert(forest, &buf, id);
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Search a time-partitioned forest of RTrees with a bounding box,
+ * collecting matching IDs into a MeosArray
+ * @details As #rtree_search, where only the trees of the buckets whose time
+ * range intersects the time extent of the query are searched. A query
+ * without time dimension searches every bucket. The ids are returned by
+ * bucket in time order.
+ * @param[in] forest The forest to query
+ * @param[in] op The search operation
+ * @param[in] query The bounding box that serves as query
+ * @param[out] result MeosArray of int to collect matching IDs
+ * @return Number of matching IDs
+ */
+int
+rtree_forest_search(const RTreeForest *forest, RTreeSearchOp op,
+  const void *query, MeosArray *result)
+{
+  meos_array_reset(result);
+  TimestampTz lower, upper;
+  bool timed = bbox_time_bounds(forest->bboxtype, query, &lower, &upper);
+  /* Every search operation requires the time extents to intersect */
+  for (int i = 0; i < forest->count; i++)
+  {
+    const RTreeBucket *bucket = &forest->buckets[i];
+    if (timed && bucket->start > upper)
+      break;
+    if (timed && bucket->tmax < lower)
+      continue;
+    rtree_search_append(bucket->rtree, op, query, result, NULL);
+  }
+  return meos_array_count(result);
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Search a time-partitioned forest of RTrees using a temporal value's
+ * bounding box, collecting matching IDs into a MeosArray
+ * @param[in] forest The forest to query
+ * @param[in] op The search operation
+ * @param[in] temp The temporal value whose bounding box serves as query
+ * @param[out] result MeosArray of int to collect matching IDs
+ * @return Number of matching IDs
+ */
+int
+rtree_forest_search_temporal(const RTreeForest *forest, RTreeSearchOp op,
+  const Temporal *temp, MeosArray *result)
+{
+  if (! ensure_bbox_temporal_compatible(forest->bboxtype, temp))
+  {
+    meos_array_reset(result);
+    return 0;
+  }
+  /* Use a stack buffer large enough for any MEOS bounding box type */
+  bboxunion buf;
+  memset(&buf, 0, sizeof(buf));
+  temporal_set_bbox(temp, &buf);
+  return rtree_forest_search(forest, op, &buf, result);
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Freeze the buckets of a time-partitioned forest of RTrees that end
+ * before a timestamp
+ * @details The tree of a bucket whose time range ends at or before @p t is
+ * rebuilt with the Sort-Tile-Recursive packing of #rtree_load, which fills
+ * its nodes to capacity, and the bucket no longer accepts inserts. This suits
+ * the buckets of a stream that are past the arrival of late data.
+ * @param[in] forest The forest
+ * @param[in] t The timestamp
+ * @return Number of buckets frozen by the call
+ */
+int
+rtree_forest_freeze(RTreeForest *forest, TimestampTz t)
+{
+  int result = 0;
+  for (int i = 0; i < forest->count; i++)
+  {
+    RTreeBucket *bucket = &forest->buckets[i];
+    if (bucket->start + forest->tunits > t)
+      break;
+    if (bucket->frozen)
+      continue;
+    MeosArray *boxes = meos_array_create((int) forest->bboxsize);
+    MeosArray *ids = meos_array_create(sizeof(int64));
+    if (bucket->rtree->root)
+      node_collect(bucket->rtree->root, boxes, ids);
+    int count = meos_array_count(ids);
+    char *boxbuf = palloc(forest->bboxsize * (count ? count : 1));
+    int64 *idbuf = palloc(sizeof(int64) * (count ? count : 1));
+    for (int j = 0; j < count; j++)
+    {
+      memcpy(boxbuf + j * forest->bboxsize, meos_array_get(boxes, j),
+        forest->bboxsize);
+      idbuf[j] = *(int64 *) meos_array_get(ids, j);
+    }
+    meos_array_destroy(boxes);
+    meos_array_destroy(ids);
+    RTree *packed = rtree_create(forest->bboxtype);
+    rtree_load(packed, boxbuf, idbuf, count);
+    pfree(boxbuf); pfree(idbuf);
+    rtree_free(bucket->rtree);
+    bucket->rtree = packed;
+    bucket->frozen = true;
+    result++;
+  }
+  return result;
+}
+
+/**
+ * @ingroup meos_geo_box_index
+ * @brief Drop the buckets of a time-partitioned forest of RTrees whose boxes
+ * all end before a timestamp
+ * @details This implements the retention of a stream: the trees of the
+ * expired buckets are freed at once instead of deleting their entries.
+ * @param[in] forest The forest
+ * @param[in] t The timestamp
+ * @return Number of buckets dropped
+ */
+int
+rtree_forest_drop(RTreeForest *forest, TimestampTz t)
+{
+  int j = 0;
+  for (int i = 0; i < forest->count; i++)
+  {
+    if (forest->buckets[i].tmax < t)
+      rtree_free(forest->buckets[i].rtree);
+    else
+      forest->buckets[j++] = forest->buckets[i];
+  }
+  int result = forest->count - j;
+  forest->count = j;
+  return result;
+}
+
 /*****************************************************************************/
@@ -41,7 +41,14 @@
  */
 
 /* C */
+#include <stdio.h>
 #include <stdlib.h>
+#if MEOS
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
 /* MEOS */
 #include <meos.h>
 #include <meos_geo.h>
@@ -65,14 +72,15 @@
  *
  * The bits are those the matching getQuadrant assigns, and the order is the one
  * the matching *node_kdtree_next walks, so the two orders being different — as
- * they are for the spatiotemporal box, whose bits run Z, Y, X, period while its
- * search narrows X, Y, Z, period — is carried by the table rather than by a
+ * they are for the span, whose search narrows the upper bound first, and for
+ * the spatiotemporal box, whose bits run Z, Y, X, period while its search
+ * narrows X, Y, Z, period — is carried by the table rather than by a
  * rule. `*node_kdtree_next` is shared with the SP-GiST operator classes, whose
  * descent is PostgreSQL's, so the order it walks is fixed and this side adapts.
  *****************************************************************************/
 
-/* lower, upper */
-static const uint8 SPAN_KD_BITS[2] = {1, 0};
+/* upper, lower */
+static const uint8 SPAN_KD_BITS[2] = {0, 1};
 /* span.lower, span.upper, period.lower, period.upper */
 static const uint8 TBOX_KD_BITS[4] = {3, 2, 1, 0};
 /* xmin, xmax, ymin, ymax, zmin, zmax, period.lower, period.upper */
@@ -124,6 +132,14 @@ span_inner_consistent(const void *nodebox, const void *query, RTreeSearchOp op)
   return overlap2D(n, q);
 }
 
+static void
+span_nodebox_cover(const void *nodebox, void *box)
+{
+  const SpanNode *n = (const SpanNode *) nodebox;
+  span_set(n->left.lower, n->right.upper, n->left.lower_inc,
+    n->right.upper_inc, n->left.basetype, n->left.spantype, (Span *) box);
+}
+
 static bool
 span_leaf_consistent(const void *key, const void *query, RTreeSearchOp op)
 {
@@ -179,6 +195,18 @@ tbox_inner_consistent(const void *nodebox, const void *query, RTreeSearchOp op)
   return overlap4D(n, q);
 }
 
+static void
+tbox_nodebox_cover(const void *nodebox, void *box)
+{
+  const TboxNode *n = (const TboxNode *) nodebox;
+  TBox *result = (TBox *) box;
+  memcpy(result, &n->left, sizeof(TBox));
+  result->span.upper = n->right.span.upper;
+  result->span.upper_inc = n->right.span.upper_inc;
+  result->period.upper = n->right.period.upper;
+  result->period.upper_inc = n->right.period.upper_inc;
+}
+
 static bool
 tbox_leaf_consistent(const void *key, const void *query, RTreeSearchOp op)
 {
@@ -240,6 +268,19 @@ stbox_inner_consistent(const void *nodebox, const void *query, RTreeSearchOp op)
   return overlap8D(n, q);
 }
 
+static void
+stbox_nodebox_cover(const void *nodebox, void *box)
+{
+  const STboxNode *n = (const STboxNode *) nodebox;
+  STBox *result = (STBox *) box;
+  memcpy(result, &n->left, sizeof(STBox));
+  result->xmax = n->right.xmax;
+  result->ymax = n->right.ymax;
+  result->zmax = n->right.zmax;
+  result->period.upper = n->right.period.upper;
+  result->period.upper_inc = n->right.period.upper_inc;
+}
+
 static bool
 stbox_leaf_consistent(const void *key, const void *query, RTreeSearchOp op)
 {
@@ -281,6 +322,7 @@ tpcbox_project(const void *in, void *out)
  *****************************************************************************/
 
 /**
+ * @ingroup meos_internal_box_index
  * @brief Create an in-memory space-partitioning index for a bounding box type
  * @param[in] bboxtype Type of the bounding box (a span type or @p T_TBOX)
  * @param[in] kind Quad-tree or k-d tree
@@ -288,16 +330,46 @@ tpcbox_project(const void *in, void *out)
  */
 SPTree *
 sptree_create(MeosType bboxtype, SPTreeKind kind)
+{
+  return sptree_create_config(bboxtype, kind, 0);
+}
+
+/**
+ * @ingroup meos_internal_box_index
+ * @brief Create an in-memory space-partitioning index for a bounding box type
+ * with leaf buckets
+ * @details The subtrees holding at most @p bucketsize boxes are replaced by a
+ * leaf bucket storing the boxes and their ids contiguously, which the
+ * searches scan linearly. A bucket that overflows is split into an inner node
+ * and buckets for its children. This cuts the number of nodes, and thus the
+ * memory per box and the cache misses of the searches, by about the size of
+ * the buckets.
+ * @param[in] bboxtype Type of the bounding box (a span type or @p T_TBOX)
+ * @param[in] kind Quad-tree or k-d tree
+ * @param[in] bucketsize Capacity of the leaf buckets, from 2 to 256, or 0 for
+ * a tree without leaf buckets
+ * @return SPTree initialized, `NULL` if the capacity is out of range
+ */
+SPTree *
+sptree_create_config(MeosType bboxtype, SPTreeKind kind, int bucketsize)
 {
   assert(span_type(bboxtype) || bboxtype == T_TBOX || bboxtype == T_STBOX
 #if POINTCLOUD
     || bboxtype == T_TPCBOX
 #endif
     );
+  if (bucketsize != 0 && (bucketsize < 2 || bucketsize > SPTREE_MAX_BUCKET))
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "The capacity of the leaf buckets of an SPTree must be 0 or between "
+      "2 and %d", SPTREE_MAX_BUCKET);
+    return NULL;
+  }
   SPTree *sptree = palloc0(sizeof(SPTree));
   sptree->bboxtype = bboxtype;
   sptree->boxsize = bbox_get_size(bboxtype);
   sptree->kind = kind;
+  sptree->bucketsize = bucketsize;
   sptree->root = NULL;
   if (span_type(bboxtype))
   {
@@ -311,6 +383,7 @@ sptree_create(MeosType bboxtype, SPTreeKind kind)
     sptree->quadtree_next = &span_quadtree_next;
     sptree->kdtree_next = &span_kdtree_next;
     sptree->inner_consistent = &span_inner_consistent;
+    sptree->nodebox_cover = &span_nodebox_cover;
     sptree->leaf_consistent = &span_leaf_consistent;
   }
   else if (bboxtype == T_TBOX)
@@ -323,6 +396,7 @@ sptree_create(MeosType bboxtype, SPTreeKind kind)
     sptree->quadtree_next = &tbox_quadtree_next;
     sptree->kdtree_next = &tbox_kdtree_next;
     sptree->inner_consistent = &tbox_inner_consistent;
+    sptree->nodebox_cover = &tbox_nodebox_cover;
     sptree->leaf_consistent = &tbox_leaf_consistent;
   }
 #if POINTCLOUD
@@ -341,6 +415,7 @@ sptree_create(MeosType bboxtype, SPTreeKind kind)
     sptree->quadtree_next = &stbox_quadtree_next;
     sptree->kdtree_next = &stbox_kdtree_next;
     sptree->inner_consistent = &stbox_inner_consistent;
+    sptree->nodebox_cover = &stbox_nodebox_cover;
     sptree->leaf_consistent = &stbox_leaf_consistent;
   }
 #endif /* POINTCLOUD */
@@ -356,6 +431,7 @@ sptree_create(MeosType bboxtype, SPTreeKind kind)
     sptree->quadtree_next = &stbox_quadtree_next;
     sptree->kdtree_next = &stbox_kdtree_next;
     sptree->inner_consistent = &stbox_inner_consistent;
+    sptree->nodebox_cover = &stbox_nodebox_cover;
     sptree->leaf_consistent = &stbox_leaf_consistent;
   }
   sptree->nchild = (sptree->dims < 0) ? -1 :
@@ -472,24 +548,233 @@ sptree_create_tpcbox(SPTreeKind kind)
  *****************************************************************************/
 
 /**
- * @brief Return a new node holding a bounding box
+ * @brief Return the offset of the array of children within an inner node
+ */
+static inline size_t
+spnode_childoff(const SPTree *sptree)
+{
+  return MAXALIGN(sizeof(SPNode) + sptree->boxsize);
+}
+
+/**
+ * @brief Return the size of an inner node, with its array of children
+ */
+static inline size_t
+spnode_size(const SPTree *sptree)
+{
+  return spnode_childoff(sptree) +
+    (size_t) Max(sptree->nchild, 0) * sizeof(int64);
+}
+
+/**
+ * @brief Return the size of a leaf bucket, with its boxes and ids
+ */
+static inline size_t
+spbucket_size(const SPTree *sptree)
+{
+  return MAXALIGN(sizeof(SPNode) + (size_t) sptree->bucketsize *
+    sptree->boxsize) + (size_t) sptree->bucketsize * sizeof(int64);
+}
+
+/**
+ * @brief Allocate zeroed memory for a node from the arena of an SPTree
+ * @details The nodes are carved out of large blocks, which are only released
+ * when the tree is freed, so that a node costs no allocation of its own and
+ * the nodes built together are close in memory
+ */
+static void *
+sptree_alloc(SPTree *sptree, size_t size)
+{
+  size = MAXALIGN(size);
+  SPArenaBlock *block = sptree->arena;
+  if (! block || block->used + size > block->size)
+  {
+    size_t blocksize = Max(SPTREE_ARENA_BLOCKSIZE, size);
+    block = palloc(sizeof(SPArenaBlock) + blocksize);
+    block->next = sptree->arena;
+    block->size = blocksize;
+    block->used = 0;
+    sptree->arena = block;
+  }
+  void *result = block->data + block->used;
+  block->used += size;
+  memset(result, 0, size);
+  return result;
+}
+
+/**
+ * @brief Return a new inner node holding a bounding box, reusing a released
+ * one if any
  */
 static SPNode *
-spnode_make(const SPTree *sptree, const void *box, int64 id)
+spnode_make(SPTree *sptree, const void *box, int64 id)
 {
-  SPNode *node = palloc0(sizeof(SPNode) + sptree->boxsize);
+  SPNode *node = sptree->freenodes;
+  if (node)
+  {
+    memcpy(&sptree->freenodes, node->centroid, sizeof(SPNode *));
+    memset(node, 0, spnode_size(sptree));
+  }
+  else
+    node = sptree_alloc(sptree, spnode_size(sptree));
   node->id = id;
-  node->children = palloc0((size_t) sptree->nchild * sizeof(SPNode *));
+  node->children = (SPNode **) ((char *) node + spnode_childoff(sptree));
   memcpy(node->centroid, box, sptree->boxsize);
   return node;
 }
 
+/**
+ * @brief Release an inner node for reuse by #spnode_make
+ */
+static void
+spnode_release(SPTree *sptree, SPNode *node)
+{
+  memcpy(node->centroid, &sptree->freenodes, sizeof(SPNode *));
+  sptree->freenodes = node;
+  return;
+}
+
+/**
+ * @brief Return a new empty leaf bucket, reusing a released one if any
+ */
+static SPNode *
+spbucket_make(SPTree *sptree)
+{
+  SPNode *node = sptree->freebuckets;
+  if (node)
+  {
+    memcpy(&sptree->freebuckets, node->centroid, sizeof(SPNode *));
+    memset(node, 0, spbucket_size(sptree));
+    return node;
+  }
+  return sptree_alloc(sptree, spbucket_size(sptree));
+}
+
+/**
+ * @brief Release a leaf bucket for reuse by #spbucket_make
+ */
+static void
+spbucket_release(SPTree *sptree, SPNode *node)
+{
+  memcpy(node->centroid, &sptree->freebuckets, sizeof(SPNode *));
+  sptree->freebuckets = node;
+  return;
+}
+
+/**
+ * @brief Append a box to a leaf bucket that is not full
+ */
+static void
+spbucket_add(const SPTree *sptree, SPNode *node, const void *box, int64 id)
+{
+  assert(node->count < sptree->bucketsize);
+  memcpy(SPNODE_BOX_N(sptree, node, node->count), box, sptree->boxsize);
+  SPNODE_IDS(sptree, node)[node->count++] = id;
+  return;
+}
+
+/**
+ * @brief Ensure that an SPTree can be modified, i.e., that it is not mapped
+ * read-only from a file by #sptree_open
+ */
+static bool
+ensure_sptree_not_mapped(const SPTree *sptree)
+{
+  if (! sptree->base)
+    return true;
+  meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+    "An SPTree opened from a file cannot be modified");
+  return false;
+}
+
+/**
+ * @brief Set the dimensions of an SPTree whose dimensions depend on the data
+ * (STBox: 6 for 2D+T, 8 for 3D+T) and hence the number of children per node
+ */
+static void
+sptree_set_dims(SPTree *sptree, int dims)
+{
+  sptree->dims = dims;
+  sptree->kd_bits = (dims == 8) ? STBOX_KD_BITS_Z : STBOX_KD_BITS;
+  sptree->nchild = (sptree->kind == SPTREE_QUADTREE) ? (1 << dims) : 2;
+  return;
+}
+
+/**
+ * @brief Return the child of a node of an SPTree under which a box is stored
+ * @details The box is stored under the bit of the dimension the search
+ * narrows at the level of the node, so that the region a search descends
+ * into is the region the box was partitioned by
+ */
+static inline int
+spnode_child_index(const SPTree *sptree, const void *centroid,
+  const void *box, int level)
+{
+  uint8 quadrant = sptree->get_quadrant(centroid, box);
+  return (sptree->kind == SPTREE_QUADTREE) ? (int) quadrant :
+    (int) ((quadrant >> sptree->kd_bits[level % sptree->dims]) & 1);
+}
+
+/**
+ * @brief Return true if two boxes of an SPTree are equal, i.e., each one
+ * contains the other
+ */
+static inline bool
+spbox_same(const SPTree *sptree, const void *box1, const void *box2)
+{
+  return sptree->leaf_consistent(box1, box2, RTREE_CONTAINS) &&
+    sptree->leaf_consistent(box2, box1, RTREE_CONTAINS);
+}
+
+/**
+ * @brief Entry of the bulk load of an SPTree
+ */
+typedef struct
+{
+  const void *box;    /**< Bounding box */
+  int64 id;           /**< Identifier of the box */
+} SPLoadItem;
+
+static SPNode *spnode_load(SPTree *sptree, SPLoadItem *items,
+  SPLoadItem *scratch, int count, int level);
+
+/**
+ * @brief Split a full leaf bucket receiving one more box
+ * @details The boxes of the bucket and the new one are built into a subtree
+ * by the bulk load, i.e., an inner node holding their median and, since the
+ * others are at most as many as the capacity of the buckets, one leaf bucket
+ * per nonempty child
+ */
+static SPNode *
+spbucket_split(SPTree *sptree, SPNode *bucket, const void *box, int64 id,
+  int level)
+{
+  int count = bucket->count + 1;
+  SPLoadItem *items = palloc(sizeof(SPLoadItem) * count);
+  SPLoadItem *scratch = palloc(sizeof(SPLoadItem) * count);
+  const int64 *ids = SPNODE_IDS(sptree, bucket);
+  for (int i = 0; i < bucket->count; i++)
+  {
+    items[i].box = SPNODE_BOX_N(sptree, bucket, i);
+    items[i].id = ids[i];
+  }
+  items[count - 1].box = box;
+  items[count - 1].id = id;
+  SPNode *result = spnode_load(sptree, items, scratch, count, level);
+  pfree(items); pfree(scratch);
+  spbucket_release(sptree, bucket);
+  return result;
+}
+
 /**
  * @ingroup meos_temporal_box_index
  * @brief Insert a bounding box into an in-memory space-partitioning index
  * @details The box is stored at the first empty child slot reached while
  * descending from the root by quadrant. Equal boxes chain through the first
- * child, so the search still finds every id.
+ * child, so the search still finds every id. In a tree with leaf buckets the
+ * box is appended to the bucket reached, which is split when it is full. An
+ * inner node whose box was deleted by #sptree_delete and that is reached with
+ * an equal box stores the new entry again.
  * @param[in] sptree The SPTree previously initialized
  * @param[in] box The bounding box to insert
  * @param[in] id The id associated with the box
@@ -497,6 +782,8 @@ spnode_make(const SPTree *sptree, const void *box, int64 id)
 void
 sptree_insert(SPTree *sptree, void *box, int64 id)
 {
+  if (! ensure_sptree_not_mapped(sptree))
+    return;
   /* Project the incoming box into the internal box type (TPCBox: STBox) */
   bboxunion proj;
   if (sptree->project)
@@ -504,36 +791,345 @@ sptree_insert(SPTree *sptree, void *box, int64 id)
     sptree->project(box, &proj);
     box = &proj;
   }
-  /* Determine the deferred dimensions from the first box (STBox: 6 for 2D+T,
-   * 8 for 3D+T) and hence the number of children per node */
+  /* Determine the deferred dimensions from the first box */
   if (sptree->dims < 0)
-  {
-    sptree->dims = sptree->box_dims(box);
-    sptree->kd_bits = (sptree->dims == 8) ? STBOX_KD_BITS_Z : STBOX_KD_BITS;
-    sptree->nchild = (sptree->kind == SPTREE_QUADTREE) ?
-      (1 << sptree->dims) : 2;
-  }
+    sptree_set_dims(sptree, sptree->box_dims(box));
   SPNode **slot = &sptree->root;
   int level = 0;
-  while (*slot != NULL)
+  while (*slot != NULL && ! SPNODE_IS_BUCKET(*slot))
   {
-    uint8 quadrant = sptree->get_quadrant((*slot)->centroid, box);
-    /* Store the box under the bit of the dimension the search narrows at this
-     * level, so that the region a search descends into is the region the box
-     * was partitioned by */
-    int child = (sptree->kind == SPTREE_QUADTREE) ? (int) quadrant :
-      (int) ((quadrant >> sptree->kd_bits[level % sptree->dims]) & 1);
+    if ((*slot)->deleted && spbox_same(sptree, (*slot)->centroid, box))
+    {
+      (*slot)->id = id;
+      (*slot)->deleted = false;
+      return;
+    }
+    int child = spnode_child_index(sptree, (*slot)->centroid, box, level);
     slot = &(*slot)->children[child];
     level++;
   }
-  *slot = spnode_make(sptree, box, id);
+  if (! sptree->bucketsize)
+    *slot = spnode_make(sptree, box, id);
+  else if (! *slot)
+  {
+    *slot = spbucket_make(sptree);
+    spbucket_add(sptree, *slot, box, id);
+  }
+  else if ((*slot)->count < sptree->bucketsize)
+    spbucket_add(sptree, *slot, box, id);
+  else
+    *slot = spbucket_split(sptree, *slot, box, id, level);
+  return;
+}
+
+/*****************************************************************************
+ * Bulk load
+ *
+ * A balanced tree is built top-down: the box stored at a node of a level is
+ * the median of the boxes of its subtree along the dimension narrowed at that
+ * level, found by quickselect, and the other boxes are distributed among the
+ * children exactly as #sptree_insert would. Every child then holds at most
+ * half of the boxes, so the depth is logarithmic whatever the order of the
+ * input, e.g., for time-ordered boxes that make inserted k-d trees degenerate
+ * into chains. In a tree with leaf buckets, a subtree of at most
+ * @p bucketsize boxes is built as a single bucket.
+ *****************************************************************************/
+
+/**
+ * @brief Compare two boxes along the dimension carried by a quadrant bit
+ * @details The bit of the quadrant of a box is set when its bound in that
+ * dimension is greater than the one of the centroid
+ */
+static int
+spload_cmp(const SPTree *sptree, const void *box1, const void *box2, int bit)
+{
+  if ((sptree->get_quadrant(box1, box2) >> bit) & 1)
+    return -1;
+  if ((sptree->get_quadrant(box2, box1) >> bit) & 1)
+    return 1;
+  return 0;
+}
+
+/**
+ * @brief Reorder the items so that the k-th one is the one of a sort along
+ * the dimension carried by a quadrant bit, the items before being not greater
+ * and those after not smaller (nth-element)
+ */
+static void
+spload_select(const SPTree *sptree, SPLoadItem *items, int count, int k,
+  int bit)
+{
+  int lo = 0, hi = count - 1;
+  while (lo < hi)
+  {
+    /* Median of three as pivot, moved to the front */
+    int mid = lo + (hi - lo) / 2;
+    SPLoadItem tmp;
+    if (spload_cmp(sptree, items[mid].box, items[lo].box, bit) < 0)
+      { tmp = items[mid]; items[mid] = items[lo]; items[lo] = tmp; }
+    if (spload_cmp(sptree, items[hi].box, items[lo].box, bit) < 0)
+      { tmp = items[hi]; items[hi] = items[lo]; items[lo] = tmp; }
+    if (spload_cmp(sptree, items[hi].box, items[mid].box, bit) < 0)
+      { tmp = items[hi]; items[hi] = items[mid]; items[mid] = tmp; }
+    tmp = items[mid]; items[mid] = items[lo]; items[lo] = tmp;
+    const void *pivot = items[lo].box;
+    /* Hoare partition around the pivot */
+    int i = lo, j = hi + 1;
+    while (1)
+    {
+      do i++; while (i <= hi && spload_cmp(sptree, items[i].box, pivot,
+        bit) < 0);
+      do j--; while (spload_cmp(sptree, items[j].box, pivot, bit) > 0);
+      if (i >= j)
+        break;
+      tmp = items[i]; items[i] = items[j]; items[j] = tmp;
+    }
+    tmp = items[lo]; items[lo] = items[j]; items[j] = tmp;
+    if (j == k)
+      return;
+    if (j < k)
+      lo = j + 1;
+    else
+      hi = j - 1;
+  }
+  return;
+}
+
+/**
+ * @brief Build a balanced subtree from the items of a slice
+ * @param[in] sptree The SPTree
+ * @param[in,out] items The items of the subtree, reordered by the call
+ * @param[in] scratch Buffer of at least @p count items
+ * @param[in] count Number of items
+ * @param[in] level The depth of the subtree
+ */
+static SPNode *
+spnode_load(SPTree *sptree, SPLoadItem *items, SPLoadItem *scratch,
+  int count, int level)
+{
+  if (count == 0)
+    return NULL;
+  /* A subtree small enough is a leaf bucket */
+  if (count <= sptree->bucketsize)
+  {
+    SPNode *bucket = spbucket_make(sptree);
+    for (int i = 0; i < count; i++)
+      spbucket_add(sptree, bucket, items[i].box, items[i].id);
+    return bucket;
+  }
+  /* Store at the node the median along the dimension narrowed at this level */
+  int bit = sptree->kd_bits[level % sptree->dims];
+  int k = count / 2;
+  spload_select(sptree, items, count, k, bit);
+  SPNode *node = spnode_make(sptree, items[k].box, items[k].id);
+  items[k] = items[count - 1];
+  count--;
+
+  /* Distribute the other items among the children by counting sort */
+  int *child = palloc(sizeof(int) * (count ? count : 1));
+  int *start = palloc0(sizeof(int) * (sptree->nchild + 1));
+  for (int i = 0; i < count; i++)
+  {
+    child[i] = spnode_child_index(sptree, node->centroid, items[i].box,
+      level);
+    start[child[i] + 1]++;
+  }
+  for (int c = 0; c < sptree->nchild; c++)
+    start[c + 1] += start[c];
+  int *pos = palloc(sizeof(int) * sptree->nchild);
+  memcpy(pos, start, sizeof(int) * sptree->nchild);
+  for (int i = 0; i < count; i++)
+    scratch[pos[child[i]]++] = items[i];
+  memcpy(items, scratch, sizeof(SPLoadItem) * count);
+  pfree(child); pfree(pos);
+
+  for (int c = 0; c < sptree->nchild; c++)
+    node->children[c] = spnode_load(sptree, items + start[c],
+      scratch + start[c], start[c + 1] - start[c], level + 1);
+  pfree(start);
+  return node;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Build an in-memory space-partitioning index from all of its entries
+ * at once
+ * @details The tree is balanced, its depth being logarithmic in the number of
+ * entries whatever their order, and it answers the same queries as inserting
+ * every entry one by one with #sptree_insert, which can still be used
+ * afterwards.
+ * @param[in] sptree An EMPTY SPTree of the appropriate bounding box type
+ * @param[in] boxes Contiguous array of @p count boxes of the tree bbox type
+ * @param[in] ids The id of each box
+ * @param[in] count Number of entries
+ */
+void
+sptree_load(SPTree *sptree, const void *boxes, const int64 *ids, int count)
+{
+  if (! ensure_sptree_not_mapped(sptree) || count <= 0)
+    return;
+  if (sptree->root)
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "An SPTree must be empty to be loaded");
+    return;
+  }
+  /* Project the incoming boxes into the internal box type (TPCBox: STBox) */
+  size_t stride = bbox_get_size(sptree->bboxtype);
+  char *proj = NULL;
+  if (sptree->project)
+  {
+    proj = palloc(sptree->boxsize * (size_t) count);
+    for (int i = 0; i < count; i++)
+      sptree->project((const char *) boxes + (size_t) i * stride,
+        proj + (size_t) i * sptree->boxsize);
+    boxes = proj;
+    stride = sptree->boxsize;
+  }
+  /* Determine the deferred dimensions from the first box */
+  if (sptree->dims < 0)
+    sptree_set_dims(sptree, sptree->box_dims(boxes));
+
+  SPLoadItem *items = palloc(sizeof(SPLoadItem) * (size_t) count);
+  SPLoadItem *scratch = palloc(sizeof(SPLoadItem) * (size_t) count);
+  for (int i = 0; i < count; i++)
+  {
+    items[i].box = (const char *) boxes + (size_t) i * stride;
+    items[i].id = ids[i];
+  }
+  sptree->root = spnode_load(sptree, items, scratch, count, 0);
+  pfree(items); pfree(scratch);
+  if (proj)
+    pfree(proj);
   return;
 }
 
+/*****************************************************************************
+ * Deletion
+ *
+ * An entry is found by descending from the root along the path by which
+ * #sptree_insert and #sptree_load place its box. The box of an inner node
+ * still partitions the space for the boxes of its subtree, so a deleted inner
+ * node is only marked as such, and skipped by the searches, until its last
+ * child is gone. An entry of a leaf bucket is replaced by the last one of the
+ * bucket. The emptied nodes and buckets are released for reuse.
+ *****************************************************************************/
+
+/**
+ * @brief Delete an entry from the subtree of a slot of an SPTree
+ * @param[in] sptree The SPTree
+ * @param[in,out] slot The slot of the subtree, set to `NULL` when the subtree
+ * becomes empty
+ * @param[in] box The box of the entry
+ * @param[in] id The id of the entry
+ * @param[in] level The depth of the subtree
+ * @return True if the entry was found and deleted
+ */
+static bool
+spnode_delete(SPTree *sptree, SPNode **slot, const void *box, int64 id,
+  int level)
+{
+  SPNode *node = *slot;
+  if (! node)
+    return false;
+  if (SPNODE_IS_BUCKET(node))
+  {
+    int64 *ids = SPNODE_IDS(sptree, node);
+    for (int i = 0; i < node->count; i++)
+    {
+      if (ids[i] != id || ! spbox_same(sptree, SPNODE_BOX_N(sptree, node, i),
+          box))
+        continue;
+      int last = --node->count;
+      if (i < last)
+      {
+        memcpy(SPNODE_BOX_N(sptree, node, i), SPNODE_BOX_N(sptree, node, last),
+          sptree->boxsize);
+        ids[i] = ids[last];
+      }
+      if (node->count == 0)
+      {
+        spbucket_release(sptree, node);
+        *slot = NULL;
+      }
+      return true;
+    }
+    return false;
+  }
+  bool found = false;
+  if (! node->deleted && node->id == id &&
+      spbox_same(sptree, node->centroid, box))
+  {
+    node->deleted = true;
+    found = true;
+  }
+  else
+  {
+    int child = spnode_child_index(sptree, node->centroid, box, level);
+    found = spnode_delete(sptree, &node->children[child], box, id, level + 1);
+  }
+  if (found && node->deleted)
+  {
+    /* A deleted node without children no longer partitions anything */
+    for (int i = 0; i < sptree->nchild; i++)
+    {
+      if (node->children[i])
+        return true;
+    }
+    spnode_release(sptree, node);
+    *slot = NULL;
+  }
+  return found;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Delete an entry from an in-memory space-partitioning index
+ * @details The entry is identified by its id together with its box, so that
+ * an id inserted with several boxes, as #sptree_insert_temporal_split does,
+ * loses only the given one. The box of a deleted inner node is kept to
+ * partition the space for its children, so the tree is not restructured; a
+ * later insertion of an equal box reuses the node.
+ * @param[in] sptree The SPTree
+ * @param[in] box The bounding box with which the entry was inserted
+ * @param[in] id The id of the entry
+ * @return True if the entry was found and deleted, false otherwise
+ */
+bool
+sptree_delete(SPTree *sptree, const void *box, int64 id)
+{
+  if (! ensure_sptree_not_mapped(sptree) || ! sptree->root)
+    return false;
+  /* Project the box into the internal box type (TPCBox: STBox) */
+  bboxunion proj;
+  if (sptree->project)
+  {
+    sptree->project(box, &proj);
+    box = &proj;
+  }
+  return spnode_delete(sptree, &sptree->root, box, id, 0);
+}
+
 /*****************************************************************************
  * Search
  *****************************************************************************/
 
+/**
+ * @brief Return the n-th child of a node, or `NULL` when the slot is empty
+ * @details In a tree mapped from a file the @p children field of a node holds
+ * the offset of an array of child offsets from the start of the mapping, an
+ * empty slot being a zero offset
+ */
+static inline const SPNode *
+spnode_child(const SPTree *sptree, const SPNode *node, int n)
+{
+  if (! sptree->base)
+    return node->children[n];
+  const int64 *offsets = (const int64 *) (sptree->base +
+    (uintptr_t) node->children);
+  return offsets[n] ? (const SPNode *) (sptree->base + offsets[n]) : NULL;
+}
+
 /**
  * @brief Recursively collect the ids of the boxes consistent with the query
  * @param[in] sptree The SPTree
@@ -543,19 +1139,42 @@ sptree_insert(SPTree *sptree, void *box, int64 id)
  * @param[in] query The query bounding box
  * @param[in] level The depth of @p node (drives the k-d tree dimension)
  * @param[out] result MeosArray collecting the matching ids
+ * @param[in,out] cost Counters of the cost of the search, may be `NULL`
  */
 static void
 spnode_search(const SPTree *sptree, const SPNode *node, const void *nodebox,
-  RTreeSearchOp op, const void *query, int level, MeosArray *result)
+  RTreeSearchOp op, const void *query, int level, MeosArray *result,
+  RTreeSearchCost *cost)
 {
-  if (sptree->leaf_consistent(node->centroid, query, op))
+  if (SPNODE_IS_BUCKET(node))
+  {
+    if (cost)
+    {
+      cost->leaves++;
+      cost->entries += node->count;
+    }
+    /* The boxes of a leaf bucket are scanned linearly */
+    const int64 *ids = SPNODE_IDS(sptree, node);
+    for (int i = 0; i < node->count; i++)
+    {
+      if (sptree->leaf_consistent(SPNODE_BOX_N(sptree, node, i), query, op))
+        meos_array_add(result, (void *) &ids[i]);
+    }
+    return;
+  }
+  if (cost)
+  {
+    cost->inner_nodes++;
+    cost->entries += ! node->deleted;
+  }
+  if (! node->deleted && sptree->leaf_consistent(node->centroid, query, op))
   {
     int64 id = node->id;
     meos_array_add(result, &id);
   }
   for (int quadrant = 0; quadrant < sptree->nchild; quadrant++)
   {
-    const SPNode *child = node->children[quadrant];
+    const SPNode *child = spnode_child(sptree, node, quadrant);
     if (! child)
       continue;
     char next[SPTREE_NODEBOX_MAXSIZE];
@@ -565,7 +1184,7 @@ spnode_search(const SPTree *sptree, const SPNode *node, const void *nodebox,
       sptree->kdtree_next(nodebox, node->centroid, (uint8) quadrant, level,
         next);
     if (sptree->inner_consistent(next, query, op))
-      spnode_search(sptree, child, next, op, query, level + 1, result);
+      spnode_search(sptree, child, next, op, query, level + 1, result, cost);
   }
   return;
 }
@@ -586,6 +1205,27 @@ spnode_search(const SPTree *sptree, const SPNode *node, const void *nodebox,
 int
 sptree_search(const SPTree *sptree, RTreeSearchOp op, const void *query,
   MeosArray *result)
+{
+  return sptree_search_cost(sptree, op, query, result, NULL);
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Search an in-memory space-partitioning index with a bounding box as
+ * #sptree_search, measuring the cost of the search
+ * @details The counters of @p cost are incremented as for #rtree_search_cost,
+ * where the inner nodes are those storing a box, whose box is tested against
+ * the query unless it was deleted, and the leaves are the leaf buckets.
+ * @param[in] sptree The SPTree to query
+ * @param[in] op The search operation
+ * @param[in] query The bounding box that serves as query
+ * @param[out] result MeosArray of int to collect matching ids
+ * @param[in,out] cost Counters of the cost of the searches
+ * @return Number of matching ids
+ */
+int
+sptree_search_cost(const SPTree *sptree, RTreeSearchOp op, const void *query,
+  MeosArray *result, RTreeSearchCost *cost)
 {
   /* Project the query box into the internal box type (TPCBox: STBox) */
   bboxunion proj;
@@ -599,9 +1239,387 @@ sptree_search(const SPTree *sptree, RTreeSearchOp op, const void *query,
   {
     char rootbox[SPTREE_NODEBOX_MAXSIZE];
     sptree->nodebox_init(rootbox, sptree->root->centroid, sptree);
-    spnode_search(sptree, sptree->root, rootbox, op, query, 0, result);
+    spnode_search(sptree, sptree->root, rootbox, op, query, 0, result, cost);
   }
-  return meos_array_count(result);
+  int count = meos_array_count(result);
+  if (cost)
+    cost->results += count;
+  return count;
+}
+
+/*****************************************************************************
+ * Join
+ *
+ * Both trees are descended at once. For a pair of subtrees, the boxes stored
+ * at the root of the first one are searched in the whole second subtree, the
+ * boxes stored at the root of the second one are searched in the children of
+ * the first one, and every pair of children is joined in turn unless the
+ * region of the child of the second tree cannot hold any box overlapping the
+ * smallest box covering the region of the child of the first tree.
+ *****************************************************************************/
+
+/**
+ * @brief Return the operation finding the entries of the second tree of a
+ * join when searching it with an entry of the first tree
+ */
+static inline RTreeSearchOp
+spjoin_commute(RTreeSearchOp op)
+{
+  if (op == RTREE_CONTAINS)
+    return RTREE_CONTAINED_BY;
+  if (op == RTREE_CONTAINED_BY)
+    return RTREE_CONTAINS;
+  return op;
+}
+
+/**
+ * @brief Return the region of the n-th child of a node of an SPTree
+ */
+static inline void
+spnode_child_region(const SPTree *sptree, const SPNode *node,
+  const void *nodebox, int n, int level, void *next)
+{
+  if (sptree->kind == SPTREE_QUADTREE)
+    sptree->quadtree_next(nodebox, node->centroid, (uint8) n, next);
+  else
+    sptree->kdtree_next(nodebox, node->centroid, (uint8) n, level, next);
+  return;
+}
+
+/**
+ * @brief Add to the result of a join the pairs made of an id and each id
+ * collected by a search
+ */
+static void
+spjoin_add_pairs(int64 id, bool first, MeosArray *found, MeosArray *result)
+{
+  int count = meos_array_count(found);
+  for (int i = 0; i < count; i++)
+  {
+    int64 other = *(int64 *) meos_array_get(found, i);
+    meos_array_add(result, first ? &id : &other);
+    meos_array_add(result, first ? &other : &id);
+  }
+  meos_array_reset(found);
+  return;
+}
+
+/**
+ * @brief Join a pair of subtrees of two SPTrees
+ * @param[in] sptree1,sptree2 The SPTrees
+ * @param[in] node1,node2 The roots of the subtrees
+ * @param[in] region1,region2 The regions covered by @p node1 and @p node2
+ * @param[in] level1,level2 The depths of @p node1 and @p node2
+ * @param[in] op The join operation
+ * @param[in] found Scratch array of the ids found by a search
+ * @param[out] result MeosArray collecting the pairs of ids
+ */
+static void
+spnode_join(const SPTree *sptree1, const SPNode *node1, const void *region1,
+  int level1, const SPTree *sptree2, const SPNode *node2, const void *region2,
+  int level2, RTreeSearchOp op, MeosArray *found, MeosArray *result)
+{
+  /* The boxes stored at the first node against the whole second subtree */
+  RTreeSearchOp op2 = spjoin_commute(op);
+  if (SPNODE_IS_BUCKET(node1))
+  {
+    const int64 *ids = SPNODE_IDS(sptree1, node1);
+    for (int i = 0; i < node1->count; i++)
+    {
+      spnode_search(sptree2, node2, region2, op2,
+        SPNODE_BOX_N(sptree1, node1, i), level2, found, NULL);
+      spjoin_add_pairs(ids[i], true, found, result);
+    }
+    return;
+  }
+  if (! node1->deleted)
+  {
+    spnode_search(sptree2, node2, region2, op2, node1->centroid, level2,
+      found, NULL);
+    spjoin_add_pairs(node1->id, true, found, result);
+  }
+
+  /* The boxes stored at the second node against the children of the first */
+  char next1[SPTREE_NODEBOX_MAXSIZE];
+  for (int c1 = 0; c1 < sptree1->nchild; c1++)
+  {
+    const SPNode *child1 = spnode_child(sptree1, node1, c1);
+    if (! child1)
+      continue;
+    spnode_child_region(sptree1, node1, region1, c1, level1, next1);
+    if (SPNODE_IS_BUCKET(node2))
+    {
+      const int64 *ids = SPNODE_IDS(sptree2, node2);
+      for (int i = 0; i < node2->count; i++)
+      {
+        const void *box2 = SPNODE_BOX_N(sptree2, node2, i);
+        if (! sptree1->inner_consistent(next1, box2, op))
+          continue;
+        spnode_search(sptree1, child1, next1, op, box2, level1 + 1, found,
+          NULL);
+        spjoin_add_pairs(ids[i], false, found, result);
+      }
+    }
+    else if (! node2->deleted &&
+        sptree1->inner_consistent(next1, node2->centroid, op))
+    {
+      spnode_search(sptree1, child1, next1, op, node2->centroid, level1 + 1,
+        found, NULL);
+      spjoin_add_pairs(node2->id, false, found, result);
+    }
+  }
+  if (SPNODE_IS_BUCKET(node2))
+    return;
+
+  /* The pairs of children whose regions may hold overlapping boxes */
+  char next2[SPTREE_NODEBOX_MAXSIZE];
+  bboxunion cover1;
+  for (int c1 = 0; c1 < sptree1->nchild; c1++)
+  {
+    const SPNode *child1 = spnode_child(sptree1, node1, c1);
+    if (! child1)
+      continue;
+    spnode_child_region(sptree1, node1, region1, c1, level1, next1);
+    sptree1->nodebox_cover(next1, &cover1);
+    for (int c2 = 0; c2 < sptree2->nchild; c2++)
+    {
+      const SPNode *child2 = spnode_child(sptree2, node2, c2);
+      if (! child2)
+        continue;
+      spnode_child_region(sptree2, node2, region2, c2, level2, next2);
+      if (sptree2->inner_consistent(next2, &cover1, RTREE_OVERLAPS))
+        spnode_join(sptree1, child1, next1, level1 + 1, sptree2, child2,
+          next2, level2 + 1, op, found, result);
+    }
+  }
+  return;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Join two in-memory space-partitioning indexes, collecting the ids of
+ * every qualifying pair into a MeosArray
+ * @details Descends both trees at once, pruning the pairs of subtrees whose
+ * regions cannot hold overlapping boxes, as #rtree_join does for RTrees. The
+ * trees may be of different kinds and may have been opened from a file.
+ *
+ * The result array is reset before the join. It receives two ids per pair, the
+ * entry of @p sptree1 followed by the entry of @p sptree2, so pair `k` is read
+ * with #meos_array_get at positions `2 * k` and `2 * k + 1`.
+ * @param[in] sptree1,sptree2 The SPTrees to join, of the same bounding box
+ * type
+ * @param[in] op The join operation: @p RTREE_OVERLAPS pairs entries that
+ * overlap, @p RTREE_CONTAINS pairs entries of @p sptree1 that contain an entry
+ * of @p sptree2, @p RTREE_CONTAINED_BY pairs entries of @p sptree1 contained
+ * by an entry of @p sptree2
+ * @param[out] result MeosArray of int to collect the ids (created by the caller
+ * with `meos_array_create(sizeof(int64))`)
+ * @return Number of qualifying pairs, half the number of collected ids
+ */
+int
+sptree_join(const SPTree *sptree1, const SPTree *sptree2, RTreeSearchOp op,
+  MeosArray *result)
+{
+  assert(sptree1->bboxtype == sptree2->bboxtype);
+  meos_array_reset(result);
+  if (! sptree1->root || ! sptree2->root)
+    return 0;
+  char region1[SPTREE_NODEBOX_MAXSIZE], region2[SPTREE_NODEBOX_MAXSIZE];
+  sptree1->nodebox_init(region1, sptree1->root->centroid, sptree1);
+  sptree2->nodebox_init(region2, sptree2->root->centroid, sptree2);
+  MeosArray *found = meos_array_create(sizeof(int64));
+  spnode_join(sptree1, sptree1->root, region1, 0, sptree2, sptree2->root,
+    region2, 0, op, found, result);
+  meos_array_destroy(found);
+  return meos_array_count(result) / 2;
+}
+
+/*****************************************************************************
+ * Search cursor
+ *
+ * The depth-first traversal of #sptree_search made incremental: the cursor
+ * keeps one frame per level of the tree with the node, its region, and the
+ * next child to examine, so that its memory is bounded by the height of the
+ * tree whatever the number of matches, and the ids are produced in the order
+ * in which #sptree_search collects them.
+ *****************************************************************************/
+
+/**
+ * @brief Frame of the traversal of the search cursor
+ */
+typedef struct
+{
+  const SPNode *node;           /**< Node being visited */
+  int level;                    /**< Depth of @p node */
+  int next;                     /**< Next child to examine, -1 when the box
+                                     stored at the node is still to test, or
+                                     next box of a leaf bucket */
+  char region[SPTREE_NODEBOX_MAXSIZE];  /**< Region covered by @p node */
+} SPSearchFrame;
+
+/**
+ * @brief Incremental search cursor over an SPTree
+ */
+struct SPSearchCursor
+{
+  const SPTree *sptree;     /**< Indexed SPTree (borrowed, not owned) */
+  RTreeSearchOp op;         /**< Search operation */
+  void *query;              /**< Private copy of the projected query box */
+  SPSearchFrame *stack;     /**< Frames of the nodes being visited */
+  int depth;                /**< Number of frames */
+  int capacity;             /**< Allocated capacity of the stack */
+};
+
+/**
+ * @brief Push a node onto the stack of a search cursor, returning the frame
+ * whose region is to be filled by the caller
+ */
+static SPSearchFrame *
+spsearch_cursor_push(SPSearchCursor *cursor, const SPNode *node, int level)
+{
+  if (cursor->depth == cursor->capacity)
+  {
+    cursor->capacity *= 2;
+    cursor->stack = repalloc(cursor->stack,
+      (size_t) cursor->capacity * sizeof(SPSearchFrame));
+  }
+  SPSearchFrame *frame = &cursor->stack[cursor->depth++];
+  frame->node = node;
+  frame->level = level;
+  frame->next = -1;
+  return frame;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Open a cursor that yields the ids of an SPTree satisfying a search
+ * operation with a query bounding box
+ * @details Repeated calls to #sptree_search_cursor_next return the ids that
+ * #sptree_search would collect, in the same order, without materializing
+ * them. The caller may stop at any time and the rest of the tree is not
+ * visited. The query box is copied into the cursor, and the tree must not be
+ * modified while the cursor is open. Close the cursor with
+ * #sptree_search_cursor_close.
+ * @param[in] sptree The SPTree to query
+ * @param[in] op The search operation, as for #sptree_search
+ * @param[in] query The query bounding box of type @p sptree->bboxtype
+ * @return A cursor to be freed with #sptree_search_cursor_close
+ */
+SPSearchCursor *
+sptree_search_cursor_open(const SPTree *sptree, RTreeSearchOp op,
+  const void *query)
+{
+  assert(sptree); assert(query);
+  SPSearchCursor *cursor = palloc0(sizeof(SPSearchCursor));
+  cursor->sptree = sptree;
+  cursor->op = op;
+  cursor->query = palloc(sptree->boxsize);
+  /* Project the query box into the internal box type (TPCBox: STBox) */
+  if (sptree->project)
+    sptree->project(query, cursor->query);
+  else
+    memcpy(cursor->query, query, sptree->boxsize);
+  cursor->capacity = 16;
+  cursor->stack = palloc((size_t) cursor->capacity * sizeof(SPSearchFrame));
+  cursor->depth = 0;
+  if (sptree->root)
+  {
+    SPSearchFrame *frame = spsearch_cursor_push(cursor, sptree->root, 0);
+    sptree->nodebox_init(frame->region, sptree->root->centroid, sptree);
+  }
+  return cursor;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Advance a search cursor to the next id satisfying the search
+ * @param[in] cursor The cursor previously opened with
+ * #sptree_search_cursor_open
+ * @param[out] id_out Receives the id, or @p NULL
+ * @return @p true if an id was produced, @p false once exhausted
+ */
+bool
+sptree_search_cursor_next(SPSearchCursor *cursor, int64 *id_out)
+{
+  assert(cursor);
+  const SPTree *sptree = cursor->sptree;
+  while (cursor->depth > 0)
+  {
+    SPSearchFrame *frame = &cursor->stack[cursor->depth - 1];
+    const SPNode *node = frame->node;
+    if (SPNODE_IS_BUCKET(node))
+    {
+      /* The boxes of a leaf bucket are scanned linearly */
+      if (frame->next < 0)
+        frame->next = 0;
+      while (frame->next < node->count)
+      {
+        int i = frame->next++;
+        if (sptree->leaf_consistent(SPNODE_BOX_N(sptree, node, i),
+            cursor->query, cursor->op))
+        {
+          if (id_out)
+            *id_out = SPNODE_IDS(sptree, node)[i];
+          return true;
+        }
+      }
+      cursor->depth--;
+      continue;
+    }
+    if (frame->next < 0)
+    {
+      /* The box stored at the node comes before its children */
+      frame->next = 0;
+      if (! node->deleted &&
+          sptree->leaf_consistent(node->centroid, cursor->query, cursor->op))
+      {
+        if (id_out)
+          *id_out = node->id;
+        return true;
+      }
+      continue;
+    }
+    if (frame->next == sptree->nchild)
+    {
+      cursor->depth--;
+      continue;
+    }
+    int quadrant = frame->next++;
+    const SPNode *child = spnode_child(sptree, node, quadrant);
+    if (! child)
+      continue;
+    char next[SPTREE_NODEBOX_MAXSIZE];
+    if (sptree->kind == SPTREE_QUADTREE)
+      sptree->quadtree_next(frame->region, node->centroid, (uint8) quadrant,
+        next);
+    else
+      sptree->kdtree_next(frame->region, node->centroid, (uint8) quadrant,
+        frame->level, next);
+    if (sptree->inner_consistent(next, cursor->query, cursor->op))
+    {
+      /* The frame may move when the stack grows */
+      int level = frame->level + 1;
+      SPSearchFrame *childframe = spsearch_cursor_push(cursor, child, level);
+      memcpy(childframe->region, next, sptree->nodeboxsize);
+    }
+  }
+  return false;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Close a search cursor and free its resources
+ * @param[in] cursor The cursor to close; @p NULL is ignored
+ */
+void
+sptree_search_cursor_close(SPSearchCursor *cursor)
+{
+  if (! cursor)
+    return;
+  pfree(cursor->stack);
+  pfree(cursor->query);
+  pfree(cursor);
+  return;
 }
 
 /*****************************************************************************
@@ -776,37 +1794,325 @@ sptree_search_temporal_dedup(const SPTree *sptree, RTreeSearchOp op,
 }
 
 /*****************************************************************************
- * Free
+ * Statistics
  *****************************************************************************/
 
 /**
- * @brief Recursively free a node and its children
+ * @brief Accumulate the statistics of a subtree of an SPTree
+ * @details The fill factor of an inner node is the ratio of its non-empty
+ * child slots and the one of a leaf bucket the ratio of its boxes
  */
 static void
-spnode_free(const SPTree *sptree, SPNode *node)
+spnode_stats(const SPTree *sptree, const SPNode *node, int level,
+  RTreeStats *stats)
 {
-  if (! node)
+  stats->height = Max(stats->height, level);
+  if (SPNODE_IS_BUCKET(node))
+  {
+    stats->leaves++;
+    stats->entries += node->count;
+    stats->fill += (double) node->count / sptree->bucketsize;
     return;
-  for (int i = 0; i < sptree->nchild; i++)
-    spnode_free(sptree, node->children[i]);
-  pfree(node->children);
-  pfree(node);
+  }
+  stats->inner_nodes++;
+  stats->entries += ! node->deleted;
+  int nchild = 0;
+  for (int quadrant = 0; quadrant < sptree->nchild; quadrant++)
+  {
+    const SPNode *child = spnode_child(sptree, node, quadrant);
+    if (! child)
+      continue;
+    nchild++;
+    spnode_stats(sptree, child, level + 1, stats);
+  }
+  stats->fill += (double) nchild / sptree->nchild;
   return;
 }
 
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Return the statistics of an in-memory space-partitioning index
+ * @details The inner nodes are those storing a box and the leaves are the leaf
+ * buckets. The memory is the one of the arena of the nodes, including the
+ * nodes released by the deletions and kept for reuse, or the size of the file
+ * mapping for a tree opened by #sptree_open. The overlap is zero since the
+ * children of a node partition its region.
+ * @param[in] sptree The SPTree
+ * @param[out] stats The statistics
+ * @see rtree_stats
+ */
+void
+sptree_stats(const SPTree *sptree, RTreeStats *stats)
+{
+  assert(sptree); assert(stats);
+  memset(stats, 0, sizeof(RTreeStats));
+  stats->memory = sizeof(SPTree);
+  if (sptree->base)
+    stats->memory += sptree->mapsize;
+  for (const SPArenaBlock *block = sptree->arena; block; block = block->next)
+    stats->memory += sizeof(SPArenaBlock) + block->size;
+  if (! sptree->root)
+    return;
+  spnode_stats(sptree, sptree->root, 1, stats);
+  stats->fill /= (double) (stats->inner_nodes + stats->leaves);
+  return;
+}
+
+/*****************************************************************************
+ * Free
+ *****************************************************************************/
+
 /**
  * @ingroup meos_temporal_box_index
  * @brief Free an in-memory space-partitioning index
+ * @details For an SPTree opened by #sptree_open, the file mapping is released
  * @param[in] sptree The SPTree to free
  */
 void
 sptree_free(SPTree *sptree)
 {
-  spnode_free(sptree, sptree->root);
+  /* The nodes of a tree opened from a file live in the file mapping */
+  if (sptree->base)
+  {
+#if MEOS
+    munmap((void *) sptree->base, sptree->mapsize);
+#endif
+  }
+  /* The nodes of a tree in memory live in its arena */
+  SPArenaBlock *block = sptree->arena;
+  while (block)
+  {
+    SPArenaBlock *next = block->next;
+    pfree(block);
+    block = next;
+  }
   pfree(sptree);
   return;
 }
 
+#if MEOS
+/*****************************************************************************
+ * File serialization
+ *
+ * As for the RTree, an SPTree is saved as a header followed by its nodes in
+ * breadth-first order, and the file is mapped read-only and searched in place.
+ * An inner node is written as the SPNode with its box, followed by the array
+ * of the offsets of its children from the start of the file, where an empty
+ * slot is a zero offset. The @p children field of the node holds the offset of
+ * that array. A leaf bucket is written as it is laid out in memory, with a
+ * zero @p children field.
+ *****************************************************************************/
+
+#define SPTREE_FILE_MAGIC "MEOSSPT"
+#define SPTREE_FILE_VERSION 2
+
+/**
+ * @brief Header of an SPTree file
+ */
+typedef struct
+{
+  char magic[8];       /**< Identifies an SPTree file */
+  uint32 version;      /**< Version of the file layout */
+  uint32 nodesize;     /**< Size of a node, which depends on the platform */
+  int32 bboxtype;      /**< Type of the bounding box */
+  int32 kind;          /**< Quad-tree or k-d tree */
+  int32 dims;          /**< Number of dimensions of the tree */
+  int32 bucketsize;    /**< Capacity of the leaf buckets */
+  uint64 size;         /**< Size of the file */
+  uint64 root;         /**< Offset of the root node, 0 for an empty tree */
+} SPTreeFileHeader;
+
+/**
+ * @brief Return the size of a node of an SPTree file
+ */
+static inline size_t
+sptree_file_nodesize(const SPTree *sptree, const SPNode *node)
+{
+  return SPNODE_IS_BUCKET(node) ? spbucket_size(sptree) : spnode_size(sptree);
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Save an SPTree into a file that can be opened with #sptree_open
+ * @details The tree is written with offsets instead of pointers, so that the
+ * file can be mapped into memory and searched in place.
+ * @param[in] sptree The SPTree
+ * @param[in] filename The name of the file, which is overwritten if it exists
+ * @return True on success, false if the file cannot be written
+ * @see sptree_open
+ */
+bool
+sptree_save(const SPTree *sptree, const char *filename)
+{
+  assert(sptree); assert(filename);
+  size_t childoff = spnode_childoff(sptree);
+  size_t start = MAXALIGN(sizeof(SPTreeFileHeader));
+
+  /* Number the nodes in breadth-first order and compute their offsets */
+  int capacity = 64, nnodes = 0;
+  const SPNode **queue = palloc(sizeof(SPNode *) * capacity);
+  size_t *offsets = palloc(sizeof(size_t) * (capacity + 1));
+  if (sptree->root)
+    queue[nnodes++] = sptree->root;
+  offsets[0] = start;
+  for (int k = 0; k < nnodes; k++)
+  {
+    if (nnodes + sptree->nchild > capacity)
+    {
+      capacity *= 2;
+      queue = repalloc(queue, sizeof(SPNode *) * capacity);
+      offsets = repalloc(offsets, sizeof(size_t) * (capacity + 1));
+    }
+    offsets[k + 1] = offsets[k] + sptree_file_nodesize(sptree, queue[k]);
+    if (SPNODE_IS_BUCKET(queue[k]))
+      continue;
+    for (int i = 0; i < sptree->nchild; i++)
+    {
+      const SPNode *child = spnode_child(sptree, queue[k], i);
+      if (child)
+        queue[nnodes++] = child;
+    }
+  }
+
+  FILE *file = fopen(filename, "wb");
+  if (! file)
+  {
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR,
+      "Cannot open the file \"%s\" for writing", filename);
+    pfree(queue); pfree(offsets);
+    return false;
+  }
+  size_t bufsize = Max(start, Max(spnode_size(sptree), spbucket_size(sptree)));
+  char *buf = palloc0(bufsize);
+  SPTreeFileHeader *header = (SPTreeFileHeader *) buf;
+  memcpy(header->magic, SPTREE_FILE_MAGIC, sizeof(header->magic));
+  header->version = SPTREE_FILE_VERSION;
+  header->nodesize = (uint32) spnode_size(sptree);
+  header->bboxtype = (int32) sptree->bboxtype;
+  header->kind = (int32) sptree->kind;
+  header->dims = (int32) sptree->dims;
+  header->bucketsize = (int32) sptree->bucketsize;
+  header->size = (uint64) offsets[nnodes];
+  header->root = nnodes ? (uint64) start : 0;
+  bool ok = (fwrite(buf, start, 1, file) == 1);
+
+  /* The children of the nodes follow each other in the breadth-first order */
+  int next = 1;
+  SPNode *copy = (SPNode *) buf;
+  int64 *childoffs = (int64 *) (buf + childoff);
+  for (int k = 0; k < nnodes && ok; k++)
+  {
+    const SPNode *node = queue[k];
+    size_t nodesize = sptree_file_nodesize(sptree, node);
+    if (SPNODE_IS_BUCKET(node))
+      /* A leaf bucket is written as it is */
+      memcpy(buf, node, nodesize);
+    else
+    {
+      memset(buf, 0, nodesize);
+      copy->id = node->id;
+      copy->deleted = node->deleted;
+      copy->children = (SPNode **) (uintptr_t) (offsets[k] + childoff);
+      memcpy(copy->centroid, node->centroid, sptree->boxsize);
+      for (int i = 0; i < sptree->nchild; i++)
+      {
+        if (spnode_child(sptree, node, i))
+          childoffs[i] = (int64) offsets[next++];
+      }
+    }
+    ok = (fwrite(buf, nodesize, 1, file) == 1);
+  }
+  if (fclose(file) != 0)
+    ok = false;
+  if (! ok)
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR, "Cannot write the file \"%s\"",
+      filename);
+  pfree(buf);
+  pfree(queue); pfree(offsets);
+  return ok;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Open an SPTree saved by #sptree_save
+ * @details The file is mapped read-only into memory and the tree is searched
+ * in place, so that opening a tree of any size costs a constant time and the
+ * pages of the file are loaded on demand and shared with the other processes
+ * mapping it. The tree can be searched with #sptree_search,
+ * #sptree_search_temporal, and the nearest-neighbour cursor, but not modified.
+ * The file must not be modified while it is open, and the mapping is released
+ * by #sptree_free.
+ * @param[in] filename The name of the file
+ * @return The SPTree, or `NULL` if the file cannot be mapped or is not an
+ * SPTree file written on the same platform
+ * @see sptree_save
+ */
+SPTree *
+sptree_open(const char *filename)
+{
+  assert(filename);
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+  {
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR, "Cannot open the file \"%s\"",
+      filename);
+    return NULL;
+  }
+  struct stat st;
+  char *base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(SPTreeFileHeader))
+    base = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR, "Cannot map the file \"%s\"",
+      filename);
+    return NULL;
+  }
+
+  const SPTreeFileHeader *header = (const SPTreeFileHeader *) base;
+  MeosType bboxtype = (MeosType) header->bboxtype;
+  SPTree *sptree = NULL;
+  if (memcmp(header->magic, SPTREE_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+      header->version == SPTREE_FILE_VERSION &&
+      header->size == (uint64) st.st_size &&
+      (header->kind == SPTREE_QUADTREE || header->kind == SPTREE_KDTREE) &&
+      (span_type(bboxtype) || bboxtype == T_TBOX || bboxtype == T_STBOX
+#if POINTCLOUD
+        || bboxtype == T_TPCBOX
+#endif
+      ))
+  {
+    sptree = sptree_create(bboxtype, (SPTreeKind) header->kind);
+    if (sptree->dims < 0 && (header->dims == 6 || header->dims == 8))
+      sptree_set_dims(sptree, header->dims);
+    if (header->bucketsize == 0 || (header->bucketsize >= 2 &&
+        header->bucketsize <= SPTREE_MAX_BUCKET))
+      sptree->bucketsize = header->bucketsize;
+    if (sptree->dims != header->dims ||
+        sptree->bucketsize != header->bucketsize ||
+        header->nodesize != spnode_size(sptree))
+    {
+      pfree(sptree);
+      sptree = NULL;
+    }
+  }
+  if (! sptree)
+  {
+    munmap(base, (size_t) st.st_size);
+    meos_error(ERROR, MEOS_ERR_FILE_ERROR,
+      "The file \"%s\" is not an SPTree file written on this platform",
+      filename);
+    return NULL;
+  }
+
+  sptree->root = header->root ? (SPNode *) (base + header->root) : NULL;
+  sptree->base = base;
+  sptree->mapsize = (size_t) st.st_size;
+  return sptree;
+}
+#endif /* MEOS */
+
 /*****************************************************************************
  * Nearest-neighbour (kNN) cursor
  *
@@ -1037,14 +2343,30 @@ sptree_nn_cursor_next(SPNNCursor *cursor, int64 *id_out, double *dist_out)
     SPNNEntry emit;
     memset(&emit, 0, sizeof(emit));
     emit.is_emit = true;
-    emit.id = node->id;
-    char centroidbox[SPTREE_NODEBOX_MAXSIZE];
-    sptree_box_nodebox(sptree, node->centroid, centroidbox);
-    emit.dist = sptree_nodebox_distance(sptree, cursor->query, centroidbox);
-    spnn_heap_push(cursor, &emit);
+    if (SPNODE_IS_BUCKET(node))
+    {
+      /* Emit every box of a leaf bucket */
+      for (int i = 0; i < node->count; i++)
+      {
+        char box[SPTREE_NODEBOX_MAXSIZE];
+        sptree_box_nodebox(sptree, SPNODE_BOX_N(sptree, node, i), box);
+        emit.id = SPNODE_IDS(sptree, node)[i];
+        emit.dist = sptree_nodebox_distance(sptree, cursor->query, box);
+        spnn_heap_push(cursor, &emit);
+      }
+      continue;
+    }
+    if (! node->deleted)
+    {
+      emit.id = node->id;
+      char centroidbox[SPTREE_NODEBOX_MAXSIZE];
+      sptree_box_nodebox(sptree, node->centroid, centroidbox);
+      emit.dist = sptree_nodebox_distance(sptree, cursor->query, centroidbox);
+      spnn_heap_push(cursor, &emit);
+    }
     for (int quadrant = 0; quadrant < sptree->nchild; quadrant++)
     {
-      const SPNode *child = node->children[quadrant];
+      const SPNode *child = spnode_child(sptree, node, quadrant);
       if (! child)
         continue;
       SPNNEntry childentry;
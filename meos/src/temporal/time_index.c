@@ -0,0 +1,399 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief Static in-memory index of time ranges
+ * @details Purely temporal lookups, e.g., the trips active during a period,
+ * only need a one-dimensional index. The time ranges are sorted by lower
+ * bound into an array read as an implicit augmented binary search tree,
+ * where every entry keeps the latest upper bound of its subtree. A search
+ * descends only into the subtrees whose latest upper bound reaches the query
+ * and stops at the first entry starting after it, which answers stabbing and
+ * overlap queries in `O(log n + k)` time for `k` results, without the nodes
+ * and the boxes of the inner levels of an RTree. The index is built at once
+ * and is not modified afterwards.
+ * @note The implicit tree is the one of the cgranges library of Heng Li.
+ */
+
+#include "temporal/time_index.h"
+
+/* C */
+#include <assert.h>
+/* PostgreSQL */
+#include <postgres.h>
+#include <utils/timestamp.h>
+/* MEOS */
+#include <meos.h>
+#include <meos_internal.h>
+#include "temporal/span.h"
+#include "temporal/tbox.h"
+#include "temporal/temporal.h"
+
+/* Maximum number of frames of the traversal of the implicit tree, twice its
+ * largest height */
+#define TIMEINDEX_MAX_DEPTH 64
+
+/* Level up to which a subtree is scanned linearly instead of descended */
+#define TIMEINDEX_SCAN_LEVEL 3
+
+/*****************************************************************************
+ * Construction
+ *****************************************************************************/
+
+/**
+ * @brief Comparator of the entries of a time index by lower bound, then by
+ * upper bound, then by identifier
+ */
+static int
+timeindex_entry_cmp(const void *a, const void *b)
+{
+  const TimeIndexEntry *e1 = (const TimeIndexEntry *) a;
+  const TimeIndexEntry *e2 = (const TimeIndexEntry *) b;
+  TimestampTz l1 = DatumGetTimestampTz(e1->period.lower);
+  TimestampTz l2 = DatumGetTimestampTz(e2->period.lower);
+  if (l1 != l2)
+    return (l1 < l2) ? -1 : 1;
+  TimestampTz u1 = DatumGetTimestampTz(e1->period.upper);
+  TimestampTz u2 = DatumGetTimestampTz(e2->period.upper);
+  if (u1 != u2)
+    return (u1 < u2) ? -1 : 1;
+  return (e1->id > e2->id) - (e1->id < e2->id);
+}
+
+/**
+ * @brief Compute the latest upper bound of the subtree of every entry of the
+ * implicit tree, bottom up
+ * @details When the number of entries is not a power of 2 the tree is
+ * incomplete and a child of an entry may be past the end of the array. Such
+ * a child stands for the last complete subtree at its level, whose latest
+ * upper bound is kept in @p last while climbing the levels.
+ * @param[in,out] entries Entries sorted by lower bound
+ * @param[in] count Number of entries
+ * @return Level of the root of the tree, -1 for an empty index
+ */
+static int
+timeindex_prepare(TimeIndexEntry *entries, int count)
+{
+  if (count <= 0)
+    return -1;
+  int64 last_i = 0;
+  TimestampTz last = 0;
+  for (int64 i = 0; i < count; i += 2)
+  {
+    last_i = i;
+    last = entries[i].maxupper = DatumGetTimestampTz(entries[i].period.upper);
+  }
+  int k;
+  for (k = 1; (INT64CONST(1) << k) <= count; k++)
+  {
+    int64 x = INT64CONST(1) << (k - 1), step = x << 2;
+    for (int64 i = (x << 1) - 1; i < count; i += step)
+    {
+      TimestampTz upper = DatumGetTimestampTz(entries[i].period.upper);
+      TimestampTz left = entries[i - x].maxupper;
+      TimestampTz right = (i + x < count) ? entries[i + x].maxupper : last;
+      entries[i].maxupper = Max(upper, Max(left, right));
+    }
+    last_i = ((last_i >> k) & 1) ? last_i - x : last_i + x;
+    if (last_i < count && entries[last_i].maxupper > last)
+      last = entries[last_i].maxupper;
+  }
+  return k - 1;
+}
+
+/**
+ * @brief Return a static index of the time ranges of an array of boxes
+ * @param[in] bboxtype Type of the boxes, either @p T_TSTZSPAN or @p T_TBOX
+ * @param[in] boxes Contiguous array of boxes
+ * @param[in] ids The id of each box
+ * @param[in] count Number of boxes
+ * @return The index, or `NULL` on error
+ */
+static TimeIndex *
+timeindex_make(MeosType bboxtype, const void *boxes, const int64 *ids,
+  int count)
+{
+  assert(bboxtype == T_TSTZSPAN || bboxtype == T_TBOX);
+  /* Ensure the validity of the arguments */
+  if (count > 0)
+  {
+    VALIDATE_NOT_NULL(boxes, NULL); VALIDATE_NOT_NULL(ids, NULL);
+  }
+  for (int i = 0; i < count; i++)
+  {
+    if (bboxtype == T_TSTZSPAN)
+    {
+      if (! ensure_span_isof_type(&((const Span *) boxes)[i], T_TSTZSPAN))
+        return NULL;
+    }
+    else if (! ensure_has_T(T_TBOX, ((const TBox *) boxes)[i].flags))
+      return NULL;
+  }
+
+  TimeIndex *tindex = palloc0(sizeof(TimeIndex));
+  tindex->count = Max(count, 0);
+  tindex->entries = palloc(sizeof(TimeIndexEntry) * Max(count, 1));
+  for (int i = 0; i < count; i++)
+  {
+    tindex->entries[i].period = (bboxtype == T_TSTZSPAN) ?
+      ((const Span *) boxes)[i] : ((const TBox *) boxes)[i].period;
+    tindex->entries[i].id = ids[i];
+  }
+  qsort(tindex->entries, (size_t) tindex->count, sizeof(TimeIndexEntry),
+    timeindex_entry_cmp);
+  tindex->height = timeindex_prepare(tindex->entries, tindex->count);
+  return tindex;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Return a static index of an array of timestamptz spans
+ * @details The index answers the searches of an RTree created by
+ * #rtree_create_tstzspan for the same spans, with the same @p RTreeSearchOp
+ * operations, and cannot be modified once built.
+ * @param[in] spans Array of timestamptz spans
+ * @param[in] ids The id of each span
+ * @param[in] count Number of spans
+ * @return The index, or `NULL` on error
+ */
+TimeIndex *
+timeindex_make_tstzspan(const Span *spans, const int64 *ids, int count)
+{
+  return timeindex_make(T_TSTZSPAN, spans, ids, count);
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Return a static index of the time ranges of an array of temporal
+ * boxes
+ * @details Only the time dimension of the boxes is indexed, so that the
+ * searches compare the time ranges of the boxes with the query, whatever
+ * their value dimension.
+ * @param[in] boxes Array of temporal boxes, all of them with a time dimension
+ * @param[in] ids The id of each box
+ * @param[in] count Number of boxes
+ * @return The index, or `NULL` on error
+ */
+TimeIndex *
+timeindex_make_tbox(const TBox *boxes, const int64 *ids, int count)
+{
+  return timeindex_make(T_TBOX, boxes, ids, count);
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Free a static index of time ranges
+ * @param[in] tindex The index, may be `NULL`
+ */
+void
+timeindex_free(TimeIndex *tindex)
+{
+  if (! tindex)
+    return;
+  pfree(tindex->entries);
+  pfree(tindex);
+  return;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Return the number of entries of a static index of time ranges
+ * @param[in] tindex The index
+ */
+int
+timeindex_count(const TimeIndex *tindex)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(tindex, -1);
+  return tindex->count;
+}
+
+/*****************************************************************************
+ * Search
+ *****************************************************************************/
+
+/**
+ * @brief Return true if the time range of an entry satisfies a search
+ * operation with a query, as the predicates of the span types
+ */
+static bool
+timeindex_consistent(const Span *period, const Span *query, RTreeSearchOp op)
+{
+  const Span *s1 = (op == RTREE_CONTAINED_BY) ? query : period;
+  const Span *s2 = (op == RTREE_CONTAINED_BY) ? period : query;
+  TimestampTz l1 = DatumGetTimestampTz(s1->lower);
+  TimestampTz u1 = DatumGetTimestampTz(s1->upper);
+  TimestampTz l2 = DatumGetTimestampTz(s2->lower);
+  TimestampTz u2 = DatumGetTimestampTz(s2->upper);
+  if (op == RTREE_OVERLAPS)
+    return (l1 < u2 || (l1 == u2 && s1->lower_inc && s2->upper_inc)) &&
+      (l2 < u1 || (l2 == u1 && s2->lower_inc && s1->upper_inc));
+  /* The first span contains the second one */
+  return (l1 < l2 || (l1 == l2 && (s1->lower_inc || ! s2->lower_inc))) &&
+    (u1 > u2 || (u1 == u2 && (s1->upper_inc || ! s2->upper_inc)));
+}
+
+/**
+ * @brief Frame of the traversal of the implicit tree
+ */
+typedef struct
+{
+  int64 pos;     /**< Position of the entry rooting the subtree */
+  int level;     /**< Level of the entry */
+  bool left;     /**< True when the left subtree has been pushed */
+} TimeIndexFrame;
+
+/**
+ * @brief Collect the ids of the entries satisfying a search operation among
+ * those starting at most at @p smax and ending at least at @p emin
+ * @details The subtrees are visited in order, so the ids are collected by
+ * increasing lower bound. A left subtree is pruned when its latest upper
+ * bound is before @p emin, and a right subtree when its root starts after
+ * @p smax, since all its entries start after it. The small subtrees are
+ * scanned linearly.
+ */
+static void
+timeindex_collect(const TimeIndex *tindex, TimestampTz smax, TimestampTz emin,
+  const Span *query, RTreeSearchOp op, MeosArray *result)
+{
+  const TimeIndexEntry *entries = tindex->entries;
+  int64 count = tindex->count;
+  TimeIndexFrame stack[TIMEINDEX_MAX_DEPTH];
+  int depth = 0;
+  stack[depth].pos = (INT64CONST(1) << tindex->height) - 1;
+  stack[depth].level = tindex->height;
+  stack[depth++].left = false;
+  while (depth > 0)
+  {
+    TimeIndexFrame frame = stack[--depth];
+    if (frame.level <= TIMEINDEX_SCAN_LEVEL)
+    {
+      /* Scan the subtree, whose entries are contiguous */
+      int64 first = frame.pos >> frame.level << frame.level;
+      int64 end = Min(first + (INT64CONST(1) << (frame.level + 1)) - 1,
+        count);
+      for (int64 i = first; i < end &&
+          DatumGetTimestampTz(entries[i].period.lower) <= smax; i++)
+      {
+        if (DatumGetTimestampTz(entries[i].period.upper) >= emin &&
+            timeindex_consistent(&entries[i].period, query, op))
+          meos_array_add(result, (void *) &entries[i].id);
+      }
+    }
+    else if (! frame.left)
+    {
+      /* Visit the left subtree before the entry, which is pushed again. The
+       * left child may be past the end of the array while some of its
+       * descendants are not. */
+      int64 child = frame.pos - (INT64CONST(1) << (frame.level - 1));
+      frame.left = true;
+      stack[depth++] = frame;
+      if (child >= count || entries[child].maxupper >= emin)
+      {
+        stack[depth].pos = child;
+        stack[depth].level = frame.level - 1;
+        stack[depth++].left = false;
+      }
+    }
+    else if (frame.pos < count &&
+      DatumGetTimestampTz(entries[frame.pos].period.lower) <= smax)
+    {
+      const TimeIndexEntry *entry = &entries[frame.pos];
+      if (DatumGetTimestampTz(entry->period.upper) >= emin &&
+          timeindex_consistent(&entry->period, query, op))
+        meos_array_add(result, (void *) &entry->id);
+      stack[depth].pos = frame.pos + (INT64CONST(1) << (frame.level - 1));
+      stack[depth].level = frame.level - 1;
+      stack[depth++].left = false;
+    }
+  }
+  return;
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Search a static index of time ranges with a timestamptz span,
+ * collecting the matching ids into a MeosArray
+ * @details The ids are those that an RTree created by #rtree_create_tstzspan
+ * for the same time ranges returns, collected by increasing lower bound of
+ * their time range. The overlaps and contains searches only visit the
+ * entries that may qualify, while the contained-by search visits those
+ * overlapping the query. The result array is reset before the search.
+ * @param[in] tindex The index to query
+ * @param[in] op The search operation, as for #rtree_search
+ * @param[in] query The timestamptz span that serves as query
+ * @param[out] result MeosArray of int to collect matching ids (created by the
+ * caller with `meos_array_create(sizeof(int64))`)
+ * @return Number of matching ids, -1 on error
+ */
+int
+timeindex_search(const TimeIndex *tindex, RTreeSearchOp op, const Span *query,
+  MeosArray *result)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(tindex, -1); VALIDATE_NOT_NULL(query, -1);
+  VALIDATE_NOT_NULL(result, -1);
+  meos_array_reset(result);
+  if (! ensure_span_isof_type(query, T_TSTZSPAN))
+    return -1;
+  if (! tindex->count)
+    return 0;
+  /* The entries containing the query start at most at its lower bound and
+   * end at least at its upper bound, the other ones overlap the query */
+  TimestampTz lower = DatumGetTimestampTz(query->lower);
+  TimestampTz upper = DatumGetTimestampTz(query->upper);
+  if (op == RTREE_CONTAINS)
+    timeindex_collect(tindex, lower, upper, query, op, result);
+  else
+    timeindex_collect(tindex, upper, lower, query, op, result);
+  return meos_array_count(result);
+}
+
+/**
+ * @ingroup meos_temporal_box_index
+ * @brief Search a static index of time ranges for the ranges containing a
+ * timestamp, collecting their ids into a MeosArray
+ * @details The ids are collected by increasing lower bound of their time
+ * range. The result array is reset before the search.
+ * @param[in] tindex The index to query
+ * @param[in] t The timestamp
+ * @param[out] result MeosArray of int to collect matching ids
+ * @return Number of matching ids, -1 on error
+ */
+int
+timeindex_stab(const TimeIndex *tindex, TimestampTz t, MeosArray *result)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(tindex, -1);
+  Span query;
+  span_set(TimestampTzGetDatum(t), TimestampTzGetDatum(t), true, true,
+    T_TIMESTAMPTZ, T_TSTZSPAN, &query);
+  return timeindex_search(tindex, RTREE_CONTAINS, &query, result);
+}
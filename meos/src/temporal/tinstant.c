@@ -216,6 +216,21 @@ TInstant *
 tinstant_make(Datum value, MeosType temptype, TimestampTz t)
 {
   /* Ensure the validity of the arguments */
+  if (! tinstant_make_valid(value, temptype))
+    return NULL;
+  /* Create the temporal instant */
+  size_t size = tinstant_make_size(value, temptype);
+  TInstant *result = palloc0(size);
+  tinstant_make_in_place(value, temptype, t, result);
+  return result;
+}
+
+/**
+ * @brief Ensure the validity of the arguments when creating a temporal instant
+ */
+bool
+tinstant_make_valid(Datum value, MeosType temptype)
+{
   // TODO Should we bypass the tests on tnpoint ?
   if (tspatial_type(temptype) && temptype != T_TNPOINT)
   {
@@ -224,13 +239,54 @@ tinstant_make(Datum value, MeosType temptype, TimestampTz t)
     /* Ensure that the SRID is geodetic for geography */
     if (tgeodetic_type(temptype) && srid != SRID_UNKNOWN &&
         ! ensure_srid_is_latlong(srid))
-      return NULL;
+      return false;
     /* Ensure that a geometry/geography is not empty */
     if (tgeo_type_all(temptype) && 
         ! ensure_not_empty(DatumGetGserializedP(value)))
-      return NULL;
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Return the size in bytes of a temporal instant from the arguments
+ * @param[in] value Value
+ * @param[in] temptype Temporal type
+ */
+size_t
+tinstant_make_size(Datum value, MeosType temptype)
+{
+  MeosType basetype = temptype_basetype(temptype);
+  size_t value_size;
+  if (basetype_byvalue(basetype))
+    /* For base types passed by value */
+    value_size = DOUBLE_PAD(sizeof(Datum));
+  else
+  {
+    /* For base types passed by reference */
+    int16 typlen = meostype_length(basetype);
+    value_size = (typlen != -1) ? DOUBLE_PAD((unsigned int) typlen) :
+      DOUBLE_PAD(VARSIZE(DatumGetPointer(value)));
   }
+  return offsetof(TInstant, value) + value_size;
+}
 
+/**
+ * @brief Construct a temporal instant from the arguments in the memory
+ * pointed to by the last argument
+ * @details This function enables the construction of instants directly in
+ * the memory of a temporal sequence, as done by #tsequencebuilder_append
+ * @param[in] value Value
+ * @param[in] temptype Temporal type
+ * @param[in] t Timestamp
+ * @param[out] result Temporal instant
+ * @pre The memory pointed to by @p result is zeroed and has at least the
+ * size returned by #tinstant_make_size
+ */
+void
+tinstant_make_in_place(Datum value, MeosType temptype, TimestampTz t,
+  TInstant *result)
+{
   size_t value_offset = offsetof(TInstant, value);
   size_t size = value_offset;
   /* Create the temporal instant */
@@ -264,11 +320,11 @@ tinstant_make(Datum value, MeosType temptype, TimestampTz t)
     }
   }
   size += value_size;
-  TInstant *result = palloc0(size);
   void *value_to = ((char *) result) + value_offset;
-  /* Copy only the actual value bytes; palloc0 already zeroed any DOUBLE_PAD
-   * trailing bytes in the destination, so reading past the source object
-   * (which may be a tightly-allocated varlena) is unnecessary and unsafe. */
+  /* Copy only the actual value bytes; the destination is zeroed so any
+   * DOUBLE_PAD trailing bytes are already set, and reading past the source
+   * object (which may be a tightly-allocated varlena) is unnecessary and
+   * unsafe. */
   memcpy(value_to, value_from, value_copy_size);
   /* Initialize fixed-size values */
   result->temptype = temptype;
@@ -286,7 +342,7 @@ tinstant_make(Datum value, MeosType temptype, TimestampTz t)
     MEOS_FLAGS_SET_Z(result->flags, MEOS_FLAGS_GET_Z(flags));
     MEOS_FLAGS_SET_GEODETIC(result->flags, MEOS_FLAGS_GET_GEODETIC(flags));
   }
-  return result;
+  return;
 }
 
 /**
@@ -1327,17 +1327,480 @@ tsequence_subseq(const TSequence *seq, int from, int to, bool lower_inc,
   assert(seq);
   assert (from <= to && from >= 0 && to >= 0 && from < seq->count &&
     to < seq->count);
-  /* General case */
-  int count = to - from + 1;
-  TInstant **instants = palloc(sizeof(TInstant *) * count);
-  for (int i = 0; i < to - from; i++)
-    instants[i] = (TInstant *) TSEQUENCE_INST_N(seq, i + from);
-  TSequence *result = tsequence_make(instants, count, lower_inc, upper_inc,
-    MEOS_FLAGS_GET_INTERP(seq->flags), NORMALIZE_NO);
+  TSequenceView view;
+  tsequenceview_set(seq, from, to, lower_inc, upper_inc, &view);
+  return tsequenceview_to_tsequence(&view);
+}
+#endif /* MEOS */
+
+/*****************************************************************************
+ * View functions
+ *****************************************************************************/
+
+/**
+ * @brief Set a view of the instants of a temporal sequence between two
+ * indexes
+ * @param[in] seq Temporal sequence
+ * @param[in] from,to Indexes
+ * @param[in] lower_inc,upper_inc True when the bounds are inclusive
+ * @param[out] view Result
+ * @note The view points to the instants of the sequence, which must not be
+ * freed while the view is used
+ */
+void
+tsequenceview_set(const TSequence *seq, int from, int to, bool lower_inc,
+  bool upper_inc, TSequenceView *view)
+{
+  assert(seq); assert(view);
+  assert(from <= to && from >= 0 && to < seq->count);
+  view->seq = seq;
+  view->start = view->end = NULL;
+  view->from = from;
+  view->count = to - from + 1;
+  span_set(TimestampTzGetDatum(TSEQUENCE_INST_N(seq, from)->t),
+    TimestampTzGetDatum(TSEQUENCE_INST_N(seq, to)->t), lower_inc, upper_inc,
+    T_TIMESTAMPTZ, T_TSTZSPAN, &view->period);
+  return;
+}
+
+/**
+ * @brief Return a temporal sequence constructed from a view, copying its
+ * instants
+ * @param[in] view Temporal sequence view
+ */
+TSequence *
+tsequenceview_to_tsequence(const TSequenceView *view)
+{
+  assert(view);
+  const TInstant **instants = palloc(sizeof(TInstant *) * view->count);
+  for (int i = 0; i < view->count; i++)
+    instants[i] = TSEQUENCEVIEW_INST_N(view, i);
+  /* Since by definition the parent sequence is normalized it is not
+   * necessary to normalize the view */
+  TSequence *result = tsequence_make((TInstant **) instants, view->count,
+    view->period.lower_inc, view->period.upper_inc,
+    MEOS_FLAGS_GET_INTERP(view->seq->flags), NORMALIZE_NO);
   pfree(instants);
   return result;
 }
-#endif /* MEOS */
+
+/**
+ * @brief Free the instants of a temporal sequence view that do not belong to
+ * its parent sequence
+ * @param[in] view Temporal sequence view
+ */
+void
+tsequenceview_free(TSequenceView *view)
+{
+  assert(view);
+  if (view->start)
+    pfree(view->start);
+  if (view->end)
+    pfree(view->end);
+  view->start = view->end = NULL;
+  return;
+}
+
+/*****************************************************************************
+ * Builder functions
+ *****************************************************************************/
+
+/**
+ * @brief Return true if the bounding box of a temporal sequence of the type
+ * is the union of the bounding boxes of its instants
+ * @details This is not the case, e.g., for temporal network points with
+ * linear interpolation, whose bounding box covers the route segments
+ */
+static bool
+tsequencebuilder_instbox(MeosType temptype)
+{
+  return talpha_type(temptype) || tnumber_type(temptype) ||
+    tgeo_type_all(temptype);
+}
+
+/**
+ * @brief Return a pointer to the memory of the instants of a sequence being
+ * built
+ */
+static inline char *
+tsequencebuilder_insts(const TSequence *seq)
+{
+  return (char *) (TSEQUENCE_OFFSETS_PTR(seq) + seq->maxcount);
+}
+
+/**
+ * @brief Initialize a builder of a temporal sequence
+ * @param[out] builder Builder
+ * @param[in] temptype Temporal type of the result
+ * @param[in] interp Interpolation of the result
+ * @param[in] maxcount Estimated number of instants of the result
+ * @param[in] normalize True if the result should be normalized
+ */
+void
+tsequencebuilder_init(TSequenceBuilder *builder, MeosType temptype,
+  interpType interp, int maxcount, bool normalize)
+{
+  assert(builder); assert(temporal_type(temptype));
+  builder->seq = NULL;
+  builder->temptype = temptype;
+  builder->interp = interp;
+  builder->normalize = normalize && interp != DISCRETE;
+  builder->maxcount = Max(maxcount, 2);
+  builder->used = 0;
+  builder->hasbox = false;
+  builder->error = false;
+  return;
+}
+
+/**
+ * @brief Ensure that the sequence being built has space for an additional
+ * instant of the given size, expanding it otherwise
+ * @details Both the number of instants and the space for them are doubled
+ * when exhausted. Since the offsets array precedes the instants, the instants
+ * are shifted when the number of instants is expanded.
+ */
+static void
+tsequencebuilder_reserve(TSequenceBuilder *builder, size_t size)
+{
+  TSequence *seq = builder->seq;
+  int maxcount = seq->maxcount;
+  if (seq->count == maxcount)
+    maxcount *= 2;
+  size_t hdrsize = (char *) TSEQUENCE_OFFSETS_PTR(seq) - (char *) seq;
+  size_t avail = VARSIZE(seq) - hdrsize - sizeof(size_t) * seq->maxcount;
+  size_t newavail = avail;
+  while (builder->used + size > newavail)
+    newavail *= 2;
+  if (maxcount == seq->maxcount && newavail == avail)
+    return;
+  /* Expand the sequence */
+  size_t memsize = hdrsize + sizeof(size_t) * maxcount + newavail;
+  seq = repalloc(seq, memsize);
+  if (maxcount != seq->maxcount)
+  {
+    char *insts = tsequencebuilder_insts(seq);
+    memmove(insts + sizeof(size_t) * (maxcount - seq->maxcount), insts,
+      builder->used);
+    seq->maxcount = maxcount;
+  }
+  SET_VARSIZE(seq, memsize);
+  builder->seq = seq;
+  return;
+}
+
+/**
+ * @brief Create the sequence of a builder given the size of its first
+ * instant
+ */
+static void
+tsequencebuilder_alloc(TSequenceBuilder *builder, size_t size)
+{
+  MeosType temptype = builder->temptype;
+  size_t bboxsize = DOUBLE_PAD(temporal_bbox_size(temptype));
+  /* The period component of the bbox is already declared in the struct */
+  size_t memsize = DOUBLE_PAD(sizeof(TSequence)) + bboxsize - sizeof(Span) +
+    sizeof(size_t) * builder->maxcount + size * builder->maxcount;
+  TSequence *seq = palloc0(memsize);
+  SET_VARSIZE(seq, memsize);
+  seq->count = 0;
+  seq->maxcount = builder->maxcount;
+  seq->temptype = temptype;
+  seq->subtype = TSEQUENCE;
+  seq->bboxsize = (int16) bboxsize;
+  MEOS_FLAGS_SET_CONTINUOUS(seq->flags, temptype_supports_linear(temptype));
+  MEOS_FLAGS_SET_INTERP(seq->flags, builder->interp);
+  MEOS_FLAGS_SET_X(seq->flags, true);
+  MEOS_FLAGS_SET_T(seq->flags, true);
+  builder->seq = seq;
+  builder->used = 0;
+  return;
+}
+
+/**
+ * @brief Append an instant to the sequence of a builder
+ * @details The instant is constructed directly in the memory of the result.
+ * When the builder normalizes, the last instant is overwritten by the new one
+ * if it is redundant, and otherwise it is added to the bounding box of the
+ * inner instants, since the first and last instants are only accounted for
+ * when the builder is finished.
+ * @param[inout] builder Builder
+ * @param[in] value Value
+ * @param[in] t Timestamp
+ * @return False on error, in which case the builder is invalidated so that
+ * the subsequent calls fail and #tsequencebuilder_finish returns @p NULL
+ * @note The value is copied, the calling function remains responsible for
+ * freeing it. The value may be the one of an instant of the builder.
+ */
+bool
+tsequencebuilder_append(TSequenceBuilder *builder, Datum value,
+  TimestampTz t)
+{
+  assert(builder);
+  MeosType temptype = builder->temptype;
+  if (builder->error || ! tinstant_make_valid(value, temptype))
+  {
+    builder->error = true;
+    return false;
+  }
+  size_t size = DOUBLE_PAD(tinstant_make_size(value, temptype));
+  if (! builder->seq)
+    tsequencebuilder_alloc(builder, size);
+  TSequence *seq = builder->seq;
+  /* Copy a value passed by reference that is in the memory of the builder,
+   * which may be moved or overwritten when appending the instant */
+  MeosType basetype = temptype_basetype(temptype);
+  char *ptr = DatumGetPointer(value);
+  if (! basetype_byvalue(basetype) && ptr >= (char *) seq &&
+      ptr < (char *) seq + VARSIZE(seq))
+  {
+    value = datum_copy(value, basetype);
+    bool result = tsequencebuilder_append(builder, value, t);
+    DATUM_FREE(value, basetype);
+    return result;
+  }
+  if (seq->count > 0)
+  {
+    const TInstant *last = TSEQUENCE_INST_N(seq, seq->count - 1);
+    if (t <= last->t)
+    {
+      char *t1 = pg_timestamptz_out(last->t);
+      char *t2 = pg_timestamptz_out(t);
+      meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+        "Timestamps for temporal value must be increasing: %s, %s", t1, t2);
+      builder->error = true;
+      return false;
+    }
+    /* Normalize */
+    bool redundant = false;
+    if (builder->normalize && seq->count > 1)
+    {
+      const TInstant *penult = TSEQUENCE_INST_N(seq, seq->count - 2);
+      redundant = tsequence_norm_test(tinstant_value_p(penult),
+        tinstant_value_p(last), value, basetype, builder->interp, penult->t,
+        last->t, t);
+    }
+    if (redundant)
+    {
+      /* The new instant overwrites the last one */
+      seq->count--;
+      builder->used = (TSEQUENCE_OFFSETS_PTR(seq))[seq->count];
+    }
+    else if (seq->count > 1 && tsequencebuilder_instbox(temptype))
+    {
+      /* The last instant becomes an inner one */
+      bboxunion box;
+      tinstant_set_bbox(last, &box);
+      if (builder->hasbox)
+        bbox_expand(&box, &builder->box, temptype);
+      else
+        memcpy(&builder->box, &box, sizeof(bboxunion));
+      builder->hasbox = true;
+    }
+  }
+  tsequencebuilder_reserve(builder, size);
+  seq = builder->seq;
+  /* Construct the instant in place */
+  TInstant *inst = (TInstant *) (tsequencebuilder_insts(seq) +
+    builder->used);
+  memset(inst, 0, size);
+  tinstant_make_in_place(value, temptype, t, inst);
+  TInstant *instants[2];
+  instants[0] = (seq->count > 0) ?
+    (TInstant *) TSEQUENCE_INST_N(seq, seq->count - 1) : NULL;
+  instants[1] = inst;
+  if (! ensure_valid_tinstarr(instants[0] ? instants : &instants[1],
+        instants[0] ? 2 : 1, MERGE_NO, builder->interp))
+  {
+    builder->error = true;
+    return false;
+  }
+  if (seq->count == 0 && tspatial_type(temptype))
+  {
+    MEOS_FLAGS_SET_Z(seq->flags, MEOS_FLAGS_GET_Z(inst->flags));
+    MEOS_FLAGS_SET_GEODETIC(seq->flags, MEOS_FLAGS_GET_GEODETIC(inst->flags));
+  }
+  (TSEQUENCE_OFFSETS_PTR(seq))[seq->count++] = builder->used;
+  builder->used += size;
+  return true;
+}
+
+/**
+ * @brief Set the value of the last instant of the sequence of a builder to
+ * the one of the previous instant
+ * @details This is needed for sequences with step interpolation and exclusive
+ * upper bound, whose last two values must be equal. The function does
+ * nothing when the sequence has less than two instants.
+ * @param[inout] builder Builder
+ * @return False on error
+ * @pre The interpolation is not linear, so that normalizing the last instant
+ * only depends on the previous ones
+ */
+bool
+tsequencebuilder_repeat_prev_value(TSequenceBuilder *builder)
+{
+  assert(builder); assert(builder->interp != LINEAR);
+  if (builder->error)
+    return false;
+  TSequence *seq = builder->seq;
+  if (! seq || seq->count < 2)
+    return true;
+  TimestampTz t = TSEQUENCE_INST_N(seq, seq->count - 1)->t;
+  /* Remove the last instant and append it again with the new value */
+  seq->count--;
+  builder->used = (TSEQUENCE_OFFSETS_PTR(seq))[seq->count];
+  return tsequencebuilder_append(builder,
+    tinstant_value_p(TSEQUENCE_INST_N(seq, seq->count - 1)), t);
+}
+
+/**
+ * @brief Return the last instant of the sequence of a builder, or @p NULL if
+ * it is empty
+ * @note The instant is only valid until the next call to the builder
+ */
+const TInstant *
+tsequencebuilder_last(const TSequenceBuilder *builder)
+{
+  assert(builder);
+  return (builder->seq && builder->seq->count > 0) ?
+    TSEQUENCE_INST_N(builder->seq, builder->seq->count - 1) : NULL;
+}
+
+/**
+ * @brief Set the bounding box of the sequence of a builder
+ */
+static void
+tsequencebuilder_set_bbox(TSequenceBuilder *builder, bool lower_inc,
+  bool upper_inc)
+{
+  TSequence *seq = builder->seq;
+  MeosType temptype = seq->temptype;
+  void *box = TSEQUENCE_BBOX_PTR(seq);
+  if (! tsequencebuilder_instbox(temptype))
+  {
+    TInstant **instants = palloc(sizeof(TInstant *) * seq->count);
+    for (int i = 0; i < seq->count; i++)
+      instants[i] = (TInstant *) TSEQUENCE_INST_N(seq, i);
+    tinstarr_set_bbox(instants, seq->count, lower_inc, upper_inc,
+      builder->interp, box);
+    pfree(instants);
+    return;
+  }
+
+  /* Expand the box of the inner instants with the first and last ones */
+  const TInstant *first = TSEQUENCE_INST_N(seq, 0);
+  const TInstant *last = TSEQUENCE_INST_N(seq, seq->count - 1);
+  tinstant_set_bbox(first, box);
+  if (builder->hasbox)
+    bbox_expand(&builder->box, box, temptype);
+  if (seq->count > 1)
+  {
+    bboxunion box1;
+    tinstant_set_bbox(last, &box1);
+    bbox_expand(&box1, box, temptype);
+  }
+  /* For linear interpolation the value span of a temporal number excludes
+   * the values only reached at an exclusive bound, as in
+   * #tnumberinstarr_set_tbox */
+  if (tnumber_type(temptype) && builder->interp == LINEAR &&
+      seq->count > 1 && (! lower_inc || ! upper_inc))
+  {
+    MeosType basetype = temptype_basetype(temptype);
+    Span *span = &((TBox *) box)->span;
+    if (datum_ne(span->lower, span->upper, basetype))
+    {
+      Datum value1 = tinstant_value_p(first);
+      Datum value2 = tinstant_value_p(last);
+      span->lower_inc = (builder->hasbox &&
+          datum_eq(builder->box.b.span.lower, span->lower, basetype)) ||
+        (lower_inc && datum_eq(value1, span->lower, basetype)) ||
+        (upper_inc && datum_eq(value2, span->lower, basetype));
+      span->upper_inc = (builder->hasbox &&
+          datum_eq(builder->box.b.span.upper, span->upper, basetype)) ||
+        (lower_inc && datum_eq(value1, span->upper, basetype)) ||
+        (upper_inc && datum_eq(value2, span->upper, basetype));
+    }
+  }
+  /* Set the period at the beginning of the bounding box */
+  span_set(TimestampTzGetDatum(first->t), TimestampTzGetDatum(last->t),
+    lower_inc, upper_inc, T_TIMESTAMPTZ, T_TSTZSPAN, (Span *) box);
+  return;
+}
+
+/**
+ * @brief Return the temporal sequence constructed by a builder
+ * @details The sequence is compacted in place so that it does not have
+ * space for additional instants. The builder is emptied and can be reused,
+ * in which case the next sequence starts with space for two instants and is
+ * expanded as needed, since the number of instants given to
+ * #tsequencebuilder_init estimates the one of all the sequences built, e.g.,
+ * the pieces of a sequence restricted to the complement of a timestamp set.
+ * @param[inout] builder Builder
+ * @param[in] lower_inc,upper_inc True if the respective bound is inclusive
+ * @return On error return @p NULL, which is also the case when no instant
+ * has been appended, in both cases the builder is freed
+ */
+TSequence *
+tsequencebuilder_finish(TSequenceBuilder *builder, bool lower_inc,
+  bool upper_inc)
+{
+  assert(builder);
+  TSequence *seq = builder->seq;
+  if (! seq || builder->error)
+  {
+    tsequencebuilder_free(builder);
+    return NULL;
+  }
+  /* Ensure the validity of the bounds given the last two instants */
+  int count = Min(seq->count, 2);
+  TInstant *instants[2];
+  for (int i = 0; i < count; i++)
+    instants[i] = (TInstant *) TSEQUENCE_INST_N(seq, seq->count - count + i);
+  if (! ensure_valid_tinstarr_common(instants, count, lower_inc, upper_inc,
+        builder->interp))
+  {
+    tsequencebuilder_free(builder);
+    return NULL;
+  }
+  /* Compact the sequence by shifting the instants after the offsets array */
+  if (seq->count < seq->maxcount)
+  {
+    char *insts = tsequencebuilder_insts(seq);
+    memmove(insts - sizeof(size_t) * (seq->maxcount - seq->count), insts,
+      builder->used);
+    seq->maxcount = seq->count;
+  }
+  size_t memsize = (tsequencebuilder_insts(seq) - (char *) seq) +
+    builder->used;
+  if (memsize < VARSIZE(seq))
+  {
+    seq = repalloc(seq, memsize);
+    SET_VARSIZE(seq, memsize);
+  }
+  builder->seq = seq;
+  tsequencebuilder_set_bbox(builder, lower_inc, upper_inc);
+  builder->seq = NULL;
+  builder->maxcount = 2;
+  builder->used = 0;
+  builder->hasbox = false;
+  return seq;
+}
+
+/**
+ * @brief Free the sequence of a builder that has not been finished
+ * @param[inout] builder Builder
+ */
+void
+tsequencebuilder_free(TSequenceBuilder *builder)
+{
+  assert(builder);
+  if (builder->seq)
+    pfree(builder->seq);
+  builder->seq = NULL;
+  builder->used = 0;
+  builder->hasbox = false;
+  builder->error = false;
+  return;
+}
 
 /*****************************************************************************/
 
@@ -2803,12 +3266,28 @@ tnumberseq_integral(const TSequence *seq)
 {
   assert(seq);
   assert(tnumber_type(seq->temptype));
+  TSequenceView view;
+  tsequenceview_set(seq, 0, seq->count - 1, seq->period.lower_inc,
+    seq->period.upper_inc, &view);
+  return tnumberseqview_integral(&view);
+}
+
+/**
+ * @brief Return the integral (area under the curve) of a temporal sequence
+ * number view
+ * @param[in] view Temporal sequence view
+ */
+double
+tnumberseqview_integral(const TSequenceView *view)
+{
+  assert(view);
+  assert(tnumber_type(view->seq->temptype));
   double result = 0.0;
-  const TInstant *inst1 = TSEQUENCE_INST_N(seq, 0);
-  for (int i = 1; i < seq->count; i++)
+  const TInstant *inst1 = TSEQUENCEVIEW_INST_N(view, 0);
+  for (int i = 1; i < view->count; i++)
   {
-    const TInstant *inst2 = TSEQUENCE_INST_N(seq, i);
-    if (MEOS_FLAGS_LINEAR_INTERP(seq->flags))
+    const TInstant *inst2 = TSEQUENCEVIEW_INST_N(view, i);
+    if (MEOS_FLAGS_LINEAR_INTERP(view->seq->flags))
     {
       /* Linear interpolation */
       double min = Min(DatumGetFloat8(tinstant_value_p(inst1)),
@@ -0,0 +1,672 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief Compressed encoding of temporal sequences
+ * @details The instants of a temporal sequence with a regular sampling are
+ * highly redundant: the difference between consecutive timestamps is almost
+ * constant and the values change slowly. The compressed encoding writes the
+ * timestamps as deltas of deltas and the values either as the XOR of
+ * consecutive values, as in the Gorilla time-series database of Facebook,
+ * or as deltas of deltas of the values quantized to a number of decimal
+ * digits, using variable-length bit codes. The instants are split into blocks
+ * with a header giving their first timestamp, so that the value at a
+ * timestamp is found by decoding a single block. The encoding is defined for
+ * temporal floats and temporal points.
+ */
+
+#include "temporal/tsequence_comp.h"
+
+/* C */
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+/* PostgreSQL */
+#include <postgres.h>
+#include <varatt.h>
+#include <utils/timestamp.h>
+/* MEOS */
+#include <meos.h>
+#include <meos_internal.h>
+#include <meos_internal_geo.h>
+#include "temporal/span.h"
+#include "temporal/temporal.h"
+#include "temporal/tsequence.h"
+#include "geo/geo_funcs.h"
+
+/* Number of bits of the variable-length integer codes after their prefix of
+ * 0 to 5 ones */
+static const int INTCODE_BITS[] = {0, 7, 14, 28, 40, 64};
+
+/*****************************************************************************
+ * Bit streams
+ *****************************************************************************/
+
+/**
+ * @brief Writer of a stream of bits, the most significant bits first
+ */
+typedef struct
+{
+  uint8 *data;          /**< Bytes of the stream */
+  size_t capacity;      /**< Allocated capacity of @p data in bytes */
+  uint64 pos;           /**< Number of bits written */
+} BitWriter;
+
+/**
+ * @brief Reader of a stream of bits
+ */
+typedef struct
+{
+  const uint8 *data;    /**< Bytes of the stream */
+  uint64 pos;           /**< Number of bits read */
+} BitReader;
+
+/**
+ * @brief Write the lowest bits of a value into a stream of bits
+ */
+static void
+bits_write(BitWriter *bw, uint64 value, int nbits)
+{
+  size_t needed = (size_t) ((bw->pos + nbits + 7) / 8);
+  if (needed > bw->capacity)
+  {
+    size_t capacity = Max(bw->capacity * 2, needed);
+    bw->data = repalloc(bw->data, capacity);
+    memset(bw->data + bw->capacity, 0, capacity - bw->capacity);
+    bw->capacity = capacity;
+  }
+  while (nbits > 0)
+  {
+    int room = 8 - (int) (bw->pos & 7);
+    int n = Min(room, nbits);
+    uint8 chunk = (uint8) ((value >> (nbits - n)) & ((1u << n) - 1));
+    bw->data[bw->pos >> 3] |= (uint8) (chunk << (room - n));
+    bw->pos += n;
+    nbits -= n;
+  }
+  return;
+}
+
+/**
+ * @brief Read a value of a number of bits from a stream of bits
+ */
+static uint64
+bits_read(BitReader *br, int nbits)
+{
+  uint64 result = 0;
+  while (nbits > 0)
+  {
+    int room = 8 - (int) (br->pos & 7);
+    int n = Min(room, nbits);
+    uint8 chunk = (uint8) ((br->data[br->pos >> 3] >> (room - n)) &
+      ((1u << n) - 1));
+    result = (result << n) | chunk;
+    br->pos += n;
+    nbits -= n;
+  }
+  return result;
+}
+
+/**
+ * @brief Write a signed integer with a variable-length code
+ * @details The integer is zigzag-encoded and written after a prefix of ones
+ * giving its number of bits, a zero taking a single bit
+ */
+static void
+intcode_write(BitWriter *bw, int64 value)
+{
+  uint64 u = ((uint64) value << 1) ^ (uint64) (value >> 63);
+  if (u == 0)
+  {
+    bits_write(bw, 0, 1);
+    return;
+  }
+  int k = 1;
+  while (k < 5 && u >= ((uint64) 1 << INTCODE_BITS[k]))
+    k++;
+  /* A prefix of k ones ended by a zero, but for the last code */
+  if (k < 5)
+    bits_write(bw, ((uint64) 1 << (k + 1)) - 2, k + 1);
+  else
+    bits_write(bw, 0x1F, 5);
+  bits_write(bw, u, INTCODE_BITS[k]);
+  return;
+}
+
+/**
+ * @brief Read a signed integer written with #intcode_write
+ */
+static int64
+intcode_read(BitReader *br)
+{
+  int k = 0;
+  while (k < 5 && bits_read(br, 1) == 1)
+    k++;
+  if (k == 0)
+    return 0;
+  uint64 u = bits_read(br, INTCODE_BITS[k]);
+  return (int64) (u >> 1) ^ -((int64) (u & 1));
+}
+
+/**
+ * @brief State of the XOR encoding of a stream of doubles
+ */
+typedef struct
+{
+  uint64 prev;          /**< Bits of the previous value */
+  int lead;             /**< Leading zeros of the current window, -1 if
+                             there is no window yet */
+  int trail;            /**< Trailing zeros of the current window */
+} XorState;
+
+/**
+ * @brief Write a double as the XOR with the previous one
+ * @details A value equal to the previous one takes a single bit, otherwise
+ * the meaningful bits of the XOR are written, either within the window of
+ * the previous XOR if they fit into it, or after the size of a new window.
+ */
+static void
+xor_write(BitWriter *bw, XorState *state, double value)
+{
+  uint64 bits;
+  memcpy(&bits, &value, sizeof(uint64));
+  uint64 x = bits ^ state->prev;
+  state->prev = bits;
+  if (x == 0)
+  {
+    bits_write(bw, 0, 1);
+    return;
+  }
+  int lead = Min(__builtin_clzll(x), 31);
+  int trail = __builtin_ctzll(x);
+  if (state->lead >= 0 && lead >= state->lead && trail >= state->trail)
+  {
+    bits_write(bw, 2, 2);
+    bits_write(bw, x >> state->trail, 64 - state->lead - state->trail);
+    return;
+  }
+  int n = 64 - lead - trail;
+  bits_write(bw, 3, 2);
+  bits_write(bw, (uint64) lead, 5);
+  bits_write(bw, (uint64) (n - 1), 6);
+  bits_write(bw, x >> trail, n);
+  state->lead = lead;
+  state->trail = trail;
+  return;
+}
+
+/**
+ * @brief Read a double written with #xor_write
+ */
+static double
+xor_read(BitReader *br, XorState *state)
+{
+  if (bits_read(br, 1) == 1)
+  {
+    if (bits_read(br, 1) == 1)
+    {
+      state->lead = (int) bits_read(br, 5);
+      int n = (int) bits_read(br, 6) + 1;
+      state->trail = 64 - state->lead - n;
+    }
+    state->prev ^= bits_read(br, 64 - state->lead - state->trail) <<
+      state->trail;
+  }
+  double result;
+  memcpy(&result, &state->prev, sizeof(double));
+  return result;
+}
+
+/*****************************************************************************
+ * Encoding and decoding of the blocks
+ *****************************************************************************/
+
+/**
+ * @brief Return the number of values of an instant of a compressed sequence
+ */
+static inline int
+tsequencecomp_ndims(MeosType temptype, int16 flags)
+{
+  if (temptype == T_TFLOAT)
+    return 1;
+  return MEOS_FLAGS_GET_Z(flags) ? 3 : 2;
+}
+
+/**
+ * @brief Get the values of an instant, i.e., its float or the coordinates of
+ * its point
+ */
+static void
+tinstant_comp_values(const TInstant *inst, int ndims, double *values)
+{
+  Datum value = tinstant_value_p(inst);
+  if (inst->temptype == T_TFLOAT)
+    values[0] = DatumGetFloat8(value);
+  else if (ndims == 3)
+  {
+    const POINT3DZ *p = DATUM_POINT3DZ_P(value);
+    values[0] = p->x; values[1] = p->y; values[2] = p->z;
+  }
+  else
+  {
+    const POINT2D *p = DATUM_POINT2D_P(value);
+    values[0] = p->x; values[1] = p->y;
+  }
+  return;
+}
+
+/**
+ * @brief Quantize a value to a number of decimal digits
+ * @return On error return false
+ */
+static bool
+value_quantize(double value, double scale, int64 *result)
+{
+  double v = value * scale;
+  /* The bounds keep the deltas of deltas of quantized values in 64 bits */
+  if (! isfinite(v) || fabs(v) >= 1e18)
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "The value %g cannot be quantized with the given precision", value);
+    return false;
+  }
+  *result = llround(v);
+  return true;
+}
+
+/**
+ * @brief Encode the instants of a block of a temporal sequence
+ * @return On error return false
+ */
+static bool
+tsequencecomp_encode_block(const TSequence *seq, int first, int count,
+  int ndims, int precision, BitWriter *bw)
+{
+  double scale = (precision >= 0) ? pow(10.0, precision) : 0.0;
+  XorState xor[3];
+  int64 prevq[3], prevdq[3];
+  TimestampTz prevt = 0;
+  int64 prevdt = 0;
+  for (int i = 0; i < count; i++)
+  {
+    const TInstant *inst = TSEQUENCE_INST_N(seq, first + i);
+    double values[3];
+    tinstant_comp_values(inst, ndims, values);
+    /* The timestamp of the first instant is in the header of the block */
+    if (i > 0)
+    {
+      int64 dt = (int64) ((uint64) inst->t - (uint64) prevt);
+      intcode_write(bw, (int64) ((uint64) dt - (uint64) prevdt));
+      prevdt = dt;
+    }
+    prevt = inst->t;
+    for (int d = 0; d < ndims; d++)
+    {
+      if (precision < 0)
+      {
+        if (i == 0)
+        {
+          memcpy(&xor[d].prev, &values[d], sizeof(uint64));
+          xor[d].lead = -1;
+          xor[d].trail = 0;
+          bits_write(bw, xor[d].prev, 64);
+        }
+        else
+          xor_write(bw, &xor[d], values[d]);
+        continue;
+      }
+      int64 q;
+      if (! value_quantize(values[d], scale, &q))
+        return false;
+      if (i == 0)
+      {
+        bits_write(bw, (uint64) q, 64);
+        prevdq[d] = 0;
+      }
+      else
+      {
+        int64 dq = q - prevq[d];
+        intcode_write(bw, dq - prevdq[d]);
+        prevdq[d] = dq;
+      }
+      prevq[d] = q;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Decode the first instants of a block of a compressed sequence
+ * @param[in] cseq Compressed sequence
+ * @param[in] b Number of the block
+ * @param[in] maxcount Maximum number of instants decoded
+ * @param[out] times Timestamps of the instants
+ * @param[out] values Values of the instants, @p ndims per instant
+ * @return Number of instants decoded
+ */
+static int
+tsequencecomp_decode_block(const TSequenceComp *cseq, int b, int maxcount,
+  TimestampTz *times, double *values)
+{
+  const TSequenceCompBlock *block = &TSEQUENCECOMP_BLOCKS(cseq)[b];
+  int ndims = tsequencecomp_ndims(cseq->temptype, cseq->flags);
+  int count = Min(block->count, maxcount);
+  double scale = (cseq->precision >= 0) ? pow(10.0, cseq->precision) : 0.0;
+  BitReader br;
+  br.data = TSEQUENCECOMP_DATA(cseq) + block->offset;
+  br.pos = 0;
+  XorState xor[3];
+  int64 prevq[3], prevdq[3];
+  int64 prevdt = 0;
+  for (int i = 0; i < count; i++)
+  {
+    if (i == 0)
+      times[0] = block->t;
+    else
+    {
+      prevdt = (int64) ((uint64) prevdt + (uint64) intcode_read(&br));
+      times[i] = (TimestampTz) ((uint64) times[i - 1] + (uint64) prevdt);
+    }
+    for (int d = 0; d < ndims; d++)
+    {
+      double *value = &values[i * ndims + d];
+      if (cseq->precision < 0)
+      {
+        if (i == 0)
+        {
+          xor[d].prev = bits_read(&br, 64);
+          xor[d].lead = -1;
+          xor[d].trail = 0;
+          memcpy(value, &xor[d].prev, sizeof(double));
+        }
+        else
+          *value = xor_read(&br, &xor[d]);
+        continue;
+      }
+      if (i == 0)
+      {
+        prevq[d] = (int64) bits_read(&br, 64);
+        prevdq[d] = 0;
+      }
+      else
+      {
+        prevdq[d] += intcode_read(&br);
+        prevq[d] += prevdq[d];
+      }
+      *value = (double) prevq[d] / scale;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Return the value of an instant of a compressed sequence from its
+ * decoded values
+ */
+static Datum
+tsequencecomp_value(const TSequenceComp *cseq, const double *values)
+{
+  if (cseq->temptype == T_TFLOAT)
+    return Float8GetDatum(values[0]);
+  bool hasz = MEOS_FLAGS_GET_Z(cseq->flags);
+  return PointerGetDatum(geopoint_make(values[0], values[1],
+    hasz ? values[2] : 0.0, hasz, MEOS_FLAGS_GET_GEODETIC(cseq->flags),
+    cseq->srid));
+}
+
+/*****************************************************************************
+ * Compression and decompression
+ *****************************************************************************/
+
+/**
+ * @ingroup meos_temporal_conversion
+ * @brief Return a temporal sequence converted to the compressed encoding
+ * @param[in] seq Temporal float or temporal point sequence
+ * @param[in] precision Number of decimal digits to which the floats or the
+ * coordinates are quantized, -1 for lossless values
+ * @return On error return @p NULL
+ * @note The timestamps are always kept exactly
+ * @see #tsequence_decompress
+ */
+TSequenceComp *
+tsequence_compress(const TSequence *seq, int precision)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(seq, NULL);
+  if (! ensure_temporal_isof_subtype((Temporal *) seq, TSEQUENCE))
+    return NULL;
+  if (seq->temptype != T_TFLOAT && ! tpoint_type(seq->temptype))
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_TYPE,
+      "The temporal value must be a temporal float or a temporal point");
+    return NULL;
+  }
+  if (precision < -1 || precision > TSEQUENCECOMP_MAX_PRECISION)
+  {
+    meos_error(ERROR, MEOS_ERR_INVALID_ARG_VALUE,
+      "The precision must be -1 or between 0 and %d",
+      TSEQUENCECOMP_MAX_PRECISION);
+    return NULL;
+  }
+
+  int ndims = tsequencecomp_ndims(seq->temptype, seq->flags);
+  int nblocks = (seq->count + TSEQUENCECOMP_BLOCK_SIZE - 1) /
+    TSEQUENCECOMP_BLOCK_SIZE;
+  TSequenceCompBlock *blocks = palloc(sizeof(TSequenceCompBlock) * nblocks);
+  BitWriter bw;
+  bw.capacity = (size_t) seq->count * (ndims + 1) * 2 + 64;
+  bw.data = palloc0(bw.capacity);
+  bw.pos = 0;
+  for (int b = 0; b < nblocks; b++)
+  {
+    int first = b * TSEQUENCECOMP_BLOCK_SIZE;
+    /* Every block starts on a byte */
+    bw.pos = (bw.pos + 7) & ~((uint64) 7);
+    blocks[b].t = TSEQUENCE_INST_N(seq, first)->t;
+    blocks[b].count = Min(TSEQUENCECOMP_BLOCK_SIZE, seq->count - first);
+    blocks[b].offset = (uint32) (bw.pos >> 3);
+    if (! tsequencecomp_encode_block(seq, first, blocks[b].count, ndims,
+        precision, &bw))
+    {
+      pfree(blocks); pfree(bw.data);
+      return NULL;
+    }
+  }
+
+  size_t datasize = (size_t) ((bw.pos + 7) / 8);
+  size_t size = sizeof(TSequenceComp) + sizeof(TSequenceCompBlock) * nblocks +
+    datasize;
+  TSequenceComp *result = palloc0(size);
+  SET_VARSIZE(result, size);
+  result->temptype = seq->temptype;
+  result->precision = (int8) precision;
+  result->flags = seq->flags;
+  result->count = seq->count;
+  result->nblocks = nblocks;
+  result->srid = tpoint_type(seq->temptype) ?
+    tspatial_srid((Temporal *) seq) : 0;
+  result->period = seq->period;
+  memcpy(TSEQUENCECOMP_BLOCKS(result), blocks,
+    sizeof(TSequenceCompBlock) * nblocks);
+  memcpy(TSEQUENCECOMP_DATA(result), bw.data, datasize);
+  pfree(blocks); pfree(bw.data);
+  return result;
+}
+
+/**
+ * @ingroup meos_temporal_conversion
+ * @brief Return a compressed temporal sequence converted to a temporal
+ * sequence
+ * @param[in] cseq Compressed temporal sequence
+ * @return On error return @p NULL
+ * @see #tsequence_compress
+ */
+TSequence *
+tsequence_decompress(const TSequenceComp *cseq)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(cseq, NULL);
+
+  int ndims = tsequencecomp_ndims(cseq->temptype, cseq->flags);
+  TInstant **instants = palloc(sizeof(TInstant *) * cseq->count);
+  TimestampTz times[TSEQUENCECOMP_BLOCK_SIZE];
+  double values[TSEQUENCECOMP_BLOCK_SIZE * 3];
+  int ninsts = 0;
+  for (int b = 0; b < cseq->nblocks; b++)
+  {
+    int count = tsequencecomp_decode_block(cseq, b, TSEQUENCECOMP_BLOCK_SIZE,
+      times, values);
+    for (int i = 0; i < count; i++)
+    {
+      Datum value = tsequencecomp_value(cseq, &values[i * ndims]);
+      instants[ninsts++] = (cseq->temptype == T_TFLOAT) ?
+        tinstant_make(value, cseq->temptype, times[i]) :
+        tinstant_make_free(value, cseq->temptype, times[i]);
+    }
+  }
+  return tsequence_make_free(instants, ninsts, cseq->period.lower_inc,
+    cseq->period.upper_inc, MEOS_FLAGS_GET_INTERP(cseq->flags), NORMALIZE_NO);
+}
+
+/*****************************************************************************
+ * Accessor functions
+ *****************************************************************************/
+
+/**
+ * @ingroup meos_temporal_accessor
+ * @brief Return the number of instants of a compressed temporal sequence
+ * @param[in] cseq Compressed temporal sequence
+ * @return On error return -1
+ */
+int
+tsequencecomp_num_instants(const TSequenceComp *cseq)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(cseq, -1);
+  return cseq->count;
+}
+
+/**
+ * @ingroup meos_temporal_accessor
+ * @brief Return the size in bytes of a compressed temporal sequence
+ * @param[in] cseq Compressed temporal sequence
+ * @return On error return 0
+ * @see #temporal_mem_size
+ */
+size_t
+tsequencecomp_mem_size(const TSequenceComp *cseq)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(cseq, 0);
+  return VARSIZE(cseq);
+}
+
+/**
+ * @ingroup meos_internal_temporal_accessor
+ * @brief Return in the last argument a copy of the value of a compressed
+ * temporal sequence at a timestamptz
+ * @details Only the block containing the timestamp is decoded, together with
+ * the first instant of the next block for the last segment of the block.
+ * @param[in] cseq Compressed temporal sequence
+ * @param[in] t Timestamp
+ * @param[in] strict True if inclusive/exclusive bounds are taken into account
+ * @param[out] result Result
+ * @return Return true if the timestamp is contained in the sequence
+ * @see #tsequence_value_at_timestamptz
+ */
+bool
+tsequencecomp_value_at_timestamptz(const TSequenceComp *cseq, TimestampTz t,
+  bool strict, Datum *result)
+{
+  /* Ensure the validity of the arguments */
+  VALIDATE_NOT_NULL(cseq, false); VALIDATE_NOT_NULL(result, false);
+
+  interpType interp = MEOS_FLAGS_GET_INTERP(cseq->flags);
+  /* Return the value even when the timestamp is at an exclusive bound */
+  bool atbound = ! strict && interp != DISCRETE &&
+    (t == DatumGetTimestampTz(cseq->period.lower) ||
+     t == DatumGetTimestampTz(cseq->period.upper));
+  if (! atbound && ! contains_span_timestamptz(&cseq->period, t))
+    return false;
+
+  /* Find the last block starting at or before the timestamp */
+  const TSequenceCompBlock *blocks = TSEQUENCECOMP_BLOCKS(cseq);
+  int first = 0, last = cseq->nblocks - 1;
+  while (first < last)
+  {
+    int middle = first + (last - first + 1) / 2;
+    if (blocks[middle].t <= t)
+      first = middle;
+    else
+      last = middle - 1;
+  }
+  int b = first;
+  int ndims = tsequencecomp_ndims(cseq->temptype, cseq->flags);
+  TimestampTz times[TSEQUENCECOMP_BLOCK_SIZE];
+  double values[TSEQUENCECOMP_BLOCK_SIZE * 3];
+  int count = tsequencecomp_decode_block(cseq, b, TSEQUENCECOMP_BLOCK_SIZE,
+    times, values);
+  int n = count - 1;
+  while (times[n] > t)
+    n--;
+  if (times[n] == t || interp == STEP)
+  {
+    *result = tsequencecomp_value(cseq, &values[n * ndims]);
+    return true;
+  }
+  if (interp == DISCRETE)
+    return false;
+
+  /* The end of the segment may be the first instant of the next block */
+  TimestampTz t2;
+  const double *values2;
+  double next[3];
+  if (n < count - 1)
+  {
+    t2 = times[n + 1];
+    values2 = &values[(n + 1) * ndims];
+  }
+  else
+  {
+    tsequencecomp_decode_block(cseq, b + 1, 1, &t2, next);
+    values2 = next;
+  }
+  Datum start = tsequencecomp_value(cseq, &values[n * ndims]);
+  Datum end = tsequencecomp_value(cseq, values2);
+  *result = tsegment_value_at_timestamptz(start, end, cseq->temptype,
+    times[n], t2, t);
+  if (cseq->temptype != T_TFLOAT)
+  {
+    pfree(DatumGetPointer(start)); pfree(DatumGetPointer(end));
+  }
+  return true;
+}
+
+/*****************************************************************************/
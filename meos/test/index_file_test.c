@@ -0,0 +1,384 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests saving the in-memory indexes into a file and
+ * searching them in place after mapping the file, i.e., rtree_save,
+ * rtree_open, sptree_save and sptree_open.
+ *
+ * An RTree of spatiotemporal boxes and SPTrees of temporal boxes (quad-tree
+ * and k-d tree) are built, saved, and opened again, and the answers of the
+ * opened trees are compared with those of the trees in memory. Four properties
+ * are asserted:
+ *  (i)   every search returns the same ids as the tree in memory;
+ *  (ii)  the nearest-neighbour cursor returns the same ids at the same
+ *        distances, and the join of the opened RTree with the tree in memory
+ *        is the self join of the latter;
+ *  (iii) an opened tree cannot be modified, and a file that is missing, is
+ *        not an index file of the right kind, or is corrupted is rejected;
+ *  (iv)  an empty tree is saved and opened as an empty tree.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o index_file_test index_file_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+
+/* Number of boxes inserted into every index */
+#define NUM_BOXES 4000
+/* Number of query windows */
+#define NUM_QUERIES 100
+/* Number of neighbours compared per cursor */
+#define NUM_NEIGHBOURS 50
+/* Microseconds in a day */
+#define DAY_USECS ((TimestampTz) 86400000000)
+
+#define RTREE_FILE "index_file_test.rtree"
+#define SPTREE_FILE "index_file_test.sptree"
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random double in [min, max] */
+static double
+random_double(double min, double max)
+{
+  return min + (max - min) * ((double) rand() / (double) RAND_MAX);
+}
+
+static STBox *
+random_stbox(double size)
+{
+  char buf[256];
+  double x = random_double(0, 1000), y = random_double(0, 1000);
+  int day = rand() % 300;
+  snprintf(buf, sizeof(buf),
+    "STBOX XT(((%.3f,%.3f),(%.3f,%.3f)),[2000-01-01,2000-01-01])",
+    x, y, x + random_double(0, size), y + random_double(0, size));
+  STBox *box = stbox_in(buf);
+  box->period.lower += day * DAY_USECS;
+  box->period.upper += (day + 1 + rand() % 5) * DAY_USECS;
+  return box;
+}
+
+static TBox *
+random_tbox(double size)
+{
+  char buf[256];
+  double x = random_double(0, 1000);
+  int day = rand() % 300;
+  snprintf(buf, sizeof(buf), "TBOXFLOAT XT([%.3f,%.3f],[2000-01-01,2000-01-02])",
+    x, x + random_double(0, size));
+  TBox *box = tbox_in(buf);
+  box->period.lower += day * DAY_USECS;
+  box->period.upper += day * DAY_USECS;
+  return box;
+}
+
+/* Return true if two result arrays hold the same ids in the same order */
+static bool
+same_ids(MeosArray *a, MeosArray *b)
+{
+  int n = meos_array_count(a);
+  if (n != meos_array_count(b))
+    return false;
+  for (int i = 0; i < n; i++)
+    if (*(int64 *) meos_array_get(a, i) != *(int64 *) meos_array_get(b, i))
+      return false;
+  return true;
+}
+
+/* Copy a file, overwriting the 8 bytes at an offset with a value */
+static void
+copy_corrupted(const char *from, const char *to, long offset, int64 value)
+{
+  FILE *in = fopen(from, "rb");
+  FILE *out = fopen(to, "wb");
+  int c;
+  for (long pos = 0; (c = fgetc(in)) != EOF; pos++)
+  {
+    if (pos >= offset && pos < offset + (long) sizeof(int64))
+      c = ((unsigned char *) &value)[pos - offset];
+    fputc(c, out);
+  }
+  fclose(in);
+  fclose(out);
+}
+
+/* Write a file holding text, which is not an index file */
+static void
+write_garbage(const char *filename)
+{
+  FILE *file = fopen(filename, "w");
+  fprintf(file, "This is not an index file, although it is long enough to "
+    "hold the header of one.\n");
+  fclose(file);
+}
+
+static void
+test_rtree(void)
+{
+  printf("RTree of spatiotemporal boxes:\n");
+  STBox *boxes = malloc(sizeof(STBox) * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  RTree *rtree = rtree_create_stbox();
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    STBox *box = random_stbox(20);
+    memcpy(&boxes[i], box, sizeof(STBox));
+    free(box);
+    /* Ids above 2^31 */
+    ids[i] = ((int64) 1 << 40) + i;
+    rtree_insert(rtree, &boxes[i], ids[i]);
+  }
+  check("the tree is saved", rtree_save(rtree, RTREE_FILE));
+  RTree *mapped = rtree_open(RTREE_FILE);
+  check("the tree is opened", mapped != NULL);
+  if (! mapped)
+    return;
+
+  /* (i) searches */
+  MeosArray *expected = meos_array_create(sizeof(int64));
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool same = true;
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    STBox *query = random_stbox(q % 2 ? 100 : 5);
+    for (int o = 0; o < 3; o++)
+    {
+      rtree_search(rtree, ops[o], query, expected);
+      rtree_search(mapped, ops[o], query, result);
+      same &= same_ids(expected, result);
+    }
+    free(query);
+  }
+  check("(i) searches return the same ids", same);
+
+  /* (ii) nearest neighbours and join */
+  same = true;
+  for (int q = 0; q < 20; q++)
+  {
+    STBox *query = random_stbox(5);
+    RTreeNNCursor *c1 = rtree_nn_cursor_open(rtree, query);
+    RTreeNNCursor *c2 = rtree_nn_cursor_open(mapped, query);
+    for (int k = 0; k < NUM_NEIGHBOURS; k++)
+    {
+      int64 id1, id2;
+      double d1, d2;
+      bool more1 = rtree_nn_cursor_next(c1, &id1, &d1);
+      bool more2 = rtree_nn_cursor_next(c2, &id2, &d2);
+      if (more1 != more2 || (more1 && (id1 != id2 || d1 != d2)))
+        same = false;
+    }
+    rtree_nn_cursor_close(c1);
+    rtree_nn_cursor_close(c2);
+    free(query);
+  }
+  check("(ii) nearest neighbours are the same", same);
+  int n1 = rtree_join(rtree, rtree, RTREE_OVERLAPS, expected);
+  int n2 = rtree_join(mapped, rtree, RTREE_OVERLAPS, result);
+  check("(ii) the join with the tree in memory is the self join",
+    n1 == n2 && same_ids(expected, result));
+
+  /* (iii) the opened tree is read-only */
+  meos_errno_reset();
+  rtree_insert(mapped, &boxes[0], 0);
+  bool rejected = meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= ! rtree_delete(mapped, &boxes[0], ids[0]) && meos_errno() != 0;
+  rtree_search(mapped, RTREE_OVERLAPS, &boxes[0], result);
+  rtree_search(rtree, RTREE_OVERLAPS, &boxes[0], expected);
+  check("(iii) the opened tree cannot be modified",
+    rejected && same_ids(expected, result));
+
+  /* (iii) invalid files */
+  meos_errno_reset();
+  bool invalid = rtree_open("index_file_test.missing") == NULL &&
+    meos_errno() != 0;
+  write_garbage(RTREE_FILE ".bad");
+  invalid &= rtree_open(RTREE_FILE ".bad") == NULL;
+  invalid &= rtree_open(SPTREE_FILE) == NULL;
+  /* The first child slot of the root, which follows a header of 48 bytes, the
+   * box of the tree, and the size, count, and type of the node, points out of
+   * the file or back to the root */
+  copy_corrupted(RTREE_FILE, RTREE_FILE ".bad", 128 + 16, (int64) 1 << 40);
+  invalid &= rtree_open(RTREE_FILE ".bad") == NULL;
+  copy_corrupted(RTREE_FILE, RTREE_FILE ".bad", 128 + 16, 128);
+  invalid &= rtree_open(RTREE_FILE ".bad") == NULL;
+  remove(RTREE_FILE ".bad");
+  check("(iii) invalid files are rejected", invalid);
+  meos_errno_reset();
+
+  /* (iv) empty tree */
+  RTree *empty = rtree_create_stbox();
+  rtree_save(empty, RTREE_FILE ".empty");
+  RTree *mapped_empty = rtree_open(RTREE_FILE ".empty");
+  check("(iv) an empty tree is opened empty", mapped_empty &&
+    rtree_search(mapped_empty, RTREE_OVERLAPS, &boxes[0], result) == 0);
+  if (mapped_empty)
+    rtree_free(mapped_empty);
+  rtree_free(empty);
+  remove(RTREE_FILE ".empty");
+
+  meos_array_destroy(expected);
+  meos_array_destroy(result);
+  rtree_free(mapped);
+  rtree_free(rtree);
+  remove(RTREE_FILE);
+  free(boxes);
+  free(ids);
+  return;
+}
+
+static void
+test_sptree(SPTreeKind kind)
+{
+  printf("%s of temporal boxes:\n",
+    kind == SPTREE_QUADTREE ? "Quad-tree" : "K-d tree");
+  SPTree *sptree = sptree_create_tbox(kind);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    TBox *box = random_tbox(20);
+    sptree_insert(sptree, box, i);
+    free(box);
+  }
+  check("the tree is saved", sptree_save(sptree, SPTREE_FILE));
+  SPTree *mapped = sptree_open(SPTREE_FILE);
+  check("the tree is opened", mapped != NULL);
+  if (! mapped)
+    return;
+
+  /* (i) searches */
+  MeosArray *expected = meos_array_create(sizeof(int64));
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool same = true;
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    TBox *query = random_tbox(q % 2 ? 100 : 5);
+    for (int o = 0; o < 3; o++)
+    {
+      sptree_search(sptree, ops[o], query, expected);
+      sptree_search(mapped, ops[o], query, result);
+      same &= same_ids(expected, result);
+    }
+    free(query);
+  }
+  check("(i) searches return the same ids", same);
+
+  /* (ii) nearest neighbours */
+  same = true;
+  for (int q = 0; q < 20; q++)
+  {
+    TBox *query = random_tbox(5);
+    SPNNCursor *c1 = sptree_nn_cursor_open(sptree, query);
+    SPNNCursor *c2 = sptree_nn_cursor_open(mapped, query);
+    for (int k = 0; k < NUM_NEIGHBOURS; k++)
+    {
+      int64 id1, id2;
+      double d1, d2;
+      bool more1 = sptree_nn_cursor_next(c1, &id1, &d1);
+      bool more2 = sptree_nn_cursor_next(c2, &id2, &d2);
+      if (more1 != more2 || (more1 && (id1 != id2 || d1 != d2)))
+        same = false;
+    }
+    sptree_nn_cursor_close(c1);
+    sptree_nn_cursor_close(c2);
+    free(query);
+  }
+  check("(ii) nearest neighbours are the same", same);
+
+  /* (iii) the opened tree is read-only, and an RTree file is rejected */
+  TBox *box = random_tbox(5);
+  meos_errno_reset();
+  sptree_insert(mapped, box, 0);
+  check("(iii) the opened tree cannot be modified", meos_errno() != 0);
+  free(box);
+  RTree *rtree = rtree_create_tbox();
+  rtree_save(rtree, RTREE_FILE);
+  check("(iii) invalid files are rejected",
+    sptree_open(RTREE_FILE) == NULL && sptree_open("missing") == NULL);
+  remove(RTREE_FILE);
+  rtree_free(rtree);
+  meos_errno_reset();
+
+  /* (iv) empty tree */
+  SPTree *empty = sptree_create_stbox(kind);
+  sptree_save(empty, SPTREE_FILE ".empty");
+  SPTree *mapped_empty = sptree_open(SPTREE_FILE ".empty");
+  STBox *query = random_stbox(5);
+  check("(iv) an empty tree is opened empty", mapped_empty &&
+    sptree_search(mapped_empty, RTREE_OVERLAPS, query, result) == 0);
+  free(query);
+  if (mapped_empty)
+    sptree_free(mapped_empty);
+  sptree_free(empty);
+  remove(SPTREE_FILE ".empty");
+
+  meos_array_destroy(expected);
+  meos_array_destroy(result);
+  sptree_free(mapped);
+  sptree_free(sptree);
+  /* Keep the file of the last tree for the RTree test of invalid files */
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The rejected operations must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  test_sptree(SPTREE_QUADTREE);
+  test_sptree(SPTREE_KDTREE);
+  test_rtree();
+  remove(SPTREE_FILE);
+
+  printf(failures ? "\nSome index file tests FAILED.\n" :
+    "\nAll index file tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the statistics of the in-memory indexes, i.e.,
+ * rtree_stats, sptree_stats, and sptree_search_cost.
+ *
+ * Five properties are asserted:
+ *  (i)   the shape of an RTree packed by rtree_load is the expected one, with
+ *        full nodes, and an RTree grown by insertion holds every entry;
+ *  (ii)  the cost of a search of an RTree is bounded by its statistics;
+ *  (iii) an SPTree, with or without leaf buckets, counts its entries,
+ *        including after deletions;
+ *  (iv)  sptree_search_cost returns the ids of sptree_search and counts the
+ *        nodes visited;
+ *  (v)   the statistics of empty trees are zero but for the memory.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o index_stats_test index_stats_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of boxes, a grid of 64 x 64 cells */
+#define NUM_BOXES 4096
+/* Capacity of the nodes of the RTree */
+#define CAPACITY 16
+/* Number of query windows */
+#define NUM_QUERIES 100
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return true if two searches returned the same ids in the same order */
+static bool
+same_ids(MeosArray *a, MeosArray *b)
+{
+  int n = meos_array_count(a);
+  if (n != meos_array_count(b))
+    return false;
+  for (int i = 0; i < n; i++)
+  {
+    if (*(int64 *) meos_array_get(a, i) != *(int64 *) meos_array_get(b, i))
+      return false;
+  }
+  return true;
+}
+
+/* Return a temporal box over a span of minutes of January 2000 */
+static TBox *
+minute_tbox(double xmin, double xmax, int from, int to)
+{
+  Span *s = floatspan_make(xmin, xmax, true, true);
+  Span *p = tstzspan_make((TimestampTz) from * 60000000,
+    (TimestampTz) to * 60000000, true, true);
+  TBox *result = tbox_make(s, p);
+  free(s); free(p);
+  return result;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  char buf[256];
+
+  /* The cells of a grid as spatiotemporal and temporal boxes */
+  STBox *boxes = malloc(sizeof(STBox) * NUM_BOXES);
+  TBox *tboxes = malloc(sizeof(TBox) * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    int x = i % 64, y = i / 64;
+    snprintf(buf, sizeof(buf),
+      "STBOX XT(((%d,%d),(%d,%d)),[2000-01-01,2000-01-02])", x, y, x + 1, y + 1);
+    STBox *box = stbox_in(buf);
+    boxes[i] = *box;
+    free(box);
+    TBox *tbox = minute_tbox(x, x + 1, y, y + 1);
+    tboxes[i] = *tbox;
+    free(tbox);
+    ids[i] = i;
+  }
+  STBox *queries[NUM_QUERIES];
+  TBox *tqueries[NUM_QUERIES];
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    int x = (q * 7) % 60, y = (q * 11) % 60;
+    snprintf(buf, sizeof(buf),
+      "STBOX XT(((%d,%d),(%d,%d)),[2000-01-01,2000-01-02])", x, y, x + 3, y + 3);
+    queries[q] = stbox_in(buf);
+    tqueries[q] = minute_tbox(x, x + 3, y, y + 3);
+  }
+
+  /* (i) RTree shape: 4096 entries in 256 full leaves under 16 full nodes */
+  RTree *packed = rtree_create_config(T_STBOX, RTREE_LAYOUT_BOXES, CAPACITY,
+    RTREE_SPLIT_LARGEST_AXIS);
+  rtree_load(packed, boxes, ids, NUM_BOXES);
+  RTreeStats stats;
+  rtree_stats(packed, &stats);
+  RTreeOverlap overlap;
+  rtree_overlap(packed, &overlap);
+  check("(i) a packed RTree has the expected shape",
+    stats.entries == NUM_BOXES && stats.height == 3 && stats.leaves == 256 &&
+    stats.inner_nodes == 17 && stats.fill == 1.0 &&
+    stats.overlap == overlap.overlap && stats.memory > 0);
+  RTree *grown = rtree_create_config(T_STBOX, RTREE_LAYOUT_BOXES, CAPACITY,
+    RTREE_SPLIT_RSTAR);
+  for (int i = 0; i < NUM_BOXES; i++)
+    rtree_insert(grown, &boxes[i], ids[i]);
+  RTreeStats gstats;
+  rtree_stats(grown, &gstats);
+  check("(i) a grown RTree holds every entry", gstats.entries == NUM_BOXES &&
+    gstats.height >= 3 && gstats.fill > 0.0 && gstats.fill <= 1.0 &&
+    gstats.leaves >= 256);
+
+  /* (ii) search cost */
+  MeosArray *expected = meos_array_create(sizeof(int64));
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool bounded = true;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    RTreeSearchCost cost;
+    memset(&cost, 0, sizeof(cost));
+    int n = rtree_search_cost(packed, RTREE_OVERLAPS, queries[q], result,
+      &cost);
+    bounded &= n > 0 && cost.results == n && cost.entries >= n &&
+      cost.leaves <= stats.leaves && cost.inner_nodes <= stats.inner_nodes;
+  }
+  check("(ii) the cost of a search is bounded by the statistics", bounded);
+
+  /* (iii) SPTree entries, with and without leaf buckets */
+  SPTree *plain = sptree_create_tbox(SPTREE_KDTREE);
+  SPTree *bucket = sptree_create_config(T_TBOX, SPTREE_QUADTREE, 16);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    sptree_insert(plain, &tboxes[i], ids[i]);
+    sptree_insert(bucket, &tboxes[i], ids[i]);
+  }
+  RTreeStats pstats, bstats;
+  sptree_stats(plain, &pstats);
+  sptree_stats(bucket, &bstats);
+  check("(iii) an SPTree counts its entries",
+    pstats.entries == NUM_BOXES && pstats.inner_nodes == NUM_BOXES &&
+    pstats.leaves == 0 && bstats.entries == NUM_BOXES && bstats.leaves > 0 &&
+    bstats.fill > 0.0 && bstats.fill <= 1.0 && bstats.overlap == 0.0 &&
+    bstats.memory > 0 && pstats.memory > 0);
+  for (int i = 0; i < NUM_BOXES; i += 4)
+  {
+    sptree_delete(plain, &tboxes[i], ids[i]);
+    sptree_delete(bucket, &tboxes[i], ids[i]);
+  }
+  sptree_stats(plain, &pstats);
+  sptree_stats(bucket, &bstats);
+  check("(iii) an SPTree counts its entries after deletions",
+    pstats.entries == NUM_BOXES * 3 / 4 && bstats.entries == NUM_BOXES * 3 / 4);
+
+  /* (iv) SPTree search cost */
+  bool same = true;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    RTreeSearchCost cost;
+    memset(&cost, 0, sizeof(cost));
+    sptree_search(bucket, RTREE_OVERLAPS, tqueries[q], expected);
+    int n = sptree_search_cost(bucket, RTREE_OVERLAPS, tqueries[q], result,
+      &cost);
+    same &= same_ids(expected, result) && cost.results == n &&
+      cost.entries >= n && cost.inner_nodes + cost.leaves > 0 &&
+      cost.leaves <= bstats.leaves && cost.inner_nodes <= bstats.inner_nodes;
+  }
+  check("(iv) sptree_search_cost returns the ids of sptree_search", same);
+
+  /* (v) empty trees */
+  RTree *rempty = rtree_create_stbox();
+  SPTree *sempty = sptree_create_tbox(SPTREE_QUADTREE);
+  rtree_stats(rempty, &stats);
+  sptree_stats(sempty, &pstats);
+  check("(v) the statistics of empty trees are zero",
+    stats.entries == 0 && stats.height == 0 && stats.inner_nodes == 0 &&
+    stats.leaves == 0 && stats.memory > 0 && pstats.entries == 0 &&
+    pstats.height == 0 && pstats.memory > 0);
+  rtree_free(rempty);
+  sptree_free(sempty);
+
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    free(queries[q]);
+    free(tqueries[q]);
+  }
+  meos_array_destroy(expected);
+  meos_array_destroy(result);
+  rtree_free(packed);
+  rtree_free(grown);
+  sptree_free(plain);
+  sptree_free(bucket);
+  free(boxes);
+  free(tboxes);
+  free(ids);
+
+  printf(failures ? "\nSome index statistics tests FAILED.\n" :
+    "\nAll index statistics tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the batched search of the in-memory RTree
+ * index, i.e., rtree_search_batch, against one call of rtree_search per query.
+ *
+ * For RTrees with both node layouts, opened from a file, and over integer
+ * spans and temporal boxes, three properties are asserted:
+ *  (i)   every query of the batch gets the ids of rtree_search, in the same
+ *        order, for the overlaps, contains, and contained-by operations, with
+ *        batches larger than the groups sharing a traversal, with repeated
+ *        queries, and with queries outside the extent of the tree;
+ *  (ii)  the number returned is the total number of ids;
+ *  (iii) an empty batch and a batch over an empty tree yield no ids and the
+ *        offsets of empty answers.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o rtree_batch_test rtree_batch_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of boxes inserted into every index */
+#define NUM_BOXES 5000
+/* Number of queries of a batch, several groups sharing a traversal */
+#define NUM_QUERIES 1000
+
+#define BATCH_FILE "rtree_batch_test.rtree"
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Return a random box of a type of a given width */
+static void *
+random_box(MeosType bboxtype, int w)
+{
+  char buf[256];
+  /* Some queries are outside the extent of the trees */
+  int x = random_int(-100, 1100), y = random_int(-100, 1100);
+  int day = random_int(1, 20);
+  switch (bboxtype)
+  {
+    case T_INTSPAN:
+      snprintf(buf, sizeof(buf), "[%d,%d]", x, x + w);
+      return span_in(buf, T_INTSPAN);
+    case T_TBOX:
+      snprintf(buf, sizeof(buf),
+        "TBOXFLOAT XT([%d,%d],[2000-01-%02d,2000-01-%02d])", x, x + w, day,
+        day + 1 + w / 40);
+      return tbox_in(buf);
+    default: /* T_STBOX */
+      snprintf(buf, sizeof(buf),
+        "STBOX XT(((%d,%d),(%d,%d)),[2000-01-%02d,2000-01-%02d])", x, y,
+        x + w, y + w, day, day + 1 + w / 40);
+      return stbox_in(buf);
+  }
+}
+
+/**
+ * @brief Compare the batched search of a tree with its search on every query
+ */
+static void
+test_tree(const char *name, const RTree *rtree, const char *queries,
+  size_t size)
+{
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  const char *opnames[] = {"overlaps", "contains", "contained by"};
+  MeosArray *result = meos_array_create(sizeof(int64));
+  MeosArray *offsets = meos_array_create(sizeof(int));
+  MeosArray *single = meos_array_create(sizeof(int64));
+  char label[128];
+  for (int o = 0; o < 3; o++)
+  {
+    int total = rtree_search_batch(rtree, ops[o], queries, NUM_QUERIES,
+      result, offsets);
+    bool same = (meos_array_count(offsets) == NUM_QUERIES + 1) &&
+      (*(int *) meos_array_get(offsets, 0) == 0);
+    int64 expected = 0;
+    for (int q = 0; q < NUM_QUERIES && same; q++)
+    {
+      int n = rtree_search(rtree, ops[o], queries + q * size, single);
+      expected += n;
+      int start = *(int *) meos_array_get(offsets, q);
+      int end = *(int *) meos_array_get(offsets, q + 1);
+      same = (end - start == n);
+      for (int i = 0; i < n && same; i++)
+        same = (*(int64 *) meos_array_get(result, start + i) ==
+          *(int64 *) meos_array_get(single, i));
+    }
+    snprintf(label, sizeof(label), "(i) %s, %s: same ids per query", name,
+      opnames[o]);
+    check(label, same && expected > 0);
+    snprintf(label, sizeof(label), "(ii) %s, %s: total number of ids", name,
+      opnames[o]);
+    check(label, total == expected && meos_array_count(result) == total);
+  }
+  meos_array_destroy(result);
+  meos_array_destroy(offsets);
+  meos_array_destroy(single);
+  return;
+}
+
+/**
+ * @brief Fill trees of a box type and compare their batched searches
+ */
+static void
+test_type(const char *name, MeosType bboxtype)
+{
+  printf("%s:\n", name);
+  size_t size = bbox_get_size(bboxtype);
+  char *boxes = malloc(size * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  char *queries = malloc(size * NUM_QUERIES);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    void *box = random_box(bboxtype, random_int(1, 40));
+    memcpy(boxes + i * size, box, size);
+    free(box);
+    ids[i] = i;
+  }
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    /* Every tenth query repeats the previous one */
+    if (q % 10 == 9)
+    {
+      memcpy(queries + q * size, queries + (q - 1) * size, size);
+      continue;
+    }
+    /* Small queries for the contains operation, large ones otherwise */
+    void *query = random_box(bboxtype, q % 2 ? 1 : 120);
+    memcpy(queries + q * size, query, size);
+    free(query);
+  }
+
+  RTree *rtree = rtree_create_layout(bboxtype, RTREE_LAYOUT_BOXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+    rtree_insert(rtree, boxes + i * size, ids[i]);
+  test_tree("boxes", rtree, queries, size);
+  rtree_save(rtree, BATCH_FILE);
+  RTree *mapped = rtree_open(BATCH_FILE);
+  test_tree("mapped", mapped, queries, size);
+  rtree_free(mapped);
+  remove(BATCH_FILE);
+  rtree_free(rtree);
+
+  RTree *axes = rtree_create_layout(bboxtype, RTREE_LAYOUT_AXES);
+  rtree_load(axes, boxes, ids, NUM_BOXES);
+  test_tree("axes", axes, queries, size);
+  rtree_free(axes);
+
+  free(boxes);
+  free(ids);
+  free(queries);
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  srand(1);
+
+  test_type("Spatiotemporal boxes", T_STBOX);
+  test_type("Temporal boxes", T_TBOX);
+  test_type("Integer spans", T_INTSPAN);
+
+  /* (iii) empty batches and empty trees */
+  printf("Empty batches and trees:\n");
+  MeosArray *result = meos_array_create(sizeof(int64));
+  MeosArray *offsets = meos_array_create(sizeof(int));
+  RTree *rtree = rtree_create_stbox();
+  STBox *query = random_box(T_STBOX, 50);
+  int n = rtree_search_batch(rtree, RTREE_OVERLAPS, NULL, 0, result, offsets);
+  check("(iii) an empty batch yields nothing", n == 0 &&
+    meos_array_count(offsets) == 1 && *(int *) meos_array_get(offsets, 0) == 0);
+  n = rtree_search_batch(rtree, RTREE_OVERLAPS, query, 1, result, offsets);
+  check("(iii) a batch over an empty tree yields nothing", n == 0 &&
+    meos_array_count(result) == 0 && meos_array_count(offsets) == 2 &&
+    *(int *) meos_array_get(offsets, 1) == 0);
+  free(query);
+  rtree_free(rtree);
+  meos_array_destroy(result);
+  meos_array_destroy(offsets);
+
+  printf(failures ? "\nSome batched RTree search tests FAILED.\n" :
+    "\nAll batched RTree search tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the concurrent mode of the RTree, where a
+ * writer inserts entries while readers search snapshots of the tree.
+ *
+ * Four properties are asserted:
+ *  (i)   a snapshot keeps the tree at the time it was opened, whatever the
+ *        insertions published afterwards;
+ *  (ii)  reader threads searching snapshots while the main thread inserts
+ *        always see a consistent tree, i.e., the answer of a search of a
+ *        snapshot holding k entries is the one over the first k boxes;
+ *  (iii) deletions, updates, and bulk loads are rejected in the concurrent
+ *        mode;
+ *  (iv)  a snapshot cannot be opened on a tree not in the concurrent mode.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -pthread -o rtree_concurrent_test rtree_concurrent_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of boxes, a grid of 64 x 64 cells */
+#define NUM_BOXES 4096
+/* Number of reader threads */
+#define NUM_READERS 4
+/* Number of query windows */
+#define NUM_QUERIES 64
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Inputs shared by the writer and the readers, read-only once built */
+static STBox *boxes;
+static STBox *queries[NUM_QUERIES];
+static RTree *rtree;
+static int done = 0;
+
+typedef struct
+{
+  int searches;
+  int snapshots;
+  int errors;
+} ReaderResult;
+
+/* Return true if the ids found in a snapshot of k entries are the ids of the
+ * first k boxes overlapping the query */
+static bool
+consistent(const STBox *query, MeosArray *result, int k, char *seen)
+{
+  memset(seen, 0, NUM_BOXES);
+  int n = meos_array_count(result);
+  for (int i = 0; i < n; i++)
+  {
+    int64 id = *(int64 *) meos_array_get(result, i);
+    if (id < 0 || id >= k || seen[id])
+      return false;
+    seen[id] = 1;
+  }
+  for (int i = 0; i < k; i++)
+  {
+    if (overlaps_stbox_stbox(&boxes[i], query) != (bool) seen[i])
+      return false;
+  }
+  return true;
+}
+
+static void *
+reader(void *arg)
+{
+  ReaderResult *res = (ReaderResult *) arg;
+  meos_initialize();
+  /* The error handler is process-wide and meos_initialize resets it */
+  meos_initialize_noexit_error_handler();
+  MeosArray *result = meos_array_create(sizeof(int64));
+  char *seen = malloc(NUM_BOXES);
+  int q = 0;
+  while (! __atomic_load_n(&done, __ATOMIC_ACQUIRE) || res->snapshots == 0)
+  {
+    RTreeSnapshot *snapshot = rtree_snapshot_open(rtree);
+    if (! snapshot)
+    {
+      res->errors++;
+      break;
+    }
+    res->snapshots++;
+    const RTree *tree = rtree_snapshot_tree(snapshot);
+    RTreeStats stats;
+    rtree_stats(tree, &stats);
+    for (int i = 0; i < 4; i++, q = (q + 1) % NUM_QUERIES)
+    {
+      rtree_search(tree, RTREE_OVERLAPS, queries[q], result);
+      if (! consistent(queries[q], result, (int) stats.entries, seen))
+        res->errors++;
+      res->searches++;
+    }
+    rtree_snapshot_close(snapshot);
+  }
+  free(seen);
+  meos_array_destroy(result);
+  meos_finalize();
+  return NULL;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  meos_initialize_noexit_error_handler();
+  char buf[256];
+
+  /* The cells of a grid in a scattered order of insertion */
+  boxes = malloc(sizeof(STBox) * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    int cell = (i * 1031) % NUM_BOXES;
+    int x = cell % 64, y = cell / 64;
+    snprintf(buf, sizeof(buf),
+      "STBOX XT(((%d,%d),(%d,%d)),[2000-01-01,2000-01-02])", x, y, x + 1, y + 1);
+    STBox *box = stbox_in(buf);
+    boxes[i] = *box;
+    free(box);
+    ids[i] = i;
+  }
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    int x = (q * 7) % 60, y = (q * 11) % 60;
+    snprintf(buf, sizeof(buf),
+      "STBOX XT(((%d,%d),(%d,%d)),[2000-01-01,2000-01-02])", x, y, x + 4, y + 4);
+    queries[q] = stbox_in(buf);
+  }
+  MeosArray *before = meos_array_create(sizeof(int64));
+  MeosArray *after = meos_array_create(sizeof(int64));
+  char *seen = malloc(NUM_BOXES);
+
+  /* (i) a snapshot keeps its tree */
+  rtree = rtree_create_config(T_STBOX, RTREE_LAYOUT_BOXES, 8,
+    RTREE_SPLIT_RSTAR);
+  check("(i) an empty RTree is set in the concurrent mode",
+    rtree_set_concurrent(rtree));
+  for (int i = 0; i < NUM_BOXES / 2; i++)
+    rtree_insert(rtree, &boxes[i], ids[i]);
+  RTreeSnapshot *snapshot = rtree_snapshot_open(rtree);
+  const RTree *tree = rtree_snapshot_tree(snapshot);
+  int n1 = rtree_search(tree, RTREE_OVERLAPS, queries[0], before);
+  for (int i = NUM_BOXES / 2; i < NUM_BOXES; i++)
+    rtree_insert(rtree, &boxes[i], ids[i]);
+  int n2 = rtree_search(tree, RTREE_OVERLAPS, queries[0], after);
+  check("(i) a snapshot is unchanged by later insertions",
+    n1 == n2 && consistent(queries[0], after, NUM_BOXES / 2, seen));
+  rtree_snapshot_close(snapshot);
+  snapshot = rtree_snapshot_open(rtree);
+  rtree_search(rtree_snapshot_tree(snapshot), RTREE_OVERLAPS, queries[0],
+    after);
+  check("(i) a new snapshot sees every insertion",
+    consistent(queries[0], after, NUM_BOXES, seen));
+  rtree_snapshot_close(snapshot);
+  rtree_free(rtree);
+
+  /* (ii) readers concurrent with a writer */
+  rtree = rtree_create_config(T_STBOX, RTREE_LAYOUT_BOXES, 8,
+    RTREE_SPLIT_RSTAR);
+  rtree_set_concurrent(rtree);
+  pthread_t threads[NUM_READERS];
+  ReaderResult results[NUM_READERS];
+  memset(results, 0, sizeof(results));
+  for (int t = 0; t < NUM_READERS; t++)
+    pthread_create(&threads[t], NULL, reader, &results[t]);
+  for (int i = 0; i < NUM_BOXES; i++)
+    rtree_insert(rtree, &boxes[i], ids[i]);
+  __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+  int searches = 0, errors = 0;
+  for (int t = 0; t < NUM_READERS; t++)
+  {
+    pthread_join(threads[t], NULL);
+    searches += results[t].searches;
+    errors += results[t].errors;
+  }
+  /* A reader may have reset the handler before installing its own */
+  meos_initialize_noexit_error_handler();
+  printf("  %d searches of snapshots during %d insertions\n", searches,
+    NUM_BOXES);
+  check("(ii) concurrent readers always see a consistent tree",
+    searches > 0 && errors == 0);
+  RTreeStats stats;
+  rtree_stats(rtree, &stats);
+  check("(ii) the writer published every insertion",
+    stats.entries == NUM_BOXES);
+
+  /* (iii) operations rejected in the concurrent mode */
+  meos_errno_reset();
+  bool rejected = ! rtree_delete(rtree, &boxes[0], ids[0]) &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= ! rtree_update(rtree, &boxes[0], &boxes[1], ids[0]) &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  rtree_load(rtree, boxes, ids, NUM_BOXES);
+  rejected &= meos_errno() != 0;
+  meos_errno_reset();
+  rtree_stats(rtree, &stats);
+  check("(iii) deletions, updates, and loads are rejected",
+    rejected && stats.entries == NUM_BOXES);
+  rtree_free(rtree);
+
+  /* (iv) no snapshot of a tree not in the concurrent mode */
+  rtree = rtree_create_stbox();
+  rtree_insert(rtree, &boxes[0], ids[0]);
+  snapshot = rtree_snapshot_open(rtree);
+  check("(iv) a snapshot requires the concurrent mode",
+    snapshot == NULL && meos_errno() != 0);
+  meos_errno_reset();
+  rtree_free(rtree);
+
+  for (int q = 0; q < NUM_QUERIES; q++)
+    free(queries[q]);
+  meos_array_destroy(before);
+  meos_array_destroy(after);
+  free(seen);
+  free(boxes);
+  free(ids);
+
+  printf(failures ? "\nSome concurrent RTree tests FAILED.\n" :
+    "\nAll concurrent RTree tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
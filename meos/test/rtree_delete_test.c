@@ -0,0 +1,239 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the deletion and the update of the entries of
+ * the in-memory RTree index, i.e., rtree_delete and rtree_update, against an
+ * exact brute-force oracle.
+ *
+ * The oracle is the set of live entries kept by the program, and the answer of
+ * the tree to a query window is compared with #overlaps_stbox_stbox applied to
+ * every live entry. Deleting most of the entries empties and eliminates whole
+ * nodes, so the reinsertion of the entries of an underflowing node and the
+ * shortening of the tree are exercised.
+ *
+ * Five properties are asserted:
+ *  (i)   after deleting every other entry, every window returns exactly the
+ *        live entries it overlaps;
+ *  (ii)  an entry that is not in the tree, or that is given with a box other
+ *        than its own, is not deleted and leaves the tree unchanged;
+ *  (iii) after moving entries, both a little (in place) and far away (by
+ *        deletion and reinsertion), every window returns exactly the live
+ *        entries it overlaps at their new position;
+ *  (iv)  the same holds for a tree built by rtree_load, whose nodes are full;
+ *  (v)   deleting every entry leaves a tree that answers nothing and that can
+ *        be filled again.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o rtree_delete_test rtree_delete_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+
+/* Number of entries, enough for a tree of three levels */
+#define NUM_BOXES 5000
+/* Number of query windows compared against the oracle */
+#define NUM_QUERIES 150
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/**
+ * @brief Return a spatiotemporal box of unit size at a position
+ */
+static STBox *
+make_box(double x, double y)
+{
+  char buf[256];
+  snprintf(buf, sizeof(buf),
+    "STBOX XT(((%.3f,%.3f),(%.3f,%.3f)),[2000-01-01,2000-01-02])",
+    x, y, x + 1, y + 1);
+  return stbox_in(buf);
+}
+
+/**
+ * @brief Return true if the tree answers every query window exactly as the
+ * oracle over the live entries
+ */
+static bool
+matches_oracle(const RTree *rtree, STBox *boxes, const bool *live, int count)
+{
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool *seen = malloc(sizeof(bool) * (size_t) count);
+  bool ok = true;
+  for (int q = 0; q < NUM_QUERIES && ok; q++)
+  {
+    STBox *query = make_box((q * 7) % 100, (q * 11) % 100);
+    query->xmax += 4; query->ymax += 4;
+    memset(seen, 0, sizeof(bool) * (size_t) count);
+    int n = rtree_search(rtree, RTREE_OVERLAPS, query, result);
+    for (int i = 0; i < n; i++)
+    {
+      int64 id = *(int64 *) meos_array_get(result, i);
+      /* Unknown, dead, duplicated, or not overlapping the window */
+      if (id < 0 || id >= count || ! live[id] || seen[id] ||
+          ! overlaps_stbox_stbox(&boxes[id], query))
+        ok = false;
+      else
+        seen[id] = true;
+    }
+    for (int i = 0; i < count; i++)
+      if (live[i] && ! seen[i] && overlaps_stbox_stbox(&boxes[i], query))
+        ok = false;
+    free(query);
+  }
+  free(seen);
+  meos_array_destroy(result);
+  return ok;
+}
+
+/**
+ * @brief Delete, move, and check the entries of a tree holding @p boxes
+ */
+static void
+exercise(RTree *rtree, STBox *boxes, int count)
+{
+  bool *live = malloc(sizeof(bool) * (size_t) count);
+  for (int i = 0; i < count; i++)
+    live[i] = true;
+
+  /* (i) delete every other entry */
+  bool all_deleted = true;
+  for (int i = 0; i < count; i += 2)
+  {
+    all_deleted &= rtree_delete(rtree, &boxes[i], i);
+    live[i] = false;
+  }
+  check("every deleted entry is found", all_deleted);
+  check("(i) answers match the oracle after deletions",
+    matches_oracle(rtree, boxes, live, count));
+
+  /* (ii) entries that are not in the tree */
+  STBox *elsewhere = make_box(500, 500);
+  bool none = ! rtree_delete(rtree, &boxes[0], 0) &&
+    ! rtree_delete(rtree, elsewhere, 1) &&
+    ! rtree_delete(rtree, &boxes[1], count + 1) &&
+    ! rtree_update(rtree, elsewhere, &boxes[1], 1);
+  free(elsewhere);
+  check("(ii) absent entries are neither deleted nor updated", none);
+  check("(ii) the tree is unchanged",
+    matches_oracle(rtree, boxes, live, count));
+
+  /* (iii) move the live entries, a little or far away */
+  bool all_updated = true;
+  for (int i = 1; i < count; i += 2)
+  {
+    double shift = (i % 3 == 0) ? 0.25 : 37.0;
+    STBox *moved = make_box(boxes[i].xmin + shift,
+      (i % 3 == 0) ? boxes[i].ymin : boxes[i].ymin - shift);
+    all_updated &= rtree_update(rtree, &boxes[i], moved, i);
+    memcpy(&boxes[i], moved, sizeof(STBox));
+    free(moved);
+  }
+  check("every updated entry is found", all_updated);
+  check("(iii) answers match the oracle after updates",
+    matches_oracle(rtree, boxes, live, count));
+
+  /* (v) delete everything, then fill again */
+  for (int i = 1; i < count; i += 2)
+  {
+    rtree_delete(rtree, &boxes[i], i);
+    live[i] = false;
+  }
+  STBox *whole = make_box(-1000, -1000);
+  whole->xmax = whole->ymax = 1000;
+  MeosArray *result = meos_array_create(sizeof(int64));
+  check("(v) an emptied tree answers nothing",
+    rtree_search(rtree, RTREE_OVERLAPS, whole, result) == 0);
+  for (int i = 0; i < 100; i++)
+  {
+    rtree_insert(rtree, &boxes[i], i);
+    live[i] = true;
+  }
+  check("(v) an emptied tree can be filled again",
+    matches_oracle(rtree, boxes, live, count));
+  meos_array_destroy(result);
+  free(whole);
+  free(live);
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+
+  STBox *boxes = malloc(sizeof(STBox) * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    STBox *box = make_box((i * 37) % 100, (i * 53) % 100 + (i % 7) * 0.1);
+    memcpy(&boxes[i], box, sizeof(STBox));
+    free(box);
+    ids[i] = i;
+  }
+  STBox *copy = malloc(sizeof(STBox) * NUM_BOXES);
+
+  printf("Tree built by insertion:\n");
+  memcpy(copy, boxes, sizeof(STBox) * NUM_BOXES);
+  RTree *grown = rtree_create_stbox();
+  for (int i = 0; i < NUM_BOXES; i++)
+    rtree_insert(grown, &copy[i], i);
+  exercise(grown, copy, NUM_BOXES);
+  rtree_free(grown);
+
+  printf("(iv) Tree built by rtree_load:\n");
+  memcpy(copy, boxes, sizeof(STBox) * NUM_BOXES);
+  RTree *packed = rtree_create_stbox();
+  rtree_load(packed, copy, ids, NUM_BOXES);
+  exercise(packed, copy, NUM_BOXES);
+  rtree_free(packed);
+
+  free(copy);
+  free(boxes);
+  free(ids);
+  printf(failures ? "\nSome deletion RTree tests FAILED.\n" :
+    "\nAll deletion RTree tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
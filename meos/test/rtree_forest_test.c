@@ -0,0 +1,245 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the time-partitioned forest of in-memory RTree
+ * indexes, i.e., rtree_forest_insert, rtree_forest_search,
+ * rtree_forest_freeze, and rtree_forest_drop, against a single RTree holding
+ * the same boxes.
+ *
+ * Spatiotemporal boxes of a stream in time order, some of them spanning
+ * several days, are inserted into a forest with daily buckets. Five
+ * properties are asserted:
+ *  (i)   every search returns the ids of the single RTree, for the overlaps,
+ *        contains, and contained-by operations and for queries without time
+ *        dimension;
+ *  (ii)  there is one bucket per day of the stream;
+ *  (iii) freezing the past buckets does not change the answers and the
+ *        frozen buckets reject inserts;
+ *  (iv)  dropping the expired buckets removes exactly the boxes that end
+ *        before the retention time;
+ *  (v)   a box without time dimension is rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o rtree_forest_test rtree_forest_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+
+/* Number of days of the stream */
+#define NUM_DAYS 20
+/* Number of boxes inserted per day */
+#define BOXES_PER_DAY 200
+/* Number of queries per operation */
+#define NUM_QUERIES 200
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Return a random box starting on a day and lasting up to a number of days */
+static STBox *
+random_box(int day, int w, int maxdays, bool timed)
+{
+  char buf[256];
+  int x = random_int(0, 1000), y = random_int(0, 1000);
+  int hour = random_int(0, 23);
+  if (! timed)
+    snprintf(buf, sizeof(buf), "STBOX X((%d,%d),(%d,%d))", x, y, x + w,
+      y + w);
+  else
+    snprintf(buf, sizeof(buf), "STBOX XT(((%d,%d),(%d,%d)),"
+      "[2000-01-%02d %02d:00:00,2000-01-%02d %02d:30:00])", x, y, x + w,
+      y + w, day, hour, day + random_int(0, maxdays), hour);
+  return stbox_in(buf);
+}
+
+static int
+cmp_int64(const void *a, const void *b)
+{
+  int64 x = *(const int64 *) a, y = *(const int64 *) b;
+  return (x > y) - (x < y);
+}
+
+/* Return true when two arrays hold the same ids in any order */
+static bool
+same_ids(MeosArray *a, MeosArray *b)
+{
+  int n = meos_array_count(a);
+  if (n != meos_array_count(b))
+    return false;
+  int64 *x = malloc(sizeof(int64) * (n + 1));
+  int64 *y = malloc(sizeof(int64) * (n + 1));
+  for (int i = 0; i < n; i++)
+  {
+    x[i] = *(int64 *) meos_array_get(a, i);
+    y[i] = *(int64 *) meos_array_get(b, i);
+  }
+  qsort(x, n, sizeof(int64), cmp_int64);
+  qsort(y, n, sizeof(int64), cmp_int64);
+  bool result = memcmp(x, y, sizeof(int64) * n) == 0;
+  free(x); free(y);
+  return result;
+}
+
+/* Compare the searches of the forest and of the single tree */
+static bool
+same_answers(const RTreeForest *forest, const RTree *rtree)
+{
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  MeosArray *r1 = meos_array_create(sizeof(int64));
+  MeosArray *r2 = meos_array_create(sizeof(int64));
+  bool result = true;
+  for (int o = 0; o < 3; o++)
+  {
+    for (int q = 0; q < NUM_QUERIES; q++)
+    {
+      /* Wide queries for contained by, and some without time dimension */
+      int w = ops[o] == RTREE_CONTAINED_BY ? 300 : random_int(0, 20);
+      STBox *query = random_box(random_int(1, NUM_DAYS), w,
+        ops[o] == RTREE_CONTAINED_BY ? 5 : 0, q % 10 != 0);
+      int n1 = rtree_forest_search(forest, ops[o], query, r1);
+      int n2 = rtree_search(rtree, ops[o], query, r2);
+      if (n1 != n2 || ! same_ids(r1, r2))
+        result = false;
+      free(query);
+    }
+  }
+  meos_array_destroy(r1);
+  meos_array_destroy(r2);
+  return result;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The rejected inserts must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  Interval *day = interval_in("1 day", -1);
+  TimestampTz origin = timestamptz_in("2000-01-01", -1);
+  RTreeForest *forest = rtree_forest_create_stbox(day, origin);
+  RTree *rtree = rtree_create_stbox();
+  int nboxes = NUM_DAYS * BOXES_PER_DAY;
+  STBox **boxes = malloc(sizeof(STBox *) * nboxes);
+  bool inserted = true;
+  for (int i = 0; i < nboxes; i++)
+  {
+    /* One box out of twenty spans several days */
+    boxes[i] = random_box(1 + i / BOXES_PER_DAY, random_int(0, 20),
+      i % 20 ? 0 : 3, true);
+    inserted &= rtree_forest_insert(forest, boxes[i], i);
+    rtree_insert(rtree, boxes[i], i);
+  }
+
+  printf("Time-partitioned RTree forest:\n");
+  check("(i) every box is inserted", inserted);
+  check("(i) the searches return the ids of a single RTree",
+    same_answers(forest, rtree));
+  check("(ii) one bucket per day",
+    rtree_forest_buckets(forest) == NUM_DAYS);
+
+  /* (iii) freeze the first half of the days */
+  TimestampTz half = timestamptz_in("2000-01-11", -1);
+  check("(iii) the past buckets are frozen",
+    rtree_forest_freeze(forest, half) == NUM_DAYS / 2);
+  check("(iii) freezing again freezes nothing",
+    rtree_forest_freeze(forest, half) == 0);
+  check("(iii) the frozen buckets return the same ids",
+    same_answers(forest, rtree));
+  STBox *late = random_box(3, 10, 0, true);
+  check("(iii) a frozen bucket rejects an insert",
+    ! rtree_forest_insert(forest, late, nboxes));
+  free(late);
+
+  /* (iv) drop the boxes ending before a retention time */
+  TimestampTz retention = timestamptz_in("2000-01-08", -1);
+  int dropped = rtree_forest_drop(forest, retention);
+  MeosArray *result = meos_array_create(sizeof(int64));
+  STBox *all = stbox_in("STBOX X((-10,-10),(2000,2000))");
+  rtree_forest_search(forest, RTREE_OVERLAPS, all, result);
+  bool *present = calloc(nboxes, sizeof(bool));
+  for (int i = 0; i < meos_array_count(result); i++)
+    present[*(int64 *) meos_array_get(result, i)] = true;
+  /* A bucket survives when one of its boxes ends after the retention time */
+  bool retained = true;
+  for (int i = 0; i < nboxes; i++)
+  {
+    TimestampTz tmax;
+    stbox_tmax(boxes[i], &tmax);
+    if (tmax >= retention && ! present[i])
+      retained = false;
+    if (i / BOXES_PER_DAY >= 7 && ! present[i])
+      retained = false;
+  }
+  check("(iv) expired buckets are dropped", dropped > 0 && dropped <= 7);
+  check("(iv) the boxes ending after the retention time remain", retained);
+  free(present);
+  free(all);
+  meos_array_destroy(result);
+
+  /* (v) a box without time dimension */
+  STBox *notime = random_box(1, 10, 0, false);
+  check("(v) a box without time dimension is rejected",
+    ! rtree_forest_insert(forest, notime, nboxes));
+  free(notime);
+
+  rtree_forest_free(forest);
+  rtree_free(rtree);
+  for (int i = 0; i < nboxes; i++)
+    free(boxes[i]);
+  free(boxes);
+  free(day);
+  printf(failures ? "\nSome RTree forest tests FAILED.\n" :
+    "\nAll RTree forest tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,253 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the bulk build of the in-memory RTree index in
+ * the order of the Hilbert curve, i.e., rtree_load_config with
+ * RTREE_LOAD_HILBERT, against the Sort-Tile-Recursive build of rtree_load,
+ * and reports the overlap of the nodes of both trees with rtree_overlap.
+ *
+ * The entries are the boxes of the segments of long trajectories, for which
+ * the slabs of Sort-Tile-Recursive gather in a node segments far apart in
+ * time. The overlap and the number of nodes visited by the searches of both
+ * trees are printed for comparison but not asserted.
+ *
+ * Four properties are asserted:
+ *  (i)   the two trees return the same ids for space-time windows;
+ *  (ii)  a parallel Hilbert build is the sequential one, every window
+ *        returning the same ids in the same order;
+ *  (iii) the overlap statistics are consistent, every pair of entries of an
+ *        inner node being counted once;
+ *  (iv)  an unknown load strategy is rejected and leaves the tree empty.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o rtree_hilbert_test rtree_hilbert_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+
+/* Number of trajectories and of segments of a trajectory */
+#define NUM_TRIPS 40
+#define NUM_SEGMENTS 500
+#define NUM_BOXES (NUM_TRIPS * NUM_SEGMENTS)
+/* Number of query windows */
+#define NUM_QUERIES 300
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+static int
+cmp_int64(const void *a, const void *b)
+{
+  int64 x = *(const int64 *) a, y = *(const int64 *) b;
+  return (x > y) - (x < y);
+}
+
+/* Return true if two searches returned the same ids, in the same order when
+ * ordered is true */
+static bool
+same_ids(MeosArray *a, MeosArray *b, bool ordered)
+{
+  int n = meos_array_count(a);
+  if (n != meos_array_count(b))
+    return false;
+  int64 *x = malloc(sizeof(int64) * (n + 1));
+  int64 *y = malloc(sizeof(int64) * (n + 1));
+  for (int i = 0; i < n; i++)
+  {
+    x[i] = *(int64 *) meos_array_get(a, i);
+    y[i] = *(int64 *) meos_array_get(b, i);
+  }
+  if (! ordered)
+  {
+    qsort(x, (size_t) n, sizeof(int64), cmp_int64);
+    qsort(y, (size_t) n, sizeof(int64), cmp_int64);
+  }
+  bool same = memcmp(x, y, sizeof(int64) * n) == 0;
+  free(x);
+  free(y);
+  return same;
+}
+
+/* Print the overlap of the nodes of a tree and the cost of the queries */
+static void
+report(const char *name, const RTree *rtree, STBox **queries)
+{
+  RTreeOverlap stats;
+  rtree_overlap(rtree, &stats);
+  RTreeSearchCost cost;
+  memset(&cost, 0, sizeof(cost));
+  MeosArray *result = meos_array_create(sizeof(int64));
+  for (int q = 0; q < NUM_QUERIES; q++)
+    rtree_search_cost(rtree, RTREE_OVERLAPS, queries[q], result, &cost);
+  meos_array_destroy(result);
+  printf("  %-8s %lld inner nodes, %lld of %lld pairs overlapping, "
+    "overlap %.4f, volume %.4f, %lld nodes visited\n", name,
+    (long long) stats.nodes, (long long) stats.overlapping,
+    (long long) stats.pairs, stats.overlap, stats.volume,
+    (long long) (cost.inner_nodes + cost.leaves));
+}
+
+/* Return a planar box over a span of minutes of January 2000 */
+static STBox *
+minute_box(double xmin, double ymin, double xmax, double ymax, int from,
+  int to)
+{
+  Span *s = tstzspan_make((TimestampTz) from * 60000000,
+    (TimestampTz) to * 60000000, true, true);
+  STBox *result = stbox_make(true, false, false, 0, xmin, xmax, ymin, ymax,
+    0, 0, s);
+  free(s);
+  return result;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The invalid arguments must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  /* The segments of random walks of one minute each */
+  STBox *boxes = malloc(sizeof(STBox) * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  for (int t = 0; t < NUM_TRIPS; t++)
+  {
+    double x = rand() % 1000, y = rand() % 1000;
+    for (int s = 0; s < NUM_SEGMENTS; s++)
+    {
+      double nx = x + rand() % 21 - 10, ny = y + rand() % 21 - 10;
+      STBox *box = minute_box(x < nx ? x : nx, y < ny ? y : ny,
+        x < nx ? nx : x, y < ny ? ny : y, s, s + 1);
+      int i = t * NUM_SEGMENTS + s;
+      boxes[i] = *box;
+      ids[i] = i;
+      free(box);
+      x = nx; y = ny;
+    }
+  }
+  STBox *queries[NUM_QUERIES];
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    int x = rand() % 1000, y = rand() % 1000, m = rand() % NUM_SEGMENTS;
+    queries[q] = minute_box(x, y, x + 50, y + 50, m, m + 30);
+  }
+
+  RTree *str = rtree_create_stbox();
+  rtree_load(str, boxes, ids, NUM_BOXES);
+  RTree *hilbert = rtree_create_stbox();
+  rtree_load_config(hilbert, boxes, ids, NUM_BOXES, RTREE_LOAD_HILBERT, 1);
+
+  /* (i) same answers */
+  MeosArray *expected = meos_array_create(sizeof(int64));
+  MeosArray *result = meos_array_create(sizeof(int64));
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  bool same = true;
+  int hits = 0;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    for (int o = 0; o < 3; o++)
+    {
+      rtree_search(str, ops[o], queries[q], expected);
+      rtree_search(hilbert, ops[o], queries[q], result);
+      same &= same_ids(expected, result, false);
+      hits += meos_array_count(expected);
+    }
+  }
+  check("(i) the Hilbert and STR trees return the same ids", same &&
+    hits > 0);
+
+  /* (ii) parallel build */
+  int nthreads[] = {2, 3};
+  same = true;
+  for (int t = 0; t < 2; t++)
+  {
+    RTree *parallel = rtree_create_stbox();
+    rtree_load_config(parallel, boxes, ids, NUM_BOXES, RTREE_LOAD_HILBERT,
+      nthreads[t]);
+    for (int q = 0; q < NUM_QUERIES; q++)
+    {
+      rtree_search(hilbert, RTREE_OVERLAPS, queries[q], expected);
+      rtree_search(parallel, RTREE_OVERLAPS, queries[q], result);
+      same &= same_ids(expected, result, true);
+    }
+    rtree_free(parallel);
+  }
+  check("(ii) a parallel Hilbert build is the sequential one", same);
+
+  /* (iii) overlap statistics */
+  RTreeOverlap stats;
+  rtree_overlap(hilbert, &stats);
+  check("(iii) the overlap statistics are consistent", stats.nodes > 0 &&
+    stats.overlapping <= stats.pairs && stats.overlap >= 0.0 &&
+    stats.volume > 0.0);
+  report("STR", str, queries);
+  report("Hilbert", hilbert, queries);
+
+  /* (iv) unknown load strategy */
+  RTree *empty = rtree_create_stbox();
+  meos_errno_reset();
+  rtree_load_config(empty, boxes, ids, NUM_BOXES, (RTreeLoad) 7, 1);
+  bool rejected = meos_errno() != 0;
+  meos_errno_reset();
+  rtree_search(empty, RTREE_OVERLAPS, queries[0], result);
+  rtree_overlap(empty, &stats);
+  check("(iv) an unknown load strategy is rejected", rejected &&
+    meos_array_count(result) == 0 && stats.nodes == 0);
+  rtree_free(empty);
+
+  for (int q = 0; q < NUM_QUERIES; q++)
+    free(queries[q]);
+  meos_array_destroy(expected);
+  meos_array_destroy(result);
+  rtree_free(str);
+  rtree_free(hilbert);
+  free(boxes);
+  free(ids);
+
+  printf(failures ? "\nSome Hilbert load tests FAILED.\n" :
+    "\nAll Hilbert load tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -30,7 +30,7 @@
 /**
  * @file
  * @brief A program that tests the join of two in-memory RTree indexes, i.e.,
- * rtree_join, against an exact brute-force oracle.
+ * rtree_join and rtree_join_parallel, against an exact brute-force oracle.
  *
  * The oracle is the public box predicate the join is meant to reproduce --
  * #overlaps_stbox_stbox and #contains_stbox_stbox -- applied to every pair of
@@ -41,12 +41,14 @@
  * one side while the other is still a leaf, and the boxes carry both space and
  * time, so a pair is reported only when it overlaps in every dimension.
  *
- * Four properties are asserted per operation:
+ * Five properties are asserted per operation:
  *  (i)   soundness: every reported pair satisfies the predicate;
  *  (ii)  completeness: every pair satisfying the predicate is reported;
  *  (iii) no duplicates: no pair is reported twice, so a caller counting the
  *        result counts each pair once;
- *  (iv)  count: the number of reported pairs equals the brute-force count.
+ *  (iv)  count: the number of reported pairs equals the brute-force count;
+ *  (v)   parallelism: the parallel join with any number of threads reports
+ *        the pairs of the sequential join in the same order.
  * The degenerate cases of an empty index and of two indexes that share no box
  * are asserted separately.
  *
@@ -115,6 +117,22 @@ random_stbox(double span, double minext, double maxext, int days, int hours)
   return stbox_in(buf);
 }
 
+/* Return true if the parallel join with a number of threads reports the same
+ * ids as the sequential join, in the same order */
+static bool
+same_parallel(const RTree *rtree1, const RTree *rtree2, RTreeSearchOp op,
+  const MeosArray *expected, int nthreads)
+{
+  MeosArray *result = meos_array_create(sizeof(int64));
+  int npairs = rtree_join_parallel(rtree1, rtree2, op, result, nthreads);
+  bool same = (2 * npairs == meos_array_count(expected));
+  for (int k = 0; k < 2 * npairs && same; k++)
+    same = (*(int64 *) meos_array_get(result, k) ==
+      *(int64 *) meos_array_get(expected, k));
+  meos_array_destroy(result);
+  return same;
+}
+
 /* Comparison function sorting id pairs lexicographically */
 static int
 cmp_pair(const void *a, const void *b)
@@ -234,6 +252,14 @@ test_stbox_join(RTreeSearchOp op, const char *opname, int count1, int count2,
   snprintf(name, sizeof(name), "%s: reports no pair twice", opname);
   check(name, distinct);
 
+  bool parallel = true;
+  for (int nthreads = 2; nthreads <= 8 && parallel; nthreads *= 2)
+    parallel = same_parallel(rtree1, rtree2, op, result, nthreads);
+  parallel &= same_parallel(rtree1, rtree2, op, result, 3);
+  snprintf(name, sizeof(name), "%s: the parallel join reports the same",
+    opname);
+  check(name, parallel);
+
   printf("    (%d pairs over %d x %d boxes)\n", npairs, count1, count2);
 
   meos_array_destroy(result);
@@ -260,6 +286,8 @@ test_degenerate(void)
   RTree *empty2 = rtree_create_stbox();
   check("empty joined with empty reports no pair",
     rtree_join(empty1, empty2, RTREE_OVERLAPS, result) == 0);
+  check("empty joined in parallel with empty reports no pair",
+    rtree_join_parallel(empty1, empty2, RTREE_OVERLAPS, result, 4) == 0);
 
   RTree *filled = rtree_create_stbox();
   STBox *box = stbox_in("STBOX XT(((0,0),(1,1)),[2000-01-01, 2000-01-02])");
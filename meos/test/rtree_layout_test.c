@@ -0,0 +1,338 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the per-axis node layout of the in-memory RTree
+ * index, i.e., rtree_create_layout with @p RTREE_LAYOUT_AXES, against the
+ * default layout.
+ *
+ * For integer spans with exclusive bounds and negative values, float spans,
+ * temporal boxes, and spatiotemporal boxes with and without Z, two trees with
+ * the two layouts are filled with the same boxes and their answers compared.
+ * Three properties are asserted per box type:
+ *  (i)   the overlaps, contains, and contained-by searches return the same
+ *        ids, for trees built by insertion and by rtree_load;
+ *  (ii)  the same holds after deleting and moving entries;
+ *  (iii) the same holds for the trees saved into a file and opened again.
+ * Spatiotemporal boxes with and without the space or the time dimension are
+ * also searched, the dimensions that a box lacks being ignored.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o rtree_layout_test rtree_layout_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of boxes inserted into every index */
+#define NUM_BOXES 3000
+/* Number of query boxes */
+#define NUM_QUERIES 200
+
+#define LAYOUT_FILE "rtree_layout_test.rtree"
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Return the last day of a period of a box of a given width */
+static int
+last_day(int day, int w)
+{
+  return day + w / 16 < 28 ? day + w / 16 : 28;
+}
+
+/* Write into buf a random box of a type in text format */
+static void
+random_box_text(MeosType bboxtype, char *buf, size_t size, int extent)
+{
+  int x = random_int(-500, 500), y = random_int(-500, 500);
+  int z = random_int(-500, 500), day = random_int(1, 28);
+  int w = random_int(1, extent);
+  switch (bboxtype)
+  {
+    case T_INTSPAN:
+      /* Both bounds exclusive needs a width of two to be nonempty */
+      snprintf(buf, size, "%c%d,%d%c", rand() % 2 ? '[' : '(', x, x + w + 1,
+        rand() % 2 ? ']' : ')');
+      break;
+    case T_FLOATSPAN:
+      snprintf(buf, size, "%c%d.5,%d.25%c", rand() % 2 ? '[' : '(', x, x + w,
+        rand() % 2 ? ']' : ')');
+      break;
+    case T_TBOX:
+      snprintf(buf, size, "TBOXFLOAT XT([%d,%d],[2000-01-%02d,2000-01-%02d])",
+        x, x + w, day, last_day(day, w));
+      break;
+    default: /* T_STBOX, with Z when extent is odd */
+      if (extent % 2)
+        snprintf(buf, size,
+          "STBOX ZT(((%d,%d,%d),(%d,%d,%d)),[2000-01-%02d,2000-01-%02d])",
+          x, y, z, x + w, y + w, z + w, day, last_day(day, w));
+      else
+        snprintf(buf, size,
+          "STBOX XT(((%d,%d),(%d,%d)),[2000-01-%02d,2000-01-%02d])",
+          x, y, x + w, y + w, day, last_day(day, w));
+      break;
+  }
+  return;
+}
+
+/* Return a random box of a type */
+static void *
+random_box(MeosType bboxtype, int extent)
+{
+  char buf[256];
+  random_box_text(bboxtype, buf, sizeof(buf), extent);
+  if (bboxtype == T_INTSPAN || bboxtype == T_FLOATSPAN)
+    return span_in(buf, bboxtype);
+  if (bboxtype == T_TBOX)
+    return tbox_in(buf);
+  return stbox_in(buf);
+}
+
+static int
+id_cmp(const void *a, const void *b)
+{
+  int64 x = *(const int64 *) a, y = *(const int64 *) b;
+  return (x > y) - (x < y);
+}
+
+/* Return true if the two trees answer every query the same way */
+static bool
+same_answers(const RTree *rtree1, const RTree *rtree2, void **queries)
+{
+  MeosArray *res1 = meos_array_create(sizeof(int64));
+  MeosArray *res2 = meos_array_create(sizeof(int64));
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  bool same = true;
+  for (int q = 0; q < NUM_QUERIES && same; q++)
+  {
+    for (int o = 0; o < 3; o++)
+    {
+      int n1 = rtree_search(rtree1, ops[o], queries[q], res1);
+      int n2 = rtree_search(rtree2, ops[o], queries[q], res2);
+      if (n1 != n2)
+      {
+        same = false;
+        break;
+      }
+      /* The entries are visited in another order with the axes layout */
+      int64 *ids1 = malloc(sizeof(int64) * (n1 + 1));
+      int64 *ids2 = malloc(sizeof(int64) * (n1 + 1));
+      for (int i = 0; i < n1; i++)
+      {
+        ids1[i] = *(int64 *) meos_array_get(res1, i);
+        ids2[i] = *(int64 *) meos_array_get(res2, i);
+      }
+      qsort(ids1, n1, sizeof(int64), id_cmp);
+      qsort(ids2, n1, sizeof(int64), id_cmp);
+      if (memcmp(ids1, ids2, sizeof(int64) * n1) != 0)
+        same = false;
+      free(ids1);
+      free(ids2);
+    }
+  }
+  meos_array_destroy(res1);
+  meos_array_destroy(res2);
+  return same;
+}
+
+static void
+test_type(const char *name, MeosType bboxtype, int extent)
+{
+  printf("%s:\n", name);
+  size_t size = bbox_get_size(bboxtype);
+  char *boxes = malloc(size * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  void *queries[NUM_QUERIES];
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    void *box = random_box(bboxtype, extent);
+    memcpy(boxes + i * size, box, size);
+    free(box);
+    ids[i] = i;
+  }
+  for (int q = 0; q < NUM_QUERIES; q++)
+    queries[q] = random_box(bboxtype, q % 2 ? extent * 4 : extent);
+
+  /* (i) trees built by insertion and by rtree_load */
+  RTree *boxtree = rtree_create_layout(bboxtype, RTREE_LAYOUT_BOXES);
+  RTree *axestree = rtree_create_layout(bboxtype, RTREE_LAYOUT_AXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    rtree_insert(boxtree, boxes + i * size, ids[i]);
+    rtree_insert(axestree, boxes + i * size, ids[i]);
+  }
+  check("(i) the searches agree on trees built by insertion",
+    same_answers(boxtree, axestree, queries));
+  RTree *packed = rtree_create_layout(bboxtype, RTREE_LAYOUT_AXES);
+  rtree_load(packed, boxes, ids, NUM_BOXES);
+  check("(i) the searches agree on trees built by rtree_load",
+    same_answers(boxtree, packed, queries));
+  rtree_free(packed);
+
+  /* (ii) deletions and moves */
+  for (int i = 0; i < NUM_BOXES; i += 3)
+  {
+    rtree_delete(boxtree, boxes + i * size, ids[i]);
+    rtree_delete(axestree, boxes + i * size, ids[i]);
+  }
+  for (int i = 1; i < NUM_BOXES; i += 3)
+  {
+    void *box = random_box(bboxtype, extent);
+    rtree_update(boxtree, boxes + i * size, box, ids[i]);
+    rtree_update(axestree, boxes + i * size, box, ids[i]);
+    free(box);
+  }
+  check("(ii) the searches agree after deletions and moves",
+    same_answers(boxtree, axestree, queries));
+
+  /* (iii) trees saved and opened again */
+  rtree_save(axestree, LAYOUT_FILE);
+  RTree *mapped = rtree_open(LAYOUT_FILE);
+  check("(iii) the searches agree on the opened tree",
+    mapped && same_answers(boxtree, mapped, queries));
+  if (mapped)
+    rtree_free(mapped);
+  remove(LAYOUT_FILE);
+
+  rtree_free(boxtree);
+  rtree_free(axestree);
+  for (int q = 0; q < NUM_QUERIES; q++)
+    free(queries[q]);
+  free(boxes);
+  free(ids);
+  return;
+}
+
+/* Return a random spatiotemporal box with space and time, space only, or time
+ * only */
+static STBox *
+random_mixed_stbox(int kind, int extent)
+{
+  char buf[256];
+  int x = random_int(-500, 500), y = random_int(-500, 500);
+  int day = random_int(1, 28), w = random_int(1, extent);
+  if (kind == 0)
+    snprintf(buf, sizeof(buf),
+      "STBOX XT(((%d,%d),(%d,%d)),[2000-01-%02d,2000-01-%02d])",
+      x, y, x + w, y + w, day, last_day(day, w));
+  else if (kind == 1)
+    snprintf(buf, sizeof(buf), "STBOX X((%d,%d),(%d,%d))", x, y, x + w,
+      y + w);
+  else
+    snprintf(buf, sizeof(buf), "STBOX T([2000-01-%02d,2000-01-%02d])", day,
+      last_day(day, w));
+  return stbox_in(buf);
+}
+
+/* Spatiotemporal boxes with and without the space or the time dimension,
+ * whose missing dimensions are ignored by the predicates */
+static void
+test_mixed(void)
+{
+  printf("Spatiotemporal boxes of mixed dimensions:\n");
+  STBox *boxes = malloc(sizeof(STBox) * NUM_BOXES);
+  void *queries[NUM_QUERIES];
+  RTree *boxtree = rtree_create_layout(T_STBOX, RTREE_LAYOUT_BOXES);
+  RTree *axestree = rtree_create_layout(T_STBOX, RTREE_LAYOUT_AXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    STBox *box = random_mixed_stbox(i % 3, 64);
+    boxes[i] = *box;
+    free(box);
+    rtree_insert(boxtree, &boxes[i], i);
+    rtree_insert(axestree, &boxes[i], i);
+  }
+  for (int q = 0; q < NUM_QUERIES; q++)
+    queries[q] = random_mixed_stbox(0, 256);
+  check("(i) the searches agree on boxes of mixed dimensions",
+    same_answers(boxtree, axestree, queries));
+
+  /* The boxes lacking a dimension of the query are found inside it */
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool found = true;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    int n = rtree_search(axestree, RTREE_CONTAINED_BY, queries[q], result);
+    int expected = 0;
+    for (int i = 0; i < NUM_BOXES; i++)
+      expected += contained_stbox_stbox(&boxes[i], queries[q]);
+    found &= (n == expected);
+  }
+  check("(i) contained-by finds the boxes lacking a dimension", found);
+
+  meos_array_destroy(result);
+  rtree_free(boxtree);
+  rtree_free(axestree);
+  for (int q = 0; q < NUM_QUERIES; q++)
+    free(queries[q]);
+  free(boxes);
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  srand(1);
+
+  test_type("Integer spans", T_INTSPAN, 40);
+  test_type("Float spans", T_FLOATSPAN, 40);
+  test_type("Temporal boxes", T_TBOX, 64);
+  test_type("Spatiotemporal boxes", T_STBOX, 64);
+  test_type("Spatiotemporal boxes with Z", T_STBOX, 129);
+  test_mixed();
+
+  printf(failures ? "\nSome RTree layout tests FAILED.\n" :
+    "\nAll RTree layout tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
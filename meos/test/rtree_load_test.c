@@ -31,14 +31,15 @@
  * @file
  * @brief A program that tests the bulk build of the in-memory RTree index,
  * i.e., rtree_load, against a tree of the same entries built one at a time by
- * rtree_insert.
+ * rtree_insert, and of its multi-threaded variant, rtree_load_parallel,
+ * against rtree_load.
  *
  * rtree_load packs the entries bottom-up by Sort-Tile-Recursive, so the tree it
  * produces has a different shape from one grown by repeated insertion. The
  * shape is free to differ; the answers are not. The insert-built tree is
  * therefore the oracle, and the two trees are required to agree exactly.
  *
- * Five properties are asserted:
+ * Six properties are asserted:
  *  (i)   same answers: over a spread of query windows the two trees return
  *        identical id sets, compared as sorted sequences so that a difference
  *        in traversal order is not mistaken for a difference in results;
@@ -50,7 +51,10 @@
  *  (iv)  the ids survive: they are spread beyond 2^31, so a build carrying them
  *        at a narrower width would return different numbers;
  *  (v)   the degenerate counts are handled: loading no entries leaves a tree
- *        that answers nothing, and loading one returns that one.
+ *        that answers nothing, and loading one returns that one;
+ *  (vi)  a parallel build is the sequential one: whatever the number of
+ *        threads, every window returns the same ids in the same order, which
+ *        only the same tree does, so here the results are NOT sorted.
  *
  * The program can be built as follows
  * @code
@@ -80,6 +84,22 @@ cmp_int64(const void *a, const void *b)
   return (x > y) - (x < y);
 }
 
+/**
+ * @brief Return the ids a tree reports for a query, in traversal order
+ */
+static int64 *
+search_raw(const RTree *rtree, const STBox *query, int *count)
+{
+  MeosArray *result = meos_array_create(sizeof(int64));
+  rtree_search(rtree, RTREE_OVERLAPS, query, result);
+  *count = meos_array_count(result);
+  int64 *ids = malloc(sizeof(int64) * (size_t) (*count ? *count : 1));
+  for (int i = 0; i < *count; i++)
+    ids[i] = *(int64 *) meos_array_get(result, i);
+  meos_array_destroy(result);
+  return ids;
+}
+
 /**
  * @brief Return the ids a tree reports for a query, sorted ascending
  */
@@ -207,6 +227,45 @@ main(void)
     failures++;
   }
   free(s);
+
+  /* (vi) a parallel build is the sequential one, for an even and an odd number
+   * of threads, the latter leaving a run out of every round of merges */
+  int nthreads[] = {2, 3, 4};
+  for (int t = 0; t < 3; t++)
+  {
+    RTree *parallel = rtree_create_stbox();
+    rtree_load_parallel(parallel, boxes, ids, NUM_BOXES, nthreads[t]);
+    int differ = 0;
+    for (int q = 0; q <= NUM_QUERIES; q++)
+    {
+      STBox *query = whole;
+      if (q < NUM_QUERIES)
+      {
+        int x = (q * 13) % 60, y = (q * 5) % 30;
+        snprintf(buf, sizeof(buf),
+          "STBOX XT(((%d,%d),(%d,%d)),[2000-01-01,2000-01-02])", x, y,
+          x + 3, y + 9);
+        query = stbox_in(buf);
+      }
+      int nseq, npar;
+      int64 *sq = search_raw(packed, query, &nseq);
+      int64 *pq = search_raw(parallel, query, &npar);
+      if (nseq != npar ||
+          (nseq && memcmp(sq, pq, sizeof(int64) * (size_t) nseq) != 0))
+        differ++;
+      free(sq);
+      free(pq);
+      if (query != whole)
+        free(query);
+    }
+    if (differ)
+    {
+      printf("rtree_load_parallel: with %d threads %d windows answered "
+        "differently from rtree_load\n", nthreads[t], differ);
+      failures++;
+    }
+    rtree_free(parallel);
+  }
   free(whole);
 
   rtree_free(grown);
@@ -0,0 +1,235 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the nearest-neighbour cursors of the in-memory
+ * RTree index that rank the ids by an exact distance, i.e.,
+ * rtree_nn_cursor_open_refine and rtree_nn_cursor_open_tgeo, against the
+ * nearest approach distance of every trip computed by brute force.
+ *
+ * Trips of temporal points are indexed by their boxes, some of them outside
+ * the time frame of the queries. Four properties are asserted:
+ *  (i)   the cursor yields every id once, by nondecreasing distance, each with
+ *        its nearest approach distance to the query trip, infinite for the
+ *        trips outside its time frame, so that the first k ids are the true
+ *        k nearest trips;
+ *  (ii)  the exact distance is computed for a fraction of the trips only when
+ *        k ids are read;
+ *  (iii) a refine function returning the box distance yields the ids at the
+ *        distances of the plain cursor;
+ *  (iv)  a query of another type than the index is rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o rtree_nn_refine_test rtree_nn_refine_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of indexed trips */
+#define NUM_TRIPS 2000
+/* Number of query trips */
+#define NUM_QUERIES 10
+/* Number of neighbours read for property (ii) */
+#define K 10
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/**
+ * @brief Return a random trip of three points starting on a day
+ */
+static Temporal *
+random_trip(int day)
+{
+  char buf[256];
+  int x = random_int(0, 1000), y = random_int(0, 1000);
+  snprintf(buf, sizeof(buf),
+    "[POINT(%d %d)@2000-01-%02d, POINT(%d %d)@2000-01-%02d 12:00:00, "
+    "POINT(%d %d)@2000-01-%02d]", x, y, day,
+    x + random_int(-40, 40), y + random_int(-40, 40), day,
+    x + random_int(-80, 80), y + random_int(-80, 80), day + 1);
+  return tgeompoint_in(buf);
+}
+
+/* Trips indexed by the test and number of exact distances computed */
+static Temporal *trips[NUM_TRIPS];
+static int nrefined = 0;
+
+static const Temporal *
+lookup_trip(int64 id, void *arg)
+{
+  (void) arg;
+  nrefined++;
+  return trips[id];
+}
+
+static double
+refine_box(int64 id, void *arg)
+{
+  STBox *box = tspatial_to_stbox(trips[id]);
+  double result = nad_stbox_stbox((const STBox *) arg, box);
+  free(box);
+  return result;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The rejected query must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  RTree *rtree = rtree_create_stbox();
+  for (int i = 0; i < NUM_TRIPS; i++)
+  {
+    /* One trip out of ten is outside the time frame of the queries */
+    trips[i] = random_trip(i % 10 ? 1 : 10);
+    rtree_insert_temporal(rtree, trips[i], i);
+  }
+
+  bool exact = true, complete = true, fraction = true, same_box = true;
+  double *dists = malloc(sizeof(double) * NUM_TRIPS);
+  bool *seen = malloc(sizeof(bool) * NUM_TRIPS);
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    Temporal *query = random_trip(1);
+    for (int i = 0; i < NUM_TRIPS; i++)
+    {
+      /* The cursor reports the trips outside the time frame of the query at
+       * an infinite distance */
+      dists[i] = nad_tgeo_tgeo(query, trips[i]);
+      if (dists[i] == DBL_MAX)
+        dists[i] = INFINITY;
+    }
+
+    /* (i) every id by nondecreasing exact distance */
+    memset(seen, 0, sizeof(bool) * NUM_TRIPS);
+    RTreeNNCursor *cursor = rtree_nn_cursor_open_tgeo(rtree, query,
+      lookup_trip, NULL);
+    if (! cursor)
+    {
+      exact = complete = fraction = false;
+      free(query);
+      continue;
+    }
+    int64 id;
+    double dist, prev = 0.0;
+    int n = 0;
+    while (rtree_nn_cursor_next(cursor, &id, &dist))
+    {
+      if (id < 0 || id >= NUM_TRIPS || seen[id] || dist != dists[id] ||
+          dist < prev)
+        exact = false;
+      else
+        seen[id] = true;
+      prev = dist;
+      n++;
+    }
+    complete &= (n == NUM_TRIPS);
+    rtree_nn_cursor_close(cursor);
+
+    /* (ii) only the candidates of the k nearest trips are refined */
+    nrefined = 0;
+    cursor = rtree_nn_cursor_open_tgeo(rtree, query, lookup_trip, NULL);
+    if (cursor)
+    {
+      for (int k = 0; k < K; k++)
+        rtree_nn_cursor_next(cursor, NULL, NULL);
+      fraction &= (nrefined >= K && nrefined < NUM_TRIPS / 10);
+      rtree_nn_cursor_close(cursor);
+    }
+    else
+      fraction = false;
+
+    /* (iii) refining by the box distance changes nothing */
+    STBox *box = tspatial_to_stbox(query);
+    RTreeNNCursor *plain = rtree_nn_cursor_open(rtree, box);
+    cursor = rtree_nn_cursor_open_refine(rtree, box, refine_box, box);
+    double dist1, dist2;
+    bool more1, more2;
+    do
+    {
+      more1 = rtree_nn_cursor_next(plain, NULL, &dist1);
+      more2 = rtree_nn_cursor_next(cursor, NULL, &dist2);
+      if (more1 != more2 || (more1 && dist1 != dist2))
+        same_box = false;
+    } while (more1 && more2);
+    rtree_nn_cursor_close(plain);
+    rtree_nn_cursor_close(cursor);
+    free(box);
+    free(query);
+  }
+  free(dists);
+  free(seen);
+
+  printf("Nearest neighbours by exact distance:\n");
+  check("(i) every id once by nondecreasing exact distance", exact);
+  check("(i) the cursor yields every id", complete);
+  check("(ii) the k nearest refine a fraction of the trips", fraction);
+  check("(iii) refining by the box distance changes nothing", same_box);
+
+  /* (iv) a temporal number on an index of spatiotemporal boxes */
+  Temporal *tnum = tfloat_in("[1@2000-01-01, 2@2000-01-02]");
+  check("(iv) a temporal number query is rejected",
+    rtree_nn_cursor_open_tgeo(rtree, tnum, lookup_trip, NULL) == NULL);
+  free(tnum);
+
+  rtree_free(rtree);
+  for (int i = 0; i < NUM_TRIPS; i++)
+    free(trips[i]);
+  printf(failures ? "\nSome nearest-neighbour refinement tests FAILED.\n" :
+    "\nAll nearest-neighbour refinement tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
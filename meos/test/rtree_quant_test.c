@@ -0,0 +1,318 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the quantized node layouts of the in-memory
+ * RTree index, i.e., rtree_create_layout with @p RTREE_LAYOUT_QUANT8 and
+ * @p RTREE_LAYOUT_QUANT16, against an exact tree.
+ *
+ * For integer spans, float spans, temporal boxes, and spatiotemporal boxes
+ * with and without Z, trees with the three layouts are built by rtree_load
+ * from the same boxes. Four properties are asserted per box type and
+ * quantized layout:
+ *  (i)   the overlaps, contains, and contained-by searches return every id
+ *        the exact tree returns, with few extra candidates, and so does the
+ *        search cursor;
+ *  (ii)  the tree saved into a file is several times smaller than the exact
+ *        one, and the tree opened again returns the same candidates;
+ *  (iii) the tree cannot be modified.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o rtree_quant_test rtree_quant_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of boxes loaded into every index */
+#define NUM_BOXES 5000
+/* Number of query boxes */
+#define NUM_QUERIES 200
+
+#define EXACT_FILE "rtree_quant_test.exact.rtree"
+#define QUANT_FILE "rtree_quant_test.quant.rtree"
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Return the last day of a period of a box of a given width */
+static int
+last_day(int day, int w)
+{
+  return day + w / 16 < 28 ? day + w / 16 : 28;
+}
+
+/* Return a random box of a type */
+static void *
+random_box(MeosType bboxtype, int extent)
+{
+  char buf[256];
+  int x = random_int(-500, 500), y = random_int(-500, 500);
+  int z = random_int(-500, 500), day = random_int(1, 28);
+  int w = random_int(1, extent);
+  switch (bboxtype)
+  {
+    case T_INTSPAN:
+      snprintf(buf, sizeof(buf), "[%d,%d]", x, x + w);
+      return span_in(buf, bboxtype);
+    case T_FLOATSPAN:
+      snprintf(buf, sizeof(buf), "[%d.5,%d.25]", x, x + w);
+      return span_in(buf, bboxtype);
+    case T_TBOX:
+      snprintf(buf, sizeof(buf),
+        "TBOXFLOAT XT([%d,%d],[2000-01-%02d,2000-01-%02d])",
+        x, x + w, day, last_day(day, w));
+      return tbox_in(buf);
+    default: /* T_STBOX, with Z when extent is odd */
+      if (extent % 2)
+        snprintf(buf, sizeof(buf),
+          "STBOX ZT(((%d,%d,%d),(%d,%d,%d)),[2000-01-%02d,2000-01-%02d])",
+          x, y, z, x + w, y + w, z + w, day, last_day(day, w));
+      else
+        snprintf(buf, sizeof(buf),
+          "STBOX XT(((%d,%d),(%d,%d)),[2000-01-%02d,2000-01-%02d])",
+          x, y, x + w, y + w, day, last_day(day, w));
+      return stbox_in(buf);
+  }
+}
+
+static int
+id_cmp(const void *a, const void *b)
+{
+  int64 x = *(const int64 *) a, y = *(const int64 *) b;
+  return (x > y) - (x < y);
+}
+
+/* Sort the ids of an array in place */
+static void
+sort_ids(MeosArray *ids)
+{
+  int count = meos_array_count(ids);
+  if (count > 1)
+    qsort(meos_array_get(ids, 0), count, sizeof(int64), id_cmp);
+}
+
+/* Return true if every id of the sorted array sub is in the sorted array sup */
+static bool
+subset_ids(MeosArray *sub, MeosArray *sup)
+{
+  int n = meos_array_count(sub), m = meos_array_count(sup), j = 0;
+  for (int i = 0; i < n; i++)
+  {
+    int64 id = *(int64 *) meos_array_get(sub, i);
+    while (j < m && *(int64 *) meos_array_get(sup, j) < id)
+      j++;
+    if (j == m || *(int64 *) meos_array_get(sup, j) != id)
+      return false;
+  }
+  return true;
+}
+
+/* Return true if the two sorted arrays have the same ids */
+static bool
+same_ids(MeosArray *ids1, MeosArray *ids2)
+{
+  return meos_array_count(ids1) == meos_array_count(ids2) &&
+    subset_ids(ids1, ids2);
+}
+
+/* Return the size of a file */
+static long
+file_size(const char *filename)
+{
+  FILE *file = fopen(filename, "rb");
+  if (! file)
+    return -1;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+static void
+test_layout(const char *name, MeosType bboxtype, RTreeLayout layout,
+  const RTree *exact, const char *boxes, const int64 *ids, void **queries,
+  double maxratio)
+{
+  printf("%s:\n", name);
+  RTree *quant = rtree_create_layout(bboxtype, layout);
+  rtree_load(quant, boxes, ids, NUM_BOXES);
+
+  /* (i) searches and search cursor */
+  MeosArray *expected = meos_array_create(sizeof(int64));
+  MeosArray *result = meos_array_create(sizeof(int64));
+  MeosArray *cursor_ids = meos_array_create(sizeof(int64));
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  bool superset = true, cursor_same = true;
+  long nexact = 0, ncand = 0;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    for (int o = 0; o < 3; o++)
+    {
+      nexact += rtree_search(exact, ops[o], queries[q], expected);
+      ncand += rtree_search(quant, ops[o], queries[q], result);
+      sort_ids(expected);
+      sort_ids(result);
+      superset &= subset_ids(expected, result);
+      meos_array_reset(cursor_ids);
+      RTreeSearchCursor *cursor = rtree_search_cursor_open(quant, ops[o],
+        queries[q]);
+      int64 id;
+      while (rtree_search_cursor_next(cursor, &id))
+        meos_array_add(cursor_ids, &id);
+      rtree_search_cursor_close(cursor);
+      sort_ids(cursor_ids);
+      cursor_same &= same_ids(result, cursor_ids);
+    }
+  }
+  check("(i) the candidates contain the exact answers", superset);
+  printf("  %ld exact answers, %ld candidates\n", nexact, ncand);
+  check("(i) the extra candidates are few",
+    ncand <= (long) (nexact * maxratio) + NUM_QUERIES);
+  check("(i) the search cursor returns the same candidates", cursor_same);
+
+  /* (ii) size of the saved trees and opened tree */
+  rtree_save(exact, EXACT_FILE);
+  rtree_save(quant, QUANT_FILE);
+  long exact_size = file_size(EXACT_FILE), quant_size = file_size(QUANT_FILE);
+  printf("  %.1f bytes per entry instead of %.1f\n",
+    (double) quant_size / NUM_BOXES, (double) exact_size / NUM_BOXES);
+  check("(ii) the tree is at least twice smaller",
+    quant_size > 0 && 2 * quant_size < exact_size);
+  RTree *mapped = rtree_open(QUANT_FILE);
+  bool same = (mapped != NULL);
+  for (int q = 0; q < NUM_QUERIES && same; q++)
+  {
+    rtree_search(quant, RTREE_OVERLAPS, queries[q], expected);
+    rtree_search(mapped, RTREE_OVERLAPS, queries[q], result);
+    sort_ids(expected);
+    sort_ids(result);
+    same = same_ids(expected, result);
+  }
+  check("(ii) the opened tree returns the same candidates", same);
+  if (mapped)
+    rtree_free(mapped);
+  remove(EXACT_FILE);
+  remove(QUANT_FILE);
+
+  /* (iii) the tree is read-only */
+  meos_errno_reset();
+  rtree_insert(quant, (void *) boxes, 0);
+  bool rejected = meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= ! rtree_delete(quant, boxes, ids[0]) && meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= rtree_nn_cursor_open(quant, boxes) == NULL;
+  meos_errno_reset();
+  rtree_search(quant, RTREE_CONTAINS, boxes, result);
+  check("(iii) the tree cannot be modified",
+    rejected && meos_array_count(result) > 0);
+
+  meos_array_destroy(expected);
+  meos_array_destroy(result);
+  meos_array_destroy(cursor_ids);
+  rtree_free(quant);
+  return;
+}
+
+static void
+test_type(const char *name, MeosType bboxtype, int extent)
+{
+  size_t size = bbox_get_size(bboxtype);
+  char *boxes = malloc(size * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  void *queries[NUM_QUERIES];
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    void *box = random_box(bboxtype, extent);
+    memcpy(boxes + i * size, box, size);
+    free(box);
+    ids[i] = i;
+  }
+  for (int q = 0; q < NUM_QUERIES; q++)
+    queries[q] = random_box(bboxtype, q % 2 ? extent * 4 : extent);
+
+  RTree *exact = rtree_create(bboxtype);
+  rtree_load(exact, boxes, ids, NUM_BOXES);
+  char title[128];
+  snprintf(title, sizeof(title), "%s, 8-bit codes", name);
+  test_layout(title, bboxtype, RTREE_LAYOUT_QUANT8, exact, boxes, ids,
+    queries, 1.5);
+  snprintf(title, sizeof(title), "%s, 16-bit codes", name);
+  test_layout(title, bboxtype, RTREE_LAYOUT_QUANT16, exact, boxes, ids,
+    queries, 1.1);
+
+  rtree_free(exact);
+  for (int q = 0; q < NUM_QUERIES; q++)
+    free(queries[q]);
+  free(boxes);
+  free(ids);
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The rejected modifications of a quantized tree raise errors */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  test_type("Integer spans", T_INTSPAN, 40);
+  test_type("Float spans", T_FLOATSPAN, 40);
+  test_type("Temporal boxes", T_TBOX, 64);
+  test_type("Spatiotemporal boxes", T_STBOX, 64);
+  test_type("Spatiotemporal boxes with Z", T_STBOX, 129);
+
+  printf(failures ? "\nSome RTree quantization tests FAILED.\n" :
+    "\nAll RTree quantization tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
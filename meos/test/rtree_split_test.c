@@ -0,0 +1,339 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the node capacities and split algorithms of the
+ * in-memory RTree index, i.e., rtree_create_config, against an exact
+ * brute-force oracle, and that prints the cost of the searches measured by
+ * rtree_search_cost for every configuration.
+ *
+ * Four properties are asserted per configuration:
+ *  (i)   every window returns exactly the entries it overlaps, for a tree
+ *        built by insertion, which splits nodes, and by rtree_load;
+ *  (ii)  the same holds after deleting and moving entries;
+ *  (iii) the cost reports as many results as the searches return and visits
+ *        at least one leaf per nonempty answer;
+ *  (iv)  the tree saved into a file and opened again returns the same ids.
+ * Capacities out of range are rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o rtree_split_test rtree_split_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+#if POINTCLOUD
+#include <meos_pointcloud.h>
+#endif
+
+/* Number of entries */
+#define NUM_BOXES 4000
+/* Number of query windows compared against the oracle */
+#define NUM_QUERIES 100
+
+#define SPLIT_FILE "rtree_split_test.rtree"
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/**
+ * @brief Return a spatiotemporal box at a position
+ */
+static STBox *
+make_box(double x, double y, double w, int day)
+{
+  char buf[256];
+  snprintf(buf, sizeof(buf),
+    "STBOX XT(((%.3f,%.3f),(%.3f,%.3f)),[2000-01-%02d,2000-01-%02d])",
+    x, y, x + w, y + w, day, day + 1);
+  return stbox_in(buf);
+}
+
+/**
+ * @brief Return the query window number q
+ */
+static STBox *
+make_query(int q)
+{
+  return make_box((q * 37) % 1000, (q * 91) % 1000, 20 + q % 60, 1 + q % 20);
+}
+
+/**
+ * @brief Return true if the tree answers every query window exactly as the
+ * oracle over the live entries, adding the cost of the searches to @p cost
+ */
+static bool
+matches_oracle(const RTree *rtree, const STBox *boxes, const bool *live,
+  RTreeSearchCost *cost)
+{
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool *seen = malloc(sizeof(bool) * NUM_BOXES);
+  bool ok = true;
+  for (int q = 0; q < NUM_QUERIES && ok; q++)
+  {
+    STBox *query = make_query(q);
+    memset(seen, 0, sizeof(bool) * NUM_BOXES);
+    int n = rtree_search_cost(rtree, RTREE_OVERLAPS, query, result, cost);
+    for (int i = 0; i < n; i++)
+    {
+      int64 id = *(int64 *) meos_array_get(result, i);
+      if (id < 0 || id >= NUM_BOXES || ! live[id] || seen[id] ||
+          ! overlaps_stbox_stbox(&boxes[id], query))
+        ok = false;
+      else
+        seen[id] = true;
+    }
+    for (int i = 0; i < NUM_BOXES; i++)
+      if (live[i] && ! seen[i] && overlaps_stbox_stbox(&boxes[i], query))
+        ok = false;
+    free(query);
+  }
+  free(seen);
+  meos_array_destroy(result);
+  return ok;
+}
+
+/**
+ * @brief Return true if two trees return the same ids in the same order
+ */
+static bool
+same_answers(const RTree *rtree1, const RTree *rtree2)
+{
+  MeosArray *res1 = meos_array_create(sizeof(int64));
+  MeosArray *res2 = meos_array_create(sizeof(int64));
+  bool same = true;
+  for (int q = 0; q < NUM_QUERIES && same; q++)
+  {
+    STBox *query = make_query(q);
+    int n = rtree_search(rtree1, RTREE_OVERLAPS, query, res1);
+    same = (n == rtree_search(rtree2, RTREE_OVERLAPS, query, res2));
+    for (int i = 0; i < n && same; i++)
+      same = (*(int64 *) meos_array_get(res1, i) ==
+        *(int64 *) meos_array_get(res2, i));
+    free(query);
+  }
+  meos_array_destroy(res1);
+  meos_array_destroy(res2);
+  return same;
+}
+
+static void
+test_config(const char *name, int capacity, RTreeSplit split,
+  const STBox *orig, const int64 *ids)
+{
+  char buf[128];
+  STBox *boxes = malloc(sizeof(STBox) * NUM_BOXES);
+  bool *live = malloc(sizeof(bool) * NUM_BOXES);
+  memcpy(boxes, orig, sizeof(STBox) * NUM_BOXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+    live[i] = true;
+
+  /* (i) built by insertion and by rtree_load */
+  RTree *rtree = rtree_create_config(T_STBOX, RTREE_LAYOUT_BOXES, capacity,
+    split);
+  for (int i = 0; i < NUM_BOXES; i++)
+    rtree_insert(rtree, &boxes[i], ids[i]);
+  RTreeSearchCost cost;
+  memset(&cost, 0, sizeof(cost));
+  snprintf(buf, sizeof(buf), "(i) %s, capacity %d: insertion", name, capacity);
+  check(buf, matches_oracle(rtree, boxes, live, &cost));
+  printf("      cost: %lld inner nodes, %lld leaves, %lld entries, "
+    "%lld results\n", (long long) cost.inner_nodes, (long long) cost.leaves,
+    (long long) cost.entries, (long long) cost.results);
+
+  /* (iii) consistency of the cost */
+  MeosArray *result = meos_array_create(sizeof(int64));
+  int64 total = 0, nonempty = 0;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    STBox *query = make_query(q);
+    int n = rtree_search(rtree, RTREE_OVERLAPS, query, result);
+    total += n;
+    nonempty += (n > 0);
+    free(query);
+  }
+  meos_array_destroy(result);
+  snprintf(buf, sizeof(buf), "(iii) %s, capacity %d: cost", name, capacity);
+  check(buf, cost.results == total && cost.leaves >= nonempty &&
+    cost.entries >= cost.results);
+
+  RTree *packed = rtree_create_config(T_STBOX, RTREE_LAYOUT_BOXES, capacity,
+    split);
+  rtree_load(packed, boxes, ids, NUM_BOXES);
+  snprintf(buf, sizeof(buf), "(i) %s, capacity %d: rtree_load", name,
+    capacity);
+  check(buf, matches_oracle(packed, boxes, live, NULL));
+  rtree_free(packed);
+
+  /* (ii) delete and move entries */
+  for (int i = 0; i < NUM_BOXES; i += 3)
+  {
+    rtree_delete(rtree, &boxes[i], ids[i]);
+    live[i] = false;
+  }
+  for (int i = 1; i < NUM_BOXES; i += 3)
+  {
+    STBox *moved = make_box(boxes[i].xmin + (i % 2 ? 0.5 : 250.0),
+      boxes[i].ymin, 3.0, 1 + i % 25);
+    rtree_update(rtree, &boxes[i], moved, ids[i]);
+    memcpy(&boxes[i], moved, sizeof(STBox));
+    free(moved);
+  }
+  snprintf(buf, sizeof(buf), "(ii) %s, capacity %d: deletions and moves",
+    name, capacity);
+  check(buf, matches_oracle(rtree, boxes, live, NULL));
+
+  /* (iv) saved and opened again */
+  rtree_save(rtree, SPLIT_FILE);
+  RTree *mapped = rtree_open(SPLIT_FILE);
+  snprintf(buf, sizeof(buf), "(iv) %s, capacity %d: opened tree", name,
+    capacity);
+  check(buf, mapped && same_answers(rtree, mapped));
+  if (mapped)
+    rtree_free(mapped);
+  remove(SPLIT_FILE);
+
+  rtree_free(rtree);
+  free(boxes);
+  free(live);
+  return;
+}
+
+#if POINTCLOUD
+/**
+ * @brief Return true if a tree of pointcloud boxes split with the linear
+ * algorithm answers every query window exactly as the oracle
+ * @details A pointcloud box is larger than a spatiotemporal box, which the
+ * buffers of the split must hold
+ */
+static bool
+test_tpcbox_linear(void)
+{
+  TPCBox **boxes = malloc(sizeof(TPCBox *) * NUM_BOXES);
+  RTree *rtree = rtree_create_config(T_TPCBOX, RTREE_LAYOUT_BOXES, 4,
+    RTREE_SPLIT_LINEAR);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    double x = rand() % 1000, y = rand() % 1000;
+    TimestampTz t = (TimestampTz) (rand() % 1000) * 60000000;
+    Span *p = tstzspan_make(t, t + 60000000, true, true);
+    boxes[i] = tpcbox_make(true, false, true, false, 0, 1, x, x + 5, y, y + 5,
+      0, 0, p);
+    free(p);
+    rtree_insert(rtree, boxes[i], i);
+  }
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool ok = true;
+  for (int q = 0; q < NUM_QUERIES && ok; q++)
+  {
+    double x = (q * 37) % 1000, y = (q * 91) % 1000;
+    Span *p = tstzspan_make(0, (TimestampTz) 1000 * 60000000, true, true);
+    TPCBox *query = tpcbox_make(true, false, true, false, 0, 1, x, x + 50, y,
+      y + 50, 0, 0, p);
+    free(p);
+    int n = rtree_search(rtree, RTREE_OVERLAPS, query, result);
+    int expected = 0;
+    for (int i = 0; i < NUM_BOXES; i++)
+      expected += overlaps_tpcbox_tpcbox(boxes[i], query);
+    ok = (n == expected);
+    free(query);
+  }
+  meos_array_destroy(result);
+  rtree_free(rtree);
+  for (int i = 0; i < NUM_BOXES; i++)
+    free(boxes[i]);
+  free(boxes);
+  return ok;
+}
+#endif /* POINTCLOUD */
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The rejected capacities must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  STBox *boxes = malloc(sizeof(STBox) * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    /* Clustered boxes, as the positions of a fleet */
+    int cluster = rand() % 20;
+    STBox *box = make_box((cluster * 47) % 1000 + rand() % 80,
+      (cluster * 71) % 1000 + rand() % 80, 1 + rand() % 5, 1 + rand() % 25);
+    memcpy(&boxes[i], box, sizeof(STBox));
+    free(box);
+    ids[i] = i;
+  }
+
+  const char *names[] = {"largest axis", "R*-tree", "linear"};
+  RTreeSplit splits[] = {RTREE_SPLIT_LARGEST_AXIS, RTREE_SPLIT_RSTAR,
+    RTREE_SPLIT_LINEAR};
+  int capacities[] = {4, 16, 64};
+  for (int s = 0; s < 3; s++)
+  {
+    printf("Split algorithm %s:\n", names[s]);
+    for (int c = 0; c < 3; c++)
+      test_config(names[s], capacities[c], splits[s], boxes, ids);
+  }
+
+#if POINTCLOUD
+  printf("Pointcloud boxes:\n");
+  check("(i) the linear split of pointcloud boxes", test_tpcbox_linear());
+#endif
+
+  printf("Capacities out of range:\n");
+  check("a capacity of 3 is rejected", ! rtree_create_config(T_STBOX,
+    RTREE_LAYOUT_BOXES, 3, RTREE_SPLIT_RSTAR));
+  check("a capacity of 65 is rejected", ! rtree_create_config(T_STBOX,
+    RTREE_LAYOUT_BOXES, 65, RTREE_SPLIT_RSTAR));
+
+  free(boxes);
+  free(ids);
+  printf(failures ? "\nSome split RTree tests FAILED.\n" :
+    "\nAll split RTree tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
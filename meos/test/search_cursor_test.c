@@ -0,0 +1,279 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the search cursors of the in-memory RTree and
+ * SPTree indexes, i.e., rtree_search_cursor_* and sptree_search_cursor_*,
+ * against the materializing searches rtree_search and sptree_search.
+ *
+ * For RTrees with both node layouts and opened from a file, and for
+ * quad-trees and k-d trees, three properties are asserted per operation:
+ *  (i)   the cursor yields the ids of the search, in the same order;
+ *  (ii)  a cursor closed after a few ids yields a prefix of the search;
+ *  (iii) a cursor over an empty tree yields nothing.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o search_cursor_test search_cursor_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of boxes inserted into every index */
+#define NUM_BOXES 5000
+/* Number of query windows */
+#define NUM_QUERIES 60
+/* Number of ids read before closing a cursor early */
+#define LIMIT 10
+
+#define CURSOR_FILE "search_cursor_test.rtree"
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/**
+ * @brief Return a spatiotemporal box at a position
+ */
+static STBox *
+make_box(int x, int y, int w, int day)
+{
+  char buf[256];
+  snprintf(buf, sizeof(buf),
+    "STBOX XT(((%d,%d),(%d,%d)),[2000-01-%02d,2000-01-%02d])",
+    x, y, x + w, y + w, day, day + 1 + w / 40);
+  return stbox_in(buf);
+}
+
+/**
+ * @brief Return the query window number q
+ */
+static STBox *
+make_query(int q)
+{
+  return make_box((q * 37) % 900, (q * 53) % 900, 30 + (q * 7) % 90,
+    1 + q % 20);
+}
+
+/* Search functions common to both index types */
+typedef int (*search_fn)(const void *index, RTreeSearchOp op,
+  const void *query, MeosArray *result);
+typedef void *(*open_fn)(const void *index, RTreeSearchOp op,
+  const void *query);
+typedef bool (*next_fn)(void *cursor, int64 *id);
+typedef void (*close_fn)(void *cursor);
+
+static int
+rtree_search_fn(const void *index, RTreeSearchOp op, const void *query,
+  MeosArray *result)
+{
+  return rtree_search((const RTree *) index, op, query, result);
+}
+static void *
+rtree_open_fn(const void *index, RTreeSearchOp op, const void *query)
+{
+  return rtree_search_cursor_open((const RTree *) index, op, query);
+}
+static bool
+rtree_next_fn(void *cursor, int64 *id)
+{
+  return rtree_search_cursor_next((RTreeSearchCursor *) cursor, id);
+}
+static void
+rtree_close_fn(void *cursor)
+{
+  rtree_search_cursor_close((RTreeSearchCursor *) cursor);
+}
+
+static int
+sptree_search_fn(const void *index, RTreeSearchOp op, const void *query,
+  MeosArray *result)
+{
+  return sptree_search((const SPTree *) index, op, query, result);
+}
+static void *
+sptree_open_fn(const void *index, RTreeSearchOp op, const void *query)
+{
+  return sptree_search_cursor_open((const SPTree *) index, op, query);
+}
+static bool
+sptree_next_fn(void *cursor, int64 *id)
+{
+  return sptree_search_cursor_next((SPSearchCursor *) cursor, id);
+}
+static void
+sptree_close_fn(void *cursor)
+{
+  sptree_search_cursor_close((SPSearchCursor *) cursor);
+}
+
+/**
+ * @brief Compare the cursor of an index with its search on every query
+ */
+static void
+test_index(const char *name, const void *index, search_fn search,
+  open_fn open, next_fn next, close_fn close)
+{
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  const char *opnames[] = {"overlaps", "contains", "contained by"};
+  MeosArray *result = meos_array_create(sizeof(int64));
+  char label[128];
+  for (int o = 0; o < 3; o++)
+  {
+    bool same = true, prefix = true;
+    int64 total = 0;
+    for (int q = 0; q < NUM_QUERIES; q++)
+    {
+      STBox *query = make_query(q);
+      /* A small query inside a large box for the contains operation */
+      if (ops[o] == RTREE_CONTAINS)
+        query->xmax = query->xmin + 1, query->ymax = query->ymin + 1;
+      int n = search(index, ops[o], query, result);
+      total += n;
+
+      /* (i) the whole sequence */
+      void *cursor = open(index, ops[o], query);
+      int64 id;
+      int k = 0;
+      while (next(cursor, &id))
+      {
+        if (k >= n || id != *(int64 *) meos_array_get(result, k))
+          same = false;
+        k++;
+      }
+      same &= (k == n);
+      /* Once exhausted the cursor stays exhausted */
+      same &= ! next(cursor, &id);
+      close(cursor);
+
+      /* (ii) early termination */
+      cursor = open(index, ops[o], query);
+      for (k = 0; k < LIMIT && next(cursor, &id); k++)
+        prefix &= (id == *(int64 *) meos_array_get(result, k));
+      prefix &= (k == (n < LIMIT ? n : LIMIT));
+      close(cursor);
+      free(query);
+    }
+    snprintf(label, sizeof(label), "(i) %s, %s: same ids in the same order",
+      name, opnames[o]);
+    check(label, same && total > 0);
+    snprintf(label, sizeof(label), "(ii) %s, %s: early termination", name,
+      opnames[o]);
+    check(label, prefix);
+  }
+  meos_array_destroy(result);
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  srand(1);
+
+  STBox **boxes = malloc(sizeof(STBox *) * NUM_BOXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+    boxes[i] = make_box(rand() % 1000, rand() % 1000, 1 + rand() % 60,
+      1 + rand() % 25);
+
+  /* RTrees */
+  RTree *rtree = rtree_create_stbox();
+  for (int i = 0; i < NUM_BOXES; i++)
+    rtree_insert(rtree, boxes[i], i);
+  printf("RTree:\n");
+  test_index("rtree", rtree, rtree_search_fn, rtree_open_fn, rtree_next_fn,
+    rtree_close_fn);
+  rtree_save(rtree, CURSOR_FILE);
+  RTree *mapped = rtree_open(CURSOR_FILE);
+  printf("RTree opened from a file:\n");
+  test_index("mapped", mapped, rtree_search_fn, rtree_open_fn, rtree_next_fn,
+    rtree_close_fn);
+  rtree_free(mapped);
+  remove(CURSOR_FILE);
+  rtree_free(rtree);
+  RTree *axes = rtree_create_layout(T_STBOX, RTREE_LAYOUT_AXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+    rtree_insert(axes, boxes[i], i);
+  printf("RTree with the per-axis layout:\n");
+  test_index("axes", axes, rtree_search_fn, rtree_open_fn, rtree_next_fn,
+    rtree_close_fn);
+  rtree_free(axes);
+
+  /* SPTrees */
+  SPTreeKind kinds[] = {SPTREE_QUADTREE, SPTREE_KDTREE};
+  const char *kindnames[] = {"quad-tree", "k-d tree"};
+  for (int k = 0; k < 2; k++)
+  {
+    SPTree *sptree = sptree_create_stbox(kinds[k]);
+    for (int i = 0; i < NUM_BOXES; i++)
+      sptree_insert(sptree, boxes[i], i);
+    printf("SPTree %s:\n", kindnames[k]);
+    test_index(kindnames[k], sptree, sptree_search_fn, sptree_open_fn,
+      sptree_next_fn, sptree_close_fn);
+    sptree_free(sptree);
+  }
+
+  /* (iii) empty trees */
+  printf("Empty trees:\n");
+  RTree *rempty = rtree_create_stbox();
+  SPTree *spempty = sptree_create_stbox(SPTREE_QUADTREE);
+  RTreeSearchCursor *rcursor = rtree_search_cursor_open(rempty,
+    RTREE_OVERLAPS, boxes[0]);
+  SPSearchCursor *spcursor = sptree_search_cursor_open(spempty,
+    RTREE_OVERLAPS, boxes[0]);
+  check("(iii) a cursor over an empty RTree yields nothing",
+    ! rtree_search_cursor_next(rcursor, NULL));
+  check("(iii) a cursor over an empty SPTree yields nothing",
+    ! sptree_search_cursor_next(spcursor, NULL));
+  rtree_search_cursor_close(rcursor);
+  sptree_search_cursor_close(spcursor);
+  rtree_free(rempty);
+  sptree_free(spempty);
+
+  for (int i = 0; i < NUM_BOXES; i++)
+    free(boxes[i]);
+  free(boxes);
+  printf(failures ? "\nSome search cursor tests FAILED.\n" :
+    "\nAll search cursor tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
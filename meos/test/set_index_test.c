@@ -0,0 +1,219 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the in-memory inverted index for sets, i.e.,
+ * setindex_insert and setindex_search, against a linear scan of the sets.
+ *
+ * Four properties are asserted:
+ *  (i)   the overlaps, contains, and contained-by searches on integer sets
+ *        return the ids of the sets satisfying overlaps_set_set,
+ *        contains_set_set, and contained_set_set, in the order of insertion,
+ *        including for elements whose posting lists span several blocks;
+ *  (ii)  the same holds for text sets;
+ *  (iii) a query with elements missing from the index answers consistently;
+ *  (iv)  an empty index answers nothing and sets of another type are
+ *        rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o set_index_test set_index_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_internal.h>
+
+/* Number of sets of the index */
+#define NUM_SETS 4000
+/* Number of query sets */
+#define NUM_QUERIES 300
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Return a random set of at most maxcount elements, drawn from a small range
+ * of frequent elements for one element in two so that their posting lists
+ * span several blocks, and quoted when text is true */
+static Set *
+random_set(int maxcount, int range, bool text)
+{
+  char buf[2048];
+  int len = snprintf(buf, sizeof(buf), "{");
+  int count = random_int(1, maxcount);
+  for (int i = 0; i < count; i++)
+  {
+    int value = rand() % 2 ? random_int(0, 9) : random_int(0, range);
+    len += snprintf(buf + len, sizeof(buf) - len, text ? "%s\"v%d\"" : "%s%d",
+      i ? "," : "", value);
+  }
+  snprintf(buf + len, sizeof(buf) - len, "}");
+  return text ? textset_in(buf) : bigintset_in(buf);
+}
+
+/* Compare the index with a linear scan of the sets for every query and
+ * search operation */
+static bool
+same_as_scan(const SetIndex *sindex, Set **sets, Set **queries,
+  MeosArray *result)
+{
+  bool (*preds[])(const Set *, const Set *) =
+    {overlaps_set_set, contains_set_set, contained_set_set};
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    for (int o = 0; o < 3; o++)
+    {
+      int n = setindex_search(sindex, ops[o], queries[q], result);
+      if (n != meos_array_count(result))
+        return false;
+      int k = 0;
+      for (int i = 0; i < NUM_SETS; i++)
+      {
+        if (! preds[o](sets[i], queries[q]))
+          continue;
+        if (k >= n || *(int64 *) meos_array_get(result, k) != 1000 + i)
+          return false;
+        k++;
+      }
+      if (k != n)
+        return false;
+    }
+  }
+  return true;
+}
+
+/* Build an index of random sets and compare it with a linear scan */
+static bool
+test_sets(bool text, MeosArray *result)
+{
+  Set **sets = malloc(sizeof(Set *) * NUM_SETS);
+  Set *queries[NUM_QUERIES];
+  SetIndex *sindex = setindex_create();
+  bool ok = true;
+  for (int i = 0; i < NUM_SETS; i++)
+  {
+    sets[i] = random_set(8, 200, text);
+    ok &= setindex_insert(sindex, sets[i], 1000 + i);
+  }
+  ok &= setindex_count(sindex) == NUM_SETS;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    /* One query in three is a set of the index, the others are small sets
+     * or large sets of the frequent elements */
+    queries[q] = (q % 3) ? random_set(q % 2 ? 2 : 40, q % 2 ? 200 : 10, text) :
+      set_copy(sets[rand() % NUM_SETS]);
+  }
+  ok &= same_as_scan(sindex, sets, queries, result);
+  for (int q = 0; q < NUM_QUERIES; q++)
+    free(queries[q]);
+  for (int i = 0; i < NUM_SETS; i++)
+    free(sets[i]);
+  free(sets);
+  setindex_free(sindex);
+  return ok;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The invalid arguments must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  MeosArray *result = meos_array_create(sizeof(int64));
+
+  /* (i) and (ii) searches */
+  check("(i) the searches on integer sets match a linear scan",
+    test_sets(false, result));
+  check("(ii) the searches on text sets match a linear scan",
+    test_sets(true, result));
+
+  /* (iii) elements missing from the index */
+  SetIndex *sindex = setindex_create();
+  Set *s1 = bigintset_in("{1,2,3}");
+  Set *s2 = bigintset_in("{3,4}");
+  setindex_insert(sindex, s1, 1);
+  setindex_insert(sindex, s2, 2);
+  Set *q1 = bigintset_in("{3,99}");
+  Set *q2 = bigintset_in("{3,4,99}");
+  bool ok = setindex_search(sindex, RTREE_CONTAINS, q1, result) == 0;
+  ok &= setindex_search(sindex, RTREE_OVERLAPS, q1, result) == 2;
+  ok &= setindex_search(sindex, RTREE_CONTAINED_BY, q2, result) == 1 &&
+    *(int64 *) meos_array_get(result, 0) == 2;
+  check("(iii) elements missing from the index are handled", ok);
+
+  /* (iv) empty index and invalid arguments */
+  SetIndex *empty = setindex_create();
+  check("(iv) an empty index answers nothing",
+    setindex_count(empty) == 0 &&
+    setindex_search(empty, RTREE_OVERLAPS, q1, result) == 0);
+  setindex_free(empty);
+  meos_errno_reset();
+  Set *intset = intset_in("{1,2}");
+  bool rejected = ! setindex_insert(sindex, intset, 3) && meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= setindex_search(sindex, RTREE_OVERLAPS, intset, result) == -1 &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= setindex_count(sindex) == 2;
+  check("(iv) sets of another type are rejected", rejected);
+
+  free(intset);
+  free(s1);
+  free(s2);
+  free(q1);
+  free(q2);
+  setindex_free(sindex);
+  meos_array_destroy(result);
+
+  printf(failures ? "\nSome inverted index tests FAILED.\n" :
+    "\nAll inverted index tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,283 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the in-memory space-partitioning index with
+ * leaf buckets, i.e., sptree_create_config, against the same index without
+ * leaf buckets.
+ *
+ * For the temporal box and spatiotemporal box bounding box types, for both
+ * the quad-tree and the k-d tree kinds, and for several capacities of the
+ * buckets, the boxes are inserted one by one or loaded at once. Five
+ * properties are asserted per configuration:
+ *  (i)   the overlaps, contains and contained-by searches return the ids of
+ *        the tree without leaf buckets, whether it is built by insertion or
+ *        by bulk load;
+ *  (ii)  the search cursor returns the ids of the search;
+ *  (iii) the nearest-neighbour cursor returns the distances of the tree
+ *        without leaf buckets;
+ *  (iv)  the tree saved into a file and opened again returns the same ids;
+ *  (v)   a capacity of the buckets out of range is rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o sptree_bucket_test sptree_bucket_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of boxes inserted into every index */
+#define NUM_BOXES 5000
+/* Number of queries per operator */
+#define NUM_QUERIES 50
+/* Number of neighbours compared */
+#define NUM_NEIGHBOURS 50
+
+#define BUCKET_FILE "sptree_bucket_test.sptree"
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Return a random box of a type of a given width */
+static void *
+random_box(MeosType bboxtype, int w)
+{
+  /* Few distinct coordinates, so that some boxes are equal */
+  int x = random_int(0, 200) * 5, y = random_int(0, 200) * 5;
+  TimestampTz t = (TimestampTz) random_int(0, 1000) * 60000000;
+  Span *s = tstzspan_make(t, t + (TimestampTz) random_int(1, w) * 60000000,
+    true, true);
+  void *result;
+  if (bboxtype == T_TBOX)
+  {
+    Span *v = floatspan_make(x, x + random_int(0, w), true, true);
+    result = tbox_make(v, s);
+    free(v);
+  }
+  else
+    result = stbox_make(true, false, false, 0, x, x + random_int(0, w), y,
+      y + random_int(0, w), 0, 0, s);
+  free(s);
+  return result;
+}
+
+static int
+cmp_int64(const void *a, const void *b)
+{
+  int64 x = *(const int64 *) a, y = *(const int64 *) b;
+  return (x > y) - (x < y);
+}
+
+/* Return true when two arrays hold the same ids in any order */
+static bool
+same_ids(MeosArray *a, MeosArray *b)
+{
+  int n = meos_array_count(a);
+  if (n != meos_array_count(b))
+    return false;
+  int64 *x = malloc(sizeof(int64) * (n + 1));
+  int64 *y = malloc(sizeof(int64) * (n + 1));
+  for (int i = 0; i < n; i++)
+  {
+    x[i] = *(int64 *) meos_array_get(a, i);
+    y[i] = *(int64 *) meos_array_get(b, i);
+  }
+  qsort(x, n, sizeof(int64), cmp_int64);
+  qsort(y, n, sizeof(int64), cmp_int64);
+  bool result = memcmp(x, y, sizeof(int64) * n) == 0;
+  free(x); free(y);
+  return result;
+}
+
+/* Compare the searches of two trees over random queries */
+static bool
+same_searches(MeosType bboxtype, const SPTree *sptree1, const SPTree *sptree2)
+{
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  MeosArray *r1 = meos_array_create(sizeof(int64));
+  MeosArray *r2 = meos_array_create(sizeof(int64));
+  bool result = true;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    void *query = random_box(bboxtype, q % 2 ? 200 : 5);
+    for (int o = 0; o < 3; o++)
+    {
+      sptree_search(sptree1, ops[o], query, r1);
+      sptree_search(sptree2, ops[o], query, r2);
+      if (! same_ids(r1, r2))
+        result = false;
+    }
+    free(query);
+  }
+  meos_array_destroy(r1);
+  meos_array_destroy(r2);
+  return result;
+}
+
+static void
+test_bucket(MeosType bboxtype, SPTreeKind kind, int bucketsize)
+{
+  printf("%s %s with buckets of %d boxes:\n",
+    bboxtype == T_TBOX ? "Temporal box" : "Spatiotemporal box",
+    kind == SPTREE_QUADTREE ? "quad-tree" : "k-d tree", bucketsize);
+  size_t size = bboxtype == T_TBOX ? sizeof(TBox) : sizeof(STBox);
+  char *boxes = malloc(size * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  SPTree *plain = sptree_create(bboxtype, kind);
+  SPTree *inserted = sptree_create_config(bboxtype, kind, bucketsize);
+  SPTree *loaded = sptree_create_config(bboxtype, kind, bucketsize);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    void *box = random_box(bboxtype, 20);
+    memcpy(boxes + i * size, box, size);
+    ids[i] = i;
+    sptree_insert(plain, box, i);
+    sptree_insert(inserted, box, i);
+    free(box);
+  }
+  sptree_load(loaded, boxes, ids, NUM_BOXES);
+
+  /* (i) searches */
+  check("(i) the inserted tree returns the same ids",
+    same_searches(bboxtype, plain, inserted));
+  check("(i) the loaded tree returns the same ids",
+    same_searches(bboxtype, plain, loaded));
+
+  /* (ii) search cursor */
+  MeosArray *expected = meos_array_create(sizeof(int64));
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool same = true;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    void *query = random_box(bboxtype, 100);
+    sptree_search(inserted, RTREE_OVERLAPS, query, expected);
+    meos_array_reset(result);
+    SPSearchCursor *cursor = sptree_search_cursor_open(inserted,
+      RTREE_OVERLAPS, query);
+    int64 id;
+    while (sptree_search_cursor_next(cursor, &id))
+      meos_array_add(result, &id);
+    sptree_search_cursor_close(cursor);
+    same &= same_ids(expected, result);
+    free(query);
+  }
+  check("(ii) the search cursor returns the ids of the search", same);
+
+  /* (iii) nearest neighbours */
+  same = true;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    void *query = random_box(bboxtype, 5);
+    SPNNCursor *c1 = sptree_nn_cursor_open(plain, query);
+    SPNNCursor *c2 = sptree_nn_cursor_open(loaded, query);
+    for (int k = 0; k < NUM_NEIGHBOURS; k++)
+    {
+      double d1, d2;
+      bool more1 = sptree_nn_cursor_next(c1, NULL, &d1);
+      bool more2 = sptree_nn_cursor_next(c2, NULL, &d2);
+      if (more1 != more2 || (more1 && d1 != d2))
+        same = false;
+    }
+    sptree_nn_cursor_close(c1);
+    sptree_nn_cursor_close(c2);
+    free(query);
+  }
+  check("(iii) nearest neighbours are at the same distances", same);
+
+  /* (iv) file */
+  sptree_save(inserted, BUCKET_FILE);
+  SPTree *mapped = sptree_open(BUCKET_FILE);
+  check("(iv) the tree is opened", mapped != NULL);
+  if (mapped)
+  {
+    check("(iv) the opened tree returns the same ids",
+      same_searches(bboxtype, plain, mapped));
+    sptree_free(mapped);
+  }
+  remove(BUCKET_FILE);
+
+  meos_array_destroy(expected);
+  meos_array_destroy(result);
+  sptree_free(plain);
+  sptree_free(inserted);
+  sptree_free(loaded);
+  free(boxes);
+  free(ids);
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The rejected capacity must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  int sizes[] = {2, 16, 64};
+  for (int i = 0; i < 3; i++)
+  {
+    test_bucket(T_TBOX, SPTREE_QUADTREE, sizes[i]);
+    test_bucket(T_TBOX, SPTREE_KDTREE, sizes[i]);
+    test_bucket(T_STBOX, SPTREE_QUADTREE, sizes[i]);
+    test_bucket(T_STBOX, SPTREE_KDTREE, sizes[i]);
+  }
+
+  /* (v) capacity out of range */
+  printf("Capacity of the buckets:\n");
+  check("(v) a capacity out of range is rejected",
+    sptree_create_config(T_TBOX, SPTREE_KDTREE, 1) == NULL &&
+    sptree_create_config(T_TBOX, SPTREE_KDTREE, 1000) == NULL);
+
+  printf(failures ? "\nSome SPTree leaf bucket tests FAILED.\n" :
+    "\nAll SPTree leaf bucket tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
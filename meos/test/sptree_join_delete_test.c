@@ -0,0 +1,290 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the join and the deletion of the in-memory
+ * space-partitioning index, i.e., sptree_join and sptree_delete, against the
+ * in-memory RTree.
+ *
+ * For the temporal box and spatiotemporal box bounding box types, for both
+ * the quad-tree and the k-d tree kinds, with and without leaf buckets, four
+ * properties are asserted per configuration:
+ *  (i)   the overlaps, contains and contained-by joins with a tree of the
+ *        other kind return the pairs of rtree_join;
+ *  (ii)  after deleting a third of the entries, the searches return the ids
+ *        of an RTree from which the same entries are deleted, and an entry
+ *        already deleted or never inserted is not found;
+ *  (iii) after inserting the deleted entries again, the searches and the
+ *        join return the ids of the RTree with every entry;
+ *  (iv)  after deleting every entry, the tree is empty.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o sptree_join_delete_test sptree_join_delete_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of boxes inserted into every index */
+#define NUM_BOXES 3000
+/* Number of queries per operator */
+#define NUM_QUERIES 50
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Return a random box of a type of a given width */
+static void *
+random_box(MeosType bboxtype, int w)
+{
+  /* Few distinct coordinates, so that some boxes are equal */
+  int x = random_int(0, 200) * 5, y = random_int(0, 200) * 5;
+  TimestampTz t = (TimestampTz) random_int(0, 1000) * 60000000;
+  Span *s = tstzspan_make(t, t + (TimestampTz) random_int(1, w) * 60000000,
+    true, true);
+  void *result;
+  if (bboxtype == T_TBOX)
+  {
+    Span *v = floatspan_make(x, x + random_int(0, w), true, true);
+    result = tbox_make(v, s);
+    free(v);
+  }
+  else
+    result = stbox_make(true, false, false, 0, x, x + random_int(0, w), y,
+      y + random_int(0, w), 0, 0, s);
+  free(s);
+  return result;
+}
+
+static int
+cmp_int64(const void *a, const void *b)
+{
+  int64 x = *(const int64 *) a, y = *(const int64 *) b;
+  return (x > y) - (x < y);
+}
+
+/* Return true when two arrays hold the same values in any order, the values
+ * being read by groups of width 1 (ids) or 2 (pairs of ids) */
+static bool
+same_values(MeosArray *a, MeosArray *b, int width)
+{
+  int n = meos_array_count(a);
+  if (n != meos_array_count(b))
+    return false;
+  n /= width;
+  int64 *x = malloc(sizeof(int64) * (n + 1));
+  int64 *y = malloc(sizeof(int64) * (n + 1));
+  for (int i = 0; i < n; i++)
+  {
+    x[i] = *(int64 *) meos_array_get(a, i * width);
+    y[i] = *(int64 *) meos_array_get(b, i * width);
+    if (width == 2)
+    {
+      x[i] = x[i] * NUM_BOXES + *(int64 *) meos_array_get(a, i * 2 + 1);
+      y[i] = y[i] * NUM_BOXES + *(int64 *) meos_array_get(b, i * 2 + 1);
+    }
+  }
+  qsort(x, n, sizeof(int64), cmp_int64);
+  qsort(y, n, sizeof(int64), cmp_int64);
+  bool result = memcmp(x, y, sizeof(int64) * n) == 0;
+  free(x); free(y);
+  return result;
+}
+
+/* Compare the searches of an SPTree and an RTree over random queries */
+static bool
+same_searches(MeosType bboxtype, const SPTree *sptree, const RTree *rtree)
+{
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  MeosArray *r1 = meos_array_create(sizeof(int64));
+  MeosArray *r2 = meos_array_create(sizeof(int64));
+  bool result = true;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    void *query = random_box(bboxtype, q % 2 ? 200 : 5);
+    for (int o = 0; o < 3; o++)
+    {
+      sptree_search(sptree, ops[o], query, r1);
+      rtree_search(rtree, ops[o], query, r2);
+      if (! same_values(r1, r2, 1))
+        result = false;
+    }
+    free(query);
+  }
+  meos_array_destroy(r1);
+  meos_array_destroy(r2);
+  return result;
+}
+
+/* Compare the joins of two SPTrees and of two RTrees */
+static bool
+same_joins(const SPTree *sptree1, const SPTree *sptree2, const RTree *rtree1,
+  const RTree *rtree2)
+{
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  MeosArray *r1 = meos_array_create(sizeof(int64));
+  MeosArray *r2 = meos_array_create(sizeof(int64));
+  bool result = true;
+  for (int o = 0; o < 3; o++)
+  {
+    int n1 = sptree_join(sptree1, sptree2, ops[o], r1);
+    int n2 = rtree_join(rtree1, rtree2, ops[o], r2);
+    if (n1 != n2 || ! same_values(r1, r2, 2))
+      result = false;
+  }
+  meos_array_destroy(r1);
+  meos_array_destroy(r2);
+  return result;
+}
+
+static void
+test_join_delete(MeosType bboxtype, SPTreeKind kind, int bucketsize)
+{
+  printf("%s %s with buckets of %d boxes:\n",
+    bboxtype == T_TBOX ? "Temporal box" : "Spatiotemporal box",
+    kind == SPTREE_QUADTREE ? "quad-tree" : "k-d tree", bucketsize);
+  size_t size = bboxtype == T_TBOX ? sizeof(TBox) : sizeof(STBox);
+  SPTreeKind other = kind == SPTREE_QUADTREE ? SPTREE_KDTREE : SPTREE_QUADTREE;
+  char *boxes1 = malloc(size * NUM_BOXES);
+  char *boxes2 = malloc(size * NUM_BOXES);
+  int64 *ids = malloc(sizeof(int64) * NUM_BOXES);
+  SPTree *sptree1 = sptree_create_config(bboxtype, kind, bucketsize);
+  SPTree *sptree2 = sptree_create(bboxtype, other);
+  RTree *rtree1 = rtree_create(bboxtype);
+  RTree *rtree2 = rtree_create(bboxtype);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    void *box1 = random_box(bboxtype, 20);
+    void *box2 = random_box(bboxtype, 20);
+    memcpy(boxes1 + i * size, box1, size);
+    memcpy(boxes2 + i * size, box2, size);
+    ids[i] = i;
+    sptree_insert(sptree1, box1, i);
+    rtree_insert(rtree1, box1, i);
+    rtree_insert(rtree2, box2, i);
+    free(box1); free(box2);
+  }
+  sptree_load(sptree2, boxes2, ids, NUM_BOXES);
+
+  /* (i) join */
+  check("(i) the joins return the pairs of the RTree join",
+    same_joins(sptree1, sptree2, rtree1, rtree2));
+
+  /* (ii) deletion of a third of the entries */
+  bool found = true;
+  for (int i = 0; i < NUM_BOXES; i += 3)
+  {
+    found &= sptree_delete(sptree1, boxes1 + i * size, i);
+    rtree_delete(rtree1, boxes1 + i * size, i);
+  }
+  check("(ii) every deleted entry is found", found);
+  check("(ii) the searches return the ids of the RTree",
+    same_searches(bboxtype, sptree1, rtree1));
+  check("(ii) the joins return the pairs of the RTree join",
+    same_joins(sptree1, sptree2, rtree1, rtree2));
+  check("(ii) a deleted entry is not found again",
+    ! sptree_delete(sptree1, boxes1, 0));
+  check("(ii) an entry with another id is not found",
+    ! sptree_delete(sptree1, boxes1 + size, NUM_BOXES + 1));
+
+  /* (iii) insertion of the deleted entries again */
+  for (int i = 0; i < NUM_BOXES; i += 3)
+  {
+    sptree_insert(sptree1, boxes1 + i * size, i);
+    rtree_insert(rtree1, boxes1 + i * size, i);
+  }
+  check("(iii) the searches return the ids of the RTree",
+    same_searches(bboxtype, sptree1, rtree1));
+  check("(iii) the joins return the pairs of the RTree join",
+    same_joins(sptree1, sptree2, rtree1, rtree2));
+
+  /* (iv) deletion of every entry */
+  found = true;
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    found &= sptree_delete(sptree1, boxes1 + i * size, i);
+    rtree_delete(rtree1, boxes1 + i * size, i);
+  }
+  MeosArray *result = meos_array_create(sizeof(int64));
+  check("(iv) every entry is deleted and the tree is empty", found &&
+    sptree_join(sptree1, sptree2, RTREE_OVERLAPS, result) == 0 &&
+    same_searches(bboxtype, sptree1, rtree1));
+  meos_array_destroy(result);
+
+  sptree_free(sptree1);
+  sptree_free(sptree2);
+  rtree_free(rtree1);
+  rtree_free(rtree2);
+  free(boxes1);
+  free(boxes2);
+  free(ids);
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  srand(1);
+
+  int sizes[] = {0, 16};
+  for (int i = 0; i < 2; i++)
+  {
+    test_join_delete(T_TBOX, SPTREE_QUADTREE, sizes[i]);
+    test_join_delete(T_TBOX, SPTREE_KDTREE, sizes[i]);
+    test_join_delete(T_STBOX, SPTREE_QUADTREE, sizes[i]);
+    test_join_delete(T_STBOX, SPTREE_KDTREE, sizes[i]);
+  }
+
+  printf(failures ? "\nSome SPTree join and deletion tests FAILED.\n" :
+    "\nAll SPTree join and deletion tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
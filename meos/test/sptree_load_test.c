@@ -0,0 +1,240 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the bulk load of the in-memory
+ * space-partitioning index (quad-tree and k-d tree), i.e., sptree_load,
+ * against an exact brute-force oracle.
+ *
+ * For the integer span, temporal box and spatiotemporal box bounding box
+ * types, and for both the quad-tree and the k-d tree kinds, boxes in time
+ * order, as those of a stream, are loaded at once. Three properties are
+ * asserted per configuration:
+ *  (i)   the overlaps, contains and contained-by searches return exactly the
+ *        boxes satisfying the operator;
+ *  (ii)  boxes inserted one by one after the load are found as well;
+ *  (iii) loading a tree that is not empty is rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o sptree_load_test sptree_load_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+
+/* Number of boxes loaded into every index */
+#define NUM_BOXES 20000
+/* Number of boxes inserted after the load */
+#define NUM_EXTRA 1000
+/* Number of queries per operator */
+#define NUM_QUERIES 50
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Box types tested */
+typedef enum { INTSPAN, TBOX, STBOX } BoxKind;
+
+/* Return the i-th box of a stream of a type, or a query when i < 0 */
+static void *
+stream_box(BoxKind kind, int i, int w)
+{
+  /* The boxes of the stream start one second after the other */
+  int t = i < 0 ? random_int(0, NUM_BOXES + NUM_EXTRA) : i;
+  int x = random_int(0, 10000);
+  switch (kind)
+  {
+    case INTSPAN:
+      return intspan_make(t, t + random_int(1, w), true, false);
+    case TBOX:
+    {
+      Span *v = intspan_make(x, x + random_int(1, w), true, false);
+      Span *s = tstzspan_make((TimestampTz) t * 1000000,
+        (TimestampTz) (t + random_int(1, w)) * 1000000, true, true);
+      TBox *box = tbox_make(v, s);
+      free(v); free(s);
+      return box;
+    }
+    default: /* STBOX */
+    {
+      int y = random_int(0, 10000);
+      Span *s = tstzspan_make((TimestampTz) t * 1000000,
+        (TimestampTz) (t + random_int(1, w)) * 1000000, true, true);
+      STBox *box = stbox_make(true, false, false, 0, x, x + random_int(0, w),
+        y, y + random_int(0, w), 0, 0, s);
+      free(s);
+      return box;
+    }
+  }
+}
+
+/* Return true when a box satisfies an operator with a query */
+static bool
+satisfies(BoxKind kind, RTreeSearchOp op, const void *box, const void *query)
+{
+  switch (kind)
+  {
+    case INTSPAN:
+      return op == RTREE_OVERLAPS ? overlaps_span_span(box, query) :
+        op == RTREE_CONTAINS ? contains_span_span(box, query) :
+        contains_span_span(query, box);
+    case TBOX:
+      return op == RTREE_OVERLAPS ? overlaps_tbox_tbox(box, query) :
+        op == RTREE_CONTAINS ? contains_tbox_tbox(box, query) :
+        contains_tbox_tbox(query, box);
+    default: /* STBOX */
+      return op == RTREE_OVERLAPS ? overlaps_stbox_stbox(box, query) :
+        op == RTREE_CONTAINS ? contains_stbox_stbox(box, query) :
+        contains_stbox_stbox(query, box);
+  }
+}
+
+/* Compare the searches of a tree with the brute force over its boxes */
+static bool
+exact_answers(BoxKind kind, const SPTree *sptree, char *boxes, size_t size,
+  int count)
+{
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool *found = malloc(sizeof(bool) * count);
+  bool exact = true;
+  for (int o = 0; o < 3; o++)
+  {
+    for (int q = 0; q < NUM_QUERIES; q++)
+    {
+      /* Narrow queries for contains and wide ones otherwise */
+      void *query = stream_box(kind, -1,
+        ops[o] == RTREE_CONTAINS ? 2 : 2000);
+      memset(found, 0, sizeof(bool) * count);
+      int n = sptree_search(sptree, ops[o], query, result);
+      for (int i = 0; i < n; i++)
+      {
+        int64 id = *(int64 *) meos_array_get(result, i);
+        if (id < 0 || id >= count || found[id] ||
+            ! satisfies(kind, ops[o], boxes + id * size, query))
+          exact = false;
+        else
+          found[id] = true;
+      }
+      for (int i = 0; i < count; i++)
+        if (! found[i] && satisfies(kind, ops[o], boxes + i * size, query))
+          exact = false;
+      free(query);
+    }
+  }
+  free(found);
+  meos_array_destroy(result);
+  return exact;
+}
+
+static void
+test_load(BoxKind kind, const char *typename, SPTreeKind treekind,
+  const char *kindname)
+{
+  size_t size = kind == INTSPAN ? sizeof(Span) :
+    kind == TBOX ? sizeof(TBox) : sizeof(STBox);
+  int total = NUM_BOXES + NUM_EXTRA;
+  char *boxes = malloc(size * total);
+  int64 *ids = malloc(sizeof(int64) * total);
+  for (int i = 0; i < total; i++)
+  {
+    void *box = stream_box(kind, i, 50);
+    memcpy(boxes + i * size, box, size);
+    ids[i] = i;
+    free(box);
+  }
+  SPTree *sptree = kind == INTSPAN ? sptree_create_intspan(treekind) :
+    kind == TBOX ? sptree_create_tbox(treekind) :
+    sptree_create_stbox(treekind);
+  sptree_load(sptree, boxes, ids, NUM_BOXES);
+
+  char label[128];
+  printf("%s %s (%d boxes in time order):\n", typename, kindname, NUM_BOXES);
+  snprintf(label, sizeof(label), "(i) the loaded tree answers exactly");
+  check(label, exact_answers(kind, sptree, boxes, size, NUM_BOXES));
+
+  for (int i = NUM_BOXES; i < total; i++)
+    sptree_insert(sptree, boxes + i * size, i);
+  snprintf(label, sizeof(label), "(ii) the boxes inserted afterwards are found");
+  check(label, exact_answers(kind, sptree, boxes, size, total));
+
+  MeosArray *result = meos_array_create(sizeof(int64));
+  void *query = stream_box(kind, -1, 2000);
+  int before = sptree_search(sptree, RTREE_OVERLAPS, query, result);
+  sptree_load(sptree, boxes, ids, NUM_BOXES);
+  snprintf(label, sizeof(label), "(iii) loading a non-empty tree is rejected");
+  check(label, sptree_search(sptree, RTREE_OVERLAPS, query, result) == before);
+  free(query);
+  meos_array_destroy(result);
+
+  sptree_free(sptree);
+  free(boxes);
+  free(ids);
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The rejected load must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  test_load(INTSPAN, "Integer span", SPTREE_QUADTREE, "quad-tree");
+  test_load(INTSPAN, "Integer span", SPTREE_KDTREE, "k-d tree");
+  test_load(TBOX, "Temporal box", SPTREE_QUADTREE, "quad-tree");
+  test_load(TBOX, "Temporal box", SPTREE_KDTREE, "k-d tree");
+  test_load(STBOX, "Spatiotemporal box", SPTREE_QUADTREE, "quad-tree");
+  test_load(STBOX, "Spatiotemporal box", SPTREE_KDTREE, "k-d tree");
+
+  printf(failures ? "\nSome SPTree load tests FAILED.\n" :
+    "\nAll SPTree load tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
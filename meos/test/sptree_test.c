@@ -978,6 +978,69 @@ test_selective_stbox(SPTreeKind kind, const char *kindname)
   sptree_free(sptree);
 }
 
+/*****************************************************************************
+ * Integer spans with unrelated bounds
+ *
+ * Short spans have nearly the same order by lower and by upper bound, so a
+ * level partitioning the spans on one bound while the search narrows the
+ * other rarely loses one. Spans of any length expose it.
+ *****************************************************************************/
+
+/* Number of queries of the test */
+#define WIDE_QUERIES 20
+
+static void
+test_wide_intspan(SPTreeKind kind, const char *kindname)
+{
+  Span **spans = malloc(NUM_BOXES * sizeof(Span *));
+  SPTree *sptree = sptree_create_intspan(kind);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    int lo = random_int(0, 10000);
+    spans[i] = intspan_make(lo, lo + random_int(1, 10000), true, false);
+    sptree_insert(sptree, spans[i], i);
+  }
+
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  MeosArray *result = meos_array_create(sizeof(int64));
+  bool *in_index = malloc(NUM_BOXES * sizeof(bool));
+  int missed = 0, extra = 0;
+  for (int q = 0; q < WIDE_QUERIES; q++)
+  {
+    int qlo = random_int(0, 15000);
+    Span *query = intspan_make(qlo, qlo + random_int(1, 5000), true, false);
+    for (int o = 0; o < 3; o++)
+    {
+      int count = sptree_search(sptree, ops[o], query, result);
+      memset(in_index, 0, NUM_BOXES * sizeof(bool));
+      for (int i = 0; i < count; i++)
+        in_index[*(int64 *) meos_array_get(result, i)] = true;
+      for (int i = 0; i < NUM_BOXES; i++)
+      {
+        bool truth = (ops[o] == RTREE_OVERLAPS) ?
+          overlaps_span_span(spans[i], query) :
+          (ops[o] == RTREE_CONTAINS) ? contains_span_span(spans[i], query) :
+          contains_span_span(query, spans[i]);
+        if (truth && ! in_index[i])
+          missed++;
+        if (! truth && in_index[i])
+          extra++;
+      }
+    }
+    free(query);
+  }
+
+  printf("Integer span %s (%d spans of any length):\n", kindname, NUM_BOXES);
+  check("  all operators no false negatives", missed == 0);
+  check("  all operators no false positives", extra == 0);
+
+  for (int i = 0; i < NUM_BOXES; i++)
+    free(spans[i]);
+  free(spans); free(in_index);
+  meos_array_destroy(result);
+  sptree_free(sptree);
+}
+
 int
 main(void)
 {
@@ -1003,6 +1066,8 @@ main(void)
   test_selective_tbox(SPTREE_KDTREE, "k-d tree");
   test_selective_stbox(SPTREE_QUADTREE, "quad-tree");
   test_selective_stbox(SPTREE_KDTREE, "k-d tree");
+  test_wide_intspan(SPTREE_QUADTREE, "quad-tree");
+  test_wide_intspan(SPTREE_KDTREE, "k-d tree");
   test_mest();
   test_stbox_mest();
   test_nn_floatspan();
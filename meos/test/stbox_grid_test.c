@@ -0,0 +1,313 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the in-memory grid index of spatiotemporal
+ * boxes, i.e., stgrid_create, against the in-memory RTree.
+ *
+ * Points and small boxes are inserted into a grid and into an RTree. Six
+ * properties are asserted:
+ *  (i)   the overlaps, contains and contained-by searches, with and without
+ *        time dimension in the query, return the ids of the RTree;
+ *  (ii)  the nearest-neighbour cursor returns every id at the distances of
+ *        the nearest-neighbour cursor of the RTree;
+ *  (iii) after deleting a third of the entries, the searches and the
+ *        nearest-neighbour cursor agree with the RTree from which the same
+ *        entries are deleted, and a deleted entry is not found again;
+ *  (iv)  the instants of a temporal point are inserted with their bounding
+ *        box;
+ *  (v)   a box covering too many cells of the grid is rejected;
+ *  (vi)  the nearest-neighbour cursor over two clusters of points far apart
+ *        on tiny tiles, i.e., over rings much larger than the cells in use,
+ *        agrees with the RTree.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o stbox_grid_test stbox_grid_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+
+/* Number of boxes inserted into every index */
+#define NUM_BOXES 10000
+/* Number of queries per operator */
+#define NUM_QUERIES 100
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Return a random box of a given width and duration in minutes, without
+ * time dimension when the duration is negative */
+static STBox *
+random_box(int w, int d)
+{
+  double x = random_int(-5000, 5000) / 10.0, y = random_int(-5000, 5000) / 10.0;
+  Span *s = NULL;
+  if (d >= 0)
+  {
+    TimestampTz t = (TimestampTz) random_int(0, 10000) * 60000000;
+    s = tstzspan_make(t, t + (TimestampTz) d * 60000000, true, true);
+  }
+  STBox *result = stbox_make(true, false, false, 0, x, x + w, y, y + w, 0, 0,
+    s);
+  free(s);
+  return result;
+}
+
+static int
+cmp_int64(const void *a, const void *b)
+{
+  int64 x = *(const int64 *) a, y = *(const int64 *) b;
+  return (x > y) - (x < y);
+}
+
+/* Return true when two arrays hold the same ids in any order */
+static bool
+same_ids(MeosArray *a, MeosArray *b)
+{
+  int n = meos_array_count(a);
+  if (n != meos_array_count(b))
+    return false;
+  int64 *x = malloc(sizeof(int64) * (n + 1));
+  int64 *y = malloc(sizeof(int64) * (n + 1));
+  for (int i = 0; i < n; i++)
+  {
+    x[i] = *(int64 *) meos_array_get(a, i);
+    y[i] = *(int64 *) meos_array_get(b, i);
+  }
+  qsort(x, n, sizeof(int64), cmp_int64);
+  qsort(y, n, sizeof(int64), cmp_int64);
+  bool result = memcmp(x, y, sizeof(int64) * n) == 0;
+  free(x); free(y);
+  return result;
+}
+
+/* Compare the searches of a grid and an RTree over random queries */
+static bool
+same_searches(const STGrid *grid, const RTree *rtree)
+{
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  MeosArray *r1 = meos_array_create(sizeof(int64));
+  MeosArray *r2 = meos_array_create(sizeof(int64));
+  bool result = true;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    STBox *query = random_box(q % 2 ? 100 : 1, q % 5 ? 600 : -1);
+    for (int o = 0; o < 3; o++)
+    {
+      stgrid_search(grid, ops[o], query, r1);
+      rtree_search(rtree, ops[o], query, r2);
+      if (! same_ids(r1, r2))
+        result = false;
+    }
+    free(query);
+  }
+  meos_array_destroy(r1);
+  meos_array_destroy(r2);
+  return result;
+}
+
+/* Compare the nearest-neighbour cursors of a grid and an RTree, consuming
+ * them entirely */
+static bool
+same_neighbours(const STGrid *grid, const RTree *rtree)
+{
+  bool result = true;
+  for (int q = 0; q < NUM_QUERIES / 10; q++)
+  {
+    STBox *query = random_box(5, q % 2 ? 600 : -1);
+    STGridNNCursor *c1 = stgrid_nn_cursor_open(grid, query);
+    RTreeNNCursor *c2 = rtree_nn_cursor_open(rtree, query);
+    int count = 0;
+    while (true)
+    {
+      double d1, d2;
+      bool more1 = stgrid_nn_cursor_next(c1, NULL, &d1);
+      bool more2 = rtree_nn_cursor_next(c2, NULL, &d2);
+      if (more1 != more2 || (more1 && d1 != d2))
+        result = false;
+      if (! more1 || ! more2)
+        break;
+      count++;
+    }
+    if (count != stgrid_count(grid))
+      result = false;
+    stgrid_nn_cursor_close(c1);
+    rtree_nn_cursor_close(c2);
+    free(query);
+  }
+  return result;
+}
+
+/* Compare the nearest neighbours of a grid and an RTree of two clusters of
+ * points far apart on tiles much smaller than the queries */
+static bool
+sparse_neighbours(const Interval *hour, const GSERIALIZED *sorigin,
+  TimestampTz torigin)
+{
+  STGrid *grid = stgrid_create(0.01, 0.01, 0.01, hour, sorigin, torigin);
+  RTree *rtree = rtree_create_stbox();
+  for (int i = 0; i < 100; i++)
+  {
+    double x = (i % 2 ? 400.0 : -400.0) + random_int(0, 100) / 100.0;
+    double y = (i % 2 ? 400.0 : -400.0) + random_int(0, 100) / 100.0;
+    TimestampTz t = torigin + (TimestampTz) random_int(0, 600) * 60000000;
+    Span *s = tstzspan_make(t, t, true, true);
+    STBox *box = stbox_make(true, false, false, 0, x, x, y, y, 0, 0, s);
+    stgrid_insert(grid, box, i);
+    rtree_insert(rtree, box, i);
+    free(s); free(box);
+  }
+  bool result = same_neighbours(grid, rtree);
+  /* A query far from both clusters */
+  STBox *far = stbox_make(true, false, false, 0, 1e5, 1e5, -1e5, -1e5, 0, 0,
+    NULL);
+  STGridNNCursor *c1 = stgrid_nn_cursor_open(grid, far);
+  RTreeNNCursor *c2 = rtree_nn_cursor_open(rtree, far);
+  int count = 0;
+  double d1, d2;
+  while (stgrid_nn_cursor_next(c1, NULL, &d1))
+  {
+    if (! rtree_nn_cursor_next(c2, NULL, &d2) || d1 != d2)
+      result = false;
+    count++;
+  }
+  result &= (count == 100);
+  stgrid_nn_cursor_close(c1);
+  rtree_nn_cursor_close(c2);
+  free(far);
+  stgrid_free(grid);
+  rtree_free(rtree);
+  return result;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The rejected box must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  printf("Grid of 10 x 10 units and 1 hour:\n");
+  Interval *hour = interval_in("1 hour", -1);
+  GSERIALIZED *sorigin = geompoint_make2d(0, 0, 0);
+  TimestampTz torigin = timestamptz_in("2000-01-03", -1);
+  STGrid *grid = stgrid_create(10, 10, 10, hour, sorigin, torigin);
+  RTree *rtree = rtree_create_stbox();
+  STBox **boxes = malloc(sizeof(STBox *) * NUM_BOXES);
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    /* Mostly points, some boxes spanning a few cells */
+    boxes[i] = i % 10 ? random_box(0, 0) : random_box(random_int(1, 30),
+      random_int(0, 300));
+    stgrid_insert(grid, boxes[i], i);
+    rtree_insert(rtree, boxes[i], i);
+  }
+  check("(i) every box is inserted", stgrid_count(grid) == NUM_BOXES);
+
+  /* (i) searches */
+  check("(i) the searches return the ids of the RTree",
+    same_searches(grid, rtree));
+
+  /* (ii) nearest neighbours */
+  check("(ii) the neighbours are at the distances of the RTree",
+    same_neighbours(grid, rtree));
+
+  /* (iii) deletion of a third of the entries */
+  bool found = true;
+  for (int i = 0; i < NUM_BOXES; i += 3)
+  {
+    found &= stgrid_delete(grid, boxes[i], i);
+    rtree_delete(rtree, boxes[i], i);
+  }
+  check("(iii) every deleted entry is found", found);
+  check("(iii) a deleted entry is not found again",
+    ! stgrid_delete(grid, boxes[0], 0));
+  check("(iii) the searches return the ids of the RTree",
+    same_searches(grid, rtree));
+  check("(iii) the neighbours are at the distances of the RTree",
+    same_neighbours(grid, rtree));
+
+  /* (iv) temporal points */
+  int count = stgrid_count(grid);
+  for (int i = 0; i < 100; i++)
+  {
+    GSERIALIZED *gs = geompoint_make2d(0, random_int(-500, 500),
+      random_int(-500, 500));
+    TInstant *inst = tpointinst_make(gs, torigin +
+      (TimestampTz) random_int(0, 10000) * 60000000);
+    stgrid_insert_temporal(grid, (Temporal *) inst, NUM_BOXES + i);
+    free(gs); free(inst);
+  }
+  check("(iv) the instants of a temporal point are inserted",
+    stgrid_count(grid) == count + 100);
+
+  /* (v) box covering too many cells */
+  STBox *large = random_box(100000, 600);
+  check("(v) a box covering too many cells is rejected",
+    ! stgrid_insert(grid, large, -1) && stgrid_count(grid) == count + 100);
+  free(large);
+
+  /* (vi) sparse data */
+  check("(vi) the neighbours of sparse data are those of the RTree",
+    sparse_neighbours(hour, sorigin, torigin));
+
+  for (int i = 0; i < NUM_BOXES; i++)
+    free(boxes[i]);
+  free(boxes);
+  stgrid_free(grid);
+  rtree_free(rtree);
+  free(hour); free(sorigin);
+
+  printf(failures ? "\nSome grid index tests FAILED.\n" :
+    "\nAll grid index tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the static in-memory index of time ranges,
+ * i.e., timeindex_make_tstzspan and timeindex_make_tbox, against an RTree of
+ * timestamptz spans.
+ *
+ * Four properties are asserted:
+ *  (i)   the overlaps, contains, and contained-by searches return the ids of
+ *        the RTree, for spans with inclusive and exclusive bounds, instants,
+ *        and queries touching the bounds, sorted by lower bound;
+ *  (ii)  stabbing a timestamp returns the spans containing it;
+ *  (iii) an index of temporal boxes answers as the index of their periods;
+ *  (iv)  an empty index answers nothing and invalid arguments are rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o time_index_test time_index_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_internal.h>
+
+/* Number of time ranges of the index */
+#define NUM_SPANS 5000
+/* Number of query spans */
+#define NUM_QUERIES 300
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a pseudo-random integer in [min, max] */
+static int
+random_int(int min, int max)
+{
+  return min + rand() % (max - min + 1);
+}
+
+/* Return a random timestamptz span of minutes of January 2000, an instant for
+ * one span in four */
+static Span *
+random_span(int maxlen)
+{
+  int start = random_int(0, 40000);
+  int len = (rand() % 4) ? random_int(1, maxlen) : 0;
+  bool lower_inc = ! len || rand() % 2;
+  bool upper_inc = ! len || rand() % 2;
+  TimestampTz t = (TimestampTz) start * 60000000;
+  return tstzspan_make(t, t + (TimestampTz) len * 60000000, lower_inc,
+    upper_inc);
+}
+
+static int
+id_cmp(const void *a, const void *b)
+{
+  int64 x = *(const int64 *) a, y = *(const int64 *) b;
+  return (x > y) - (x < y);
+}
+
+/* Return true if the two arrays have the same ids in any order */
+static bool
+same_ids(MeosArray *ids1, MeosArray *ids2)
+{
+  int n = meos_array_count(ids1);
+  if (n != meos_array_count(ids2))
+    return false;
+  int64 *a = malloc(sizeof(int64) * (n + 1));
+  int64 *b = malloc(sizeof(int64) * (n + 1));
+  for (int i = 0; i < n; i++)
+  {
+    a[i] = *(int64 *) meos_array_get(ids1, i);
+    b[i] = *(int64 *) meos_array_get(ids2, i);
+  }
+  qsort(a, n, sizeof(int64), id_cmp);
+  qsort(b, n, sizeof(int64), id_cmp);
+  bool same = memcmp(a, b, sizeof(int64) * n) == 0;
+  free(a);
+  free(b);
+  return same;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  /* The invalid arguments must report an error instead of exiting */
+  meos_initialize_noexit_error_handler();
+  srand(1);
+
+  Span *spans = malloc(sizeof(Span) * NUM_SPANS);
+  TBox *boxes = malloc(sizeof(TBox) * NUM_SPANS);
+  int64 *ids = malloc(sizeof(int64) * NUM_SPANS);
+  RTree *rtree = rtree_create_tstzspan();
+  for (int i = 0; i < NUM_SPANS; i++)
+  {
+    /* A few long spans among many short ones */
+    Span *span = random_span(i % 10 ? 60 : 5000);
+    spans[i] = *span;
+    free(span);
+    ids[i] = 1000 + i;
+    rtree_insert(rtree, &spans[i], ids[i]);
+    char buf[512], period[256];
+    char *str = tstzspan_out(&spans[i]);
+    snprintf(period, sizeof(period), "%s", str);
+    free(str);
+    snprintf(buf, sizeof(buf), "TBOXFLOAT XT([%d,%d],%s)", i % 100,
+      i % 100 + 5, period);
+    TBox *box = tbox_in(buf);
+    boxes[i] = *box;
+    free(box);
+  }
+  TimeIndex *tindex = timeindex_make_tstzspan(spans, ids, NUM_SPANS);
+  printf("Time index of %d spans:\n", timeindex_count(tindex));
+
+  /* (i) searches */
+  MeosArray *expected = meos_array_create(sizeof(int64));
+  MeosArray *result = meos_array_create(sizeof(int64));
+  RTreeSearchOp ops[] = {RTREE_OVERLAPS, RTREE_CONTAINS, RTREE_CONTAINED_BY};
+  Span *queries[NUM_QUERIES];
+  bool same = true, sorted = true;
+  for (int q = 0; q < NUM_QUERIES; q++)
+  {
+    /* One query in three is a span of the index, touching its bounds */
+    queries[q] = (q % 3) ? random_span(q % 2 ? 3000 : 30) :
+      span_copy(&spans[rand() % NUM_SPANS]);
+    for (int o = 0; o < 3; o++)
+    {
+      rtree_search(rtree, ops[o], queries[q], expected);
+      int n = timeindex_search(tindex, ops[o], queries[q], result);
+      same &= (n == meos_array_count(result)) && same_ids(expected, result);
+      for (int i = 1; i < n; i++)
+      {
+        int64 prev = *(int64 *) meos_array_get(result, i - 1) - 1000;
+        int64 next = *(int64 *) meos_array_get(result, i) - 1000;
+        sorted &= (TimestampTz) spans[prev].lower <=
+          (TimestampTz) spans[next].lower;
+      }
+    }
+  }
+  check("(i) the searches return the ids of the RTree", same);
+  check("(i) the ids are sorted by lower bound", sorted);
+
+  /* (ii) stabbing queries */
+  same = true;
+  for (int q = 0; q < NUM_QUERIES && same; q++)
+  {
+    /* Stab at the bounds of the spans as well as anywhere */
+    TimestampTz t = (TimestampTz) (q % 2 ? spans[q].lower :
+      queries[q]->upper);
+    Span *instant = timestamptz_to_span(t);
+    rtree_search(rtree, RTREE_CONTAINS, instant, expected);
+    timeindex_stab(tindex, t, result);
+    same = same_ids(expected, result);
+    free(instant);
+  }
+  check("(ii) stabbing returns the spans containing the timestamp", same);
+
+  /* (iii) temporal boxes */
+  TimeIndex *boxindex = timeindex_make_tbox(boxes, ids, NUM_SPANS);
+  same = (boxindex != NULL);
+  for (int q = 0; q < NUM_QUERIES && same; q++)
+  {
+    for (int o = 0; o < 3; o++)
+    {
+      timeindex_search(tindex, ops[o], queries[q], expected);
+      timeindex_search(boxindex, ops[o], queries[q], result);
+      same &= same_ids(expected, result);
+    }
+  }
+  check("(iii) the boxes are indexed by their period", same);
+  timeindex_free(boxindex);
+
+  /* (iv) empty index and invalid arguments */
+  TimeIndex *empty = timeindex_make_tstzspan(NULL, NULL, 0);
+  check("(iv) an empty index answers nothing", empty &&
+    timeindex_count(empty) == 0 &&
+    timeindex_search(empty, RTREE_OVERLAPS, queries[0], result) == 0);
+  timeindex_free(empty);
+  meos_errno_reset();
+  Span *intspan = intspan_make(1, 5, true, false);
+  bool rejected = timeindex_search(tindex, RTREE_OVERLAPS, intspan,
+    result) == -1 && meos_errno() != 0;
+  meos_errno_reset();
+  TBox *notime = tbox_in("TBOXFLOAT X([1,2])");
+  rejected &= timeindex_make_tbox(notime, ids, 1) == NULL &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= timeindex_make_tstzspan(intspan, ids, 1) == NULL;
+  meos_errno_reset();
+  check("(iv) invalid arguments are rejected", rejected);
+  free(intspan);
+  free(notime);
+
+  for (int q = 0; q < NUM_QUERIES; q++)
+    free(queries[q]);
+  meos_array_destroy(expected);
+  meos_array_destroy(result);
+  timeindex_free(tindex);
+  rtree_free(rtree);
+  free(spans);
+  free(boxes);
+  free(ids);
+
+  printf(failures ? "\nSome time index tests FAILED.\n" :
+    "\nAll time index tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,286 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the packed encoding of temporal point
+ * sequences.
+ *
+ * Five properties are asserted:
+ *  (i)   the conversion of a temporal point sequence to the packed encoding
+ *        and back is lossless, for every interpolation and dimension, and
+ *        the packed encoding is smaller;
+ *  (ii)  the packed constructor and the constructor from coordinates give
+ *        the same sequence;
+ *  (iii) the value at a timestamp is that of the sequence, including at the
+ *        bounds of the sequence and of its segments;
+ *  (iv)  the length, the speed, and the nearest approach distance are those
+ *        of the sequence;
+ *  (v)   invalid arguments are rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o tpoint_packed_test tpoint_packed_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of instants of the generated sequences */
+#define NUM_INSTANTS 1000
+/* Number of timestamps probed in every sequence */
+#define NUM_PROBES 500
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return true if two doubles are equal up to a relative tolerance */
+static bool
+close_to(double a, double b)
+{
+  return fabs(a - b) <= 1e-9 * fmax(1.0, fmax(fabs(a), fabs(b)));
+}
+
+/* Return true if the packed sequence has the values of the sequence at the
+ * probed timestamps */
+static bool
+same_values(const TSequence *seq, const TPointSeqPacked *pseq, bool strict)
+{
+  TimestampTz lower = (TimestampTz) seq->period.lower,
+    upper = (TimestampTz) seq->period.upper;
+  for (int i = -1; i <= NUM_PROBES + 1; i++)
+  {
+    TimestampTz t = lower + (upper - lower) / NUM_PROBES * i;
+    if (i == NUM_PROBES)
+      t = upper;
+    GSERIALIZED *v1 = NULL, *v2 = NULL;
+    bool found1 = tgeo_value_at_timestamptz((Temporal *) seq, t, strict, &v1);
+    bool found2 = tpointseq_packed_value_at_timestamptz(pseq, t, strict, &v2);
+    bool same = (found1 == found2) && (! found1 || geo_same(v1, v2));
+    if (found1)
+      free(v1);
+    if (found2)
+      free(v2);
+    if (! same)
+      return false;
+  }
+  /* The timestamps of the instants */
+  for (int i = 0; i < seq->count; i++)
+  {
+    TInstant *inst = temporal_instant_n((Temporal *) seq, i + 1);
+    GSERIALIZED *v1 = NULL, *v2 = NULL;
+    bool found1 = tgeo_value_at_timestamptz((Temporal *) seq, inst->t, strict,
+      &v1);
+    bool found2 = tpointseq_packed_value_at_timestamptz(pseq, inst->t, strict,
+      &v2);
+    bool same = (found1 == found2) && (! found1 || geo_same(v1, v2));
+    if (found1)
+      free(v1);
+    if (found2)
+      free(v2);
+    free(inst);
+    if (! same)
+      return false;
+  }
+  return true;
+}
+
+/* Return a random walk as arrays of coordinates and timestamps */
+static void
+random_walk(double *x, double *y, double *z, TimestampTz *t, int count)
+{
+  TimestampTz start = timestamptz_in("2000-01-01 00:00:00+00", -1);
+  for (int i = 0; i < count; i++)
+  {
+    double step = (double) (rand() % 1000) / 100.0;
+    x[i] = (i == 0) ? 4.35 : x[i - 1] + ((rand() % 3) - 1) * step * 1e-3;
+    y[i] = (i == 0) ? 50.85 : y[i - 1] + ((rand() % 3) - 1) * step * 1e-3;
+    z[i] = (i == 0) ? 10.0 : z[i - 1] + ((rand() % 3) - 1) * step;
+    /* Stops, i.e., repeated points, every tenth instant */
+    if (i > 0 && i % 10 == 0)
+    {
+      x[i] = x[i - 1]; y[i] = y[i - 1]; z[i] = z[i - 1];
+    }
+    t[i] = start + (TimestampTz) i * 1000000 * (1 + rand() % 60);
+    if (i > 0 && t[i] <= t[i - 1])
+      t[i] = t[i - 1] + 1000000;
+  }
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  meos_initialize_noexit_error_handler();
+  meos_initialize_timezone("UTC");
+  srand(1);
+
+  double *x = malloc(sizeof(double) * NUM_INSTANTS);
+  double *y = malloc(sizeof(double) * NUM_INSTANTS);
+  double *z = malloc(sizeof(double) * NUM_INSTANTS);
+  TimestampTz *t = malloc(sizeof(TimestampTz) * NUM_INSTANTS);
+  random_walk(x, y, z, t, NUM_INSTANTS);
+
+  /* The sequences tested: planar and geodetic, 2D and 3D, for every
+   * interpolation and with inclusive or exclusive bounds */
+  const interpType interps[] = {LINEAR, STEP, DISCRETE};
+  bool lossless = true, smaller = true, same_make = true, values = true,
+    length = true, speed = true, nad = true;
+  int nseqs = 0;
+  for (int geodetic = 0; geodetic <= 1; geodetic++)
+  for (int hasz = 0; hasz <= 1; hasz++)
+  for (int k = 0; k < 3; k++)
+  for (int bounds = 0; bounds <= 1; bounds++)
+  {
+    interpType interp = interps[k];
+    /* A step sequence with an exclusive upper bound needs equal end values */
+    bool lower_inc = (interp == DISCRETE) || bounds == 0;
+    bool upper_inc = (interp != LINEAR) || bounds == 0;
+    int count = (nseqs % 4 == 3) ? 1 : NUM_INSTANTS;
+    if (count == 1)
+      lower_inc = upper_inc = true;
+    TSequence *seq = tpointseq_make_coords(x, y, hasz ? z : NULL, t, count,
+      4326, geodetic, lower_inc, upper_inc, interp, false);
+    nseqs++;
+
+    /* (i) round trip */
+    TPointSeqPacked *pseq = tpointseq_to_packed(seq);
+    TSequence *seq1 = tpointseq_from_packed(pseq);
+    lossless &= pseq && seq1 && temporal_eq((Temporal *) seq,
+      (Temporal *) seq1) &&
+      temporal_mem_size((Temporal *) seq) ==
+        temporal_mem_size((Temporal *) seq1) &&
+      tpointseq_packed_num_instants(pseq) == seq->count;
+    if (count > 1)
+      smaller &= tpointseq_packed_mem_size(pseq) * 2 <
+        temporal_mem_size((Temporal *) seq);
+    TInstant *inst1 = temporal_instant_n((Temporal *) seq, count);
+    TInstant *inst2 = tpointseq_packed_instant_n(pseq, count);
+    lossless &= inst2 && temporal_eq((Temporal *) inst1, (Temporal *) inst2) &&
+      tpointseq_packed_instant_n(pseq, count + 1) == NULL;
+    free(inst1); free(inst2);
+
+    /* (ii) constructor */
+    TPointSeqPacked *pseq1 = tpointseq_packed_make(x, y, hasz ? z : NULL, t,
+      count, 4326, geodetic, lower_inc, upper_inc, interp);
+    same_make &= pseq1 && tpointseq_packed_mem_size(pseq1) ==
+      tpointseq_packed_mem_size(pseq) &&
+      memcmp(pseq1, pseq, tpointseq_packed_mem_size(pseq)) == 0;
+
+    /* (iii) value at timestamp */
+    values &= same_values(seq, pseq, true) && same_values(seq, pseq, false);
+
+    /* (iv) length, speed, and distance */
+    length &= close_to(tpoint_length((Temporal *) seq),
+      tpointseq_packed_length(pseq));
+    if (interp == LINEAR)
+    {
+      Temporal *speed1 = tpoint_speed((Temporal *) seq);
+      TSequence *speed2 = tpointseq_packed_speed(pseq);
+      speed &= (speed1 == NULL && speed2 == NULL) ||
+        (speed1 && speed2 && temporal_eq(speed1, (Temporal *) speed2));
+      free(speed1); free(speed2);
+    }
+    const char *wkt[] = {"SRID=4326;POINT(4.36 50.84)",
+      "SRID=4326;POINT(4.30 50.90)", "SRID=4326;POINT Z(4.36 50.84 12)",
+      "SRID=4326;LINESTRING(4.30 50.80,4.40 50.90)"};
+    for (int i = 0; i < 4; i++)
+    {
+      if ((i == 2) != (bool) hasz && i != 3)
+        continue;
+      if (i == 3 && hasz)
+        continue;
+      GSERIALIZED *gs = geodetic ? geog_in(wkt[i], -1) : geom_in(wkt[i], -1);
+      double d1 = nad_tgeo_geo((Temporal *) seq, gs);
+      double d2 = nad_tpointseq_packed_geo(pseq, gs);
+      if (! close_to(d1, d2))
+      {
+        printf("  nad %s: %.12f %.12f\n", wkt[i], d1, d2);
+        nad = false;
+      }
+      free(gs);
+    }
+    free(seq); free(seq1); free(pseq); free(pseq1);
+  }
+  printf("  %d sequences of up to %d instants\n", nseqs, NUM_INSTANTS);
+  check("(i) the conversion to the packed encoding is lossless", lossless);
+  check("(i) the packed encoding takes less than half the bytes", smaller);
+  check("(ii) the packed constructor gives the converted sequence",
+    same_make);
+  check("(iii) the values at timestamps are those of the sequence", values);
+  check("(iv) the length is that of the sequence", length);
+  check("(iv) the speed is that of the sequence", speed);
+  check("(iv) the nearest approach distance is that of the sequence", nad);
+
+  /* (v) invalid arguments */
+  TimestampTz tdup[2] = {t[0], t[0]};
+  meos_errno_reset();
+  bool rejected = tpointseq_packed_make(x, y, NULL, tdup, 2, 4326, false,
+    true, true, LINEAR) == NULL && meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= tpointseq_packed_make(x, y, NULL, t, 1, 4326, false, false,
+    true, LINEAR) == NULL && meos_errno() != 0;
+  meos_errno_reset();
+  Temporal *tfloat = tfloat_in("[1@2000-01-01, 2@2000-01-02]");
+  rejected &= tpointseq_to_packed((TSequence *) tfloat) == NULL &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  TPointSeqPacked *pseq = tpointseq_packed_make(x, y, NULL, t, 10, 4326,
+    false, true, true, STEP);
+  rejected &= tpointseq_packed_speed(pseq) == NULL && meos_errno() != 0;
+  meos_errno_reset();
+  GSERIALIZED *gs = geom_in("SRID=3812;POINT(1 1)", -1);
+  rejected &= nad_tpointseq_packed_geo(pseq, gs) == DBL_MAX &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  check("(v) invalid arguments are rejected", rejected);
+  free(tfloat); free(pseq); free(gs);
+
+  free(x); free(y); free(z); free(t);
+
+  printf(failures ? "\nSome packed temporal point tests FAILED.\n" :
+    "\nAll packed temporal point tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
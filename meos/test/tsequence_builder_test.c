@@ -0,0 +1,350 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the functions that construct temporal
+ * sequences by appending their instants in place, which are used by the
+ * lifted functions and by the restriction to the complement of a timestamp
+ * set.
+ *
+ * Five properties are asserted:
+ *  (i)   lifting a sequence and a base value gives the sequence made of the
+ *        lifted instants, for linear and step interpolation and for
+ *        inclusive and exclusive bounds;
+ *  (ii)  the same holds when lifting two sequences, where the last value of
+ *        a step result with exclusive upper bound is the previous one;
+ *  (iii) the results of lifted functions with turning points are normalized
+ *        and have no space for additional instants;
+ *  (iv)  the restriction of a value to the complement of a timestamp set
+ *        is not defined at the set and keeps the other values;
+ *  (v)   the results above have the bounding box of their instants.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o tsequence_builder_test tsequence_builder_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <meos.h>
+#include <meos_internal.h>
+
+/* Number of instants of the generated sequences */
+#define NUM_INSTANTS 1000
+/* Number of values tested for every property */
+#define NUM_TESTS 50
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return a random walk as arrays of values and timestamps, where the values
+ * are repeated or collinear from time to time */
+static void
+random_walk(double *x, TimestampTz *t, TimestampTz start, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    int r = rand() % 4;
+    x[i] = (i == 0) ? 1.0 : (r == 0) ? x[i - 1] :
+      (r == 1) ? x[i - 1] + 1.0 : (double) (rand() % 1000) / 100.0;
+    t[i] = start + (TimestampTz) i * 1000000 * (1 + rand() % 60);
+    if (i > 0 && t[i] <= t[i - 1])
+      t[i] = t[i - 1] + 1000000;
+  }
+  return;
+}
+
+/* Return a temporal float sequence with the values and timestamps */
+static TSequence *
+tfloatseq_from_arrays(const double *x, const TimestampTz *t, int count,
+  bool lower_inc, bool upper_inc, interpType interp)
+{
+  TInstant **instants = malloc(sizeof(TInstant *) * count);
+  for (int i = 0; i < count; i++)
+    instants[i] = tfloatinst_make(x[i], t[i]);
+  TSequence *result = tsequence_make(instants, count, lower_inc, upper_inc,
+    interp, true);
+  for (int i = 0; i < count; i++)
+    free(instants[i]);
+  free(instants);
+  return result;
+}
+
+/* Return true if a sequence is equal to the one made of its instants, with
+ * the same bounding box and size */
+static bool
+same_as_rebuilt(const TSequence *seq)
+{
+  int count;
+  TInstant **instants = temporal_instants((Temporal *) seq, &count);
+  TSequence *rebuilt = tsequence_make(instants, count, seq->period.lower_inc,
+    seq->period.upper_inc, MEOS_FLAGS_GET_INTERP(seq->flags), true);
+  TBox *box1 = tnumber_to_tbox((Temporal *) seq);
+  TBox *box2 = tnumber_to_tbox((Temporal *) rebuilt);
+  bool result = rebuilt && seq->count == seq->maxcount &&
+    temporal_eq((Temporal *) seq, (Temporal *) rebuilt) &&
+    tbox_eq(box1, box2) && span_eq(&box1->span, &box2->span) &&
+    temporal_mem_size((Temporal *) seq) ==
+      temporal_mem_size((Temporal *) rebuilt);
+  for (int i = 0; i < count; i++)
+    free(instants[i]);
+  free(instants); free(rebuilt); free(box1); free(box2);
+  return result;
+}
+
+/* Return true if all the sequences of a temporal value are equal to the
+ * ones made of their instants */
+static bool
+same_as_rebuilt_temporal(const Temporal *temp)
+{
+  if (! temp)
+    return false;
+  if (temp->subtype == TINSTANT)
+    return true;
+  if (temp->subtype == TSEQUENCE)
+    return same_as_rebuilt((TSequence *) temp);
+  int count;
+  TSequence **sequences = temporal_sequences(temp, &count);
+  bool result = true;
+  for (int i = 0; i < count; i++)
+  {
+    result &= same_as_rebuilt(sequences[i]);
+    free(sequences[i]);
+  }
+  free(sequences);
+  return result;
+}
+
+/* Return true if a temporal value is equal to the expected one, with the
+ * same bounding box and size */
+static bool
+same_value(const Temporal *temp, const TSequence *expected)
+{
+  if (! temp || ! expected || temp->subtype != TSEQUENCE)
+    return false;
+  TBox *box1 = tnumber_to_tbox(temp);
+  TBox *box2 = tnumber_to_tbox((Temporal *) expected);
+  bool result = temporal_eq(temp, (Temporal *) expected) &&
+    tbox_eq(box1, box2) && span_eq(&box1->span, &box2->span) &&
+    temporal_mem_size(temp) == temporal_mem_size((Temporal *) expected);
+  free(box1); free(box2);
+  return result;
+}
+
+/* Return the expected sum of two sequences computed at the union of their
+ * timestamps in the intersection of their time spans, or NULL if the sum is
+ * not a sequence */
+static TSequence *
+expected_sum(const TSequence *seq1, const TSequence *seq2)
+{
+  Span *inter = intersection_span_span(&seq1->period, &seq2->period);
+  /* The result is an instant when the sequences only share one timestamp */
+  if (! inter || inter->lower == inter->upper)
+  {
+    free(inter);
+    return NULL;
+  }
+  TimestampTz lower = inter->lower, upper = inter->upper;
+  TInstant **instants = malloc(sizeof(TInstant *) *
+    (seq1->count + seq2->count));
+  int i = 0, j = 0, count = 0;
+  double prev = 0.0, last = 0.0;
+  while (i < seq1->count || j < seq2->count)
+  {
+    TimestampTz t1 = (i < seq1->count) ? TSEQUENCE_INST_N(seq1, i)->t :
+      upper + 1;
+    TimestampTz t2 = (j < seq2->count) ? TSEQUENCE_INST_N(seq2, j)->t :
+      upper + 1;
+    TimestampTz t = (t1 < t2) ? t1 : t2;
+    if (t1 <= t2) i++;
+    if (t2 <= t1) j++;
+    if (t < lower || t > upper)
+      continue;
+    double v1, v2;
+    tfloat_value_at_timestamptz((Temporal *) seq1, t, false, &v1);
+    tfloat_value_at_timestamptz((Temporal *) seq2, t, false, &v2);
+    prev = last;
+    last = v1 + v2;
+    instants[count++] = tfloatinst_make(last, t);
+  }
+  interpType interp = MEOS_FLAGS_GET_INTERP(seq1->flags);
+  /* The last two values of a step sequence with exclusive upper bound must
+   * be equal */
+  if (interp == STEP && ! inter->upper_inc && count > 1)
+  {
+    TInstant *inst = instants[count - 1];
+    instants[count - 1] = tfloatinst_make(prev, inst->t);
+    free(inst);
+  }
+  TSequence *result = tsequence_make(instants, count, inter->lower_inc,
+    inter->upper_inc, interp, true);
+  for (int k = 0; k < count; k++)
+    free(instants[k]);
+  free(instants); free(inter);
+  return result;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  meos_initialize_noexit_error_handler();
+  meos_initialize_timezone("UTC");
+  srand(1);
+
+  double *x = malloc(sizeof(double) * NUM_INSTANTS);
+  double *y = malloc(sizeof(double) * NUM_INSTANTS);
+  TimestampTz *t = malloc(sizeof(TimestampTz) * NUM_INSTANTS);
+  TimestampTz *u = malloc(sizeof(TimestampTz) * NUM_INSTANTS);
+  TimestampTz start = timestamptz_in("2000-01-01 00:00:00+00", -1);
+
+  /* (i) lifting a sequence and a base value */
+  bool base = true, rebuilt = true;
+  for (int i = 0; i < NUM_TESTS; i++)
+  {
+    int count = 1 + rand() % NUM_INSTANTS;
+    random_walk(x, t, start, count);
+    interpType interp = (i % 2 == 0) ? LINEAR : STEP;
+    bool lower_inc = (count == 1) || rand() % 2;
+    bool upper_inc = (count == 1) || rand() % 2;
+    /* A step sequence with an exclusive upper bound needs equal end values */
+    if (interp == STEP && ! upper_inc)
+      x[count - 1] = x[count - 2];
+    TSequence *seq = tfloatseq_from_arrays(x, t, count, lower_inc, upper_inc,
+      interp);
+    for (int k = 0; k < count; k++)
+      y[k] = x[k] + 2.5;
+    TSequence *expected = tfloatseq_from_arrays(y, t, count, lower_inc,
+      upper_inc, interp);
+    Temporal *res = add_tfloat_float((Temporal *) seq, 2.5);
+    base &= same_value(res, expected);
+    rebuilt &= same_as_rebuilt_temporal(res);
+    free(seq); free(expected); free(res);
+  }
+  check("(i) lifting a sequence and a base value", base);
+
+  /* (ii) lifting two sequences */
+  bool temporal = true;
+  for (int i = 0; i < NUM_TESTS; i++)
+  {
+    int count = 2 + rand() % (NUM_INSTANTS - 1);
+    interpType interp = (i % 2 == 0) ? LINEAR : STEP;
+    random_walk(x, t, start, count);
+    random_walk(y, u, start + (TimestampTz) (rand() % 3600) * 1000000, count);
+    bool upper_inc1 = rand() % 2;
+    bool upper_inc2 = rand() % 2;
+    if (interp == STEP)
+    {
+      if (! upper_inc1)
+        x[count - 1] = x[count - 2];
+      if (! upper_inc2)
+        y[count - 1] = y[count - 2];
+    }
+    TSequence *seq1 = tfloatseq_from_arrays(x, t, count, rand() % 2,
+      upper_inc1, interp);
+    TSequence *seq2 = tfloatseq_from_arrays(y, u, count, rand() % 2,
+      upper_inc2, interp);
+    TSequence *expected = expected_sum(seq1, seq2);
+    Temporal *res = add_tnumber_tnumber((Temporal *) seq1, (Temporal *) seq2);
+    temporal &= expected ? same_value(res, expected) :
+      (! res || res->subtype == TINSTANT);
+    if (res)
+      rebuilt &= same_as_rebuilt_temporal(res);
+    free(seq1); free(seq2); free(expected); free(res);
+  }
+  check("(ii) lifting two sequences", temporal);
+
+  /* (iii) lifting with turning points */
+  bool turnpt = true;
+  for (int i = 0; i < NUM_TESTS; i++)
+  {
+    int count = 2 + rand() % (NUM_INSTANTS - 1);
+    random_walk(x, t, start, count);
+    random_walk(y, u, start, count);
+    TSequence *seq1 = tfloatseq_from_arrays(x, t, count, true, true, LINEAR);
+    TSequence *seq2 = tfloatseq_from_arrays(y, u, count, true, true, LINEAR);
+    Temporal *res1 = mul_tnumber_tnumber((Temporal *) seq1,
+      (Temporal *) seq2);
+    Temporal *res2 = tfloat_sin((Temporal *) seq1);
+    turnpt &= res1 && res2 && same_as_rebuilt_temporal(res1) &&
+      same_as_rebuilt_temporal(res2);
+    free(seq1); free(seq2); free(res1); free(res2);
+  }
+  check("(iii) lifting with turning points gives normalized values", turnpt);
+
+  /* (iv) restriction to the complement of a timestamp set */
+  bool minus = true;
+  for (int i = 0; i < NUM_TESTS; i++)
+  {
+    int count = 2 + rand() % (NUM_INSTANTS - 1);
+    interpType interp = (i % 2 == 0) ? LINEAR : STEP;
+    random_walk(x, t, start, count);
+    TSequence *seq = tfloatseq_from_arrays(x, t, count, true, true, interp);
+    /* Timestamps inside and outside the sequence, some of them at instants */
+    int ntimes = 1 + rand() % 20;
+    for (int k = 0; k < ntimes; k++)
+      u[k] = (rand() % 3 == 0) ? t[rand() % count] :
+        t[0] - 1000000 + (t[count - 1] - t[0] + 2000000) / ntimes * k;
+    Set *s = tstzset_make(u, ntimes);
+    Temporal *minus1 = temporal_minus_tstzset((Temporal *) seq, s);
+    Temporal *at = minus1 ? temporal_at_tstzset(minus1, s) : NULL;
+    minus &= minus1 && ! at && same_as_rebuilt_temporal(minus1);
+    /* The values at the other instants are kept */
+    for (int k = 0; minus1 && k < count; k += 7)
+    {
+      if (contains_set_timestamptz(s, t[k]))
+        continue;
+      double v1, v2;
+      minus &= tfloat_value_at_timestamptz(minus1, t[k], true, &v1) &&
+        tfloat_value_at_timestamptz((Temporal *) seq, t[k], true, &v2) &&
+        v1 == v2;
+    }
+    free(seq); free(s); free(minus1); free(at);
+  }
+  check("(iv) the restriction to the complement of a set", minus);
+
+  /* (v) bounding boxes */
+  check("(v) the results have the bounding box of their instants", rebuilt);
+
+  free(x); free(y); free(t); free(u);
+
+  printf(failures ? "\nSome temporal sequence builder tests FAILED.\n" :
+    "\nAll temporal sequence builder tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,274 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the compressed encoding of temporal sequences.
+ *
+ * Four properties are asserted:
+ *  (i)   the compression without quantization is lossless for temporal floats
+ *        and temporal points, for every interpolation and dimension;
+ *  (ii)  the compression with quantization keeps the timestamps and rounds
+ *        the values to the precision, and a regularly sampled trip takes
+ *        a fraction of its bytes;
+ *  (iii) the value at a timestamp is that of the decompressed sequence,
+ *        including at the bounds of the blocks;
+ *  (iv)  invalid arguments are rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o tsequence_comp_test tsequence_comp_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of instants of the generated sequences, more than two blocks */
+#define NUM_INSTANTS 1000
+/* Number of timestamps probed in every sequence */
+#define NUM_PROBES 700
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return true if two values of a temporal type are equal, floats being
+ * passed by value so that equal floats are equal datums */
+static bool
+same_value(MeosType temptype, Datum value1, Datum value2)
+{
+  if (temptype == T_TFLOAT)
+    return value1 == value2;
+  return geo_same((GSERIALIZED *) DatumGetPointer(value1),
+    (GSERIALIZED *) DatumGetPointer(value2));
+}
+
+/* Return true if the compressed sequence has the values of the sequence at
+ * the probed timestamps and at the timestamps of the instants */
+static bool
+same_values(const TSequence *seq, const TSequenceComp *cseq, bool strict)
+{
+  TimestampTz lower = (TimestampTz) seq->period.lower,
+    upper = (TimestampTz) seq->period.upper;
+  int nprobes = NUM_PROBES + 2 + seq->count;
+  for (int i = 0; i < nprobes; i++)
+  {
+    TimestampTz t = (i <= NUM_PROBES + 1) ?
+      lower + (upper - lower) / NUM_PROBES * (i - 1) :
+      TSEQUENCE_INST_N(seq, i - NUM_PROBES - 2)->t;
+    Datum value1, value2;
+    bool found1 = tsequence_value_at_timestamptz(seq, t, strict, &value1);
+    bool found2 = tsequencecomp_value_at_timestamptz(cseq, t, strict,
+      &value2);
+    bool same = (found1 == found2) &&
+      (! found1 || same_value(seq->temptype, value1, value2));
+    if (found1 && seq->temptype != T_TFLOAT)
+      free(DatumGetPointer(value1));
+    if (found2 && seq->temptype != T_TFLOAT)
+      free(DatumGetPointer(value2));
+    if (! same)
+      return false;
+  }
+  return true;
+}
+
+/* Return a regularly sampled trip as arrays of coordinates, speeds, and
+ * timestamps, with a gap in the sampling every hundred instants */
+static void
+regular_trip(double *x, double *y, double *z, double *speed, TimestampTz *t,
+  int count)
+{
+  TimestampTz start = timestamptz_in("2000-01-01 00:00:00+00", -1);
+  double vx = 1e-4, vy = 5e-5;
+  for (int i = 0; i < count; i++)
+  {
+    if (i % 50 == 0)
+    {
+      vx = ((rand() % 200) - 100) * 1e-6;
+      vy = ((rand() % 200) - 100) * 1e-6;
+    }
+    x[i] = (i == 0) ? 4.35 : x[i - 1] + vx + (rand() % 10) * 1e-7;
+    y[i] = (i == 0) ? 50.85 : y[i - 1] + vy + (rand() % 10) * 1e-7;
+    z[i] = (i == 0) ? 10.0 : z[i - 1] + ((rand() % 3) - 1) * 0.5;
+    speed[i] = (i == 0) ? 12.5 : speed[i - 1] + ((rand() % 5) - 2) * 0.1;
+    t[i] = start + (TimestampTz) i * 10000000;
+    if (i % 100 == 99)
+      start += 3600000000;
+  }
+  return;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  meos_initialize_noexit_error_handler();
+  meos_initialize_timezone("UTC");
+  srand(1);
+
+  double *x = malloc(sizeof(double) * NUM_INSTANTS);
+  double *y = malloc(sizeof(double) * NUM_INSTANTS);
+  double *z = malloc(sizeof(double) * NUM_INSTANTS);
+  double *speed = malloc(sizeof(double) * NUM_INSTANTS);
+  TimestampTz *t = malloc(sizeof(TimestampTz) * NUM_INSTANTS);
+  regular_trip(x, y, z, speed, t, NUM_INSTANTS);
+  /* The values rounded to 6 digits */
+  double *xr = malloc(sizeof(double) * NUM_INSTANTS);
+  double *yr = malloc(sizeof(double) * NUM_INSTANTS);
+  double *zr = malloc(sizeof(double) * NUM_INSTANTS);
+  double *sr = malloc(sizeof(double) * NUM_INSTANTS);
+  for (int i = 0; i < NUM_INSTANTS; i++)
+  {
+    xr[i] = (double) llround(x[i] * 1e6) / 1e6;
+    yr[i] = (double) llround(y[i] * 1e6) / 1e6;
+    zr[i] = (double) llround(z[i] * 1e6) / 1e6;
+    sr[i] = (double) llround(speed[i] * 1e6) / 1e6;
+  }
+
+  /* The sequences tested: temporal floats and planar and geodetic points in
+   * 2D and 3D, for every interpolation and with inclusive or exclusive
+   * bounds */
+  const interpType interps[] = {LINEAR, STEP, DISCRETE};
+  bool lossless = true, values = true, quantized = true, rounded = true,
+    small_points = true, small_floats = true;
+  int nseqs = 0;
+  for (int type = 0; type < 5; type++)
+  for (int k = 0; k < 3; k++)
+  for (int bounds = 0; bounds <= 1; bounds++)
+  {
+    interpType interp = interps[k];
+    bool lower_inc = (interp == DISCRETE) || bounds == 0;
+    bool upper_inc = (interp != LINEAR) || bounds == 0;
+    int count = (nseqs % 5 == 4) ? 1 + nseqs : NUM_INSTANTS;
+    if (count == 1)
+      lower_inc = upper_inc = true;
+    TSequence *seq;
+    if (type == 0)
+    {
+      TInstant **instants = malloc(sizeof(TInstant *) * count);
+      for (int i = 0; i < count; i++)
+        instants[i] = tfloatinst_make(speed[i], t[i]);
+      seq = tsequence_make_free(instants, count, lower_inc, upper_inc,
+        interp, false);
+    }
+    else
+      seq = tpointseq_make_coords(x, y, (type > 2) ? z : NULL, t, count, 4326,
+        type % 2 == 0, lower_inc, upper_inc, interp, false);
+    nseqs++;
+
+    /* (i) lossless compression */
+    TSequenceComp *cseq = tsequence_compress(seq, -1);
+    TSequence *seq1 = tsequence_decompress(cseq);
+    lossless &= cseq && seq1 && temporal_eq((Temporal *) seq,
+      (Temporal *) seq1) && tsequencecomp_num_instants(cseq) == seq->count;
+
+    /* (iii) value at timestamp */
+    values &= same_values(seq, cseq, true) && same_values(seq, cseq, false);
+
+    /* (ii) quantized compression */
+    TSequenceComp *qseq = tsequence_compress(seq, 6);
+    TSequence *seq2 = tsequence_decompress(qseq);
+    quantized &= qseq && seq2 && seq2->count == seq->count &&
+      same_values(seq2, qseq, true);
+    TSequence *expected;
+    if (type == 0)
+    {
+      TInstant **instants = malloc(sizeof(TInstant *) * count);
+      for (int i = 0; i < count; i++)
+        instants[i] = tfloatinst_make(sr[i], t[i]);
+      expected = tsequence_make_free(instants, count, lower_inc, upper_inc,
+        interp, false);
+    }
+    else
+      expected = tpointseq_make_coords(xr, yr, (type > 2) ? zr : NULL, t,
+        count, 4326, type % 2 == 0, lower_inc, upper_inc, interp, false);
+    rounded &= seq2 && temporal_eq((Temporal *) seq2, (Temporal *) expected);
+    free(expected);
+    if (type == 1 && interp == LINEAR && count == NUM_INSTANTS)
+      printf("  %d instants of a 2D point: %d bytes, %d bytes lossless, "
+        "%d bytes quantized\n", count, (int) temporal_mem_size((Temporal *) seq),
+        (int) tsequencecomp_mem_size(cseq), (int) tsequencecomp_mem_size(qseq));
+    if (type == 1 && count == NUM_INSTANTS)
+      small_points &= tsequencecomp_mem_size(qseq) * 10 <
+        temporal_mem_size((Temporal *) seq);
+    if (type == 0 && count == NUM_INSTANTS)
+      small_floats &= tsequencecomp_mem_size(cseq) * 2 <
+        temporal_mem_size((Temporal *) seq);
+    free(seq); free(seq1); free(seq2); free(cseq); free(qseq);
+  }
+  printf("  %d sequences of up to %d instants\n", nseqs, NUM_INSTANTS);
+  check("(i) the compression without quantization is lossless", lossless);
+  check("(ii) the quantized values are rounded to the precision", rounded);
+  check("(ii) the quantized sequence is decompressed", quantized);
+  check("(ii) a quantized 2D trip takes less than a tenth of its bytes",
+    small_points);
+  check("(ii) a float sequence takes less than half of its bytes",
+    small_floats);
+  check("(iii) the values at timestamps are those of the sequence", values);
+
+  /* (iv) invalid arguments */
+  Temporal *tint = tint_in("[1@2000-01-01, 2@2000-01-02]");
+  Temporal *tfloat = tfloat_in("[1@2000-01-01, 1e300@2000-01-02]");
+  Temporal *tfloatinst = tfloat_in("1@2000-01-01");
+  meos_errno_reset();
+  bool rejected = tsequence_compress((TSequence *) tint, -1) == NULL &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= tsequence_compress((TSequence *) tfloat, 16) == NULL &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= tsequence_compress((TSequence *) tfloat, 6) == NULL &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= tsequence_compress((TSequence *) tfloatinst, -1) == NULL &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  check("(iv) invalid arguments are rejected", rejected);
+  free(tint); free(tfloat); free(tfloatinst);
+
+  free(x); free(y); free(z); free(speed); free(t);
+  free(xr); free(yr); free(zr); free(sr);
+
+  printf(failures ? "\nSome compressed sequence tests FAILED.\n" :
+    "\nAll compressed sequence tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,317 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief A program that tests the functions that compute an aggregate of a
+ * temporal value restricted to a time span on views of its sequences
+ * instead of on the restriction.
+ *
+ * Five properties are asserted:
+ *  (i)   the integral of a temporal number restricted to a span is the
+ *        integral of the restriction, for linear and step interpolation,
+ *        for sequences and sequence sets, and for spans with inclusive and
+ *        exclusive bounds inside, around, and outside the value;
+ *  (ii)  the same holds for the length of planar and geodetic, 2D and 3D
+ *        temporal points;
+ *  (iii) the restriction of a sequence to a span, which is constructed from
+ *        a view, keeps its instants and bounds;
+ *  (iv)  a subsequence between two instants ends with the last instant;
+ *  (v)   invalid arguments are rejected.
+ *
+ * The program can be built as follows
+ * @code
+ * gcc -Wall -g -I/usr/local/include -o tsequence_view_test tsequence_view_test.c -L/usr/local/lib -lmeos -lm
+ * @endcode
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <meos.h>
+#include <meos_geo.h>
+#include <meos_internal.h>
+
+/* Number of instants of the generated sequences */
+#define NUM_INSTANTS 1000
+/* Number of spans probed in every value */
+#define NUM_PROBES 300
+
+static int failures = 0;
+
+static void
+check(const char *name, bool ok)
+{
+  printf("  %-58s %s\n", name, ok ? "OK" : "FAILED");
+  if (! ok)
+    failures++;
+}
+
+/* Return true if two doubles are equal up to a relative tolerance */
+static bool
+close_to(double a, double b)
+{
+  return fabs(a - b) <= 1e-9 * fmax(1.0, fmax(fabs(a), fabs(b)));
+}
+
+/* Return a random number between 0 and a bound */
+static int64
+random_int64(int64 bound)
+{
+  return ((((int64) rand()) << 31) | rand()) % bound;
+}
+
+/* Return a random span around the time span of a temporal value, which is
+ * instantaneous or starts or ends at an instant from time to time */
+static Span *
+random_span(const Temporal *temp, int i)
+{
+  Span *period = temporal_to_tstzspan(temp);
+  TimestampTz lower = period->lower, upper = period->upper;
+  TimestampTz width = (upper - lower) / 10 + 1;
+  TimestampTz t1 = lower - width + random_int64(upper - lower + 2 * width);
+  TimestampTz t2 = t1 + random_int64(width);
+  if (i % 7 == 0)
+    t2 = t1;
+  else if (i % 5 == 0)
+  {
+    /* Start at an instant of the value */
+    int count = temporal_num_instants(temp);
+    TInstant *inst = temporal_instant_n(temp, 1 + rand() % count);
+    t1 = inst->t;
+    free(inst);
+  }
+  else if (i % 11 == 0)
+  {
+    t1 = lower; t2 = upper;
+  }
+  bool lower_inc = (t1 == t2) || rand() % 2;
+  bool upper_inc = (t1 == t2) || rand() % 2;
+  free(period);
+  return tstzspan_make(t1, t2, lower_inc, upper_inc);
+}
+
+/* Return true if the integral at spans is that of the restriction */
+static bool
+same_integrals(const Temporal *temp)
+{
+  for (int i = 0; i < NUM_PROBES; i++)
+  {
+    Span *s = random_span(temp, i);
+    Temporal *rest = temporal_at_tstzspan(temp, s);
+    double d1 = rest ? tnumber_integral(rest) : 0.0;
+    double d2 = tnumber_integral_at_tstzspan(temp, s);
+    free(rest); free(s);
+    if (! close_to(d1, d2))
+      return false;
+  }
+  return true;
+}
+
+/* Return true if the length at spans is that of the restriction */
+static bool
+same_lengths(const Temporal *temp)
+{
+  for (int i = 0; i < NUM_PROBES; i++)
+  {
+    Span *s = random_span(temp, i);
+    Temporal *rest = temporal_at_tstzspan(temp, s);
+    double d1 = rest ? tpoint_length(rest) : 0.0;
+    double d2 = tpoint_length_at_tstzspan(temp, s);
+    free(rest); free(s);
+    if (! close_to(d1, d2))
+      return false;
+  }
+  return true;
+}
+
+/* Return a random walk as arrays of values and timestamps */
+static void
+random_walk(double *x, double *y, double *z, TimestampTz *t, int count)
+{
+  TimestampTz start = timestamptz_in("2000-01-01 00:00:00+00", -1);
+  for (int i = 0; i < count; i++)
+  {
+    double step = (double) (rand() % 1000) / 100.0;
+    x[i] = (i == 0) ? 4.35 : x[i - 1] + ((rand() % 3) - 1) * step * 1e-3;
+    y[i] = (i == 0) ? 50.85 : y[i - 1] + ((rand() % 3) - 1) * step * 1e-3;
+    z[i] = (i == 0) ? 10.0 : z[i - 1] + ((rand() % 3) - 1) * step;
+    t[i] = start + (TimestampTz) i * 1000000 * (1 + rand() % 60);
+    if (i > 0 && t[i] <= t[i - 1])
+      t[i] = t[i - 1] + 1000000;
+  }
+  return;
+}
+
+/* Return a temporal float sequence with the values and timestamps */
+static TSequence *
+tfloatseq_from_arrays(const double *x, const TimestampTz *t, int count,
+  bool lower_inc, bool upper_inc, interpType interp)
+{
+  TInstant **instants = malloc(sizeof(TInstant *) * count);
+  for (int i = 0; i < count; i++)
+    instants[i] = tfloatinst_make(x[i] * 1000.0, t[i]);
+  TSequence *result = tsequence_make(instants, count, lower_inc, upper_inc,
+    interp, true);
+  for (int i = 0; i < count; i++)
+    free(instants[i]);
+  free(instants);
+  return result;
+}
+
+/* Return a sequence set made of consecutive pieces of a sequence separated
+ * by gaps */
+static TSequenceSet *
+tsequenceset_from_pieces(const TSequence *seq, int npieces)
+{
+  TSequence **sequences = malloc(sizeof(TSequence *) * npieces);
+  int size = seq->count / npieces;
+  for (int i = 0; i < npieces; i++)
+    /* A step sequence with an exclusive upper bound needs equal end values */
+    sequences[i] = tsequence_subseq(seq, i * size, (i + 1) * size - 2,
+      true, MEOS_FLAGS_LINEAR_INTERP(seq->flags) ? i % 2 == 0 : true);
+  TSequenceSet *result = tsequenceset_make(sequences, npieces, true);
+  for (int i = 0; i < npieces; i++)
+    free(sequences[i]);
+  free(sequences);
+  return result;
+}
+
+int
+main(void)
+{
+  meos_initialize();
+  meos_initialize_noexit_error_handler();
+  meos_initialize_timezone("UTC");
+  srand(1);
+
+  double *x = malloc(sizeof(double) * NUM_INSTANTS);
+  double *y = malloc(sizeof(double) * NUM_INSTANTS);
+  double *z = malloc(sizeof(double) * NUM_INSTANTS);
+  TimestampTz *t = malloc(sizeof(TimestampTz) * NUM_INSTANTS);
+  random_walk(x, y, z, t, NUM_INSTANTS);
+
+  /* (i) integral of temporal floats */
+  bool integrals = true;
+  for (int k = 0; k < 2; k++)
+  for (int bounds = 0; bounds <= 1; bounds++)
+  {
+    interpType interp = (k == 0) ? LINEAR : STEP;
+    /* A step sequence with an exclusive upper bound needs equal end values */
+    bool upper_inc = (interp == STEP) || bounds == 0;
+    TSequence *seq = tfloatseq_from_arrays(x, t, NUM_INSTANTS, bounds == 0,
+      upper_inc, interp);
+    TSequenceSet *ss = tsequenceset_from_pieces(seq, 10);
+    TSequence *inst = tfloatseq_from_arrays(x, t, 1, true, true, interp);
+    integrals &= same_integrals((Temporal *) seq) &&
+      same_integrals((Temporal *) ss) && same_integrals((Temporal *) inst);
+    free(seq); free(ss); free(inst);
+  }
+  check("(i) the integral at a span is that of the restriction", integrals);
+
+  /* (ii) length of temporal points */
+  bool lengths = true;
+  for (int geodetic = 0; geodetic <= 1; geodetic++)
+  for (int hasz = 0; hasz <= 1; hasz++)
+  {
+    TSequence *seq = tpointseq_make_coords(x, y, hasz ? z : NULL, t,
+      NUM_INSTANTS, 4326, geodetic, true, false, LINEAR, false);
+    TSequenceSet *ss = tsequenceset_from_pieces(seq, 10);
+    lengths &= same_lengths((Temporal *) seq) &&
+      same_lengths((Temporal *) ss);
+    free(seq); free(ss);
+  }
+  check("(ii) the length at a span is that of the restriction", lengths);
+
+  /* (iii) restriction to a span */
+  bool restricted = true;
+  TSequence *seq = tfloatseq_from_arrays(x, t, NUM_INSTANTS, true, true,
+    LINEAR);
+  for (int i = 0; i < NUM_PROBES; i++)
+  {
+    Span *s = random_span((Temporal *) seq, i);
+    Temporal *rest = temporal_at_tstzspan((Temporal *) seq, s);
+    if (rest)
+    {
+      Span *p = temporal_to_tstzspan(rest);
+      Span *inter = intersection_span_span(s, &seq->period);
+      restricted &= inter && span_eq(p, inter);
+      /* The instants of the restriction inside the span are those of the
+       * sequence */
+      int count = temporal_num_instants(rest);
+      for (int j = 2; j < count; j++)
+      {
+        TInstant *inst = temporal_instant_n(rest, j);
+        TInstant *inst1 = (TInstant *) temporal_at_timestamptz(
+          (Temporal *) seq, inst->t);
+        restricted &= inst1 && temporal_eq((Temporal *) inst,
+          (Temporal *) inst1);
+        free(inst); free(inst1);
+      }
+      free(p); free(inter);
+    }
+    else
+      restricted &= ! overlaps_span_span(s, &seq->period);
+    free(rest); free(s);
+  }
+  check("(iii) the restriction to a span keeps instants and bounds",
+    restricted);
+
+  /* (iv) subsequence */
+  TSequence *sub = tsequence_subseq(seq, 10, 20, true, false);
+  TInstant *inst1 = temporal_instant_n((Temporal *) sub, 11);
+  TInstant *inst2 = temporal_instant_n((Temporal *) seq, 21);
+  check("(iv) a subsequence ends with its last instant",
+    sub->count == 11 && inst1 && temporal_eq((Temporal *) inst1,
+      (Temporal *) inst2) && ! sub->period.upper_inc);
+  free(sub); free(inst1); free(inst2);
+
+  /* (v) invalid arguments */
+  Span *s = intspan_make(1, 10, true, false);
+  meos_errno_reset();
+  bool rejected = tnumber_integral_at_tstzspan((Temporal *) seq, s) ==
+    DBL_MAX && meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= tpoint_length_at_tstzspan((Temporal *) seq, &seq->period) ==
+    DBL_MAX && meos_errno() != 0;
+  meos_errno_reset();
+  rejected &= tnumber_integral_at_tstzspan(NULL, &seq->period) == DBL_MAX &&
+    meos_errno() != 0;
+  meos_errno_reset();
+  check("(v) invalid arguments are rejected", rejected);
+  free(s); free(seq);
+
+  free(x); free(y); free(z); free(t);
+
+  printf(failures ? "\nSome temporal sequence view tests FAILED.\n" :
+    "\nAll temporal sequence view tests passed.\n");
+  meos_finalize();
+  return failures ? 1 : 0;
+}
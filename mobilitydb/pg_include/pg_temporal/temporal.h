@@ -221,6 +221,11 @@ extern Datum Tcomp_temporal_base(FunctionCallInfo fcinfo,
 
 extern Temporal *temporal_slice(Datum tempdatum);
 
+/* Partial detoasting functions */
+
+extern Temporal *temporal_detoast_tstzspan(Datum tempdatum, const Span *s);
+extern Temporal *temporal_detoast_timestamptz(Datum tempdatum, TimestampTz t);
+
 /*****************************************************************************/
 
 #endif /* __PG_TEMPORAL_H__ */
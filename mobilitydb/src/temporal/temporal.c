@@ -1605,8 +1605,11 @@ PG_FUNCTION_INFO_V1(Temporal_value_at_timestamptz);
 Datum
 Temporal_value_at_timestamptz(PG_FUNCTION_ARGS)
 {
-  Temporal *temp = PG_GETARG_TEMPORAL_P(0);
   TimestampTz t = PG_GETARG_TIMESTAMPTZ(1);
+  /* Detoast only the part of the value covering the timestamptz */
+  Temporal *temp = temporal_detoast_timestamptz(PG_GETARG_DATUM(0), t);
+  if (! temp)
+    PG_RETURN_NULL();
   Datum result;
   bool found = temporal_value_at_timestamptz(temp, t, true, &result);
   PG_FREE_IF_COPY(temp, 0);
@@ -2402,8 +2405,13 @@ Tnumber_minus_tbox(PG_FUNCTION_ARGS)
 static Datum
 Temporal_restrict_timestamptz(FunctionCallInfo fcinfo, bool atfunc)
 {
-  Temporal *temp = PG_GETARG_TEMPORAL_P(0);
   TimestampTz t = PG_GETARG_TIMESTAMPTZ(1);
+  /* Detoast only the part of the value covering the timestamptz */
+  Temporal *temp = atfunc ?
+    temporal_detoast_timestamptz(PG_GETARG_DATUM(0), t) :
+    PG_GETARG_TEMPORAL_P(0);
+  if (! temp)
+    PG_RETURN_NULL();
 #if RGEO
   Temporal *result = (temp->temptype == T_TRGEOMETRY) ?
     trgeometry_restrict_timestamptz(temp, t, atfunc) :
@@ -2504,8 +2512,13 @@ Temporal_minus_tstzset(PG_FUNCTION_ARGS)
 static Datum
 Temporal_restrict_tstzspan(FunctionCallInfo fcinfo, bool atfunc)
 {
-  Temporal *temp = PG_GETARG_TEMPORAL_P(0);
   Span *s = PG_GETARG_SPAN_P(1);
+  /* Detoast only the part of the value covering the span */
+  Temporal *temp = atfunc ?
+    temporal_detoast_tstzspan(PG_GETARG_DATUM(0), s) :
+    PG_GETARG_TEMPORAL_P(0);
+  if (! temp)
+    PG_RETURN_NULL();
 #if RGEO
   Temporal *result = (temp->temptype == T_TRGEOMETRY) ?
     trgeometry_restrict_tstzspan(temp, s, atfunc) :
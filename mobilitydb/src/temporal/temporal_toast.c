@@ -0,0 +1,415 @@
+/*****************************************************************************
+ *
+ * This MobilityDB code is provided under The PostgreSQL License.
+ * Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+ * contributors
+ *
+ * MobilityDB includes portions of PostGIS version 3 source code released
+ * under the GNU General Public License (GPLv2 or later).
+ * Copyright (c) 2001-2025, PostGIS contributors
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written
+ * agreement is hereby granted, provided that the above copyright notice and
+ * this paragraph and the following two paragraphs appear in all copies.
+ *
+ * IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+ * EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+ * AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ *****************************************************************************/
+
+/**
+ * @file
+ * @brief Partial detoasting of temporal sequences and sequence sets
+ * @details Temporal values stored out of line are usually detoasted
+ * completely even when a function only needs a short time interval of them,
+ * which for long sequences means reading several megabytes to return a single
+ * value. The offsets arrays of the sequences and sequence sets, which are
+ * located in the first bytes of the values after the bounding box, are used
+ * as a directory from time to byte position: a binary search on the
+ * timestamps of the composing instants (resp. the periods of the composing
+ * sequences) fetching only the bytes needed at each step locates the byte
+ * range of the value covering a time span, and only this byte range is
+ * fetched from the TOAST table.
+ *
+ * Since a slice of a compressed value requires decompressing all the bytes
+ * before it, partial detoasting is only applied to values stored out of line
+ * without compression, that is, in columns declared with `STORAGE EXTERNAL`.
+ */
+
+/* PostgreSQL */
+#include <postgres.h>
+#include <access/detoast.h>
+#include <utils/timestamp.h>
+/* MEOS */
+#include <meos.h>
+#include <meos_internal.h>
+#include "temporal/span.h"
+#include "temporal/temporal.h"
+#include "temporal/temporal_boxops.h"
+/* MobilityDB */
+#include "pg_temporal/temporal.h"
+
+/**
+ * @brief Structure to access the composing elements of a temporal sequence
+ * (resp. sequence set) stored out of line, that is, its instants (resp. its
+ * sequences)
+ * @note Positions are given in bytes from the beginning of the temporal value
+ */
+typedef struct
+{
+  Datum datum;          /**< Toasted temporal value */
+  size_t offsets;       /**< Position of the offsets array */
+  size_t data;          /**< Position of the first element */
+  int count;            /**< Number of elements */
+  size_t keyoff;        /**< Position of the timestamp used for searching
+                             relative to the beginning of an element */
+} TemporalToast;
+
+/*****************************************************************************
+ * Fetch functions
+ *****************************************************************************/
+
+/**
+ * @brief Return true if a temporal datum is stored out of line without
+ * compression, so that any byte range can be fetched from it
+ */
+static bool
+temporal_toast_sliceable(Datum tempdatum)
+{
+  struct varlena *attr = (struct varlena *) DatumGetPointer(tempdatum);
+  if (! VARATT_IS_EXTERNAL_ONDISK(attr))
+    return false;
+  struct varatt_external toast_pointer;
+  VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
+  return ! VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer);
+}
+
+/**
+ * @brief Return a copy of a byte range of a toasted temporal value
+ * @param[in] tempdatum Temporal value
+ * @param[in] pos Position of the byte range from the beginning of the value,
+ * which must be after the varlena header
+ * @param[in] size Size of the byte range
+ * @note The result is copied to ensure its alignment
+ */
+static void *
+temporal_toast_fetch(Datum tempdatum, size_t pos, size_t size)
+{
+  /* Slice offsets are relative to the data after the varlena header */
+  struct varlena *slice = (struct varlena *) PG_DETOAST_DATUM_SLICE(tempdatum,
+    (int32) (pos - VARHDRSZ), (int32) size);
+  char *result = palloc0(size);
+  memcpy(result, VARDATA(slice), Min((size_t) VARSIZE(slice) - VARHDRSZ,
+    size));
+  pfree(slice);
+  return result;
+}
+
+/**
+ * @brief Initialize the structure to access the elements of a toasted
+ * sequence or sequence set whose bounding box is located at a position
+ * @note The offsets array of sequences and sequence sets follows the
+ * bounding box and is followed by the elements
+ */
+static void
+temporal_toast_init(Datum tempdatum, size_t bboxpos, int count, int maxcount,
+  int16 bboxsize, size_t keyoff, TemporalToast *tt)
+{
+  tt->datum = tempdatum;
+  tt->offsets = bboxpos + bboxsize;
+  tt->data = tt->offsets + sizeof(size_t) * maxcount;
+  tt->count = count;
+  tt->keyoff = keyoff;
+  return;
+}
+
+/**
+ * @brief Return the position of the n-th element of a toasted sequence or
+ * sequence set
+ */
+static size_t
+temporal_toast_elem_pos(const TemporalToast *tt, int n)
+{
+  size_t *offset = temporal_toast_fetch(tt->datum,
+    tt->offsets + sizeof(size_t) * n, sizeof(size_t));
+  size_t result = tt->data + *offset;
+  pfree(offset);
+  return result;
+}
+
+/**
+ * @brief Return the search timestamp of the element located at a position,
+ * that is, the timestamp of an instant or the lower bound of the period of a
+ * sequence
+ */
+static TimestampTz
+temporal_toast_elem_key(const TemporalToast *tt, size_t pos)
+{
+  TimestampTz *t = temporal_toast_fetch(tt->datum, pos + tt->keyoff,
+    sizeof(TimestampTz));
+  TimestampTz result = *t;
+  pfree(t);
+  return result;
+}
+
+/**
+ * @brief Return the index of the last element of a toasted sequence or
+ * sequence set whose search timestamp is less than or equal to a timestamp,
+ * or -1 if there is no such element
+ * @param[in] tt Structure to access the elements
+ * @param[in] t Timestamp
+ * @param[in] first Index of the first element to consider
+ */
+static int
+temporal_toast_find(const TemporalToast *tt, TimestampTz t, int first)
+{
+  int result = first - 1;
+  int first1 = first, last = tt->count - 1;
+  while (first1 <= last)
+  {
+    int middle = (first1 + last) / 2;
+    TimestampTz t1 = temporal_toast_elem_key(tt,
+      temporal_toast_elem_pos(tt, middle));
+    if (t1 <= t)
+    {
+      result = middle;
+      first1 = middle + 1;
+    }
+    else
+      last = middle - 1;
+  }
+  return result;
+}
+
+/**
+ * @brief Fetch the elements of a toasted sequence or sequence set between
+ * two indexes with a single read of their byte range
+ * @param[in] tt Structure to access the elements
+ * @param[in] from,to Indexes of the first and last elements, inclusive
+ * @return Array of pointers to the elements, which are located in a single
+ * memory chunk
+ */
+static void **
+temporal_toast_elems(const TemporalToast *tt, int from, int to)
+{
+  int count = to - from + 1;
+  size_t *offsets = temporal_toast_fetch(tt->datum,
+    tt->offsets + sizeof(size_t) * from, sizeof(size_t) * count);
+  /* Read the varlena header of the last element to obtain its size */
+  void *last = temporal_toast_fetch(tt->datum,
+    tt->data + offsets[count - 1], sizeof(int32));
+  size_t size = offsets[count - 1] - offsets[0] + VARSIZE(last);
+  pfree(last);
+  char *data = temporal_toast_fetch(tt->datum, tt->data + offsets[0], size);
+  void **result = palloc(sizeof(void *) * count);
+  for (int i = 0; i < count; i++)
+    result[i] = data + offsets[i] - offsets[0];
+  pfree(offsets);
+  return result;
+}
+
+/*****************************************************************************
+ * Partial detoasting of sequences and sequence sets
+ *****************************************************************************/
+
+/**
+ * @brief Return the part of a toasted temporal sequence located at a position
+ * that covers a time span
+ * @details The result contains the instants whose timestamps are in the span
+ * together with the previous and the next instants, if any, so that the
+ * result has the same value as the sequence at any timestamp of the span
+ * @param[in] tempdatum Temporal value
+ * @param[in] seq Header of the sequence
+ * @param[in] pos Position of the sequence in the temporal value
+ * @param[in] s Time span, which must overlap the period of the sequence
+ */
+static TSequence *
+tsequence_toast_tstzspan(Datum tempdatum, const TSequence *seq, size_t pos,
+  const Span *s)
+{
+  TemporalToast tt;
+  temporal_toast_init(tempdatum, pos + offsetof(TSequence, period),
+    seq->count, seq->maxcount, seq->bboxsize, offsetof(TInstant, t), &tt);
+  TimestampTz lower = DatumGetTimestampTz(s->lower);
+  TimestampTz upper = DatumGetTimestampTz(s->upper);
+  int from = Max(temporal_toast_find(&tt, lower, 0), 0);
+  int to = Max(temporal_toast_find(&tt, upper, from), from);
+  if (to < seq->count - 1 &&
+      temporal_toast_elem_key(&tt, temporal_toast_elem_pos(&tt, to)) < upper)
+    to++;
+
+  TInstant **instants = (TInstant **) temporal_toast_elems(&tt, from, to);
+  bool lower_inc = (from == 0) ? seq->period.lower_inc : true;
+  bool upper_inc = (to == seq->count - 1) ? seq->period.upper_inc : true;
+  if (from == to)
+    lower_inc = upper_inc = true;
+  TSequence *result = tsequence_make(instants, to - from + 1, lower_inc,
+    upper_inc, MEOS_FLAGS_GET_INTERP(seq->flags), NORMALIZE_NO);
+  pfree(instants[0]); pfree(instants);
+  return result;
+}
+
+/**
+ * @brief Return the part of a toasted temporal sequence set that covers a
+ * time span
+ * @details The composing sequences that are located inside the span are
+ * fetched completely while the first and the last ones are fetched
+ * partially, so that the result has the same value as the sequence set at
+ * any timestamp of the span
+ * @param[in] tempdatum Temporal value
+ * @param[in] ss Header of the sequence set
+ * @param[in] s Time span, which must overlap the period of the sequence set
+ * @return On empty intersection with the composing sequences return @p NULL
+ */
+static TSequenceSet *
+tsequenceset_toast_tstzspan(Datum tempdatum, const TSequenceSet *ss,
+  const Span *s)
+{
+  TemporalToast tt;
+  temporal_toast_init(tempdatum, offsetof(TSequenceSet, period), ss->count,
+    ss->maxcount, ss->bboxsize,
+    offsetof(TSequence, period) + offsetof(Span, lower), &tt);
+  int from = Max(temporal_toast_find(&tt, DatumGetTimestampTz(s->lower), 0),
+    0);
+  int to = temporal_toast_find(&tt, DatumGetTimestampTz(s->upper), from);
+
+  /* Fetch the headers of the first and last sequences and ensure that they
+   * overlap the span, which may not be the case if the span starts or ends
+   * in a gap between two sequences */
+  size_t frompos = 0, topos = 0;
+  TSequence *fromseq = NULL, *toseq = NULL;
+  while (from <= to)
+  {
+    frompos = temporal_toast_elem_pos(&tt, from);
+    fromseq = temporal_toast_fetch(tempdatum, frompos, sizeof(TSequence));
+    if (overlaps_span_span(&fromseq->period, s))
+      break;
+    pfree(fromseq); fromseq = NULL;
+    from++;
+  }
+  /* The last sequence is fetched only when it is not the first one, which
+   * overlaps the span */
+  while (from < to)
+  {
+    topos = temporal_toast_elem_pos(&tt, to);
+    toseq = temporal_toast_fetch(tempdatum, topos, sizeof(TSequence));
+    if (overlaps_span_span(&toseq->period, s))
+      break;
+    pfree(toseq); toseq = NULL;
+    to--;
+  }
+  if (from > to)
+  {
+    if (fromseq)
+      pfree(fromseq);
+    return NULL;
+  }
+
+  int count = to - from + 1;
+  TSequence **sequences = palloc(sizeof(TSequence *) * count);
+  sequences[0] = tsequence_toast_tstzspan(tempdatum, fromseq, frompos, s);
+  if (count > 1)
+  {
+    if (count > 2)
+    {
+      TSequence **inner = (TSequence **) temporal_toast_elems(&tt, from + 1,
+        to - 1);
+      for (int i = 1; i < count - 1; i++)
+        sequences[i] = inner[i - 1];
+      pfree(inner);
+    }
+    sequences[count - 1] = tsequence_toast_tstzspan(tempdatum, toseq, topos,
+      s);
+  }
+  TSequenceSet *result = tsequenceset_make(sequences, count, NORMALIZE_NO);
+  pfree(sequences[0]);
+  if (count > 1)
+  {
+    if (count > 2)
+      pfree(sequences[1]);
+    pfree(sequences[count - 1]);
+    pfree(toseq);
+  }
+  pfree(fromseq); pfree(sequences);
+  return result;
+}
+
+/**
+ * @brief Return a temporal value that has the same value as a temporal datum
+ * at any timestamp of a time span, detoasting only the part of the datum
+ * covering the span when possible
+ * @details If the datum is a sequence or a sequence set stored out of line
+ * without compression, only the byte ranges needed are fetched, otherwise
+ * the datum is detoasted completely. The result is only meant to be passed to
+ * functions that restrict the value to the span, such as
+ * #temporal_value_at_timestamptz or #temporal_restrict_tstzspan, whose result
+ * for the part is equal to the one for the complete value.
+ * @param[in] tempdatum Temporal value
+ * @param[in] s Time span
+ * @return On empty intersection between the time span and the value return
+ * @p NULL
+ * @note The result can be freed with @p PG_FREE_IF_COPY as any detoasted
+ * value
+ */
+Temporal *
+temporal_detoast_tstzspan(Datum tempdatum, const Span *s)
+{
+  if (! temporal_toast_sliceable(tempdatum))
+    return (Temporal *) PG_DETOAST_DATUM(tempdatum);
+
+  Temporal *temp = (Temporal *) PG_DETOAST_DATUM_SLICE(tempdatum, 0,
+    TEMPORAL_MAX_HEADER_SIZE);
+  /* Instants are detoasted completely and temporal rigid geometries keep
+   * their reference geometry in the data area before the composing
+   * elements */
+  if (temp->subtype == TINSTANT || temp->temptype == T_TRGEOMETRY)
+  {
+    pfree(temp);
+    return (Temporal *) PG_DETOAST_DATUM(tempdatum);
+  }
+
+  Temporal *result = NULL;
+  if (temp->subtype == TSEQUENCE)
+  {
+    TSequence *seq = (TSequence *) temp;
+    if (overlaps_span_span(&seq->period, s))
+      result = (Temporal *) tsequence_toast_tstzspan(tempdatum, seq, 0, s);
+  }
+  else /* temp->subtype == TSEQUENCESET */
+  {
+    TSequenceSet *ss = (TSequenceSet *) temp;
+    if (overlaps_span_span(&ss->period, s))
+      result = (Temporal *) tsequenceset_toast_tstzspan(tempdatum, ss, s);
+  }
+  pfree(temp);
+  return result;
+}
+
+/**
+ * @brief Return a temporal value that has the same value as a temporal datum
+ * at a timestamptz, detoasting only the part of the datum covering the
+ * timestamptz when possible
+ * @return On empty intersection between the timestamptz and the value return
+ * @p NULL
+ * @see #temporal_detoast_tstzspan
+ */
+Temporal *
+temporal_detoast_timestamptz(Datum tempdatum, TimestampTz t)
+{
+  Span s;
+  span_set(TimestampTzGetDatum(t), TimestampTzGetDatum(t), true, true,
+    T_TIMESTAMPTZ, T_TSTZSPAN, &s);
+  return temporal_detoast_tstzspan(tempdatum, &s);
+}
+
+/*****************************************************************************/
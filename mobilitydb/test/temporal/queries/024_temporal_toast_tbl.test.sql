@@ -0,0 +1,48 @@
+-------------------------------------------------------------------------------
+--
+-- This MobilityDB code is provided under The PostgreSQL License.
+-- Copyright (c) 2016-2026, Université libre de Bruxelles and MobilityDB
+-- contributors
+--
+-- MobilityDB includes portions of PostGIS version 3 source code released
+-- under the GNU General Public License (GPLv2 or later).
+-- Copyright (c) 2001-2025, PostGIS contributors
+--
+-- Permission to use, copy, modify, and distribute this software and its
+-- documentation for any purpose, without fee, and without a written
+-- agreement is hereby granted, provided that the above copyright notice and
+-- this paragraph and the following two paragraphs appear in all copies.
+--
+-- IN NO EVENT SHALL UNIVERSITE LIBRE DE BRUXELLES BE LIABLE TO ANY PARTY FOR
+-- DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+-- LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION,
+-- EVEN IF UNIVERSITE LIBRE DE BRUXELLES HAS BEEN ADVISED OF THE POSSIBILITY
+-- OF SUCH DAMAGE.
+--
+-- UNIVERSITE LIBRE DE BRUXELLES SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+-- INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+-- AND FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON
+-- AN "AS IS" BASIS, AND UNIVERSITE LIBRE DE BRUXELLES HAS NO OBLIGATIONS TO
+-- PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+--
+-------------------------------------------------------------------------------
+
+-------------------------------------------------------------------------------
+-- Partial detoasting of sequences and sequence sets stored out of line
+-------------------------------------------------------------------------------
+
+DROP TABLE IF EXISTS tbl_tfloat_toast;
+CREATE TABLE tbl_tfloat_toast(k int, temp_ext tfloat, temp tfloat);
+ALTER TABLE tbl_tfloat_toast ALTER COLUMN temp_ext SET STORAGE EXTERNAL;
+
+INSERT INTO tbl_tfloat_toast SELECT 1, temp, temp FROM (SELECT tfloatSeq(array_agg(tfloat(sin(i / 10.0), timestamptz '2001-01-01' + i * interval '1 minute') ORDER BY i)) AS temp FROM generate_series(1, 20000) i) t;
+INSERT INTO tbl_tfloat_toast SELECT 2, temp, temp FROM (SELECT tfloatSeqSet(array_agg(seq ORDER BY d)) AS temp FROM (SELECT d, tfloatSeq(array_agg(tfloat(cos(i / 10.0), timestamptz '2001-01-01' + d * interval '1 day' + i * interval '1 minute') ORDER BY i)) AS seq FROM generate_series(0, 19) d, generate_series(1, 1000) i GROUP BY d) t) t;
+
+SELECT COUNT(*) FROM tbl_tfloat_toast WHERE valueAtTimestamp(temp_ext, '2001-01-05 10:00:00') IS NOT NULL;
+SELECT COUNT(*) FROM tbl_tfloat_toast, generate_series(timestamptz '2000-12-31', '2001-01-22', interval '37 minutes') t WHERE valueAtTimestamp(temp_ext, t) IS DISTINCT FROM valueAtTimestamp(temp, t);
+SELECT COUNT(*) FROM tbl_tfloat_toast, generate_series(timestamptz '2000-12-31', '2001-01-22', interval '37 minutes') t WHERE atTime(temp_ext, t) IS DISTINCT FROM atTime(temp, t);
+SELECT COUNT(*) FROM tbl_tfloat_toast, generate_series(timestamptz '2000-12-31', '2001-01-22', interval '37 minutes') t WHERE atTime(temp_ext, span(t, t + interval '5 hours')) IS DISTINCT FROM atTime(temp, span(t, t + interval '5 hours'));
+
+DROP TABLE tbl_tfloat_toast;
+
+-------------------------------------------------------------------------------